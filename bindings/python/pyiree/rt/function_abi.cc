@@ -16,6 +16,7 @@
 
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "bindings/python/pyiree/common/status_utils.h"
 #include "bindings/python/pyiree/rt/hal.h"
@@ -98,6 +99,27 @@ class PyBufferReleaser {
   Py_buffer& b_;
 };
 
+// Minimum alignment of argument memory that is imported in-place. Less
+// aligned memory is copied so that executables may assume the alignment of
+// device allocations.
+constexpr uintptr_t kZeroCopyAlignment = 16;
+
+// A Py_buffer view retained by a HAL buffer that wraps its memory.
+struct RetainedPyBuffer {
+  Py_buffer view;
+
+  // iree_hal_buffer_release_fn_t called when the HAL buffer is destroyed.
+  // This may happen on any thread so the GIL must be acquired.
+  static void Release(void* user_data) {
+    auto* self = static_cast<RetainedPyBuffer*>(user_data);
+    if (Py_IsInitialized()) {
+      py::gil_scoped_acquire acquire;
+      PyBuffer_Release(&self->view);
+    }
+    delete self;
+  }
+};
+
 pybind11::error_already_set RaiseBufferMismatchError(
     std::string message, py::handle obj,
     const RawSignatureParser::Description& desc) {
@@ -335,13 +357,13 @@ void FunctionAbi::PackBuffer(const RawSignatureParser::Description& desc,
                              py::handle py_arg, VmVariantList& f_args,
                              bool writable) {
   // Request a view of the buffer (use the raw python C API to avoid some
-  // allocation and copying at the pybind level).
-  Py_buffer py_view;
-  // Note that only C-Contiguous ND-arrays are presently supported, so
-  // only request that via PyBUF_ND. Long term, we should consult an
-  // "oracle" in the runtime to determine the precise required format and
-  // set flags accordingly (and fallback/copy on failure).
-  int flags = PyBUF_FORMAT | PyBUF_ND;
+  // allocation and copying at the pybind level). The view is heap allocated
+  // so that it can outlive this call if the buffer is imported in-place.
+  // Strided views are accepted so that non-contiguous arrays can be packed
+  // via a copy instead of being rejected.
+  auto retained_view = absl::make_unique<RetainedPyBuffer>();
+  Py_buffer& py_view = retained_view->view;
+  int flags = PyBUF_FORMAT | PyBUF_STRIDES;
   if (writable) {
     flags |= PyBUF_WRITABLE;
   }
@@ -351,11 +373,8 @@ void FunctionAbi::PackBuffer(const RawSignatureParser::Description& desc,
     // The GetBuffer call is required to set an appropriate error.
     throw py::error_already_set();
   }
-  PyBufferReleaser py_view_releaser(py_view);
-
-  // Whether the py object needs to be retained with the argument.
-  // Should be set to true if directly mapping, false if copied.
-  bool depends_on_pyobject = false;
+  absl::optional<PyBufferReleaser> py_view_releaser;
+  py_view_releaser.emplace(py_view);
 
   // Verify compatibility.
   absl::InlinedVector<int, 2> dynamic_dims;
@@ -365,36 +384,71 @@ void FunctionAbi::PackBuffer(const RawSignatureParser::Description& desc,
                        "Dynamic argument dimensions not implemented");
   }
 
-  // Allocate a HalBuffer.
-  // This is hard-coded to C-contiguous right now.
-  // TODO(laurenzo): Expand to other layouts as needed.
-  // TODO(laurenzo): Wrap and retain original buffer (depends_on_pyobject=true).
-  iree_hal_buffer_t* raw_buffer;
-  CheckApiStatus(iree_hal_allocator_allocate_buffer(
-                     device_.allocator(),
-                     static_cast<iree_hal_memory_type_t>(
-                         IREE_HAL_MEMORY_TYPE_HOST_LOCAL |
-                         IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE),
-                     IREE_HAL_BUFFER_USAGE_ALL, py_view.len, &raw_buffer),
-                 "Failed to allocate device visible buffer");
-  CheckApiStatus(
-      iree_hal_buffer_write_data(raw_buffer, 0, py_view.buf, py_view.len),
-      "Error writing to input buffer");
+  // Import the memory in-place when the layout matches what the runtime
+  // expects (C-contiguous) and the device allocator can use host memory. The
+  // exporting object is retained by the HAL buffer and released when the
+  // buffer is destroyed, which may be well after the invocation if the buffer
+  // is captured by the program. The buffer only allows reads so that the
+  // runtime can never modify the caller's array, even if it was exported as
+  // writable.
+  iree_hal_buffer_t* raw_buffer = nullptr;
+  bool is_aligned =
+      reinterpret_cast<uintptr_t>(py_view.buf) % kZeroCopyAlignment == 0;
+  if (py_view.len > 0 && is_aligned && PyBuffer_IsContiguous(&py_view, 'C')) {
+    auto status = iree_hal_allocator_wrap_buffer_with_release(
+        device_.allocator(),
+        static_cast<iree_hal_memory_type_t>(
+            IREE_HAL_MEMORY_TYPE_HOST_LOCAL |
+            IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE),
+        IREE_HAL_MEMORY_ACCESS_READ, IREE_HAL_BUFFER_USAGE_ALL,
+        {static_cast<uint8_t*>(py_view.buf),
+         static_cast<iree_host_size_t>(py_view.len)},
+        &RetainedPyBuffer::Release, retained_view.get(), &raw_buffer);
+    if (status == IREE_STATUS_OK) {
+      // Ownership of the view has passed to the buffer.
+      py_view_releaser.reset();
+      retained_view.release();
+    } else {
+      // Not supported by the device allocator; fall back to a copy.
+      raw_buffer = nullptr;
+    }
+  }
+
+  if (!raw_buffer) {
+    CheckApiStatus(iree_hal_allocator_allocate_buffer(
+                       device_.allocator(),
+                       static_cast<iree_hal_memory_type_t>(
+                           IREE_HAL_MEMORY_TYPE_HOST_LOCAL |
+                           IREE_HAL_MEMORY_TYPE_DEVICE_VISIBLE),
+                       IREE_HAL_BUFFER_USAGE_ALL, py_view.len, &raw_buffer),
+                   "Failed to allocate device visible buffer");
+    HalBuffer buffer = HalBuffer::CreateRetained(raw_buffer);
+    if (PyBuffer_IsContiguous(&py_view, 'C')) {
+      CheckApiStatus(
+          iree_hal_buffer_write_data(raw_buffer, 0, py_view.buf, py_view.len),
+          "Error writing to input buffer");
+    } else {
+      // Gather the strided view into C-contiguous order.
+      iree_hal_mapped_memory_t mapped_memory;
+      CheckApiStatus(
+          iree_hal_buffer_map(raw_buffer, IREE_HAL_MEMORY_ACCESS_DISCARD_WRITE,
+                              0, py_view.len, &mapped_memory),
+          "Could not map input buffer");
+      int rc = PyBuffer_ToContiguous(mapped_memory.contents.data, &py_view,
+                                     py_view.len, 'C');
+      CheckApiStatus(iree_hal_buffer_unmap(raw_buffer, &mapped_memory),
+                     "Error unmapping input buffer");
+      if (rc != 0) {
+        throw py::error_already_set();
+      }
+    }
+    raw_buffer = buffer.steal_raw_ptr();
+  }
+
   iree_vm_ref_t buffer_ref = iree_hal_buffer_move_ref(raw_buffer);
   CheckApiStatus(
       iree_vm_variant_list_append_ref_move(f_args.raw_ptr(), &buffer_ref),
       "Error moving buffer");
-
-  // Only capture the reference to the exporting object (incrementing it)
-  // once guaranteed successful.
-  if (depends_on_pyobject) {
-    // Note for future implementation: there needs to be a place to stash
-    // references to be kept alive which back a buffer. This is likely an
-    // additional bag of refs returned from this function, which can then
-    // be attached to an invocation.
-    throw RaisePyError(PyExc_NotImplementedError,
-                       "Dependent buffer arguments not implemented");
-  }
 }
 
 void SetupFunctionAbiBindings(pybind11::module m) {
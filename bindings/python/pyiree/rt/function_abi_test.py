@@ -72,6 +72,23 @@ class FunctionAbiTest(absltest.TestCase):
     print(packed)
     self.assertEqual("<VmVariantList(1): [HalBuffer(327680)]>", repr(packed))
 
+  def test_static_arg_strided_success(self):
+    fabi = rt.FunctionAbi(self.device, self.htf,
+                          ATTRS_1ARG_FLOAT32_10X128X64_TO_SINT32_32X8X64_V1)
+    # Non-contiguous views cannot be imported in-place and are copied.
+    arg = np.zeros((10, 128, 128), dtype=np.float32)[:, :, ::2]
+    self.assertFalse(arg.flags.c_contiguous)
+    packed = fabi.raw_pack_inputs([arg])
+    self.assertEqual("<VmVariantList(1): [HalBuffer(327680)]>", repr(packed))
+
+  def test_static_arg_readonly_success(self):
+    fabi = rt.FunctionAbi(self.device, self.htf,
+                          ATTRS_1ARG_FLOAT32_10X128X64_TO_SINT32_32X8X64_V1)
+    arg = np.zeros((10, 128, 64), dtype=np.float32)
+    arg.setflags(write=False)
+    packed = fabi.raw_pack_inputs([arg])
+    self.assertEqual("<VmVariantList(1): [HalBuffer(327680)]>", repr(packed))
+
   def test_static_result_success(self):
     fabi = rt.FunctionAbi(self.device, self.htf,
                           ATTRS_1ARG_FLOAT32_10X128X64_TO_SINT32_32X8X64_V1)
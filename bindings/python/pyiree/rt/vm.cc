@@ -156,6 +156,15 @@ VmModule VmModule::FromFlatbufferBlob(py::buffer flatbuffer_blob) {
   return VmModule::CreateRetained(module);
 }
 
+VmModule VmModule::FromFile(const std::string& path) {
+  iree_vm_module_t* module;
+  CheckApiStatus(iree_vm_bytecode_module_create_from_file(
+                     {path.data(), path.size()}, IREE_ALLOCATOR_SYSTEM,
+                     &module),
+                 "Error creating vm module from file");
+  return VmModule::CreateRetained(module);
+}
+
 absl::optional<iree_vm_function_t> VmModule::LookupFunction(
     const std::string& name, iree_vm_function_linkage_t linkage) {
   iree_vm_function_t f;
@@ -240,6 +249,7 @@ void SetupVmBindings(pybind11::module m) {
 
   py::class_<VmModule>(m, "VmModule")
       .def_static("from_flatbuffer", &VmModule::FromFlatbufferBlob)
+      .def_static("from_file", &VmModule::FromFile)
       .def_property_readonly("name", &VmModule::name)
       .def("lookup_function", &VmModule::LookupFunction, py::arg("name"),
            py::arg("linkage") = IREE_VM_FUNCTION_LINKAGE_EXPORT);
@@ -116,6 +116,7 @@ class VmInstance : public ApiRefCounted<VmInstance, iree_vm_instance_t> {
 class VmModule : public ApiRefCounted<VmModule, iree_vm_module_t> {
  public:
   static VmModule FromFlatbufferBlob(py::buffer flatbuffer_blob);
+  static VmModule FromFile(const std::string& path);
 
   absl::optional<iree_vm_function_t> LookupFunction(
       const std::string& name, iree_vm_function_linkage_t linkage);
@@ -15,13 +15,16 @@
 
 # pylint: disable=unused-variable
 
+import os
+import tempfile
+
 from absl.testing import absltest
 import numpy as np
 from pyiree import compiler
 from pyiree import rt
 
 
-def create_simple_mul_module():
+def compile_simple_mul_module():
   ctx = compiler.Context()
   input_module = ctx.parse_asm("""
     func @simple_mul(%arg0: tensor<4xf32>, %arg1: tensor<4xf32>) -> tensor<4xf32>
@@ -30,7 +33,11 @@ def create_simple_mul_module():
         return %0 : tensor<4xf32>
     }
     """)
-  binary = input_module.compile()
+  return input_module.compile()
+
+
+def create_simple_mul_module():
+  binary = compile_simple_mul_module()
   m = rt.VmModule.from_flatbuffer(binary)
   return m
 
@@ -65,6 +72,17 @@ class VmTest(absltest.TestCase):
     notfound = m.lookup_function("notfound")
     self.assertIs(notfound, None)
 
+  def test_module_from_file(self):
+    binary = compile_simple_mul_module()
+    with tempfile.TemporaryDirectory() as temp_dir:
+      module_path = os.path.join(temp_dir, "simple_mul.vmfb")
+      with open(module_path, "wb") as f:
+        f.write(binary)
+      m = rt.VmModule.from_file(module_path)
+    # The mapping remains valid after the file is unlinked.
+    f = m.lookup_function("simple_mul")
+    self.assertGreater(f.ordinal, 0)
+
   def test_dynamic_module_context(self):
     instance = rt.VmInstance()
     context = rt.VmContext(instance)
@@ -99,6 +117,25 @@ class VmTest(absltest.TestCase):
     print("RESULTS:", results)
     np.testing.assert_allclose(results[0], [4., 10., 18., 28.])
 
+  def test_invoke_does_not_modify_args(self):
+    m = create_simple_mul_module()
+    instance = rt.VmInstance()
+    context = rt.VmContext(instance, modules=[self.hal_module, m])
+    f = m.lookup_function("simple_mul")
+    abi = context.create_function_abi(self.device, self.htf, f)
+    # Writable and read-only arrays may both be imported without copying.
+    arg0 = np.array([1., 2., 3., 4.], dtype=np.float32)
+    arg1 = np.array([4., 5., 6., 7.], dtype=np.float32)
+    arg1.setflags(write=False)
+    inputs = abi.raw_pack_inputs((arg0, arg1))
+    allocated_results = abi.allocate_results(inputs, static_alloc=False)
+    context.invoke(f, inputs, allocated_results)
+    results = abi.raw_unpack_results(allocated_results)
+    np.testing.assert_allclose(results[0], [4., 10., 18., 28.])
+    np.testing.assert_array_equal(arg0, [1., 2., 3., 4.])
+    np.testing.assert_array_equal(arg1, [4., 5., 6., 7.])
+    self.assertTrue(arg0.flags.writeable)
+
 
 if __name__ == "__main__":
   absltest.main()
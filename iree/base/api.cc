@@ -18,6 +18,8 @@
 #include <cstring>
 #include <string>
 
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "iree/base/api_util.h"
 #include "iree/base/file_mapping.h"
 #include "iree/base/init.h"
@@ -201,6 +203,14 @@ IREE_API_EXPORT int IREE_API_CALL iree_string_view_split(
   return offset;
 }
 
+//===----------------------------------------------------------------------===//
+// iree_time_t
+//===----------------------------------------------------------------------===//
+
+IREE_API_EXPORT iree_time_t IREE_API_CALL iree_time_now() {
+  return absl::ToUnixNanos(absl::Now());
+}
+
 //===----------------------------------------------------------------------===//
 // iree::FileMapping
 //===----------------------------------------------------------------------===//
@@ -417,6 +417,17 @@ IREE_API_EXPORT int IREE_API_CALL iree_string_view_split(
 
 #endif  // IREE_API_NO_PROTOTYPES
 
+//===----------------------------------------------------------------------===//
+// iree_time_t
+//===----------------------------------------------------------------------===//
+
+#ifndef IREE_API_NO_PROTOTYPES
+
+// Returns the current system time in nanoseconds since the unix epoch.
+IREE_API_EXPORT iree_time_t IREE_API_CALL iree_time_now(void);
+
+#endif  // IREE_API_NO_PROTOTYPES
+
 //===----------------------------------------------------------------------===//
 // iree::FileMapping
 //===----------------------------------------------------------------------===//
@@ -31,10 +31,14 @@ Status FileExists(const std::string& path);
 // Synchronously reads a file's contents into a string.
 StatusOr<std::string> GetFileContents(const std::string& path);
 
+// Synchronously writes |content| to a file, replacing any existing contents.
+Status SetFileContents(const std::string& path, const std::string& content);
+
 // Deletes the file at the provided path.
 Status DeleteFile(const std::string& path);
 
-// Moves a file from 'source_path' to 'destination_path'.
+// Moves a file from 'source_path' to 'destination_path', replacing any
+// existing file at 'destination_path'.
 //
 // This may simply rename the file, but may fall back to a full copy and delete
 // of the original if renaming is not possible (for example when moving between
@@ -51,6 +51,29 @@ StatusOr<std::string> GetFileContents(const std::string& path) {
   return result;
 }
 
+Status SetFileContents(const std::string& path, const std::string& content) {
+  HANDLE handle = ::CreateFileA(path.c_str(), GENERIC_WRITE, 0, nullptr,
+                                CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (handle == INVALID_HANDLE_VALUE) {
+    return Win32ErrorToCanonicalStatusBuilder(GetLastError(), IREE_LOC)
+           << "Unable to open file " << path << " for writing";
+  }
+  DWORD bytes_written = 0;
+  BOOL result = ::WriteFile(handle, content.data(), content.size(),
+                            &bytes_written, nullptr);
+  DWORD error = GetLastError();
+  ::CloseHandle(handle);
+  if (result == FALSE) {
+    return Win32ErrorToCanonicalStatusBuilder(error, IREE_LOC)
+           << "Unable to write file span of " << content.size() << " bytes";
+  } else if (bytes_written != content.size()) {
+    return ResourceExhaustedErrorBuilder(IREE_LOC)
+           << "Unable to write all " << content.size()
+           << " bytes to the file (wrote " << bytes_written << ")";
+  }
+  return OkStatus();
+}
+
 Status DeleteFile(const std::string& path) {
   if (::DeleteFileA(path.c_str()) == FALSE) {
     return Win32ErrorToCanonicalStatusBuilder(GetLastError(), IREE_LOC)
@@ -61,7 +84,9 @@ Status DeleteFile(const std::string& path) {
 
 Status MoveFile(const std::string& source_path,
                 const std::string& destination_path) {
-  if (::MoveFileA(source_path.c_str(), destination_path.c_str()) == FALSE) {
+  if (::MoveFileExA(source_path.c_str(), destination_path.c_str(),
+                    MOVEFILE_REPLACE_EXISTING | MOVEFILE_COPY_ALLOWED) ==
+      FALSE) {
     return Win32ErrorToCanonicalStatusBuilder(GetLastError(), IREE_LOC)
            << "Unable to move file " << source_path << " to "
            << destination_path;
@@ -34,18 +34,21 @@ namespace {
 class FileDescriptor {
  public:
   static StatusOr<std::unique_ptr<FileDescriptor>> OpenRead(std::string path) {
-    struct stat buf;
-    if (::lstat(path.c_str(), &buf) == -1) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
       return NotFoundErrorBuilder(IREE_LOC)
-             << "Unable to stat file " << path << ": " << ::strerror(errno);
+             << "Unable to open file " << path << ": " << ::strerror(errno);
     }
-    uint64_t file_size = static_cast<size_t>(buf.st_size);
 
-    int fd = ::open(path.c_str(), O_RDONLY);
-    if (fd == -1) {
+    // Stat the opened file so that symlinks report the size of their target.
+    struct stat buf;
+    if (::fstat(fd, &buf) == -1) {
+      int error = errno;
+      ::close(fd);
       return UnavailableErrorBuilder(IREE_LOC)
-             << "Unable to open file " << path << ": " << ::strerror(errno);
+             << "Unable to stat file " << path << ": " << ::strerror(error);
     }
+    uint64_t file_size = static_cast<size_t>(buf.st_size);
 
     return absl::make_unique<FileDescriptor>(std::move(path), fd, file_size);
   }
@@ -0,0 +1,216 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/base/lz4.h"
+
+#include <cstring>
+#include <vector>
+
+namespace iree {
+
+namespace {
+
+// Matches shorter than this are not worth encoding.
+constexpr size_t kMinMatch = 4;
+// The last 5 bytes of a block are always literals.
+constexpr size_t kLastLiterals = 5;
+// The last match must start at least 12 bytes before the end of the block.
+constexpr size_t kMatchFindLimit = 12;
+// Matches are encoded with a 16-bit backwards offset.
+constexpr size_t kMaxOffset = 65535;
+// Token nibbles saturate at 15 and continue in extension bytes.
+constexpr size_t kRunMask = 15;
+
+constexpr int kHashLog = 16;
+// Number of failed match attempts before the search starts skipping ahead.
+// Skipping keeps incompressible data fast at a small cost in ratio.
+constexpr int kSkipTrigger = 6;
+
+inline uint32_t Read32(const uint8_t* p) {
+  uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline uint32_t Hash(uint32_t sequence) {
+  return (sequence * 2654435761u) >> (32 - kHashLog);
+}
+
+// Writes the extension bytes of a length that saturated its token nibble.
+inline uint8_t* WriteLength(uint8_t* op, size_t length) {
+  for (; length >= 255; length -= 255) *op++ = 255;
+  *op++ = static_cast<uint8_t>(length);
+  return op;
+}
+
+// Writes a sequence of |literal_length| literals starting at |literals|
+// optionally followed by a match of |match_length| bytes at |offset| back.
+uint8_t* WriteSequence(uint8_t* op, const uint8_t* literals,
+                       size_t literal_length, size_t offset,
+                       size_t match_length) {
+  uint8_t* token = op++;
+  if (literal_length >= kRunMask) {
+    *token = kRunMask << 4;
+    op = WriteLength(op, literal_length - kRunMask);
+  } else {
+    *token = static_cast<uint8_t>(literal_length << 4);
+  }
+  std::memcpy(op, literals, literal_length);
+  op += literal_length;
+  if (!match_length) return op;
+
+  *op++ = static_cast<uint8_t>(offset);
+  *op++ = static_cast<uint8_t>(offset >> 8);
+  match_length -= kMinMatch;
+  if (match_length >= kRunMask) {
+    *token |= kRunMask;
+    op = WriteLength(op, match_length - kRunMask);
+  } else {
+    *token |= static_cast<uint8_t>(match_length);
+  }
+  return op;
+}
+
+// Reads the extension bytes of a saturated length.
+inline bool ReadLength(const uint8_t** ip, const uint8_t* ip_end,
+                       size_t* length) {
+  uint8_t byte;
+  do {
+    if (*ip >= ip_end) return false;
+    byte = *(*ip)++;
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+}  // namespace
+
+size_t Lz4CompressBound(size_t source_length) {
+  return source_length + source_length / 255 + 16;
+}
+
+size_t Lz4CompressBlock(absl::Span<const uint8_t> source,
+                        absl::Span<uint8_t> target) {
+  const uint8_t* const base = source.data();
+  const uint8_t* const source_end = base + source.size();
+  const uint8_t* anchor = base;
+  uint8_t* op = target.data();
+
+  if (source.size() > kMatchFindLimit) {
+    const uint8_t* const match_limit = source_end - kMatchFindLimit;
+    const uint8_t* const match_end_limit = source_end - kLastLiterals;
+    std::vector<uint32_t> hash_table(1 << kHashLog, 0);
+    const uint8_t* ip = base + 1;
+    int search_count = 1 << kSkipTrigger;
+    while (ip < match_limit) {
+      uint32_t sequence = Read32(ip);
+      uint32_t& entry = hash_table[Hash(sequence)];
+      const uint8_t* match = base + entry;
+      entry = static_cast<uint32_t>(ip - base);
+      if (static_cast<size_t>(ip - match) > kMaxOffset ||
+          Read32(match) != sequence) {
+        ip += search_count++ >> kSkipTrigger;
+        continue;
+      }
+      search_count = 1 << kSkipTrigger;
+
+      // Extend the match backwards over pending literals and then forwards.
+      while (ip > anchor && match > base && ip[-1] == match[-1]) {
+        --ip;
+        --match;
+      }
+      size_t match_length = kMinMatch;
+      while (ip + match_length < match_end_limit &&
+             ip[match_length] == match[match_length]) {
+        ++match_length;
+      }
+
+      op = WriteSequence(op, anchor, ip - anchor, ip - match, match_length);
+      ip += match_length;
+      anchor = ip;
+      if (ip < match_limit) {
+        // Index a position inside the match to find repeats sooner.
+        const uint8_t* p = ip - 2;
+        hash_table[Hash(Read32(p))] = static_cast<uint32_t>(p - base);
+      }
+    }
+  }
+
+  op = WriteSequence(op, anchor, source_end - anchor, 0, 0);
+  return op - target.data();
+}
+
+Status Lz4DecompressBlock(absl::Span<const uint8_t> source,
+                          absl::Span<uint8_t> target) {
+  const uint8_t* ip = source.data();
+  const uint8_t* const ip_end = ip + source.size();
+  uint8_t* op = target.data();
+  uint8_t* const op_end = op + target.size();
+
+  while (true) {
+    if (ip >= ip_end) {
+      return DataLossErrorBuilder(IREE_LOC) << "LZ4 block truncated";
+    }
+    uint8_t token = *ip++;
+
+    size_t literal_length = token >> 4;
+    if (literal_length == kRunMask &&
+        !ReadLength(&ip, ip_end, &literal_length)) {
+      return DataLossErrorBuilder(IREE_LOC) << "LZ4 literal length truncated";
+    }
+    if (literal_length > static_cast<size_t>(ip_end - ip) ||
+        literal_length > static_cast<size_t>(op_end - op)) {
+      return DataLossErrorBuilder(IREE_LOC) << "LZ4 literals out of bounds";
+    }
+    std::memcpy(op, ip, literal_length);
+    ip += literal_length;
+    op += literal_length;
+    if (ip == ip_end) break;  // The last sequence has no match.
+
+    if (ip_end - ip < 2) {
+      return DataLossErrorBuilder(IREE_LOC) << "LZ4 match offset truncated";
+    }
+    size_t offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > static_cast<size_t>(op - target.data())) {
+      return DataLossErrorBuilder(IREE_LOC) << "LZ4 match offset out of bounds";
+    }
+    size_t match_length = token & kRunMask;
+    if (match_length == kRunMask && !ReadLength(&ip, ip_end, &match_length)) {
+      return DataLossErrorBuilder(IREE_LOC) << "LZ4 match length truncated";
+    }
+    match_length += kMinMatch;
+    if (match_length > static_cast<size_t>(op_end - op)) {
+      return DataLossErrorBuilder(IREE_LOC) << "LZ4 match out of bounds";
+    }
+
+    const uint8_t* match = op - offset;
+    if (offset >= match_length) {
+      std::memcpy(op, match, match_length);
+      op += match_length;
+    } else {
+      // Overlapping matches repeat the last |offset| bytes.
+      for (size_t i = 0; i < match_length; ++i) *op++ = *match++;
+    }
+  }
+
+  if (op != op_end) {
+    return DataLossErrorBuilder(IREE_LOC)
+           << "LZ4 block decompressed to " << (op - target.data())
+           << " bytes; expected " << target.size();
+  }
+  return OkStatus();
+}
+
+}  // namespace iree
@@ -0,0 +1,56 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef IREE_BASE_LZ4_H_
+#define IREE_BASE_LZ4_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/types/span.h"
+#include "iree/base/status.h"
+
+// LZ4 block format compression.
+// https://github.com/lz4/lz4/blob/master/doc/lz4_Block_format.md
+//
+// The output is a single raw LZ4 block (no frame header or checksums) and is
+// readable by any conforming LZ4 block decoder. The block does not record its
+// decompressed size so it must be stored alongside the compressed data.
+//
+// Compression favors speed over ratio and is intended for offline use such as
+// packing constant data into modules. Decompression is fast enough to run at
+// load time and validates all offsets and lengths against the provided buffers
+// so that untrusted inputs cannot read or write out of bounds.
+namespace iree {
+
+// Returns the maximum size of the LZ4 block produced when compressing
+// |source_length| bytes.
+size_t Lz4CompressBound(size_t source_length);
+
+// Compresses |source| into |target| as a single LZ4 block.
+// |target| must be at least Lz4CompressBound(source.size()) bytes.
+// Returns the number of bytes written to |target|.
+size_t Lz4CompressBlock(absl::Span<const uint8_t> source,
+                        absl::Span<uint8_t> target);
+
+// Decompresses the LZ4 block in |source| into |target|, which must be exactly
+// the size of the decompressed data.
+// Returns DataLossError if the block is malformed or does not decompress to
+// exactly target.size() bytes.
+Status Lz4DecompressBlock(absl::Span<const uint8_t> source,
+                          absl::Span<uint8_t> target);
+
+}  // namespace iree
+
+#endif  // IREE_BASE_LZ4_H_
@@ -0,0 +1,100 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/base/lz4.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "iree/base/status_matchers.h"
+#include "iree/testing/gtest.h"
+
+namespace iree {
+namespace {
+
+using ::iree::testing::status::StatusIs;
+using ::testing::ElementsAreArray;
+
+std::vector<uint8_t> Compress(const std::vector<uint8_t>& source) {
+  std::vector<uint8_t> target(Lz4CompressBound(source.size()));
+  target.resize(Lz4CompressBlock(source, absl::MakeSpan(target)));
+  return target;
+}
+
+void ExpectRoundTrip(const std::vector<uint8_t>& source) {
+  auto compressed = Compress(source);
+  std::vector<uint8_t> decompressed(source.size());
+  ASSERT_OK(Lz4DecompressBlock(compressed, absl::MakeSpan(decompressed)));
+  EXPECT_THAT(decompressed, ElementsAreArray(source));
+}
+
+TEST(Lz4Test, Empty) { ExpectRoundTrip({}); }
+
+TEST(Lz4Test, Small) {
+  ExpectRoundTrip({1});
+  ExpectRoundTrip({1, 2, 3, 4, 1, 2, 3, 4, 1, 2, 3, 4});
+}
+
+TEST(Lz4Test, Compressible) {
+  std::vector<uint8_t> source(64 * 1024);
+  for (size_t i = 0; i < source.size(); ++i) {
+    source[i] = static_cast<uint8_t>((i / 16) % 7);
+  }
+  EXPECT_LT(Compress(source).size(), source.size() / 8);
+  ExpectRoundTrip(source);
+}
+
+TEST(Lz4Test, Repeated) {
+  // Long runs produce overlapping matches and saturated length encodings.
+  std::vector<uint8_t> source(100000, 0xAB);
+  ExpectRoundTrip(source);
+}
+
+TEST(Lz4Test, Incompressible) {
+  std::mt19937 rng(0);
+  std::vector<uint8_t> source(200000);
+  for (auto& value : source) value = static_cast<uint8_t>(rng());
+  EXPECT_LE(Compress(source).size(), Lz4CompressBound(source.size()));
+  ExpectRoundTrip(source);
+}
+
+TEST(Lz4Test, SizeMismatch) {
+  std::vector<uint8_t> source(1024, 7);
+  auto compressed = Compress(source);
+  std::vector<uint8_t> too_small(source.size() - 1);
+  EXPECT_THAT(Lz4DecompressBlock(compressed, absl::MakeSpan(too_small)),
+              StatusIs(StatusCode::kDataLoss));
+  std::vector<uint8_t> too_large(source.size() + 1);
+  EXPECT_THAT(Lz4DecompressBlock(compressed, absl::MakeSpan(too_large)),
+              StatusIs(StatusCode::kDataLoss));
+}
+
+TEST(Lz4Test, Malformed) {
+  std::vector<uint8_t> target(16);
+  // Truncated block.
+  EXPECT_THAT(Lz4DecompressBlock({}, absl::MakeSpan(target)),
+              StatusIs(StatusCode::kDataLoss));
+  // Literals run past the end of the block.
+  std::vector<uint8_t> truncated_literals = {0x40, 1, 2};
+  EXPECT_THAT(Lz4DecompressBlock(truncated_literals, absl::MakeSpan(target)),
+              StatusIs(StatusCode::kDataLoss));
+  // Match offset reaches before the start of the output.
+  std::vector<uint8_t> bad_offset = {0x10, 1, 0x08, 0x00, 0x00};
+  EXPECT_THAT(Lz4DecompressBlock(bad_offset, absl::MakeSpan(target)),
+              StatusIs(StatusCode::kDataLoss));
+}
+
+}  // namespace
+}  // namespace iree
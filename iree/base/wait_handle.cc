@@ -14,6 +14,13 @@
 
 #include "iree/base/wait_handle.h"
 
+#include "iree/base/target_platform.h"
+
+// WaitHandle is built on fds and poll; Windows has neither and needs a port to
+// kernel events (google/iree/65). Until then the library is empty there and
+// users (such as HostFence) must not rely on it.
+#if !defined(IREE_PLATFORM_WINDOWS)
+
 #include <errno.h>
 #include <fcntl.h>
 #include <poll.h>
@@ -530,3 +537,5 @@ Status ManualResetEvent::Reset() { return ClearFd(fd_type_, fd_); }
 WaitHandle ManualResetEvent::OnSet() { return WaitHandle(add_ref(this)); }
 
 }  // namespace iree
+
+#endif  // !IREE_PLATFORM_WINDOWS
@@ -33,6 +33,9 @@ namespace iree {
 // WaitableObjects are much like ::thread::Selectable, only they support both
 // the classic locking style as well as file descriptors for use with select().
 //
+// NOTE: only implemented on POSIX platforms; on Windows the declarations are
+// available but nothing is defined.
+//
 // Usage:
 //  class MyWaitableObject : public WaitableObject {
 //   public:
@@ -14,6 +14,10 @@
 
 #include "iree/base/wait_handle.h"
 
+#include "iree/base/target_platform.h"
+
+#if !defined(IREE_PLATFORM_WINDOWS)
+
 #include <unistd.h>
 
 #include <string>
@@ -552,3 +556,5 @@ TEST(ManualResetEventTest, NeverSet) {
 
 }  // namespace
 }  // namespace iree
+
+#endif  // !IREE_PLATFORM_WINDOWS
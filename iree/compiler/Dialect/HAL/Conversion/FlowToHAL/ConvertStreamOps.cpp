@@ -12,6 +12,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <limits>
+
 #include "iree/compiler/Dialect/Flow/IR/FlowOps.h"
 #include "iree/compiler/Dialect/HAL/Conversion/FlowToHAL/ConvertFlowToHAL.h"
 #include "iree/compiler/Dialect/HAL/IR/HALOps.h"
@@ -19,6 +21,9 @@
 #include "iree/compiler/Dialect/HAL/Utils/TypeUtils.h"
 #include "iree/compiler/Dialect/IREE/IR/IREETypes.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Support/MathExtras.h"
 #include "mlir/Dialect/StandardOps/Ops.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Builders.h"
@@ -52,6 +57,41 @@ struct BufferSet {
   DenseMap<Value, BufferRange> rangeMap;
 };
 
+// Commands within a stream partitioned into waves. Commands within a wave have
+// no hazards between each other and may execute concurrently while commands in
+// subsequent waves depend on at least one command in a prior wave.
+struct StreamSchedule {
+  // Commands in each wave in their original stream order.
+  SmallVector<SmallVector<Operation *, 4>, 4> waves;
+
+  // Maps each command to the wave it is scheduled in.
+  DenseMap<Operation *, int> commandWaves;
+};
+
+// Schedules the commands in |streamBlock| into waves based on their data
+// dependencies. Each command is placed in the wave following the latest of the
+// commands producing its operands so that independent commands are not
+// serialized behind each other.
+static StreamSchedule scheduleStreamCommands(Block &streamBlock) {
+  StreamSchedule schedule;
+  for (auto &op : streamBlock) {
+    if (isa<IREE::Flow::ReturnOp>(op)) continue;
+    int wave = 0;
+    for (auto operand : op.getOperands()) {
+      auto it = schedule.commandWaves.find(operand.getDefiningOp());
+      if (it != schedule.commandWaves.end()) {
+        wave = std::max(wave, it->second + 1);
+      }
+    }
+    schedule.commandWaves[&op] = wave;
+    if (wave >= static_cast<int>(schedule.waves.size())) {
+      schedule.waves.resize(wave + 1);
+    }
+    schedule.waves[wave].push_back(&op);
+  }
+  return schedule;
+}
+
 // Allocates a buffer for the given stream output value.
 // |streamValue| is the Value  used within the stream region and
 // |externalValue| is the returned value from the stream region in the parent
@@ -107,30 +147,38 @@ static void allocateOutputBuffers(IREE::Flow::ExStreamFragmentOp streamOp,
   }
 }
 
+// Memory types and usage of transient buffers used entirely within the
+// command buffer.
+// TODO(benvanik): compute from SSA use-def chain uses.
+static const IREE::HAL::MemoryTypeBitfield kTransientMemoryTypes =
+    IREE::HAL::MemoryTypeBitfield::DeviceLocal;
+static const IREE::HAL::BufferUsageBitfield kTransientBufferUsage =
+    IREE::HAL::BufferUsageBitfield::Dispatch |
+    IREE::HAL::BufferUsageBitfield::Transfer;
+
+// Byte alignment of transient buffer ranges within a packed allocation. This
+// is the largest minStorageBufferOffsetAlignment required by Vulkan devices so
+// that the ranges can be bound directly.
+static constexpr int64_t kTransientBufferAlignment = 256;
+
 // Allocates a transient buffer for use entirely within the command buffer.
 static Value allocateTransientBuffer(Value streamValue, Value allocator,
                                      ConversionPatternRewriter &rewriter) {
-  // TODO(benvanik): compute from SSA use-def chain uses.
-  IREE::HAL::MemoryTypeBitfield memoryTypes =
-      IREE::HAL::MemoryTypeBitfield::DeviceLocal;
-  IREE::HAL::BufferUsageBitfield bufferUsage =
-      IREE::HAL::BufferUsageBitfield::Dispatch |
-      IREE::HAL::BufferUsageBitfield::Transfer;
-
   // Compute the allocation size for the value.
   int elementSize = IREE::HAL::getRoundedElementByteWidth(
       streamValue.getType().cast<ShapedType>().getElementType());
   auto shape = IREE::HAL::getShapeDims(streamValue, rewriter);
   auto allocationSize = rewriter
                             .create<IREE::HAL::AllocatorComputeSizeOp>(
-                                streamValue.getLoc(), allocator, memoryTypes,
-                                bufferUsage, shape, elementSize)
+                                streamValue.getLoc(), allocator,
+                                kTransientMemoryTypes, kTransientBufferUsage,
+                                shape, elementSize)
                             .getResult();
 
   auto buffer = rewriter
                     .create<IREE::HAL::AllocatorAllocateOp>(
-                        streamValue.getLoc(), allocator, memoryTypes,
-                        bufferUsage, allocationSize)
+                        streamValue.getLoc(), allocator, kTransientMemoryTypes,
+                        kTransientBufferUsage, allocationSize)
                     .getResult();
 
   // TODO(benvanik): implement resource sets.
@@ -139,21 +187,205 @@ static Value allocateTransientBuffer(Value streamValue, Value allocator,
   return buffer;
 }
 
+// A statically-sized transient value and the range of stream ops over which it
+// is live.
+struct TransientValue {
+  // Values sharing the storage, such as tensors updated in place.
+  SmallVector<Value, 1> values;
+  int64_t byteLength = 0;
+  // Wave of the first command defining one of the values.
+  int liveStart = 0;
+  // Wave of the last command using one of the values.
+  int liveEnd = 0;
+  // Assigned byte offset within the packed allocation.
+  int64_t byteOffset = 0;
+
+  bool isLiveWith(const TransientValue &other) const {
+    return liveStart <= other.liveEnd && other.liveStart <= liveEnd;
+  }
+};
+
+// Returns the byte length of |value| if its shape is fully static.
+static Optional<int64_t> getStaticByteLength(Value value) {
+  auto shapedType = value.getType().cast<ShapedType>();
+  if (!shapedType.hasStaticShape()) return llvm::None;
+  return shapedType.getNumElements() *
+         IREE::HAL::getRoundedElementByteWidth(shapedType.getElementType());
+}
+
+// Assigns byte offsets to |transientValues| within a single allocation such
+// that no two values that are live at the same time overlap and returns the
+// total size of the allocation.
+//
+// Values are placed largest first at the lowest offset that does not overlap
+// any already-placed value live at the same time. Live ranges within streams
+// are mostly short producer-consumer chains and this greedy-by-size strategy
+// gets close to the peak live size for them.
+static int64_t packTransientValues(
+    MutableArrayRef<TransientValue> transientValues) {
+  SmallVector<TransientValue *, 8> sortedValues;
+  for (auto &transientValue : transientValues) {
+    sortedValues.push_back(&transientValue);
+  }
+  llvm::stable_sort(sortedValues,
+                    [](const TransientValue *lhs, const TransientValue *rhs) {
+                      return lhs->byteLength > rhs->byteLength;
+                    });
+
+  int64_t totalLength = 0;
+  SmallVector<TransientValue *, 8> placedValues;
+  for (auto *transientValue : sortedValues) {
+    SmallVector<TransientValue *, 8> liveValues;
+    for (auto *placedValue : placedValues) {
+      if (transientValue->isLiveWith(*placedValue)) {
+        liveValues.push_back(placedValue);
+      }
+    }
+    llvm::sort(liveValues,
+               [](const TransientValue *lhs, const TransientValue *rhs) {
+                 return lhs->byteOffset < rhs->byteOffset;
+               });
+
+    // Find the first gap between live values that fits.
+    int64_t byteOffset = 0;
+    for (auto *liveValue : liveValues) {
+      if (byteOffset + transientValue->byteLength <= liveValue->byteOffset) {
+        break;
+      }
+      byteOffset = std::max(
+          byteOffset,
+          static_cast<int64_t>(llvm::alignTo(
+              liveValue->byteOffset + liveValue->byteLength,
+              kTransientBufferAlignment)));
+    }
+
+    transientValue->byteOffset = byteOffset;
+    totalLength =
+        std::max(totalLength, byteOffset + transientValue->byteLength);
+    placedValues.push_back(transientValue);
+  }
+  return totalLength;
+}
+
+// Returns true if |updateOp| can write the update directly into the buffer of
+// its target. This requires that the target is produced within the stream and
+// has no other uses such that nothing can observe it being modified.
+static bool canUpdateInPlace(IREE::Flow::TensorUpdateOp updateOp) {
+  auto target = updateOp.target();
+  return target.getDefiningOp() && target.hasOneUse();
+}
+
 // Allocates transient buffers to store the intra-stream results and populates
 // the |bufferSet| with the new mappings.
-static void allocateTransientBuffers(IREE::Flow::ExStreamFragmentOp streamOp,
-                                     BufferSet &bufferSet,
-                                     ConversionPatternRewriter &rewriter) {
-  for (auto &op : streamOp.body().front()) {
+//
+// Targets of in-place tensor updates share storage with the update results.
+// This may chain through several updates and end in a stream output.
+//
+// Statically-shaped transients are packed into a single allocation based on
+// their live ranges within the |schedule| such that values that are never live
+// at the same time share memory. Each is then referenced as a subspan of the
+// packed buffer. Dynamically-shaped transients are allocated individually.
+//
+// Fails if the packed buffer would be larger than the i32 sizes the HAL ops
+// can express.
+static LogicalResult allocateTransientBuffers(
+    IREE::Flow::ExStreamFragmentOp streamOp, const StreamSchedule &schedule,
+    BufferSet &bufferSet, ConversionPatternRewriter &rewriter) {
+  auto &streamBlock = streamOp.body().front();
+  DenseMap<Value, Value> inPlaceResults;
+  for (auto updateOp : streamBlock.getOps<IREE::Flow::TensorUpdateOp>()) {
+    if (canUpdateInPlace(updateOp)) {
+      inPlaceResults[updateOp.target()] = updateOp.result();
+    }
+  }
+
+  // Group values by the last value in their chain of in-place updates.
+  llvm::MapVector<Value, SmallVector<Value, 1>> storageGroups;
+  for (auto &op : streamBlock) {
     for (auto result : op.getResults()) {
-      // If the result is an output buffer we can just use that directly.
-      if (bufferSet.rangeMap[result].buffer) continue;
+      auto storageValue = result;
+      while (inPlaceResults.count(storageValue)) {
+        storageValue = inPlaceResults[storageValue];
+      }
+      storageGroups[storageValue].push_back(result);
+    }
+  }
 
-      auto buffer =
-          allocateTransientBuffer(result, bufferSet.allocator, rewriter);
-      bufferSet.rangeMap[result] = BufferRange{buffer};
+  SmallVector<TransientValue, 8> transientValues;
+  for (auto &storageGroup : storageGroups) {
+    auto storageValue = storageGroup.first;
+    auto &values = storageGroup.second;
+
+    // If the storage is an output buffer we can just use that directly.
+    auto storageRange = bufferSet.rangeMap[storageValue];
+    if (!storageRange.buffer) {
+      auto byteLength = getStaticByteLength(storageValue);
+      if (byteLength.hasValue()) {
+        // Results are live from the wave of their defining op until the wave
+        // of their last use. Commands within a wave may execute concurrently
+        // so a value is live during all of these waves, which also ensures
+        // that the operands and results of an op never alias.
+        TransientValue transientValue;
+        transientValue.values = values;
+        transientValue.byteLength = byteLength.getValue();
+        transientValue.liveStart =
+            schedule.commandWaves.lookup(values.front().getDefiningOp());
+        transientValue.liveEnd = transientValue.liveStart;
+        for (auto value : values) {
+          for (auto *user : value.getUsers()) {
+            transientValue.liveEnd = std::max(
+                transientValue.liveEnd, schedule.commandWaves.lookup(user));
+          }
+        }
+        transientValues.push_back(transientValue);
+        continue;
+      }
+      storageRange = BufferRange{allocateTransientBuffer(
+          storageValue, bufferSet.allocator, rewriter)};
     }
+    for (auto value : values) {
+      bufferSet.rangeMap[value] = storageRange;
+    }
+  }
+  if (transientValues.empty()) return success();
+
+  auto loc = streamOp.getLoc();
+  int64_t totalLength = packTransientValues(transientValues);
+  if (totalLength > std::numeric_limits<int32_t>::max()) {
+    return streamOp.emitOpError()
+           << "transient values require " << totalLength
+           << " bytes which exceeds the maximum allocation size of "
+           << std::numeric_limits<int32_t>::max() << " bytes";
   }
+  auto allocationSize = rewriter.createOrFold<mlir::ConstantOp>(
+      loc, rewriter.getI32IntegerAttr(static_cast<int32_t>(totalLength)));
+  auto packedBuffer = rewriter
+                          .create<IREE::HAL::AllocatorAllocateOp>(
+                              loc, bufferSet.allocator, kTransientMemoryTypes,
+                              kTransientBufferUsage, allocationSize)
+                          .getResult();
+
+  // TODO(benvanik): implement resource sets.
+  rewriter.create<IREE::HAL::ExDeferReleaseOp>(loc, packedBuffer);
+
+  for (auto &transientValue : transientValues) {
+    auto valueLoc = transientValue.values.front().getLoc();
+    auto byteOffset = rewriter.createOrFold<mlir::ConstantOp>(
+        valueLoc, rewriter.getI32IntegerAttr(
+                      static_cast<int32_t>(transientValue.byteOffset)));
+    auto byteLength = rewriter.createOrFold<mlir::ConstantOp>(
+        valueLoc, rewriter.getI32IntegerAttr(
+                      static_cast<int32_t>(transientValue.byteLength)));
+    auto buffer = rewriter
+                      .create<IREE::HAL::BufferSubspanOp>(
+                          valueLoc, packedBuffer.getType(), packedBuffer,
+                          byteOffset, byteLength)
+                      .getResult();
+    for (auto value : transientValue.values) {
+      bufferSet.rangeMap[value] = BufferRange{buffer};
+    }
+  }
+  return success();
 }
 
 // Returns a the (x, y, z) workgroup counts calculated from the given |workload|
@@ -187,21 +419,42 @@ static std::array<Value, 3> getDispatchWorkgroupCounts(
   return result;
 }
 
-// Records a full execution barrier that forces visibility of all buffers.
-static void recordFullExecutionBarrier(Value commandBuffer, Location loc,
-                                       ConversionPatternRewriter &rewriter) {
-  auto memoryBarrier =
-      rewriter
-          .create<IREE::HAL::MakeMemoryBarrierOp>(
-              loc, IREE::HAL::AccessScopeBitfield::DispatchWrite,
-              IREE::HAL::AccessScopeBitfield::DispatchRead)
-          .getResult();
+// Records an execution barrier between commands in |sourceStage| and
+// |targetStage| that makes writes in |sourceScope| visible to |targetScope|.
+static void recordExecutionBarrier(
+    Value commandBuffer, IREE::HAL::ExecutionStageBitfield sourceStage,
+    IREE::HAL::AccessScopeBitfield sourceScope,
+    IREE::HAL::ExecutionStageBitfield targetStage,
+    IREE::HAL::AccessScopeBitfield targetScope, Location loc,
+    ConversionPatternRewriter &rewriter) {
+  auto memoryBarrier = rewriter
+                           .create<IREE::HAL::MakeMemoryBarrierOp>(
+                               loc, sourceScope, targetScope)
+                           .getResult();
   rewriter.create<IREE::HAL::CommandBufferExecutionBarrierOp>(
-      loc, commandBuffer, IREE::HAL::ExecutionStageBitfield::CommandRetire,
-      IREE::HAL::ExecutionStageBitfield::CommandIssue,
+      loc, commandBuffer, sourceStage, targetStage,
       ArrayRef<Value>{memoryBarrier}, ArrayRef<Value>{});
 }
 
+// Execution stage and memory access of a stream command.
+struct CommandAccess {
+  IREE::HAL::ExecutionStageBitfield stage;
+  IREE::HAL::AccessScopeBitfield readScope;
+  IREE::HAL::AccessScopeBitfield writeScope;
+};
+
+// Returns the execution stage and memory access of the stream command |op|.
+static CommandAccess getCommandAccess(Operation *op) {
+  if (isa<IREE::Flow::DispatchOp>(op)) {
+    return {IREE::HAL::ExecutionStageBitfield::Dispatch,
+            IREE::HAL::AccessScopeBitfield::DispatchRead,
+            IREE::HAL::AccessScopeBitfield::DispatchWrite};
+  }
+  return {IREE::HAL::ExecutionStageBitfield::Transfer,
+          IREE::HAL::AccessScopeBitfield::TransferRead,
+          IREE::HAL::AccessScopeBitfield::TransferWrite};
+}
+
 static void recordPushBindings(Value device, Value commandBuffer,
                                IREE::Flow::DispatchOp &dispatchOp,
                                IREE::HAL::ExecutableOp &executableOp,
@@ -259,23 +512,30 @@ static void recordDispatch(Value device, Value commandBuffer,
   rewriter.create<IREE::HAL::CommandBufferDispatchOp>(
       dispatchOp.getLoc(), commandBuffer, executable, entryPointOp,
       workgroupCounts[0], workgroupCounts[1], workgroupCounts[2]);
+}
 
-  // Full barriers for now as we aren't scheduling things.
-  // TODO(benvanik): don't add at the end of the command buffer (we could
-  // also do a canonicalization step that removed trailing barriers).
-  recordFullExecutionBarrier(commandBuffer, dispatchOp.getLoc(), rewriter);
+// Records a copy between buffers unless |length| is statically zero.
+static void recordCopyBuffer(Value commandBuffer, Value sourceBuffer,
+                             Value sourceOffset, Value targetBuffer,
+                             Value targetOffset, Value length, Location loc,
+                             ConversionPatternRewriter &rewriter) {
+  if (matchPattern(length, m_Zero())) return;
+  rewriter.create<IREE::HAL::CommandBufferCopyBufferOp>(
+      loc, commandBuffer, sourceBuffer, sourceOffset, targetBuffer,
+      targetOffset, length);
 }
 
 static void recordTensorUpdate(Value device, Value commandBuffer,
                                IREE::Flow::TensorUpdateOp &updateOp,
                                BufferSet &bufferSet,
                                ConversionPatternRewriter &rewriter) {
-  auto &updateBuffer = bufferSet.rangeMap[updateOp.update()];
-  auto &targetBuffer = bufferSet.rangeMap[updateOp.target()];
-  auto &resultBuffer = bufferSet.rangeMap[updateOp.result()];
+  auto updateBuffer = bufferSet.rangeMap[updateOp.update()];
+  auto targetBuffer = bufferSet.rangeMap[updateOp.target()];
+  auto resultBuffer = bufferSet.rangeMap[updateOp.result()];
+  auto loc = updateOp.getLoc();
 
   auto zeroOffset = rewriter.createOrFold<mlir::ConstantOp>(
-      updateOp.getLoc(), rewriter.getI32IntegerAttr(0));
+      loc, rewriter.getI32IntegerAttr(0));
 
   // Compute the size of the update range.
   auto updateType = updateOp.update().getType().cast<ShapedType>();
@@ -287,59 +547,127 @@ static void recordTensorUpdate(Value device, Value commandBuffer,
       updateOp.start_indices(),
       [&](Value value) { return rewriter.getRemappedValue(value); }));
   auto targetRange = rewriter.create<IREE::HAL::BufferViewComputeRangeOp>(
-      updateOp.getLoc(), targetBuffer.buffer, targetShape, startIndices,
-      updateShape, elementSize);
+      loc, targetBuffer.buffer, targetShape, startIndices, updateShape,
+      elementSize);
 
   auto updateOffset = targetRange.offset();
   auto updateLength = targetRange.length();
-  auto targetLength =
-      rewriter
-          .create<IREE::HAL::BufferViewComputeLengthOp>(
-              updateOp.getLoc(), targetBuffer.buffer, targetShape, elementSize)
-          .getResult();
 
-  // TODO(benvanik): actual buffer allocation so we aren't doing this copy.
-  rewriter.create<IREE::HAL::CommandBufferCopyBufferOp>(
-      updateOp.getLoc(), commandBuffer, targetBuffer.buffer, zeroOffset,
-      resultBuffer.buffer, zeroOffset, targetLength);
-  // TODO(benvanik): slice left/mid/right, but really just don't do this.
-  recordFullExecutionBarrier(commandBuffer, updateOp.getLoc(), rewriter);
-  rewriter.create<IREE::HAL::CommandBufferCopyBufferOp>(
-      updateOp.getLoc(), commandBuffer, updateBuffer.buffer, zeroOffset,
-      resultBuffer.buffer, updateOffset, updateLength);
+  // When the target is updated in place the result is the target buffer and
+  // only the update needs to be written. Otherwise the target is still live
+  // and the slices of it to the left and right of the update are copied into
+  // the result. The slices do not overlap the update so no barrier is needed
+  // between the copies.
+  if (resultBuffer.buffer != targetBuffer.buffer) {
+    auto targetLength =
+        rewriter
+            .create<IREE::HAL::BufferViewComputeLengthOp>(
+                loc, targetBuffer.buffer, targetShape, elementSize)
+            .getResult();
+    auto rightOffset =
+        rewriter.createOrFold<mlir::AddIOp>(loc, updateOffset, updateLength);
+    auto rightLength =
+        rewriter.createOrFold<mlir::SubIOp>(loc, targetLength, rightOffset);
+    recordCopyBuffer(commandBuffer, targetBuffer.buffer, zeroOffset,
+                     resultBuffer.buffer, zeroOffset, updateOffset, loc,
+                     rewriter);
+    recordCopyBuffer(commandBuffer, targetBuffer.buffer, rightOffset,
+                     resultBuffer.buffer, rightOffset, rightLength, loc,
+                     rewriter);
+  }
+  recordCopyBuffer(commandBuffer, updateBuffer.buffer, zeroOffset,
+                   resultBuffer.buffer, updateOffset, updateLength, loc,
+                   rewriter);
 
   // TODO(benvanik): implement resource sets.
-  rewriter.create<IREE::HAL::ExDeferReleaseOp>(updateOp.getLoc(),
-                                               targetBuffer.buffer);
-  rewriter.create<IREE::HAL::ExDeferReleaseOp>(updateOp.getLoc(),
-                                               updateBuffer.buffer);
-  rewriter.create<IREE::HAL::ExDeferReleaseOp>(updateOp.getLoc(),
-                                               resultBuffer.buffer);
-
-  // Full barriers for now as we aren't scheduling things.
-  // TODO(benvanik): don't add at the end of the command buffer (we could
-  // also do a canonicalization step that removed trailing barriers).
-  recordFullExecutionBarrier(commandBuffer, updateOp.getLoc(), rewriter);
+  rewriter.create<IREE::HAL::ExDeferReleaseOp>(loc, targetBuffer.buffer);
+  rewriter.create<IREE::HAL::ExDeferReleaseOp>(loc, updateBuffer.buffer);
+  if (resultBuffer.buffer != targetBuffer.buffer) {
+    rewriter.create<IREE::HAL::ExDeferReleaseOp>(loc, resultBuffer.buffer);
+  }
 }
 
+// Records the commands of the stream in |schedule| order.
+//
+// Barriers are only inserted between waves. Commands are executed in
+// submission order within a stage so the barrier before a wave waits on the
+// stages of all prior commands and makes all of their writes visible to the
+// wave; this covers both the data dependencies between waves and the reuse of
+// transient memory by values that are no longer live.
+//
+// Submissions are not waited on and queues do not order the execution or make
+// writes visible across command buffers on their own. A barrier after the last
+// wave ensures that any work submitted later (such as the next stream reading
+// the results of this one) waits for the writes of this stream.
 static LogicalResult recordStreamCommands(Value device, Value commandBuffer,
-                                          Block &streamBlock,
+                                          const StreamSchedule &schedule,
                                           BufferSet &bufferSet,
                                           ConversionPatternRewriter &rewriter) {
-  for (auto &op : streamBlock) {
-    if (auto dispatchOp = dyn_cast<IREE::Flow::DispatchOp>(op)) {
-      recordDispatch(device, commandBuffer, dispatchOp, bufferSet, rewriter);
-    } else if (auto updateOp = dyn_cast<IREE::Flow::TensorUpdateOp>(op)) {
-      recordTensorUpdate(device, commandBuffer, updateOp, bufferSet, rewriter);
-    } else if (auto returnOp = dyn_cast<IREE::Flow::ReturnOp>(op)) {
-      // No-op; handled by the buffer allocation.
-    } else {
-      return op.emitOpError() << "unexpected in stream";
+  auto priorStages = IREE::HAL::ExecutionStageBitfield::None;
+  auto priorWriteScopes = IREE::HAL::AccessScopeBitfield::None;
+  for (auto &wave : schedule.waves) {
+    auto waveStages = IREE::HAL::ExecutionStageBitfield::None;
+    auto waveScopes = IREE::HAL::AccessScopeBitfield::None;
+    for (auto *op : wave) {
+      auto access = getCommandAccess(op);
+      waveStages = waveStages | access.stage;
+      waveScopes = waveScopes | access.readScope | access.writeScope;
+    }
+    if (priorStages != IREE::HAL::ExecutionStageBitfield::None) {
+      recordExecutionBarrier(commandBuffer, priorStages, priorWriteScopes,
+                             waveStages, waveScopes, wave.front()->getLoc(),
+                             rewriter);
+    }
+
+    for (auto *op : wave) {
+      if (auto dispatchOp = dyn_cast<IREE::Flow::DispatchOp>(op)) {
+        recordDispatch(device, commandBuffer, dispatchOp, bufferSet, rewriter);
+      } else if (auto updateOp = dyn_cast<IREE::Flow::TensorUpdateOp>(op)) {
+        recordTensorUpdate(device, commandBuffer, updateOp, bufferSet,
+                           rewriter);
+      } else {
+        return op->emitOpError() << "unexpected in stream";
+      }
+      auto access = getCommandAccess(op);
+      priorStages = priorStages | access.stage;
+      priorWriteScopes = priorWriteScopes | access.writeScope;
     }
   }
+
+  if (priorStages != IREE::HAL::ExecutionStageBitfield::None) {
+    recordExecutionBarrier(
+        commandBuffer, priorStages, priorWriteScopes,
+        IREE::HAL::ExecutionStageBitfield::Dispatch |
+            IREE::HAL::ExecutionStageBitfield::Transfer,
+        IREE::HAL::AccessScopeBitfield::DispatchRead |
+            IREE::HAL::AccessScopeBitfield::DispatchWrite |
+            IREE::HAL::AccessScopeBitfield::TransferRead |
+            IREE::HAL::AccessScopeBitfield::TransferWrite,
+        schedule.waves.back().back()->getLoc(), rewriter);
+  }
   return success();
 }
 
+// Ensures that all work submitted within the function containing |op| has
+// completed prior to the function returning, as the caller may access the
+// results (or the buffers it passed in) from the host.
+static void waitIdleBeforeReturns(Operation *op,
+                                  ConversionPatternRewriter &rewriter) {
+  auto funcOp = op->getParentOfType<FuncOp>();
+  if (!funcOp) return;
+  OpBuilder::InsertionGuard g(rewriter);
+  for (auto &block : funcOp.getBlocks()) {
+    auto *terminator = block.getTerminator();
+    if (!isa<ReturnOp>(terminator)) continue;
+    auto *previousOp = terminator->getPrevNode();
+    if (previousOp && isa<IREE::HAL::ExWaitIdleOp>(previousOp)) continue;
+    rewriter.setInsertionPoint(terminator);
+    auto loc = terminator->getLoc();
+    auto device = rewriter.createOrFold<IREE::HAL::ExSharedDeviceOp>(loc);
+    rewriter.create<IREE::HAL::ExWaitIdleOp>(loc, device);
+  }
+}
+
 class ExStreamFragmentOpConversion
     : public OpConversionPattern<IREE::Flow::ExStreamFragmentOp> {
  public:
@@ -375,9 +703,16 @@ class ExStreamFragmentOpConversion
       }
     }
 
+    // Schedule the commands so that transient buffers can be allocated based
+    // on when they are live during execution.
+    auto schedule = scheduleStreamCommands(entryBlock);
+
     // Allocate buffers for outputs and transient buffers.
     allocateOutputBuffers(streamOp, bufferSet, rewriter);
-    allocateTransientBuffers(streamOp, bufferSet, rewriter);
+    if (failed(allocateTransientBuffers(streamOp, schedule, bufferSet,
+                                        rewriter))) {
+      return matchFailure();
+    }
 
     // Allocate and begin the command buffer.
     // In a real version we would want to pick the device based on the placement
@@ -389,18 +724,23 @@ class ExStreamFragmentOpConversion
                                                      commandBuffer);
 
     // Record all of the commands into the command buffer.
-    if (failed(recordStreamCommands(device, commandBuffer, entryBlock,
+    if (failed(recordStreamCommands(device, commandBuffer, schedule,
                                     bufferSet, rewriter))) {
       return matchFailure();
     }
 
-    // End and submit the command buffer.
-    // In a real version we'd want to setup a semaphore chain instead of
-    // submitting and waiting.
+    // End and submit the command buffer without waiting so that host work
+    // (including recording of subsequent streams) overlaps device execution.
+    // Submissions are not chained and queue order alone does not make their
+    // writes visible to later submissions; the trailing barrier recorded by
+    // recordStreamCommands does. Host accesses to buffers and returning from
+    // the function wait for the submissions to complete.
+    // In a real version we'd want to setup a semaphore chain.
     rewriter.create<IREE::HAL::CommandBufferEndOp>(streamOp.getLoc(),
                                                    commandBuffer);
-    rewriter.create<IREE::HAL::ExSubmitAndWaitOp>(streamOp.getLoc(), device,
-                                                  commandBuffer);
+    rewriter.create<IREE::HAL::ExSubmitOp>(streamOp.getLoc(), device,
+                                           commandBuffer);
+    waitIdleBeforeReturns(streamOp, rewriter);
 
     // It's annoying, but we need to do this replacement at the very end as
     // otherwise we lose access to the original values (which we need for
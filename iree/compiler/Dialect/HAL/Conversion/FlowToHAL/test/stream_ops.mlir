@@ -12,15 +12,16 @@ func @multipleDispatches(%arg0: tensor<128xf32>) -> tensor<128xf32> {
   // CHECK-DAG: [[C1:%.+]] = constant 1
   // CHECK-DAG: [[C4:%.+]] = constant 4
   // CHECK-DAG: [[C128:%.+]] = constant 128
+  // CHECK-DAG: [[C0:%.+]] = constant 0
+  // CHECK-DAG: [[C512:%.+]] = constant 512
   %cst = constant dense<[128, 1, 1]> : vector<3xi32>
   // CHECK: [[RET_BUF:%.+]] = hal.allocator.allocate.shaped {{.+}}, "HostVisible|DeviceVisible|DeviceLocal", "Constant|Transfer|Mapping|Dispatch", shape=[
   // CHECK-SAME:   [[C128]]
   // CHECK-SAME: ], element_size=4 : !iree.ref<!hal.buffer>
   // CHECK-NEXT: hal.ex.defer_release [[RET_BUF]]
-  // CHECK-NEXT: [[TMP_BUF:%.+]] = hal.allocator.allocate.shaped {{.+}}, "DeviceVisible|DeviceLocal", "Transfer|Dispatch", shape=[
-  // CHECK-SAME:   [[C128]]
-  // CHECK-SAME: ], element_size=4 : !iree.ref<!hal.buffer>
-  // CHECK-NEXT: hal.ex.defer_release [[TMP_BUF]]
+  // CHECK-NEXT: [[TMP_SLAB:%.+]] = hal.allocator.allocate {{.+}}, "DeviceVisible|DeviceLocal", "Transfer|Dispatch", [[C512]] : !iree.ref<!hal.buffer>
+  // CHECK-NEXT: hal.ex.defer_release [[TMP_SLAB]]
+  // CHECK-NEXT: [[TMP_BUF:%.+]] = hal.buffer.subspan [[TMP_SLAB]], [[C0]], [[C512]] : !iree.ref<!hal.buffer>
   // CHECK-NEXT: [[CMD:%.+]] = hal.command_buffer.create {{.+}}, "OneShot", "Transfer|Dispatch"
   // CHECK-NEXT: hal.command_buffer.begin [[CMD]]
   %0 = flow.ex.stream.fragment(%arg1 = %cst : vector<3xi32>, %arg2 = %arg0 : tensor<128xf32>) -> tensor<128xf32> {
@@ -36,7 +37,8 @@ func @multipleDispatches(%arg0: tensor<128xf32>) -> tensor<128xf32> {
     // CHECK-NEXT: hal.command_buffer.dispatch [[CMD]], [[EXE]], entry_point=0, workgroup_xyz=[
     // CHECK-SAME:   [[C4]], [[C1]], [[C1]]
     // CHECK-SAME: ]
-    // CHECK: hal.command_buffer.execution_barrier
+    // CHECK: hal.make_memory_barrier "DispatchWrite", "DispatchRead|DispatchWrite"
+    // CHECK-NEXT: hal.command_buffer.execution_barrier [[CMD]], "Dispatch", "Dispatch"
     %1 = flow.dispatch @ex0::@entry0[%arg1 : vector<3xi32>](%arg2) : (tensor<128xf32>) -> tensor<128xf32>
     // CHECK: hal.ex.push_binding [[CMD]], 0, [[TMP_BUF]], shape=[
     // CHECK-SAME:   [[C128]]
@@ -49,12 +51,16 @@ func @multipleDispatches(%arg0: tensor<128xf32>) -> tensor<128xf32> {
     // CHECK-NEXT: hal.command_buffer.dispatch [[CMD]], {{.+}}, entry_point=0, workgroup_xyz=[
     // CHECK-SAME:   [[C4]], [[C1]], [[C1]]
     // CHECK-SAME: ]
-    // CHECK: hal.command_buffer.execution_barrier
+    // CHECK: hal.make_memory_barrier "DispatchWrite", "DispatchRead|DispatchWrite|TransferRead|TransferWrite"
+    // CHECK-NEXT: hal.command_buffer.execution_barrier [[CMD]], "Dispatch", "Dispatch|Transfer"
+    // CHECK-NOT: hal.command_buffer.execution_barrier
     %2 = flow.dispatch @ex0::@entry0[%arg1 : vector<3xi32>](%1) : (tensor<128xf32>) -> tensor<128xf32>
     flow.return %2 : tensor<128xf32>
   }
   // CHECK: hal.command_buffer.end [[CMD]]
-  // CHECK-NEXT: hal.ex.submit_and_wait {{.+}}, [[CMD]]
+  // CHECK-NEXT: hal.ex.submit {{.+}}, [[CMD]]
+  // CHECK-NEXT: [[DEV:%.+]] = hal.ex.shared_device
+  // CHECK-NEXT: hal.ex.wait_idle [[DEV]]
   // CHECK-NEXT: return [[RET_BUF]]
   return %0 : tensor<128xf32>
 }
@@ -73,13 +79,171 @@ func @tensorUpdate(%arg0 : tensor<1x1x10xf32>, %arg1 : tensor<5x1x10xf32>) -> te
   %0 = flow.ex.stream.fragment(%arg2 = %arg0 : tensor<1x1x10xf32>, %arg3 = %arg1 : tensor<5x1x10xf32>, %arg4 = %c4 : i32, %arg5 = %c1 : i32) -> tensor<5x1x10xf32> {
     // CHECK-NEXT: [[UOFF:%.+]], [[ULEN:%.+]] = hal.buffer_view.compute_range [[TBUF]]
     // CHECK-NEXT: [[TLEN:%.+]] = hal.buffer_view.compute_length [[TBUF]]
-    // CHECK-NEXT: hal.command_buffer.copy_buffer [[CMD]], [[TBUF]], [[C0]], [[RET_BUF]], [[C0]], [[TLEN]]
-    // CHECK: hal.command_buffer.execution_barrier
+    // CHECK-NEXT: [[ROFF:%.+]] = addi [[UOFF]], [[ULEN]]
+    // CHECK-NEXT: [[RLEN:%.+]] = subi [[TLEN]], [[ROFF]]
+    // CHECK-NEXT: hal.command_buffer.copy_buffer [[CMD]], [[TBUF]], [[C0]], [[RET_BUF]], [[C0]], [[UOFF]]
+    // CHECK-NEXT: hal.command_buffer.copy_buffer [[CMD]], [[TBUF]], [[ROFF]], [[RET_BUF]], [[ROFF]], [[RLEN]]
     // CHECK-NEXT: hal.command_buffer.copy_buffer [[CMD]], [[UBUF]], [[C0]], [[RET_BUF]], [[UOFF]], [[ULEN]]
+    // CHECK-NEXT: hal.make_memory_barrier "TransferWrite", "DispatchRead|DispatchWrite|TransferRead|TransferWrite"
+    // CHECK-NEXT: hal.command_buffer.execution_barrier [[CMD]], "Transfer", "Dispatch|Transfer"
+    // CHECK-NEXT: hal.command_buffer.end [[CMD]]
     %1 = flow.tensor.update %arg2, %arg3[%arg4, %arg5, %arg5] : tensor<1x1x10xf32> -> tensor<5x1x10xf32>
     flow.return %1 : tensor<5x1x10xf32>
   }
   // CHECK: hal.command_buffer.end [[CMD]]
-  // CHECK: return [[RET_BUF]]
+  // CHECK-NEXT: hal.ex.submit {{.+}}, [[CMD]]
+  // CHECK: hal.ex.wait_idle
+  // CHECK-NEXT: return [[RET_BUF]]
+  return %0 : tensor<5x1x10xf32>
+}
+
+// -----
+
+hal.executable @ex0 {
+  hal.executable.entry_point @entry0 attributes {
+    ordinal = 0 : i32,
+    workgroup_size = dense<[32, 1, 1]> : vector<3xi32>
+  }
+}
+
+// Targets produced within the stream with no other uses are updated in place.
+// CHECK-LABEL: @tensorUpdateInPlace
+// CHECK-SAME: ([[UBUF:%.+]]:{{.+}}, [[TBUF:%.+]]:{{.+}})
+func @tensorUpdateInPlace(%arg0 : tensor<1x1x10xf32>, %arg1 : tensor<5x1x10xf32>) -> tensor<5x1x10xf32> {
+  // CHECK-DAG: [[C0:%.+]] = constant 0
+  %c4 = constant 4 : i32
+  %c1 = constant 1 : i32
+  %cst = constant dense<[50, 1, 1]> : vector<3xi32>
+  // CHECK: [[RET_BUF:%.+]] = hal.allocator.allocate.shaped
+  // CHECK-NOT: hal.allocator.allocate
+  // CHECK: [[CMD:%.+]] = hal.command_buffer.create
+  %0 = flow.ex.stream.fragment(%arg2 = %arg0 : tensor<1x1x10xf32>, %arg3 = %arg1 : tensor<5x1x10xf32>, %arg4 = %c4 : i32, %arg5 = %c1 : i32, %arg6 = %cst : vector<3xi32>) -> tensor<5x1x10xf32> {
+    // CHECK: hal.ex.push_binding [[CMD]], 1, [[RET_BUF]]
+    // CHECK: hal.command_buffer.dispatch [[CMD]]
+    %1 = flow.dispatch @ex0::@entry0[%arg6 : vector<3xi32>](%arg3) : (tensor<5x1x10xf32>) -> tensor<5x1x10xf32>
+    // CHECK: hal.command_buffer.execution_barrier [[CMD]], "Dispatch", "Transfer"
+    // CHECK: [[UOFF:%.+]], [[ULEN:%.+]] = hal.buffer_view.compute_range [[RET_BUF]]
+    // CHECK-NEXT: hal.command_buffer.copy_buffer [[CMD]], [[UBUF]], [[C0]], [[RET_BUF]], [[UOFF]], [[ULEN]]
+    // CHECK-NOT: hal.command_buffer.copy_buffer
+    %2 = flow.tensor.update %arg2, %1[%arg4, %arg5, %arg5] : tensor<1x1x10xf32> -> tensor<5x1x10xf32>
+    flow.return %2 : tensor<5x1x10xf32>
+  }
+  // CHECK: hal.command_buffer.end [[CMD]]
   return %0 : tensor<5x1x10xf32>
 }
+
+// -----
+
+hal.executable @ex0 {
+  hal.executable.entry_point @entry0 attributes {
+    ordinal = 0 : i32,
+    workgroup_size = dense<[32, 1, 1]> : vector<3xi32>
+  }
+}
+
+// Multiple streams are submitted back to back and only waited on once. Each
+// stream ends with a barrier so that later submissions reading its results
+// wait for its writes.
+// CHECK-LABEL: func @multipleStreams
+func @multipleStreams(%arg0: tensor<128xf32>) -> tensor<128xf32> {
+  %cst = constant dense<[128, 1, 1]> : vector<3xi32>
+  // CHECK: [[CMD0:%.+]] = hal.command_buffer.create
+  %0 = flow.ex.stream.fragment(%arg1 = %cst : vector<3xi32>, %arg2 = %arg0 : tensor<128xf32>) -> tensor<128xf32> {
+    %2 = flow.dispatch @ex0::@entry0[%arg1 : vector<3xi32>](%arg2) : (tensor<128xf32>) -> tensor<128xf32>
+    flow.return %2 : tensor<128xf32>
+  }
+  // CHECK: hal.command_buffer.dispatch [[CMD0]]
+  // CHECK: hal.make_memory_barrier "DispatchWrite", "DispatchRead|DispatchWrite|TransferRead|TransferWrite"
+  // CHECK-NEXT: hal.command_buffer.execution_barrier [[CMD0]], "Dispatch", "Dispatch|Transfer"
+  // CHECK-NEXT: hal.command_buffer.end [[CMD0]]
+  // CHECK-NEXT: hal.ex.submit {{.+}}, [[CMD0]]
+  // CHECK-NOT: hal.ex.wait_idle
+  // CHECK: [[CMD1:%.+]] = hal.command_buffer.create
+  %1 = flow.ex.stream.fragment(%arg1 = %cst : vector<3xi32>, %arg2 = %0 : tensor<128xf32>) -> tensor<128xf32> {
+    %2 = flow.dispatch @ex0::@entry0[%arg1 : vector<3xi32>](%arg2) : (tensor<128xf32>) -> tensor<128xf32>
+    flow.return %2 : tensor<128xf32>
+  }
+  // CHECK: hal.command_buffer.dispatch [[CMD1]]
+  // CHECK: hal.make_memory_barrier "DispatchWrite", "DispatchRead|DispatchWrite|TransferRead|TransferWrite"
+  // CHECK-NEXT: hal.command_buffer.execution_barrier [[CMD1]], "Dispatch", "Dispatch|Transfer"
+  // CHECK-NEXT: hal.command_buffer.end [[CMD1]]
+  // CHECK-NEXT: hal.ex.submit {{.+}}, [[CMD1]]
+  // CHECK-NEXT: [[DEV:%.+]] = hal.ex.shared_device
+  // CHECK-NEXT: hal.ex.wait_idle [[DEV]]
+  // CHECK-NEXT: return
+  return %1 : tensor<128xf32>
+}
+
+// -----
+
+hal.executable @ex0 {
+  hal.executable.entry_point @entry0 attributes {
+    ordinal = 0 : i32,
+    workgroup_size = dense<[32, 1, 1]> : vector<3xi32>
+  }
+}
+
+// Transients that are not live at the same time share memory within a single
+// packed allocation.
+// CHECK-LABEL: func @packedTransients
+func @packedTransients(%arg0: tensor<128xf32>) -> tensor<128xf32> {
+  // CHECK-DAG: [[C0:%.+]] = constant 0
+  // CHECK-DAG: [[C512:%.+]] = constant 512
+  // CHECK-DAG: [[C1024:%.+]] = constant 1024
+  %cst = constant dense<[128, 1, 1]> : vector<3xi32>
+  // CHECK: [[TMP_SLAB:%.+]] = hal.allocator.allocate {{.+}}, "DeviceVisible|DeviceLocal", "Transfer|Dispatch", [[C1024]]
+  // CHECK-NEXT: hal.ex.defer_release [[TMP_SLAB]]
+  // CHECK-NEXT: [[TMP0:%.+]] = hal.buffer.subspan [[TMP_SLAB]], [[C0]], [[C512]]
+  // CHECK-NEXT: [[TMP1:%.+]] = hal.buffer.subspan [[TMP_SLAB]], [[C512]], [[C512]]
+  // CHECK-NEXT: [[TMP2:%.+]] = hal.buffer.subspan [[TMP_SLAB]], [[C0]], [[C512]]
+  // CHECK-NOT: hal.allocator.allocate
+  %0 = flow.ex.stream.fragment(%arg1 = %cst : vector<3xi32>, %arg2 = %arg0 : tensor<128xf32>) -> tensor<128xf32> {
+    // CHECK: hal.ex.push_binding {{.+}}, 1, [[TMP0]]
+    %1 = flow.dispatch @ex0::@entry0[%arg1 : vector<3xi32>](%arg2) : (tensor<128xf32>) -> tensor<128xf32>
+    // CHECK: hal.ex.push_binding {{.+}}, 0, [[TMP0]]
+    // CHECK: hal.ex.push_binding {{.+}}, 1, [[TMP1]]
+    %2 = flow.dispatch @ex0::@entry0[%arg1 : vector<3xi32>](%1) : (tensor<128xf32>) -> tensor<128xf32>
+    // CHECK: hal.ex.push_binding {{.+}}, 0, [[TMP1]]
+    // CHECK: hal.ex.push_binding {{.+}}, 1, [[TMP2]]
+    %3 = flow.dispatch @ex0::@entry0[%arg1 : vector<3xi32>](%2) : (tensor<128xf32>) -> tensor<128xf32>
+    // CHECK: hal.ex.push_binding {{.+}}, 0, [[TMP2]]
+    %4 = flow.dispatch @ex0::@entry0[%arg1 : vector<3xi32>](%3) : (tensor<128xf32>) -> tensor<128xf32>
+    flow.return %4 : tensor<128xf32>
+  }
+  return %0 : tensor<128xf32>
+}
+
+// -----
+
+hal.executable @ex0 {
+  hal.executable.entry_point @entry0 attributes {
+    ordinal = 0 : i32,
+    workgroup_size = dense<[32, 1, 1]> : vector<3xi32>
+  }
+}
+
+// Independent dispatches are recorded together without barriers between them
+// and only dependent work waits.
+// CHECK-LABEL: func @independentDispatches
+func @independentDispatches(%arg0: tensor<128xf32>) -> (tensor<128xf32>, tensor<128xf32>) {
+  %cst = constant dense<[128, 1, 1]> : vector<3xi32>
+  // CHECK: [[CMD:%.+]] = hal.command_buffer.create
+  %0:2 = flow.ex.stream.fragment(%arg1 = %cst : vector<3xi32>, %arg2 = %arg0 : tensor<128xf32>) -> (tensor<128xf32>, tensor<128xf32>) {
+    // CHECK: hal.command_buffer.dispatch [[CMD]]
+    // CHECK-NOT: hal.command_buffer.execution_barrier
+    // CHECK: hal.command_buffer.dispatch [[CMD]]
+    %1 = flow.dispatch @ex0::@entry0[%arg1 : vector<3xi32>](%arg2) : (tensor<128xf32>) -> tensor<128xf32>
+    %2 = flow.dispatch @ex0::@entry0[%arg1 : vector<3xi32>](%arg2) : (tensor<128xf32>) -> tensor<128xf32>
+    // CHECK: hal.command_buffer.execution_barrier [[CMD]], "Dispatch", "Dispatch"
+    // CHECK: hal.command_buffer.dispatch [[CMD]]
+    // CHECK-NOT: hal.command_buffer.execution_barrier
+    // CHECK: hal.command_buffer.dispatch [[CMD]]
+    // CHECK: hal.make_memory_barrier "DispatchWrite", "DispatchRead|DispatchWrite|TransferRead|TransferWrite"
+    // CHECK-NEXT: hal.command_buffer.execution_barrier [[CMD]], "Dispatch", "Dispatch|Transfer"
+    // CHECK-NEXT: hal.command_buffer.end [[CMD]]
+    %3 = flow.dispatch @ex0::@entry0[%arg1 : vector<3xi32>](%1) : (tensor<128xf32>) -> tensor<128xf32>
+    %4 = flow.dispatch @ex0::@entry0[%arg1 : vector<3xi32>](%2) : (tensor<128xf32>) -> tensor<128xf32>
+    flow.return %3, %4 : tensor<128xf32>, tensor<128xf32>
+  }
+  return %0#0, %0#1 : tensor<128xf32>, tensor<128xf32>
+}
@@ -0,0 +1,50 @@
+// RUN: iree-opt -split-input-file -iree-convert-flow-to-hal -verify-diagnostics %s
+
+hal.executable @ex0 {
+  hal.executable.entry_point @entry0 attributes {
+    ordinal = 0 : i32,
+    workgroup_size = dense<[32, 1, 1]> : vector<3xi32>
+  }
+}
+
+// Packed transient allocations are sized with i32 constants and must not
+// exceed INT32_MAX bytes. The 2GiB intermediate here is one byte too many.
+func @oversizedTransient(%arg0: tensor<536870912xf32>) -> tensor<536870912xf32> {
+  %cst = constant dense<[536870912, 1, 1]> : vector<3xi32>
+  // expected-error @+2 {{transient values require 2147483648 bytes which exceeds the maximum allocation size of 2147483647 bytes}}
+  // expected-error @+1 {{failed to legalize operation 'flow.ex.stream.fragment'}}
+  %0 = flow.ex.stream.fragment(%arg1 = %cst : vector<3xi32>, %arg2 = %arg0 : tensor<536870912xf32>) -> tensor<536870912xf32> {
+    %1 = flow.dispatch @ex0::@entry0[%arg1 : vector<3xi32>](%arg2) : (tensor<536870912xf32>) -> tensor<536870912xf32>
+    %2 = flow.dispatch @ex0::@entry0[%arg1 : vector<3xi32>](%1) : (tensor<536870912xf32>) -> tensor<536870912xf32>
+    flow.return %2 : tensor<536870912xf32>
+  }
+  return %0 : tensor<536870912xf32>
+}
+
+// -----
+
+hal.executable @ex0 {
+  hal.executable.entry_point @entry0 attributes {
+    ordinal = 0 : i32,
+    workgroup_size = dense<[32, 1, 1]> : vector<3xi32>
+  }
+  hal.executable.entry_point @entry1 attributes {
+    ordinal = 1 : i32,
+    workgroup_size = dense<[32, 1, 1]> : vector<3xi32>
+  }
+}
+
+// Transients that are live at the same time are packed side by side and their
+// combined size is what must fit: each is 1GiB but together they need 2GiB.
+func @oversizedConcurrentTransients(%arg0: tensor<268435456xf32>) -> tensor<268435456xf32> {
+  %cst = constant dense<[268435456, 1, 1]> : vector<3xi32>
+  // expected-error @+2 {{transient values require 2147483648 bytes which exceeds the maximum allocation size of 2147483647 bytes}}
+  // expected-error @+1 {{failed to legalize operation 'flow.ex.stream.fragment'}}
+  %0 = flow.ex.stream.fragment(%arg1 = %cst : vector<3xi32>, %arg2 = %arg0 : tensor<268435456xf32>) -> tensor<268435456xf32> {
+    %1 = flow.dispatch @ex0::@entry0[%arg1 : vector<3xi32>](%arg2) : (tensor<268435456xf32>) -> tensor<268435456xf32>
+    %2 = flow.dispatch @ex0::@entry0[%arg1 : vector<3xi32>](%arg2) : (tensor<268435456xf32>) -> tensor<268435456xf32>
+    %3 = flow.dispatch @ex0::@entry1[%arg1 : vector<3xi32>](%1, %2) : (tensor<268435456xf32>, tensor<268435456xf32>) -> tensor<268435456xf32>
+    flow.return %3 : tensor<268435456xf32>
+  }
+  return %0 : tensor<268435456xf32>
+}
@@ -33,6 +33,10 @@ void populateHALExperimentalToVMPatterns(MLIRContext *context,
       "hal.ex.executable_descriptor_set_layout");
   patterns.insert<VMImportOpConversion<IREE::HAL::ExDeferReleaseOp>>(
       context, importSymbols, typeConverter, "hal.ex.defer_release");
+  patterns.insert<VMImportOpConversion<IREE::HAL::ExSubmitOp>>(
+      context, importSymbols, typeConverter, "hal.ex.submit");
+  patterns.insert<VMImportOpConversion<IREE::HAL::ExWaitIdleOp>>(
+      context, importSymbols, typeConverter, "hal.ex.wait_idle");
   patterns.insert<VMImportOpConversion<IREE::HAL::ExSubmitAndWaitOp>>(
       context, importSymbols, typeConverter, "hal.ex.submit_and_wait");
 }
@@ -252,6 +252,58 @@ static void printExDeferReleaseOp(OpAsmPrinter &p, ExDeferReleaseOp op) {
   p.printOptionalAttrDictWithKeyword(op.getAttrs());
 }
 
+//===----------------------------------------------------------------------===//
+// hal.ex.submit
+//===----------------------------------------------------------------------===//
+
+static ParseResult parseExSubmitOp(OpAsmParser &parser,
+                                   OperationState *result) {
+  SmallVector<OpAsmParser::OperandType, 2> operands;
+  auto operandsLoc = parser.getCurrentLocation();
+  if (failed(parser.parseOperandList(operands)) ||
+      failed(parser.resolveOperands(
+          operands,
+          ArrayRef<Type>{
+              RefPtrType::get(DeviceType::get(result->getContext())),
+              RefPtrType::get(CommandBufferType::get(result->getContext()))},
+          operandsLoc, result->operands)) ||
+      failed(parser.parseOptionalAttrDictWithKeyword(result->attributes))) {
+    return failure();
+  }
+  return success();
+}
+
+static void printExSubmitOp(OpAsmPrinter &p, ExSubmitOp op) {
+  p << op.getOperationName() << ' ';
+  p.printOperand(op.device());
+  p << ", ";
+  p.printOperand(op.command_buffer());
+  p.printOptionalAttrDictWithKeyword(op.getAttrs());
+}
+
+//===----------------------------------------------------------------------===//
+// hal.ex.wait_idle
+//===----------------------------------------------------------------------===//
+
+static ParseResult parseExWaitIdleOp(OpAsmParser &parser,
+                                     OperationState *result) {
+  OpAsmParser::OperandType device;
+  if (failed(parser.parseOperand(device)) ||
+      failed(parser.resolveOperand(
+          device, RefPtrType::get(DeviceType::get(result->getContext())),
+          result->operands)) ||
+      failed(parser.parseOptionalAttrDictWithKeyword(result->attributes))) {
+    return failure();
+  }
+  return success();
+}
+
+static void printExWaitIdleOp(OpAsmPrinter &p, ExWaitIdleOp op) {
+  p << op.getOperationName() << ' ';
+  p.printOperand(op.device());
+  p.printOptionalAttrDictWithKeyword(op.getAttrs());
+}
+
 //===----------------------------------------------------------------------===//
 // hal.ex.submit_and_wait
 //===----------------------------------------------------------------------===//
@@ -22,6 +22,19 @@ func @cache_executable() -> !iree.ref<!hal.executable> {
 
 // -----
 
+// CHECK-LABEL: @submit
+func @submit() {
+  %0 = "test_hal.device"() : () -> !iree.ref<!hal.device>
+  %1 = "test_hal.command_buffer"() : () -> !iree.ref<!hal.command_buffer>
+  // CHECK: hal.ex.submit %0, %1
+  hal.ex.submit %0, %1
+  // CHECK-NEXT: hal.ex.wait_idle %0
+  hal.ex.wait_idle %0
+  return
+}
+
+// -----
+
 // CHECK-LABEL: @submit_and_wait
 func @submit_and_wait() {
   %0 = "test_hal.device"() : () -> !iree.ref<!hal.device>
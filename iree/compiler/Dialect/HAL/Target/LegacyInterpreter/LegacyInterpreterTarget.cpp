@@ -123,6 +123,10 @@ static void buildInterpreterLoweringPassPipeline(OpPassManager *passManager) {
   // Lower iree_hl_interp -> iree_ll_interp.
   passManager->addPass(createLowerInterpreterDialectPass());
 
+  // Carve statically-shaped allocations from a per-function scratch arena
+  // instead of allocating each from the heap at runtime.
+  passManager->addPass(createPlanScratchAllocationsPass());
+
   // Assign ordinals used by the bytecode to reference executables and
   // functions.
   passManager->addPass(createAssignFunctionOrdinalsPass());
@@ -46,6 +46,15 @@ vm.import @ex.defer_release(
   %operand : !iree.opaque_ref
 )
 
+vm.import @ex.submit(
+  %device : !iree.ref<!hal.device>,
+  %command_buffer : !iree.ref<!hal.command_buffer>
+)
+
+vm.import @ex.wait_idle(
+  %device : !iree.ref<!hal.device>
+)
+
 vm.import @ex.submit_and_wait(
   %device : !iree.ref<!hal.device>,
   %command_buffer : !iree.ref<!hal.command_buffer>
@@ -17,6 +17,7 @@
 #include "iree/compiler/Dialect/IREE/IR/IREETypes.h"
 #include "iree/compiler/Dialect/VM/Analysis/RegisterAllocation.h"
 #include "iree/compiler/Dialect/VM/IR/VMDialect.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/STLExtras.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Diagnostics.h"
@@ -28,6 +29,80 @@ namespace VM {
 
 namespace {
 
+//===----------------------------------------------------------------------===//
+// Superinstruction selection
+//===----------------------------------------------------------------------===//
+// Common op sequences are encoded as a single fused opcode to reduce dispatch
+// overhead in the interpreter. Superinstructions have no corresponding op and
+// are only produced here during serialization.
+
+// Returns true if |values| are all i32 values stored in i32 registers.
+template <typename RangeT>
+static bool areAllI32Registers(RangeT values) {
+  return llvm::all_of(values, [](Value value) {
+    auto type = value.getType();
+    return type.isInteger(32) || type.isIndex();
+  });
+}
+
+// Returns the compare-and-branch opcode for an i32 |cmpOp|.
+// |outSwapOperands| is set when the predicate is implemented by swapping the
+// operands of the inverse comparison (a > b is encoded as b < a).
+static Optional<Opcode> getCmpBranchOpcode(Operation *cmpOp,
+                                           bool *outSwapOperands) {
+  *outSwapOperands = false;
+  if (isa<CmpEQI32Op>(cmpOp)) return Opcode::CondBranchEQI32;
+  if (isa<CmpNEI32Op>(cmpOp)) return Opcode::CondBranchNEI32;
+  if (isa<CmpLTI32SOp>(cmpOp)) return Opcode::CondBranchLTI32S;
+  if (isa<CmpLTI32UOp>(cmpOp)) return Opcode::CondBranchLTI32U;
+  if (isa<CmpLTEI32SOp>(cmpOp)) return Opcode::CondBranchLTEI32S;
+  if (isa<CmpLTEI32UOp>(cmpOp)) return Opcode::CondBranchLTEI32U;
+  *outSwapOperands = true;
+  if (isa<CmpGTI32SOp>(cmpOp)) return Opcode::CondBranchLTI32S;
+  if (isa<CmpGTI32UOp>(cmpOp)) return Opcode::CondBranchLTI32U;
+  if (isa<CmpGTEI32SOp>(cmpOp)) return Opcode::CondBranchLTEI32S;
+  if (isa<CmpGTEI32UOp>(cmpOp)) return Opcode::CondBranchLTEI32U;
+  return llvm::None;
+}
+
+// Returns the compare op producing the condition of |condBranchOp| if it can
+// be fused into the branch. The compare must immediately precede the branch so
+// that its operand registers are still live and the branch must be the only
+// user of its result so that the result need not be materialized.
+static Operation *getFusableCmpOp(CondBranchOp condBranchOp) {
+  auto *cmpOp = condBranchOp.getCondition().getDefiningOp();
+  if (!cmpOp || cmpOp->getNextNode() != condBranchOp.getOperation() ||
+      !cmpOp->getResult(0).hasOneUse()) {
+    return nullptr;
+  }
+  bool swapOperands = false;
+  if (!getCmpBranchOpcode(cmpOp, &swapOperands).hasValue()) return nullptr;
+  return cmpOp;
+}
+
+// Returns true if |callOp| is a call to an internal function taking and
+// returning only i32 values.
+static bool isInternalI32Call(CallOp callOp, SymbolTable &syms) {
+  auto *calleeOp = syms.lookup(callOp.callee());
+  if (!calleeOp || isa<ImportOp>(calleeOp)) return false;
+  return areAllI32Registers(callOp.getOperation()->getOperands()) &&
+         areAllI32Registers(callOp.getOperation()->getResults());
+}
+
+// Returns the set of ops that are subsumed by the superinstruction of another
+// op and must not be encoded themselves.
+static llvm::DenseSet<Operation *> findFusedOps(IREE::VM::FuncOp funcOp) {
+  llvm::DenseSet<Operation *> fusedOps;
+  funcOp.walk([&](Operation *op) {
+    if (auto condBranchOp = dyn_cast<CondBranchOp>(op)) {
+      if (auto *cmpOp = getFusableCmpOp(condBranchOp)) {
+        fusedOps.insert(cmpOp);
+      }
+    }
+  });
+  return fusedOps;
+}
+
 // v0 bytecode spec. This is in extreme flux and not guaranteed to be a stable
 // representation. Always generate this from source in tooling and never check
 // in any emitted files!
@@ -57,6 +132,33 @@ class V0BytecodeEncoder : public BytecodeEncoder {
     return success();
   }
 
+  // Encodes |op| as a superinstruction if one matches. |outEncoded| is set if
+  // the op was encoded and otherwise the op must be encoded normally.
+  LogicalResult encodeSuperinstruction(Operation *op, SymbolTable &syms,
+                                       bool *outEncoded) {
+    *outEncoded = true;
+    if (auto condBranchOp = dyn_cast<CondBranchOp>(op)) {
+      if (auto *cmpOp = getFusableCmpOp(condBranchOp)) {
+        return encodeCmpBranch(cmpOp, condBranchOp);
+      }
+    } else if (auto callOp = dyn_cast<CallOp>(op)) {
+      if (isInternalI32Call(callOp, syms)) {
+        return failure(
+            failed(encodeOpcode(Opcode::CallI32)) ||
+            failed(encodeSymbolOrdinal(syms, callOp.callee())) ||
+            failed(encodeOperands(op->getOperands())) ||
+            failed(encodeResults(op->getResults())));
+      }
+    } else if (isa<ReturnOp>(op)) {
+      if (areAllI32Registers(op->getOperands())) {
+        return failure(failed(encodeOpcode(Opcode::ReturnI32)) ||
+                       failed(encodeOperands(op->getOperands())));
+      }
+    }
+    *outEncoded = false;
+    return success();
+  }
+
   LogicalResult encodeI8(int value) override { return writeUint8(value); }
 
   LogicalResult encodeOpcode(StringRef name, int opcode) override {
@@ -144,13 +246,26 @@ class V0BytecodeEncoder : public BytecodeEncoder {
     // Compute required remappings - we only need to emit them when the source
     // and dest registers differ. Hopefully the allocator did a good job and
     // this list is small :)
+    //
+    // The i32 and ref remappings are written as two separate lists so that the
+    // runtime can remap each register bank without checking the register type.
+    // The banks are disjoint so the relative order within each is all that
+    // needs to be preserved.
     auto srcDstRegs = registerAllocation_->remapSuccessorRegisters(
         currentOp_, successorIndex);
-    writeUint8(srcDstRegs.size());
-    for (auto srcDstReg : srcDstRegs) {
-      if (failed(writeUint8(srcDstReg.first)) ||
-          failed(writeUint8(srcDstReg.second))) {
-        return failure();
+    for (bool refBank : {false, true}) {
+      SmallVector<std::pair<uint8_t, uint8_t>, 8> bankRegs;
+      for (auto srcDstReg : srcDstRegs) {
+        if (isRefRegister(srcDstReg.first) == refBank) {
+          bankRegs.push_back(srcDstReg);
+        }
+      }
+      if (failed(writeUint8(bankRegs.size()))) return failure();
+      for (auto srcDstReg : bankRegs) {
+        if (failed(writeUint8(srcDstReg.first)) ||
+            failed(writeUint8(srcDstReg.second))) {
+          return failure();
+        }
       }
     }
 
@@ -199,6 +314,34 @@ class V0BytecodeEncoder : public BytecodeEncoder {
   }
 
  private:
+  LogicalResult encodeOpcode(Opcode opcode) {
+    return encodeOpcode(stringifyOpcode(opcode), static_cast<int>(opcode));
+  }
+
+  // Encodes |condBranchOp| fused with the |cmpOp| producing its condition.
+  LogicalResult encodeCmpBranch(Operation *cmpOp, CondBranchOp condBranchOp) {
+    bool swapOperands = false;
+    Opcode opcode = getCmpBranchOpcode(cmpOp, &swapOperands).getValue();
+    unsigned lhsIndex = swapOperands ? 1 : 0;
+    unsigned rhsIndex = swapOperands ? 0 : 1;
+
+    // Operand registers are mapped relative to the compare as that is where
+    // their uses are, while the branch remapping is relative to the branch.
+    currentOp_ = cmpOp;
+    if (failed(encodeOpcode(opcode)) ||
+        failed(encodeOperand(cmpOp->getOperand(lhsIndex), lhsIndex)) ||
+        failed(encodeOperand(cmpOp->getOperand(rhsIndex), rhsIndex))) {
+      return failure();
+    }
+    currentOp_ = condBranchOp.getOperation();
+    return failure(failed(encodeBranch(condBranchOp.getTrueDest(),
+                                       condBranchOp.getTrueOperands(),
+                                       CondBranchOp::trueIndex)) ||
+                   failed(encodeBranch(condBranchOp.getFalseDest(),
+                                       condBranchOp.getFalseOperands(),
+                                       CondBranchOp::falseIndex)));
+  }
+
   // TODO(benvanik): replace this with something not using an ever-expanding
   // vector. I'm sure LLVM has something.
 
@@ -276,6 +419,9 @@ Optional<EncodedBytecodeFunction> BytecodeEncoder::encodeFunction(
   result.i32RegisterCount = registerAllocation.getMaxI32RegisterOrdinal() + 1;
   result.refRegisterCount = registerAllocation.getMaxRefRegisterOrdinal() + 1;
 
+  // Ops fused into superinstructions are encoded along with their consumers.
+  auto fusedOps = findFusedOps(funcOp);
+
   V0BytecodeEncoder encoder(&typeTable, &registerAllocation);
   for (auto &block : funcOp.getBlocks()) {
     if (failed(encoder.beginBlock(&block))) {
@@ -284,14 +430,18 @@ Optional<EncodedBytecodeFunction> BytecodeEncoder::encodeFunction(
     }
 
     for (auto &op : block.getOperations()) {
+      if (fusedOps.count(&op)) continue;
       auto *serializableOp =
           op.getAbstractOperation()->getInterface<IREE::VM::VMSerializableOp>();
       if (!serializableOp) {
         op.emitOpError() << "is not serializable";
         return llvm::None;
       }
+      bool encoded = false;
       if (failed(encoder.beginOp(&op)) ||
-          failed(serializableOp->encode(&op, symbolTable, encoder)) ||
+          failed(encoder.encodeSuperinstruction(&op, symbolTable, &encoded)) ||
+          (!encoded &&
+           failed(serializableOp->encode(&op, symbolTable, encoder))) ||
           failed(encoder.endOp(&op))) {
         op.emitOpError() << "failed to encode";
         return llvm::None;
@@ -15,6 +15,7 @@
 #include "iree/compiler/Dialect/VM/Target/Bytecode/BytecodeModuleTarget.h"
 
 #include <algorithm>
+#include <numeric>
 
 #include "flatbuffers/flatbuffers.h"
 #include "flatbuffers/minireflect.h"
@@ -190,6 +191,17 @@ static Optional<Offset<Vector<T>>> createOptionalVector(
   return fbb.CreateVector(contents);
 }
 
+// Returns the ordinals of |names| sorted by the bytes of each name, matching
+// the order the runtime binary searches function name indices in.
+static std::vector<int32_t> sortOrdinalsByName(ArrayRef<std::string> names) {
+  std::vector<int32_t> ordinals(names.size());
+  std::iota(ordinals.begin(), ordinals.end(), 0);
+  std::sort(ordinals.begin(), ordinals.end(), [&](int32_t lhs, int32_t rhs) {
+    return StringRef(names[lhs]) < StringRef(names[rhs]);
+  });
+  return ordinals;
+}
+
 // Returns a serialized function signature.
 static Offset<iree::vm::FunctionSignatureDef> makeFunctionSignatureDef(
     FunctionType functionType, llvm::DenseMap<Type, int> &typeTable,
@@ -291,16 +303,17 @@ static Offset<iree::vm::BytecodeModuleDef> buildFlatBufferModule(
   // Serialize read-only data first so that it ends up at the end of the file.
   // This is where large things like parameters live and we don't want that to
   // get paged in until it is needed.
-  std::vector<Offset<Vector<uint8_t>>> rodataContentOffsets;
-  rodataContentOffsets.reserve(rodataOps.size());
+  std::vector<SerializedConstant> rodataContents;
+  rodataContents.reserve(rodataOps.size());
   for (auto rodataOp : rodataOps) {
-    auto dataOffset =
-        serializeConstant(rodataOp.getLoc(), rodataOp.value(), fbb);
-    if (dataOffset.IsNull()) {
+    auto serializedConstant =
+        serializeConstant(rodataOp.getLoc(), rodataOp.value(),
+                          targetOptions.rodataCompression, fbb);
+    if (serializedConstant.data.IsNull()) {
       rodataOp.emitOpError() << "failed to encode";
       return {};
     }
-    rodataContentOffsets.push_back(dataOffset);
+    rodataContents.push_back(serializedConstant);
   }
 
   // Find all types in the module to build the type table.
@@ -347,9 +360,18 @@ static Offset<iree::vm::BytecodeModuleDef> buildFlatBufferModule(
   // Serialize metadata that should be near the front of the file.
   std::vector<Offset<iree::vm::RodataSegmentDef>> rodataSegmentOffsets;
   rodataSegmentOffsets.reserve(rodataOps.size());
-  for (auto rodataContentOffset : rodataContentOffsets) {
+  for (auto &rodataContent : rodataContents) {
+    Offset<iree::vm::LZ4DataDef> lz4DataOffset;
+    if (rodataContent.uncompressedSize) {
+      lz4DataOffset =
+          iree::vm::CreateLZ4DataDef(fbb, rodataContent.uncompressedSize);
+    }
     iree::vm::RodataSegmentDefBuilder rsd(fbb);
-    rsd.add_data(rodataContentOffset);
+    if (!lz4DataOffset.IsNull()) {
+      rsd.add_compression_type_type(iree::vm::CompressionTypeDef::LZ4DataDef);
+      rsd.add_compression_type(lz4DataOffset.Union());
+    }
+    rsd.add_data(rodataContent.data);
     rodataSegmentOffsets.push_back(rsd.Finish());
   }
   std::vector<Offset<iree::vm::RwdataSegmentDef>> rwdataSegmentOffsets;
@@ -362,9 +384,12 @@ static Offset<iree::vm::BytecodeModuleDef> buildFlatBufferModule(
     typeOffsets.push_back(tdb.Finish());
   }
   std::vector<Offset<iree::vm::ImportFunctionDef>> importFuncOffsets;
+  std::vector<std::string> importFuncNames;
   importFuncOffsets.reserve(importFuncOps.size());
+  importFuncNames.reserve(importFuncOps.size());
   for (auto importOp : importFuncOps) {
-    auto nameOffset = fbb.CreateString(importOp.getName().str());
+    importFuncNames.push_back(importOp.getName().str());
+    auto nameOffset = fbb.CreateString(importFuncNames.back());
     auto signatureOffset =
         makeFunctionSignatureDef(importOp.getType(), typeOrdinalMap,
                                  nullptr /* no reflection for imports */, fbb);
@@ -374,9 +399,12 @@ static Offset<iree::vm::BytecodeModuleDef> buildFlatBufferModule(
     importFuncOffsets.push_back(ifd.Finish());
   }
   std::vector<Offset<iree::vm::ExportFunctionDef>> exportFuncOffsets;
+  std::vector<std::string> exportFuncNames;
   exportFuncOffsets.reserve(exportFuncOps.size());
+  exportFuncNames.reserve(exportFuncOps.size());
   for (auto exportOp : exportFuncOps) {
-    auto nameOffset = fbb.CreateString(exportOp.export_name().str());
+    exportFuncNames.push_back(exportOp.export_name().str());
+    auto nameOffset = fbb.CreateString(exportFuncNames.back());
     auto funcOp = symbolTable.lookup<IREE::VM::FuncOp>(exportOp.function_ref());
     auto signatureOffset =
         makeFunctionSignatureDef(funcOp.getType(), typeOrdinalMap,
@@ -388,10 +416,13 @@ static Offset<iree::vm::BytecodeModuleDef> buildFlatBufferModule(
     exportFuncOffsets.push_back(efd.Finish());
   }
   std::vector<Offset<iree::vm::InternalFunctionDef>> internalFuncOffsets;
+  std::vector<std::string> internalFuncNames;
   if (!targetOptions.stripSymbols) {
     internalFuncOffsets.reserve(internalFuncOps.size());
+    internalFuncNames.reserve(internalFuncOps.size());
     for (auto funcOp : internalFuncOps) {
-      auto nameOffset = fbb.CreateString(funcOp.getName().str());
+      internalFuncNames.push_back(funcOp.getName().str());
+      auto nameOffset = fbb.CreateString(internalFuncNames.back());
       auto signatureOffset = makeFunctionSignatureDef(
           funcOp.getType(), typeOrdinalMap,
           funcOp.getAttrOfType<DictionaryAttr>("iree.reflection"), fbb);
@@ -411,6 +442,15 @@ static Offset<iree::vm::BytecodeModuleDef> buildFlatBufferModule(
   auto importFuncsOffset = createOptionalVector(importFuncOffsets, fbb);
   auto typesOffset = fbb.CreateVector(typeOffsets);
 
+  // Name indices allow the runtime to binary search for functions when
+  // resolving imports instead of comparing against every name.
+  auto importFuncsByNameOffset =
+      createOptionalVector(sortOrdinalsByName(importFuncNames), fbb);
+  auto exportFuncsByNameOffset =
+      createOptionalVector(sortOrdinalsByName(exportFuncNames), fbb);
+  auto internalFuncsByNameOffset =
+      createOptionalVector(sortOrdinalsByName(internalFuncNames), fbb);
+
   Optional<Offset<iree::vm::ModuleStateDef>> moduleStateDef;
   if (symbolCounts.globalBytes || symbolCounts.globalRefs) {
     iree::vm::ModuleStateDefBuilder msd(fbb);
@@ -441,6 +481,15 @@ static Offset<iree::vm::BytecodeModuleDef> buildFlatBufferModule(
   }
   bmd.add_function_descriptors(functionDescriptorsOffset);
   bmd.add_bytecode_data(bytecodeDataOffset);
+  if (importFuncsByNameOffset) {
+    bmd.add_imported_functions_by_name(importFuncsByNameOffset.getValue());
+  }
+  if (exportFuncsByNameOffset) {
+    bmd.add_exported_functions_by_name(exportFuncsByNameOffset.getValue());
+  }
+  if (internalFuncsByNameOffset) {
+    bmd.add_internal_functions_by_name(internalFuncsByNameOffset.getValue());
+  }
   return bmd.Finish();
 }
 
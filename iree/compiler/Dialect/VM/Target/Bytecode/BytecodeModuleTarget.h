@@ -16,6 +16,7 @@
 #define IREE_COMPILER_DIALECT_VM_TARGET_BYTECODE_BYTECODEMODULETARGET_H_
 
 #include "iree/compiler/Dialect/VM/IR/VMOps.h"
+#include "iree/compiler/Dialect/VM/Target/Bytecode/ConstantEncoder.h"
 #include "llvm/Support/raw_ostream.h"
 #include "mlir/IR/Module.h"
 #include "mlir/Support/LogicalResult.h"
@@ -53,6 +54,10 @@ struct BytecodeTargetOptions {
   bool stripSourceMap = false;
   // Strips vm ops with the VM_DebugOnly trait.
   bool stripDebugOps = false;
+
+  // Compression used for rodata segments. Compressed segments are decompressed
+  // on first use at runtime.
+  ConstantCompression rodataCompression = ConstantCompression::kNone;
 };
 
 // Translates a vm.module to a bytecode module flatbuffer.
@@ -14,7 +14,11 @@
 
 #include "iree/compiler/Dialect/VM/Target/Bytecode/ConstantEncoder.h"
 
+#include <vector>
+
 #include "flatbuffers/flatbuffers.h"
+#include "iree/base/lz4.h"
+#include "llvm/Support/ErrorHandling.h"
 #include "mlir/IR/Attributes.h"
 #include "mlir/IR/Diagnostics.h"
 #include "mlir/IR/StandardTypes.h"
@@ -34,110 +38,129 @@ using flatbuffers::Vector;
 
 // TODO(benvanik): switch to LLVM's BinaryStreamWriter to handle endianness.
 
-static Offset<Vector<uint8_t>> serializeConstantI8Array(
-    DenseIntElementsAttr attr, FlatBufferBuilder &fbb) {
-  uint8_t *bytePtr = nullptr;
-  auto byteVector =
-      fbb.CreateUninitializedVector(attr.getNumElements() * 1, &bytePtr);
+static void serializeConstantI8Array(DenseIntElementsAttr attr,
+                                     uint8_t *bytePtr) {
   for (APInt value : attr.getIntValues()) {
     *(bytePtr++) = value.extractBitsAsZExtValue(8, 0) & UINT8_MAX;
   }
-  return byteVector;
 }
 
-static Offset<Vector<uint8_t>> serializeConstantI16Array(
-    DenseIntElementsAttr attr, FlatBufferBuilder &fbb) {
-  uint8_t *bytePtr = nullptr;
-  auto byteVector =
-      fbb.CreateUninitializedVector(attr.getNumElements() * 2, &bytePtr);
+static void serializeConstantI16Array(DenseIntElementsAttr attr,
+                                      uint8_t *bytePtr) {
   uint16_t *nativePtr = reinterpret_cast<uint16_t *>(bytePtr);
   for (APInt value : attr.getIntValues()) {
     *(nativePtr++) = value.extractBitsAsZExtValue(16, 0) & UINT16_MAX;
   }
-  return byteVector;
 }
 
-static Offset<Vector<uint8_t>> serializeConstantI32Array(
-    DenseIntElementsAttr attr, FlatBufferBuilder &fbb) {
-  uint8_t *bytePtr = nullptr;
-  auto byteVector =
-      fbb.CreateUninitializedVector(attr.getNumElements() * 4, &bytePtr);
+static void serializeConstantI32Array(DenseIntElementsAttr attr,
+                                      uint8_t *bytePtr) {
   uint32_t *nativePtr = reinterpret_cast<uint32_t *>(bytePtr);
   for (APInt value : attr.getIntValues()) {
     *(nativePtr++) = value.extractBitsAsZExtValue(32, 0) & UINT32_MAX;
   }
-  return byteVector;
 }
 
-static Offset<Vector<uint8_t>> serializeConstantI64Array(
-    DenseIntElementsAttr attr, FlatBufferBuilder &fbb) {
-  uint8_t *bytePtr = nullptr;
-  auto byteVector =
-      fbb.CreateUninitializedVector(attr.getNumElements() * 8, &bytePtr);
+static void serializeConstantI64Array(DenseIntElementsAttr attr,
+                                      uint8_t *bytePtr) {
   uint64_t *nativePtr = reinterpret_cast<uint64_t *>(bytePtr);
   for (APInt value : attr.getIntValues()) {
     *(nativePtr++) = value.extractBitsAsZExtValue(64, 0) & UINT64_MAX;
   }
-  return byteVector;
 }
 
-static Offset<Vector<uint8_t>> serializeConstantF32Array(
-    DenseFPElementsAttr attr, FlatBufferBuilder &fbb) {
-  uint8_t *bytePtr = nullptr;
-  auto byteVector =
-      fbb.CreateUninitializedVector(attr.getNumElements() * 4, &bytePtr);
+static void serializeConstantF32Array(DenseFPElementsAttr attr,
+                                      uint8_t *bytePtr) {
   float *nativePtr = reinterpret_cast<float *>(bytePtr);
   for (APFloat value : attr.getFloatValues()) {
     *(nativePtr++) = value.convertToFloat();
   }
-  return byteVector;
 }
 
-static Offset<Vector<uint8_t>> serializeConstantF64Array(
-    DenseFPElementsAttr attr, FlatBufferBuilder &fbb) {
-  uint8_t *bytePtr = nullptr;
-  auto byteVector =
-      fbb.CreateUninitializedVector(attr.getNumElements() * 8, &bytePtr);
+static void serializeConstantF64Array(DenseFPElementsAttr attr,
+                                      uint8_t *bytePtr) {
   double *nativePtr = reinterpret_cast<double *>(bytePtr);
   for (APFloat value : attr.getFloatValues()) {
     *(nativePtr++) = value.convertToDouble();
   }
-  return byteVector;
 }
 
-Offset<Vector<uint8_t>> serializeConstant(Location loc,
-                                          ElementsAttr elementsAttr,
-                                          FlatBufferBuilder &fbb) {
+// Returns the size in bytes of |elementsAttr| when serialized or None if the
+// attribute has no serialized form.
+static Optional<size_t> getSerializedByteLength(Location loc,
+                                                ElementsAttr elementsAttr) {
+  unsigned bitWidth = elementsAttr.getType().getElementTypeBitWidth();
+  if (elementsAttr.isa<DenseIntElementsAttr>()) {
+    if (bitWidth != 8 && bitWidth != 16 && bitWidth != 32 && bitWidth != 64) {
+      emitError(loc) << "unhandled element bitwidth " << bitWidth;
+      return llvm::None;
+    }
+  } else if (elementsAttr.isa<DenseFPElementsAttr>()) {
+    if (bitWidth != 32 && bitWidth != 64) {
+      emitError(loc) << "unhandled element bitwidth " << bitWidth;
+      return llvm::None;
+    }
+  } else {
+    emitError(loc) << "unimplemented attribute encoding: "
+                   << elementsAttr.getType();
+    return llvm::None;
+  }
+  return elementsAttr.getNumElements() * (bitWidth / 8);
+}
+
+// Writes |elementsAttr| to |bytePtr|, which must have the length returned by
+// getSerializedByteLength.
+static void writeConstant(ElementsAttr elementsAttr, uint8_t *bytePtr) {
   if (auto attr = elementsAttr.dyn_cast<DenseIntElementsAttr>()) {
     switch (attr.getType().getElementTypeBitWidth()) {
       case 8:
-        return serializeConstantI8Array(attr, fbb);
+        return serializeConstantI8Array(attr, bytePtr);
       case 16:
-        return serializeConstantI16Array(attr, fbb);
+        return serializeConstantI16Array(attr, bytePtr);
       case 32:
-        return serializeConstantI32Array(attr, fbb);
+        return serializeConstantI32Array(attr, bytePtr);
       case 64:
-        return serializeConstantI64Array(attr, fbb);
-      default:
-        emitError(loc) << "unhandled element bitwidth "
-                       << attr.getType().getElementTypeBitWidth();
-        return {};
+        return serializeConstantI64Array(attr, bytePtr);
     }
   } else if (auto attr = elementsAttr.dyn_cast<DenseFPElementsAttr>()) {
     switch (attr.getType().getElementTypeBitWidth()) {
       case 32:
-        return serializeConstantF32Array(attr, fbb);
+        return serializeConstantF32Array(attr, bytePtr);
       case 64:
-        return serializeConstantF64Array(attr, fbb);
-      default:
-        emitError(loc) << "unhandled element bitwidth "
-                       << attr.getType().getElementTypeBitWidth();
-        return {};
+        return serializeConstantF64Array(attr, bytePtr);
     }
   }
-  emitError(loc) << "unimplemented attribute encoding: "
-                 << elementsAttr.getType();
-  return {};
+  llvm_unreachable("unsupported constant checked in getSerializedByteLength");
+}
+
+SerializedConstant serializeConstant(Location loc, ElementsAttr elementsAttr,
+                                     ConstantCompression compression,
+                                     FlatBufferBuilder &fbb) {
+  auto byteLength = getSerializedByteLength(loc, elementsAttr);
+  if (!byteLength.hasValue()) return {};
+
+  SerializedConstant result;
+  if (compression == ConstantCompression::kLZ4) {
+    std::vector<uint8_t> bytes(byteLength.getValue());
+    writeConstant(elementsAttr, bytes.data());
+    std::vector<uint8_t> compressed(iree::Lz4CompressBound(bytes.size()));
+    compressed.resize(
+        iree::Lz4CompressBlock(bytes, absl::MakeSpan(compressed)));
+    // Decompression costs load time and memory so only keep the compressed
+    // form when it meaningfully shrinks the module.
+    if (compressed.size() <= bytes.size() - bytes.size() / 8) {
+      result.data = fbb.CreateVector(compressed);
+      result.uncompressedSize = bytes.size();
+      return result;
+    }
+    result.data = fbb.CreateVector(bytes);
+    return result;
+  }
+
+  uint8_t *bytePtr = nullptr;
+  result.data = fbb.CreateUninitializedVector(byteLength.getValue(), &bytePtr);
+  writeConstant(elementsAttr, bytePtr);
+  return result;
 }
 
 }  // namespace VM
@@ -24,10 +24,27 @@ namespace iree_compiler {
 namespace IREE {
 namespace VM {
 
+// Compression applied to serialized constant data.
+enum class ConstantCompression {
+  // Data is stored as-is and can be referenced directly from the module.
+  kNone,
+  // Data is stored as a raw LZ4 block when doing so saves space.
+  kLZ4,
+};
+
+struct SerializedConstant {
+  // Binary blob in the FlatBuffer. Null if serialization failed.
+  flatbuffers::Offset<flatbuffers::Vector<uint8_t>> data;
+  // Size of the data after decompression if it was compressed, otherwise 0.
+  uint64_t uncompressedSize = 0;
+};
+
 // Serializes a constant attribute to the FlatBuffer as a binary blob.
-flatbuffers::Offset<flatbuffers::Vector<uint8_t>> serializeConstant(
-    Location loc, ElementsAttr elementsAttr,
-    flatbuffers::FlatBufferBuilder &fbb);
+// The blob is compressed with |compression| only if that shrinks it enough to
+// be worth the cost of decompression at load time.
+SerializedConstant serializeConstant(Location loc, ElementsAttr elementsAttr,
+                                     ConstantCompression compression,
+                                     flatbuffers::FlatBufferBuilder &fbb);
 
 }  // namespace VM
 }  // namespace IREE
@@ -66,6 +66,16 @@ static llvm::cl::opt<bool> stripDebugOpsFlag{
     llvm::cl::init(false),
 };
 
+static llvm::cl::opt<ConstantCompression> rodataCompressionFlag{
+    "iree-vm-bytecode-module-rodata-compression",
+    llvm::cl::desc("Compression used for read-only data segments"),
+    llvm::cl::init(ConstantCompression::kNone),
+    llvm::cl::values(
+        clEnumValN(ConstantCompression::kNone, "none", "No compression"),
+        clEnumValN(ConstantCompression::kLZ4, "lz4",
+                   "LZ4 block compression, decompressed on first use")),
+};
+
 BytecodeTargetOptions getBytecodeTargetOptionsFromFlags() {
   BytecodeTargetOptions targetOptions;
   targetOptions.outputFormat = outputFormatFlag;
@@ -73,6 +83,7 @@ BytecodeTargetOptions getBytecodeTargetOptionsFromFlags() {
   targetOptions.stripSymbols = stripSymbolsFlag;
   targetOptions.stripSourceMap = stripSourceMapFlag;
   targetOptions.stripDebugOps = stripDebugOpsFlag;
+  targetOptions.rodataCompression = rodataCompressionFlag;
   return targetOptions;
 }
 
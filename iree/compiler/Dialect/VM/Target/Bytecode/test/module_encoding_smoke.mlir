@@ -20,5 +20,26 @@ vm.module @simple_module {
   // CHECK-NEXT: bytecode_length: 3
   // CHECK-NEXT: i32_register_count: 1
   // CHECK-NEXT: ref_register_count: 0
-  // CHECK: bytecode_data: [ 84, 1, 0 ]
+  // CHECK: bytecode_data: [ 86, 1, 0 ]
+}
+
+// -----
+
+// CHECK: name: "name_index_module"
+vm.module @name_index_module {
+  vm.export @c
+  vm.export @a
+  vm.export @b
+  vm.func @c() {
+    vm.return
+  }
+  vm.func @a() {
+    vm.return
+  }
+  vm.func @b() {
+    vm.return
+  }
+
+  // CHECK: exported_functions_by_name: [ 1, 2, 0 ]
+  // CHECK: internal_functions_by_name: [ 1, 2, 0 ]
 }
@@ -0,0 +1,50 @@
+// RUN: iree-translate -split-input-file -iree-vm-ir-to-bytecode-module -iree-vm-bytecode-module-output-format=flatbuffer-text %s | IreeFileCheck %s
+
+// CHECK: name: "add_const_module"
+vm.module @add_const_module {
+  vm.export @add_const
+  vm.func @add_const(%arg0 : i32) -> i32 {
+    %c5 = vm.const.i32 5 : i32
+    %0 = vm.add.i32 %arg0, %c5 : i32
+    vm.return %0 : i32
+  }
+
+  // Constants are not folded into immediates (doing so measured no gain) but
+  // the return has only i32 values.
+  // CHECK: bytecode_data: [ 9, 5, 0, 0, 0, {{[0-9]+}}, 34, {{[0-9]+}}, {{[0-9]+}}, {{[0-9]+}}, 86, 1, {{[0-9]+}} ]
+}
+
+// -----
+
+// CHECK: name: "call_i32_module"
+vm.module @call_i32_module {
+  vm.func @callee(%arg0 : i32) -> i32 attributes {noinline} {
+    vm.return %arg0 : i32
+  }
+  vm.export @caller
+  vm.func @caller(%arg0 : i32) -> i32 {
+    %0 = vm.call @callee(%arg0) : (i32) -> i32
+    vm.return %0 : i32
+  }
+
+  // Internal calls carrying only i32 values use call.i32.
+  // CHECK: bytecode_data: [ {{.*}}85, {{[0-9]+}}, 0, 0, 0, 1, {{[0-9]+}}, 1, {{[0-9]+}}, 86, 1, {{[0-9]+}}{{.*}} ]
+}
+
+// -----
+
+// CHECK: name: "cmp_branch_module"
+vm.module @cmp_branch_module {
+  vm.export @cmp_branch
+  vm.func @cmp_branch(%arg0 : i32, %arg1 : i32) -> i32 {
+    %0 = vm.cmp.gt.i32.s %arg0, %arg1 : i32
+    vm.cond_br %0, ^bb1, ^bb2
+  ^bb1:
+    vm.return %arg0 : i32
+  ^bb2:
+    vm.return %arg1 : i32
+  }
+
+  // The compare is fused into the branch with its operands swapped.
+  // CHECK: bytecode_data: [ 90, 1, 0, 15, 0, 0, 0, 0, 0, 18, 0, 0, 0, 0, 0, 86, 1, 0, 86, 1, 1 ]
+}
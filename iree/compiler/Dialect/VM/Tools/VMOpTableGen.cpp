@@ -50,6 +50,15 @@ bool emitOpTableDefs(const llvm::RecordKeeper &recordKeeper, raw_ostream &os) {
     }
   }
 
+  // Superinstructions have no op of their own as they are only produced by the
+  // bytecode encoder; they still need table entries so that they dispatch.
+  for (const auto *opcode : recordKeeper.getAllDerivedDefinitions("VM_OPC")) {
+    int value = opcode->getValueAsInt("value");
+    if (opEncodings[value]) continue;
+    opRecords[value] = opcode;
+    opEncodings[value] = opcode;
+  }
+
   os << "typedef enum {\n";
   for (int i = 0; i < 256; ++i) {
     auto *def = opRecords[i];
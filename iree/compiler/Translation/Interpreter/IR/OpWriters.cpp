@@ -139,8 +139,16 @@ LogicalResult writeOp(IREEInterp::LL::CmpFOp op, BytecodeWriter *writer) {
 
 LogicalResult writeOp(IREEInterp::LL::AllocHeapOp op, BytecodeWriter *writer) {
   auto memrefType = op.getType().cast<MemRefType>();
-  RETURN_IF_FAILURE(writer->WriteOpcode(iree::InterpreterOpcode::kAllocHeap));
-  RETURN_IF_FAILURE(writer->WriteInt32(0));
+  if (auto scratchOffset =
+          op.getAttrOfType<IntegerAttr>("iree.scratch_offset")) {
+    // Planned into the function scratch arena by PlanScratchAllocations.
+    RETURN_IF_FAILURE(
+        writer->WriteOpcode(iree::InterpreterOpcode::kAllocStatic));
+    RETURN_IF_FAILURE(writer->WriteInt32(scratchOffset.getInt()));
+  } else {
+    RETURN_IF_FAILURE(writer->WriteOpcode(iree::InterpreterOpcode::kAllocHeap));
+    RETURN_IF_FAILURE(writer->WriteInt32(0));
+  }
   RETURN_IF_FAILURE(writer->WriteTypeIndex(memrefType.getElementType()));
   RETURN_IF_FAILURE(writer->WriteShapePieces(memrefType));
   RETURN_IF_FAILURE(writer->WriteLocals(op.getOperands()));
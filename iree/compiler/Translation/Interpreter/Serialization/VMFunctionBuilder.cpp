@@ -157,6 +157,10 @@ LogicalResult VMFunctionBuilder::ConvertBytecode() {
   iree::BytecodeDefBuilder bdb(*fbb_);
   bdb.add_local_count(localCount);
   bdb.add_contents(bodyOffset);
+  if (auto scratchSize =
+          function_.getAttrOfType<IntegerAttr>("iree.scratch_size")) {
+    bdb.add_scratch_size(scratchSize.getInt());
+  }
   bytecodeDef_ = bdb.Finish();
 
   return success();
@@ -74,6 +74,10 @@ std::unique_ptr<OpPassBase<ModuleOp>> createAssignFunctionOrdinalsPass();
 // Refactors entry points to match the IREE dispatch executable ABI.
 std::unique_ptr<OpPassBase<ModuleOp>> createMakeExecutableABIPass();
 
+// Plans statically-shaped heap allocations into a per-function scratch arena
+// based on their lifetimes.
+std::unique_ptr<OpPassBase<FuncOp>> createPlanScratchAllocationsPass();
+
 }  // namespace iree_compiler
 }  // namespace mlir
 
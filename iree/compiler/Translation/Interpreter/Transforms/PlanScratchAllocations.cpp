@@ -0,0 +1,279 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <limits>
+
+#include "iree/compiler/Translation/Interpreter/IR/LLOps.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/MathExtras.h"
+#include "mlir/IR/Attributes.h"
+#include "mlir/IR/Builders.h"
+#include "mlir/IR/StandardTypes.h"
+#include "mlir/Pass/Pass.h"
+#include "mlir/Pass/PassRegistry.h"
+#include "mlir/Support/LLVM.h"
+
+namespace mlir {
+namespace iree_compiler {
+
+namespace {
+
+// Alignment of each allocation within the scratch arena.
+// Matches the alignment the runtime uses when carving frames from the arena.
+constexpr int64_t kScratchAlignment = 16;
+
+// A statically-shaped allocation that can be placed in the scratch arena.
+struct ScratchAllocation {
+  IREEInterp::LL::AllocHeapOp allocOp;
+  int64_t byteLength = 0;
+  // Range of op ordinals (inclusive) during which the allocation is live.
+  int start = 0;
+  int end = 0;
+  int64_t offset = 0;
+};
+
+// Groups memref values that may share storage such that the lifetime of an
+// allocation covers the uses of all views derived from it.
+class AliasSets {
+ public:
+  int getId(Value value) {
+    auto it = ids_.find(value);
+    if (it != ids_.end()) return find(it->second);
+    int id = parents_.size();
+    ids_.insert({value, id});
+    parents_.push_back(id);
+    return id;
+  }
+
+  void unionValues(Value lhs, Value rhs) {
+    int lhsId = getId(lhs);
+    int rhsId = getId(rhs);
+    if (lhsId != rhsId) parents_[rhsId] = lhsId;
+  }
+
+ private:
+  int find(int id) {
+    while (parents_[id] != id) {
+      parents_[id] = parents_[parents_[id]];
+      id = parents_[id];
+    }
+    return id;
+  }
+
+  llvm::DenseMap<Value, int> ids_;
+  llvm::SmallVector<int, 32> parents_;
+};
+
+// Returns true if |op| produces results that may alias its memref operands.
+// CondAssignOp is handled separately as it aliases two operands.
+bool isAliasingOp(Operation *op) {
+  return isa<IREEInterp::LL::AssignOp>(op) ||
+         isa<IREEInterp::LL::DynamicSliceOp>(op) ||
+         isa<IREEInterp::LL::StaticSliceOp>(op) ||
+         isa<IREEInterp::LL::ReshapeOp>(op);
+}
+
+// Returns true if |op| produces new storage for all of its results.
+bool isAllocatingOp(Operation *op) {
+  return isa<IREEInterp::LL::AllocHeapOp>(op) ||
+         isa<IREEInterp::LL::CloneOp>(op) ||
+         isa<IREEInterp::LL::ConstantOp>(op);
+}
+
+// Returns the size in bytes of |allocOp| if it can be statically planned.
+Optional<int64_t> getStaticByteLength(IREEInterp::LL::AllocHeapOp allocOp) {
+  auto memRefType = allocOp.getType().cast<MemRefType>();
+  if (allocOp.getNumOperands() != 0 || !memRefType.hasStaticShape()) {
+    return llvm::None;
+  }
+  int64_t elementSize = (memRefType.getElementTypeBitWidth() + 7) / 8;
+  int64_t byteLength = memRefType.getNumElements() * elementSize;
+  if (byteLength == 0) return llvm::None;
+  return byteLength;
+}
+
+// Assigns each allocation an offset such that no two allocations live at the
+// same time overlap. Allocations are placed largest first at the lowest offset
+// that fits between those already placed, which is simple and packs typical
+// feed-forward graphs close to their peak live size.
+// Returns the total size of the arena.
+int64_t packAllocations(MutableArrayRef<ScratchAllocation> allocations) {
+  SmallVector<ScratchAllocation *, 16> order;
+  for (auto &allocation : allocations) order.push_back(&allocation);
+  llvm::stable_sort(order, [](ScratchAllocation *lhs, ScratchAllocation *rhs) {
+    return lhs->byteLength > rhs->byteLength;
+  });
+
+  int64_t arenaSize = 0;
+  SmallVector<ScratchAllocation *, 16> placed;
+  SmallVector<ScratchAllocation *, 16> conflicts;
+  for (auto *allocation : order) {
+    conflicts.clear();
+    for (auto *other : placed) {
+      if (other->start <= allocation->end && allocation->start <= other->end) {
+        conflicts.push_back(other);
+      }
+    }
+    llvm::sort(conflicts, [](ScratchAllocation *lhs, ScratchAllocation *rhs) {
+      return lhs->offset < rhs->offset;
+    });
+    int64_t offset = 0;
+    for (auto *other : conflicts) {
+      if (offset + allocation->byteLength <= other->offset) break;
+      offset = std::max(
+          offset, static_cast<int64_t>(llvm::alignTo(
+                      other->offset + other->byteLength, kScratchAlignment)));
+    }
+    allocation->offset = offset;
+    arenaSize = std::max(arenaSize, offset + allocation->byteLength);
+    placed.push_back(allocation);
+  }
+  return llvm::alignTo(arenaSize, kScratchAlignment);
+}
+
+}  // namespace
+
+// Plans statically-shaped heap allocations into a single per-function scratch
+// arena. Each planned alloc_heap op is annotated with its byte offset in the
+// arena (iree.scratch_offset) and the function with the total arena size
+// (iree.scratch_size) so that the runtime can carve the allocations from one
+// buffer reserved when the function is entered.
+//
+// Allocations that may outlive the function (returned or passed to calls,
+// either directly or through a view) are left on the heap. Allocations used
+// outside of the block defining them are conservatively kept live for the
+// entire function.
+class PlanScratchAllocationsPass
+    : public FunctionPass<PlanScratchAllocationsPass> {
+ public:
+  void runOnFunction() override {
+    auto funcOp = getFunction();
+    if (funcOp.isExternal()) return;
+
+    // Number ops and group values that may share storage.
+    llvm::DenseMap<Operation *, int> opOrdinals;
+    AliasSets aliasSets;
+    SmallVector<Value, 16> escapingValues;
+    int opCount = 0;
+    for (auto &block : funcOp.getBlocks()) {
+      for (auto &op : block) {
+        opOrdinals[&op] = opCount++;
+        if (auto condAssignOp = dyn_cast<IREEInterp::LL::CondAssignOp>(op)) {
+          aliasSets.unionValues(condAssignOp.getResult(), condAssignOp.lhs());
+          aliasSets.unionValues(condAssignOp.getResult(), condAssignOp.rhs());
+        } else if (isAliasingOp(&op)) {
+          // Only the source operand is aliased; any remaining operands are
+          // shapes and indices.
+          aliasSets.unionValues(op.getResult(0), op.getOperand(0));
+        } else if (op.getNumSuccessors() > 0) {
+          for (unsigned i = 0; i < op.getNumSuccessors(); ++i) {
+            auto *successor = op.getSuccessor(i);
+            for (auto operand : llvm::enumerate(op.getSuccessorOperands(i))) {
+              aliasSets.unionValues(successor->getArgument(operand.index()),
+                                    operand.value());
+            }
+          }
+        } else if (isa<IREEInterp::LL::ReturnOp>(op) ||
+                   isa<IREEInterp::LL::CallOp>(op) ||
+                   (op.getNumResults() > 0 && !isAllocatingOp(&op))) {
+          // Values passed to other functions may be retained or returned, and
+          // any op we don't know about may produce views of its operands.
+          escapingValues.append(op.operand_begin(), op.operand_end());
+        }
+      }
+    }
+
+    llvm::DenseSet<int> escapingSets;
+    for (auto value : escapingValues) {
+      escapingSets.insert(aliasSets.getId(value));
+    }
+
+    // Compute the live range of each alias set from the uses of its values.
+    struct LiveRange {
+      int start = std::numeric_limits<int>::max();
+      int end = 0;
+    };
+    llvm::DenseMap<int, LiveRange> liveRanges;
+    auto extendLiveRange = [&](Value value, Block *definingBlock, int start) {
+      auto &liveRange = liveRanges[aliasSets.getId(value)];
+      liveRange.start = std::min(liveRange.start, start);
+      for (auto &use : value.getUses()) {
+        auto *user = use.getOwner();
+        if (user->getBlock() != definingBlock) {
+          liveRange.start = 0;
+          liveRange.end = opCount;
+        } else {
+          liveRange.end = std::max(liveRange.end, opOrdinals[user]);
+        }
+      }
+    };
+    for (auto &block : funcOp.getBlocks()) {
+      for (auto argument : block.getArguments()) {
+        extendLiveRange(argument, nullptr, 0);
+      }
+      for (auto &op : block) {
+        for (auto result : op.getResults()) {
+          extendLiveRange(result, &block, opOrdinals[&op]);
+        }
+      }
+    }
+
+    // Gather the allocations that can be planned.
+    SmallVector<ScratchAllocation, 16> allocations;
+    funcOp.walk([&](IREEInterp::LL::AllocHeapOp allocOp) {
+      auto byteLength = getStaticByteLength(allocOp);
+      if (!byteLength.hasValue()) return;
+      int setId = aliasSets.getId(allocOp.getResult());
+      if (escapingSets.count(setId)) return;
+      const auto &liveRange = liveRanges[setId];
+      ScratchAllocation allocation;
+      allocation.allocOp = allocOp;
+      allocation.byteLength = byteLength.getValue();
+      allocation.start = liveRange.start;
+      allocation.end = std::max(liveRange.start, liveRange.end);
+      allocations.push_back(allocation);
+    });
+    if (allocations.empty()) return;
+
+    int64_t scratchSize = packAllocations(allocations);
+    if (scratchSize > std::numeric_limits<int32_t>::max()) {
+      // Offsets are encoded as int32; leave huge functions on the heap.
+      return;
+    }
+
+    Builder builder(&getContext());
+    for (auto &allocation : allocations) {
+      allocation.allocOp.setAttr(
+          "iree.scratch_offset",
+          builder.getI32IntegerAttr(static_cast<int32_t>(allocation.offset)));
+    }
+    funcOp.setAttr("iree.scratch_size",
+                   builder.getI32IntegerAttr(static_cast<int32_t>(scratchSize)));
+  }
+};
+
+std::unique_ptr<OpPassBase<FuncOp>> createPlanScratchAllocationsPass() {
+  return std::make_unique<PlanScratchAllocationsPass>();
+}
+
+static PassRegistration<PlanScratchAllocationsPass> pass(
+    "iree-plan-scratch-allocations",
+    "Plans static heap allocations into a per-function scratch arena");
+
+}  // namespace iree_compiler
+}  // namespace mlir
@@ -0,0 +1,52 @@
+// RUN: iree-opt %s -iree-plan-scratch-allocations -split-input-file | IreeFileCheck %s
+
+// CHECK-LABEL: func @reuseDeadAllocations
+// CHECK-SAME: attributes {iree.scratch_size = 32 : i32}
+func @reuseDeadAllocations(%arg0 : memref<4xf32>) -> memref<4xf32> {
+  // CHECK-NEXT: %0 = "iree_ll_interp.alloc_heap"() {iree.scratch_offset = 0 : i32}
+  %0 = "iree_ll_interp.alloc_heap"() : () -> memref<4xf32>
+  "iree_ll_interp.add_f"(%arg0, %arg0, %0) : (memref<4xf32>, memref<4xf32>, memref<4xf32>) -> ()
+  // CHECK: %1 = "iree_ll_interp.alloc_heap"() {iree.scratch_offset = 16 : i32}
+  %1 = "iree_ll_interp.alloc_heap"() : () -> memref<4xf32>
+  "iree_ll_interp.add_f"(%0, %arg0, %1) : (memref<4xf32>, memref<4xf32>, memref<4xf32>) -> ()
+  // CHECK: %2 = "iree_ll_interp.alloc_heap"() {iree.scratch_offset = 0 : i32}
+  %2 = "iree_ll_interp.alloc_heap"() : () -> memref<4xf32>
+  "iree_ll_interp.add_f"(%1, %arg0, %2) : (memref<4xf32>, memref<4xf32>, memref<4xf32>) -> ()
+  // CHECK: %3 = "iree_ll_interp.alloc_heap"() : () -> memref<4xf32>
+  %3 = "iree_ll_interp.alloc_heap"() : () -> memref<4xf32>
+  "iree_ll_interp.add_f"(%2, %arg0, %3) : (memref<4xf32>, memref<4xf32>, memref<4xf32>) -> ()
+  iree_ll_interp.return %3 : memref<4xf32>
+}
+
+// -----
+
+// CHECK-LABEL: func @returnedViewsStayOnHeap
+// CHECK-NOT: iree.scratch_size
+func @returnedViewsStayOnHeap(%arg0 : memref<4xf32>) -> memref<2x2xf32> {
+  %shape = "iree_ll_interp.constant"() {value = dense<[2, 2]> : tensor<2xi32>} : () -> memref<2xi32>
+  // CHECK: "iree_ll_interp.alloc_heap"() : () -> memref<4xf32>
+  %0 = "iree_ll_interp.alloc_heap"() : () -> memref<4xf32>
+  "iree_ll_interp.add_f"(%arg0, %arg0, %0) : (memref<4xf32>, memref<4xf32>, memref<4xf32>) -> ()
+  %1 = "iree_ll_interp.reshape"(%0, %shape) : (memref<4xf32>, memref<2xi32>) -> memref<2x2xf32>
+  iree_ll_interp.return %1 : memref<2x2xf32>
+}
+
+// -----
+
+// CHECK-LABEL: func @crossBlockLifetimes
+// CHECK-SAME: attributes {iree.scratch_size = 48 : i32}
+func @crossBlockLifetimes(%arg0 : memref<4xf32>, %arg1 : memref<4xf32>) {
+  // CHECK: "iree_ll_interp.alloc_heap"() {iree.scratch_offset = 0 : i32}
+  %0 = "iree_ll_interp.alloc_heap"() : () -> memref<4xf32>
+  "iree_ll_interp.add_f"(%arg0, %arg0, %0) : (memref<4xf32>, memref<4xf32>, memref<4xf32>) -> ()
+  iree_ll_interp.br ^bb1(%0 : memref<4xf32>)
+^bb1(%1 : memref<4xf32>):
+  // CHECK: "iree_ll_interp.alloc_heap"() {iree.scratch_offset = 16 : i32}
+  %2 = "iree_ll_interp.alloc_heap"() : () -> memref<4xf32>
+  "iree_ll_interp.add_f"(%1, %arg0, %2) : (memref<4xf32>, memref<4xf32>, memref<4xf32>) -> ()
+  // CHECK: "iree_ll_interp.alloc_heap"() {iree.scratch_offset = 32 : i32}
+  %3 = "iree_ll_interp.alloc_heap"() : () -> memref<4xf32>
+  "iree_ll_interp.add_f"(%2, %arg0, %3) : (memref<4xf32>, memref<4xf32>, memref<4xf32>) -> ()
+  "iree_ll_interp.add_f"(%3, %1, %arg1) : (memref<4xf32>, memref<4xf32>, memref<4xf32>) -> ()
+  iree_ll_interp.return
+}
@@ -55,6 +55,7 @@ StatusOr<ref_ptr<Buffer>> Allocator::AllocateConstant(
                    source_buffer->MapMemory<uint8_t>(MemoryAccess::kRead));
   RETURN_IF_ERROR(device_buffer->WriteData(0, source_mapping.data(),
                                            source_mapping.byte_length()));
+  device_buffer->MarkConstantContents();
   return device_buffer;
 }
 
@@ -73,5 +74,13 @@ StatusOr<ref_ptr<Buffer>> Allocator::WrapMutable(
          << "Allocator does not support wrapping host memory";
 }
 
+StatusOr<ref_ptr<Buffer>> Allocator::WrapMutableWithRelease(
+    MemoryTypeBitfield memory_type, MemoryAccessBitfield allowed_access,
+    BufferUsageBitfield buffer_usage, void* data, size_t data_length,
+    std::function<void()> release_fn) {
+  return UnimplementedErrorBuilder(IREE_LOC)
+         << "Allocator does not support wrapping host memory";
+}
+
 }  // namespace hal
 }  // namespace iree
@@ -16,6 +16,7 @@
 #define IREE_HAL_ALLOCATOR_H_
 
 #include <cstddef>
+#include <functional>
 #include <memory>
 
 #include "absl/types/span.h"
@@ -114,6 +115,18 @@ class Allocator : public RefObject<Allocator> {
                                         MemoryAccessBitfield allowed_access,
                                         BufferUsageBitfield buffer_usage,
                                         absl::Span<T> data);
+
+  // Wraps an existing host allocation in a buffer as with WrapMutable and
+  // calls |release_fn| once the buffer has been destroyed and the memory is no
+  // longer referenced by it. This allows callers to tie the lifetime of the
+  // host allocation to that of the buffer instead of tracking all uses.
+  //
+  // Fails if the allocator cannot access host memory in this way, in which
+  // case |release_fn| is not called and ownership remains with the caller.
+  virtual StatusOr<ref_ptr<Buffer>> WrapMutableWithRelease(
+      MemoryTypeBitfield memory_type, MemoryAccessBitfield allowed_access,
+      BufferUsageBitfield buffer_usage, void* data, size_t data_length,
+      std::function<void()> release_fn);
 };
 
 // Inline functions and template definitions follow:
@@ -109,6 +109,37 @@ IREE_API_EXPORT iree_status_t IREE_API_CALL iree_hal_allocator_wrap_buffer(
   return IREE_STATUS_OK;
 }
 
+IREE_API_EXPORT iree_status_t IREE_API_CALL
+iree_hal_allocator_wrap_buffer_with_release(
+    iree_hal_allocator_t* allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t buffer_usage, iree_byte_span_t data,
+    iree_hal_buffer_release_fn_t release_fn, void* release_user_data,
+    iree_hal_buffer_t** out_buffer) {
+  IREE_TRACE_SCOPE0("iree_hal_allocator_wrap_buffer_with_release");
+  if (!out_buffer) {
+    return IREE_STATUS_INVALID_ARGUMENT;
+  }
+  *out_buffer = nullptr;
+  auto* handle = reinterpret_cast<Allocator*>(allocator);
+  if (!handle || !release_fn) {
+    return IREE_STATUS_INVALID_ARGUMENT;
+  }
+
+  IREE_API_ASSIGN_OR_RETURN(
+      auto buffer,
+      handle->WrapMutableWithRelease(
+          static_cast<MemoryTypeBitfield>(memory_type),
+          static_cast<MemoryAccessBitfield>(allowed_access),
+          static_cast<BufferUsageBitfield>(buffer_usage), data.data,
+          data.data_length, [release_fn, release_user_data]() {
+            release_fn(release_user_data);
+          }));
+
+  *out_buffer = reinterpret_cast<iree_hal_buffer_t*>(buffer.release());
+  return IREE_STATUS_OK;
+}
+
 //===----------------------------------------------------------------------===//
 // iree::hal::Buffer
 //===----------------------------------------------------------------------===//
@@ -276,6 +276,10 @@ typedef struct {
   iree_device_size_t length;
 } iree_hal_buffer_barrier_t;
 
+// Called when a buffer wrapping a host allocation has been destroyed and the
+// allocation is no longer referenced by it.
+typedef void(IREE_API_PTR* iree_hal_buffer_release_fn_t)(void* user_data);
+
 //===----------------------------------------------------------------------===//
 // iree::hal::Allocator
 //===----------------------------------------------------------------------===//
@@ -321,6 +325,21 @@ IREE_API_EXPORT iree_status_t IREE_API_CALL iree_hal_allocator_wrap_buffer(
     iree_hal_buffer_usage_t buffer_usage, iree_byte_span_t data,
     iree_hal_buffer_t** out_buffer);
 
+// Wraps an existing host allocation in a buffer and calls |release_fn| with
+// |release_user_data| once the buffer has been destroyed. The memory must
+// remain valid until then. The callback may be issued from any thread.
+//
+// Fails if the allocator cannot access host memory in this way, in which case
+// |release_fn| is not called and ownership remains with the caller.
+// |out_buffer| must be released by the caller.
+IREE_API_EXPORT iree_status_t IREE_API_CALL
+iree_hal_allocator_wrap_buffer_with_release(
+    iree_hal_allocator_t* allocator, iree_hal_memory_type_t memory_type,
+    iree_hal_memory_access_t allowed_access,
+    iree_hal_buffer_usage_t buffer_usage, iree_byte_span_t data,
+    iree_hal_buffer_release_fn_t release_fn, void* release_user_data,
+    iree_hal_buffer_t** out_buffer);
+
 #endif  // IREE_API_NO_PROTOTYPES
 
 //===----------------------------------------------------------------------===//
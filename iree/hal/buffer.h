@@ -297,6 +297,21 @@ class Buffer : public Resource {
   // Bitfield describing how the buffer is to be used.
   BufferUsageBitfield usage() const { return usage_; }
 
+  // Whether the contents of the underlying allocation are program constants
+  // that will not change for its lifetime (such as module rodata).
+  // Unlike the absence of MemoryAccess::kWrite this is a promise about the
+  // memory itself - read-only imports may still be changed by their owner - and
+  // allows consumers to cache data derived from the contents on the allocation.
+  bool has_constant_contents() const {
+    return allocated_buffer_ == this
+               ? constant_contents_
+               : allocated_buffer_->has_constant_contents();
+  }
+
+  // Marks the contents of the underlying allocation as constant.
+  // Must only be called once the contents have been fully initialized.
+  void MarkConstantContents() { allocated_buffer()->constant_contents_ = true; }
+
   // Returns the underlying buffer that represents the allocated memory for the
   // Buffer. In most cases this is the buffer itself but for buffer subspan
   // references it will point to the parent buffer.
@@ -589,6 +604,7 @@ class Buffer : public Resource {
   MemoryTypeBitfield memory_type_ = MemoryType::kNone;
   MemoryAccessBitfield allowed_access_ = MemoryAccess::kNone;
   BufferUsageBitfield usage_ = BufferUsage::kNone;
+  bool constant_contents_ = false;
 
   device_size_t allocation_size_ = 0;
   device_size_t byte_offset_ = 0;
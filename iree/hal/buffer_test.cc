@@ -269,6 +269,23 @@ TEST(BufferTest, SubspanIdentity) {
             Buffer::Subspan(parent_buffer, 0, 4).ValueOrDie().get());
 }
 
+// Tests that constant contents are tracked on the allocation and shared by
+// subspans.
+TEST(BufferTest, SubspanConstantContents) {
+  std::vector<uint8_t> src_data = {0, 1, 2, 3};
+  auto parent_buffer = HeapBuffer::Wrap(
+      MemoryType::kHostLocal, BufferUsage::kAll, absl::MakeConstSpan(src_data));
+  ASSERT_OK_AND_ASSIGN(auto subspan_buffer,
+                       Buffer::Subspan(parent_buffer, 1, 2));
+  // Read-only buffers are not constant unless marked.
+  EXPECT_FALSE(parent_buffer->has_constant_contents());
+  EXPECT_FALSE(subspan_buffer->has_constant_contents());
+
+  subspan_buffer->MarkConstantContents();
+  EXPECT_TRUE(parent_buffer->has_constant_contents());
+  EXPECT_TRUE(subspan_buffer->has_constant_contents());
+}
+
 TEST(BufferTest, SubspanOutOfRange) {
   std::vector<uint8_t> src_data = {0, 1, 2, 3};
   auto parent_buffer =
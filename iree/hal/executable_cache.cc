@@ -17,9 +17,53 @@
 namespace iree {
 namespace hal {
 
+namespace {
+
+// The splitmix64 finalizer; cheap and mixes every input bit into the output.
+inline uint64_t Mix(uint64_t value) {
+  value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+  value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+  return value ^ (value >> 31);
+}
+
+// Reads up to 8 bytes as a little-endian value so that hashes do not depend on
+// the host byte order.
+inline uint64_t ReadLittleEndian(const uint8_t* data, size_t length) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < length; ++i) {
+    value |= static_cast<uint64_t>(data[i]) << (i * 8);
+  }
+  return value;
+}
+
+}  // namespace
+
+uint64_t ComputeExecutableHash(ExecutableFormat format,
+                               absl::Span<const uint8_t> data) {
+  constexpr uint64_t kIncrement = 0x9E3779B97F4A7C15ull;
+  uint64_t hash = Mix((static_cast<uint64_t>(format) << 32) ^ data.size());
+  size_t offset = 0;
+  for (; offset + 8 <= data.size(); offset += 8) {
+    hash = Mix(hash ^ ReadLittleEndian(data.data() + offset, 8)) + kIncrement;
+  }
+  hash = Mix(hash ^ ReadLittleEndian(data.data() + offset,
+                                     data.size() - offset));
+  return hash ? hash : kIncrement;
+}
+
 ExecutableCache::ExecutableCache() = default;
 
 ExecutableCache::~ExecutableCache() = default;
 
+StatusOr<std::vector<uint8_t>> ExecutableCache::Serialize() const {
+  return UnimplementedErrorBuilder(IREE_LOC)
+         << "Executable cache does not support serialization";
+}
+
+Status ExecutableCache::Deserialize(absl::Span<const uint8_t> data) {
+  return UnimplementedErrorBuilder(IREE_LOC)
+         << "Executable cache does not support serialization";
+}
+
 }  // namespace hal
 }  // namespace iree
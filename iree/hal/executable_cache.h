@@ -15,6 +15,10 @@
 #ifndef IREE_HAL_EXECUTABLE_CACHE_H_
 #define IREE_HAL_EXECUTABLE_CACHE_H_
 
+#include <cstdint>
+#include <vector>
+
+#include "absl/types/span.h"
 #include "iree/base/bitfield.h"
 #include "iree/base/ref_ptr.h"
 #include "iree/base/status.h"
@@ -75,6 +79,12 @@ enum class ExecutableCachingMode : uint32_t {
 IREE_BITFIELD(ExecutableCachingMode);
 using ExecutableCachingModeBitfield = ExecutableCachingMode;
 
+// Returns a stable 64-bit hash of an executable's |format| and |data|.
+// The hash is identical across processes and hosts so that it can be used to
+// key persisted executables. Never returns 0.
+uint64_t ComputeExecutableHash(ExecutableFormat format,
+                               absl::Span<const uint8_t> data);
+
 // A cache of prepared executables for a particular device.
 // Caches may be shared across multiple devices from the same driver or specific
 // to individual devices. Caches may persist prepared executables across process
@@ -95,8 +105,6 @@ class ExecutableCache : public RefObject<ExecutableCache> {
 
   // TODO(benvanik): status/queries (size, etc).
 
-  // TODO(b/137153339): serialization/deserialization.
-
   // Returns true if the executable cache can prepare the given executable input
   // format. Preparation may still fail if the particular version or features
   // required by the executable are not supported.
@@ -116,6 +124,18 @@ class ExecutableCache : public RefObject<ExecutableCache> {
   virtual StatusOr<ref_ptr<Executable>> PrepareExecutable(
       ExecutableCachingModeBitfield mode, const ExecutableSpec& spec) = 0;
 
+  // Serializes the executables prepared with
+  // ExecutableCachingMode::kAllowPersistentCaching so that they can be loaded
+  // into a cache in a future process with Deserialize.
+  // Returns UnimplementedError if the cache does not support serialization.
+  virtual StatusOr<std::vector<uint8_t>> Serialize() const;
+
+  // Prepares the executables in |data| as produced by Serialize such that
+  // subsequent PrepareExecutable calls for them need not prepare them again.
+  // Executables in formats the cache cannot prepare are ignored.
+  // Returns UnimplementedError if the cache does not support serialization.
+  virtual Status Deserialize(absl::Span<const uint8_t> data);
+
  protected:
   ExecutableCache();
 };
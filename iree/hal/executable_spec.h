@@ -15,6 +15,8 @@
 #ifndef IREE_HAL_EXECUTABLE_SPEC_H_
 #define IREE_HAL_EXECUTABLE_SPEC_H_
 
+#include <cstdint>
+
 #include "absl/types/span.h"
 #include "iree/hal/executable_format.h"
 
@@ -23,7 +25,10 @@ namespace hal {
 
 // Defines an executable specification used by a cache to prepare an executable.
 struct ExecutableSpec {
-  // TODO(benvanik): pre-populated hash_code/key to avoid calculation.
+  // Stable hash of the format and executable data as returned by
+  // ComputeExecutableHash. Caches that key prepared executables by content use
+  // it to avoid hashing the data on every lookup. 0 if not yet computed.
+  uint64_t hash_code = 0;
 
   // Format of the executable input data.
   ExecutableFormat format = kExecutableFormatUnspecified;
@@ -53,14 +53,12 @@ void AsyncCommandQueue::ThreadMain() {
 
   bool is_exiting = false;
   while (!is_exiting) {
-    // Block until we are either requested to exit or there are pending
-    // submissions.
+    // Capture the epoch before looking for ready work. Any semaphore signal or
+    // submission that happens after this point (including from other queues)
+    // will change the epoch and wake us below so that no wakeups are lost.
+    uint64_t epoch = HostSubmissionQueue::CurrentEpoch();
+
     submission_mutex_.Lock();
-    submission_mutex_.Await(absl::Condition(
-        +[](HostSubmissionQueue* queue) {
-          return queue->has_shutdown() || !queue->empty();
-        },
-        &submission_queue_));
     if (!submission_queue_.empty()) {
       // Run all ready submissions (this may be called many times).
       submission_mutex_.AssertHeld();
@@ -94,6 +92,12 @@ void AsyncCommandQueue::ThreadMain() {
       is_exiting = true;
     }
     submission_mutex_.Unlock();
+
+    if (!is_exiting) {
+      // Block until new work arrives or a semaphore that pending batches may be
+      // waiting on changes state.
+      HostSubmissionQueue::AwaitEpochChange(epoch);
+    }
   }
 }
 
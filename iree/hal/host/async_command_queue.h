@@ -29,8 +29,11 @@ namespace hal {
 
 // Asynchronous command queue wrapper.
 // This creates a single thread to perform all CommandQueue operations. Any
-// submitted CommandBuffer is dispatched in FIFO order on the queue thread
-// against the provided |target_queue|.
+// submitted CommandBuffer is dispatched on the queue thread against the
+// provided |target_queue| once the semaphores it waits on are signaled; batches
+// without pending dependencies run in submission order while batches waiting
+// on timeline semaphores run as soon as the payloads are reached (whether by
+// this queue, another queue, or the host).
 //
 // Target queues will receive submissions containing only command buffers as
 // all semaphore synchronization is handled by the wrapper. Fences will also be
@@ -227,6 +227,56 @@ TEST_F(AsyncCommandQueueTest, FailuresCascadeAcrossSubmits) {
   EXPECT_TRUE(IsDataLoss(command_queue->WaitIdle()));
 }
 
+// Tests that batches waiting on a timeline semaphore run once it is signaled
+// from the host and that work signaled by another queue unblocks this one.
+TEST_F(AsyncCommandQueueTest, TimelineSemaphores) {
+  EXPECT_CALL(*mock_target_queue, Submit(_, _))
+      .WillRepeatedly(
+          [](absl::Span<const SubmissionBatch> batches, FenceValue fence) {
+            return OkStatus();
+          });
+  auto other_mock_queue = absl::make_unique<MockCommandQueue>(
+      "mock", CommandCategory::kTransfer | CommandCategory::kDispatch);
+  EXPECT_CALL(*other_mock_queue, Submit(_, _))
+      .WillRepeatedly(
+          [](absl::Span<const SubmissionBatch> batches, FenceValue fence) {
+            return OkStatus();
+          });
+  std::unique_ptr<CommandQueue> other_command_queue =
+      absl::make_unique<AsyncCommandQueue>(std::move(other_mock_queue));
+
+  auto cmd_buffer_0 = make_ref<MockCommandBuffer>(
+      nullptr, CommandBufferMode::kOneShot, CommandCategory::kTransfer);
+  auto cmd_buffer_1 = make_ref<MockCommandBuffer>(
+      nullptr, CommandBufferMode::kOneShot, CommandCategory::kTransfer);
+
+  HostTimelineSemaphore semaphore(0u);
+  SemaphoreValue host_value = std::make_pair(
+      static_cast<TimelineSemaphore*>(&semaphore), static_cast<uint64_t>(1));
+  SemaphoreValue queue_value = std::make_pair(
+      static_cast<TimelineSemaphore*>(&semaphore), static_cast<uint64_t>(2));
+
+  // Queue 0 waits on the value produced by queue 1, which itself waits on the
+  // host.
+  HostFence fence_0(0u);
+  ASSERT_OK(command_queue->Submit({{queue_value}, {cmd_buffer_0.get()}, {}},
+                                  {&fence_0, 1u}));
+  HostFence fence_1(0u);
+  ASSERT_OK(other_command_queue->Submit(
+      {{host_value}, {cmd_buffer_1.get()}, {queue_value}}, {&fence_1, 1u}));
+
+  EXPECT_TRUE(IsDeadlineExceeded(HostFence::WaitForFences(
+      {{&fence_0, 1u}}, /*wait_all=*/true,
+      absl::Now() + absl::Milliseconds(50))));
+
+  ASSERT_OK(semaphore.Signal(1u));
+  ASSERT_OK(HostFence::WaitForFences({{&fence_0, 1u}, {&fence_1, 1u}},
+                                     /*wait_all=*/true,
+                                     absl::InfiniteFuture()));
+  ASSERT_OK_AND_ASSIGN(uint64_t value, semaphore.Query());
+  EXPECT_EQ(2u, value);
+}
+
 }  // namespace
 }  // namespace hal
 }  // namespace iree
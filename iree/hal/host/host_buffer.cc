@@ -17,6 +17,7 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <utility>
 
 #include "iree/base/logging.h"
 #include "iree/base/source_location.h"
@@ -36,11 +37,23 @@ HostBuffer::HostBuffer(Allocator* allocator, MemoryTypeBitfield memory_type,
       data_(data),
       owns_data_(owns_data) {}
 
+HostBuffer::HostBuffer(Allocator* allocator, MemoryTypeBitfield memory_type,
+                       MemoryAccessBitfield allowed_access,
+                       BufferUsageBitfield usage, device_size_t allocation_size,
+                       void* data, std::function<void()> release_fn)
+    : Buffer(allocator, memory_type, allowed_access, usage, allocation_size, 0,
+             allocation_size),
+      data_(data),
+      release_fn_(std::move(release_fn)) {}
+
 HostBuffer::~HostBuffer() {
   if (owns_data_ && data_) {
     std::free(data_);
     data_ = nullptr;
   }
+  if (release_fn_) {
+    release_fn_();
+  }
 }
 
 Status HostBuffer::FillImpl(device_size_t byte_offset,
@@ -16,6 +16,7 @@
 #define IREE_HAL_HOST_BUFFER_H_
 
 #include <cstdint>
+#include <functional>
 
 #include "iree/base/status.h"
 #include "iree/hal/buffer.h"
@@ -32,6 +33,13 @@ class HostBuffer : public Buffer {
              MemoryAccessBitfield allowed_access, BufferUsageBitfield usage,
              device_size_t allocation_size, void* data, bool owns_data);
 
+  // Wraps |data| without taking ownership and calls |release_fn| when the
+  // buffer is destroyed so that the owner may release the memory.
+  HostBuffer(Allocator* allocator, MemoryTypeBitfield memory_type,
+             MemoryAccessBitfield allowed_access, BufferUsageBitfield usage,
+             device_size_t allocation_size, void* data,
+             std::function<void()> release_fn);
+
   ~HostBuffer() override;
 
  protected:
@@ -59,6 +67,7 @@ class HostBuffer : public Buffer {
  private:
   void* data_ = nullptr;
   bool owns_data_ = false;
+  std::function<void()> release_fn_;
 };
 
 }  // namespace hal
@@ -14,8 +14,10 @@
 
 #include "iree/hal/host/host_fence.h"
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
+#include <utility>
 
 #include "absl/container/inlined_vector.h"
 #include "absl/synchronization/mutex.h"
@@ -25,6 +27,44 @@
 namespace iree {
 namespace hal {
 
+namespace {
+
+#if defined(IREE_PLATFORM_WINDOWS)
+// Without WaitHandles any-waiters block on a single process-wide condvar that
+// is notified whenever any host fence is signaled or fails.
+struct FenceChangeNotifier {
+  absl::Mutex mutex;
+  absl::CondVar cond_var;
+};
+
+FenceChangeNotifier* fence_change_notifier() {
+  static auto* notifier = new FenceChangeNotifier();
+  return notifier;
+}
+
+void NotifyFenceChanged() {
+  auto* notifier = fence_change_notifier();
+  absl::MutexLock lock(&notifier->mutex);
+  notifier->cond_var.SignalAll();
+}
+#endif  // IREE_PLATFORM_WINDOWS
+
+// Returns the index of the first fence that has reached its value or -1 if none
+// have. Returns the failure status of the first failed fence encountered.
+StatusOr<int> QueryAnyFence(absl::Span<const FenceValue> fences) {
+  for (int i = 0; i < static_cast<int>(fences.size()); ++i) {
+    ASSIGN_OR_RETURN(uint64_t current_value, fences[i].first->QueryValue());
+    if (current_value == UINT64_MAX) {
+      return fences[i].first->status();
+    } else if (current_value >= fences[i].second) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+}  // namespace
+
 HostFence::HostFence(uint64_t initial_value) : value_(initial_value) {}
 
 HostFence::~HostFence() = default;
@@ -39,29 +79,95 @@ StatusOr<uint64_t> HostFence::QueryValue() {
 }
 
 Status HostFence::Signal(uint64_t value) {
-  absl::MutexLock lock(&mutex_);
-  if (!status_.ok()) {
-    return status_;
+#if !defined(IREE_PLATFORM_WINDOWS)
+  absl::InlinedVector<ref_ptr<ManualResetEvent>, 4> reached_events;
+#endif  // !IREE_PLATFORM_WINDOWS
+  {
+    absl::MutexLock lock(&mutex_);
+    if (!status_.ok()) {
+      return status_;
+    }
+    if (value_.exchange(value) >= value) {
+      return InvalidArgumentErrorBuilder(IREE_LOC)
+             << "Fence values must be monotonically increasing";
+    }
+#if !defined(IREE_PLATFORM_WINDOWS)
+    auto it = value_events_.begin();
+    while (it != value_events_.end() && it->first <= value) {
+      reached_events.push_back(std::move(it->second));
+      ++it;
+    }
+    value_events_.erase(value_events_.begin(), it);
+#endif  // !IREE_PLATFORM_WINDOWS
   }
-  if (value_.exchange(value) >= value) {
-    return InvalidArgumentErrorBuilder(IREE_LOC)
-           << "Fence values must be monotonically increasing";
+
+#if defined(IREE_PLATFORM_WINDOWS)
+  NotifyFenceChanged();
+#else
+  // Wake fd waiters outside of the lock; they'll recheck the value anyway.
+  for (auto& event : reached_events) {
+    RETURN_IF_ERROR(event->Set());
   }
+#endif  // IREE_PLATFORM_WINDOWS
   return OkStatus();
 }
 
 Status HostFence::Fail(Status status) {
-  absl::MutexLock lock(&mutex_);
-  status_ = status;
-  value_.store(UINT64_MAX, std::memory_order_release);
+#if defined(IREE_PLATFORM_WINDOWS)
+  {
+    absl::MutexLock lock(&mutex_);
+    status_ = status;
+    value_.store(UINT64_MAX, std::memory_order_release);
+  }
+  NotifyFenceChanged();
+#else
+  absl::InlinedVector<std::pair<uint64_t, ref_ptr<ManualResetEvent>>, 4>
+      pending_events;
+  {
+    absl::MutexLock lock(&mutex_);
+    status_ = status;
+    value_.store(UINT64_MAX, std::memory_order_release);
+    std::swap(pending_events, value_events_);
+  }
+
+  // All waiters are woken so that they can observe the failure.
+  for (auto& value_event : pending_events) {
+    RETURN_IF_ERROR(value_event.second->Set());
+  }
+#endif  // IREE_PLATFORM_WINDOWS
   return OkStatus();
 }
 
+#if !defined(IREE_PLATFORM_WINDOWS)
+WaitHandle HostFence::OnValue(uint64_t value) {
+  absl::MutexLock lock(&mutex_);
+  if (value_.load(std::memory_order_acquire) >= value) {
+    return WaitHandle::AlwaysSignaling();
+  }
+
+  // Coalesce waiters on the same value into a single event.
+  auto it = std::lower_bound(
+      value_events_.begin(), value_events_.end(), value,
+      [](const std::pair<uint64_t, ref_ptr<ManualResetEvent>>& value_event,
+         uint64_t value) { return value_event.first < value; });
+  if (it == value_events_.end() || it->first != value) {
+    it = value_events_.insert(
+        it, std::make_pair(value, make_ref<ManualResetEvent>("HostFence")));
+  }
+  return it->second->OnSet();
+}
+#endif  // !IREE_PLATFORM_WINDOWS
+
 // static
 Status HostFence::WaitForFences(absl::Span<const FenceValue> fences,
                                 bool wait_all, absl::Time deadline) {
   IREE_TRACE_SCOPE0("HostFence::WaitForFences");
 
+  if (!wait_all) {
+    if (fences.empty()) return OkStatus();
+    return WaitAnyFence(fences, deadline).status();
+  }
+
   // Some of the fences may already be signaled; we only need to wait for those
   // that are not yet at the expected value.
   using HostFenceValue = std::pair<HostFence*, uint64_t>;
@@ -83,7 +189,6 @@ Status HostFence::WaitForFences(absl::Span<const FenceValue> fences,
   // multiple values from the same fence.
 
   // Loop over the fences and wait for them to complete.
-  // TODO(b/140026716): add WaitHandle support for !wait_all (wait any).
   for (auto& fence_value : waitable_fences) {
     auto* fence = fence_value.first;
     absl::MutexLock lock(&fence->mutex_);
@@ -106,5 +211,61 @@ Status HostFence::WaitForFences(absl::Span<const FenceValue> fences,
   return OkStatus();
 }
 
+// static
+StatusOr<int> HostFence::WaitAnyFence(absl::Span<const FenceValue> fences,
+                                      absl::Time deadline) {
+  IREE_TRACE_SCOPE0("HostFence::WaitAnyFence");
+
+  if (fences.empty()) {
+    return InvalidArgumentErrorBuilder(IREE_LOC)
+           << "At least one fence is required for WaitAnyFence";
+  }
+
+  // Try to satisfy the wait without blocking.
+  ASSIGN_OR_RETURN(int signaled_index, QueryAnyFence(fences));
+  if (signaled_index != -1) {
+    return signaled_index;
+  } else if (deadline == absl::InfinitePast()) {
+    return DeadlineExceededErrorBuilder(IREE_LOC)
+           << "Deadline exceeded waiting for fences";
+  }
+
+#if defined(IREE_PLATFORM_WINDOWS)
+  // Fences notify only after updating their value so rechecking under the
+  // notifier lock cannot miss a wakeup.
+  auto* notifier = fence_change_notifier();
+  absl::MutexLock lock(&notifier->mutex);
+  while (true) {
+    ASSIGN_OR_RETURN(signaled_index, QueryAnyFence(fences));
+    if (signaled_index != -1) {
+      return signaled_index;
+    }
+    if (notifier->cond_var.WaitWithDeadline(&notifier->mutex, deadline)) {
+      return DeadlineExceededErrorBuilder(IREE_LOC)
+             << "Deadline exceeded waiting for fences";
+    }
+  }
+#else
+  // Events are only set once the fence has been updated so any signaled index
+  // is guaranteed to have reached (or failed) by the time WaitAny returns.
+  absl::InlinedVector<WaitHandle, 4> wait_handles;
+  absl::InlinedVector<WaitHandle*, 4> wait_handle_ptrs;
+  wait_handles.reserve(fences.size());
+  wait_handle_ptrs.reserve(fences.size());
+  for (auto& fence_value : fences) {
+    auto* fence = reinterpret_cast<HostFence*>(fence_value.first);
+    wait_handles.push_back(fence->OnValue(fence_value.second));
+    wait_handle_ptrs.push_back(&wait_handles.back());
+  }
+  ASSIGN_OR_RETURN(int index, WaitHandle::WaitAny(wait_handle_ptrs, deadline));
+
+  auto* fence = reinterpret_cast<HostFence*>(fences[index].first);
+  if (fence->value_.load(std::memory_order_acquire) == UINT64_MAX) {
+    return fence->status();
+  }
+  return index;
+#endif  // IREE_PLATFORM_WINDOWS
+}
+
 }  // namespace hal
 }  // namespace iree
@@ -17,18 +17,30 @@
 
 #include <atomic>
 #include <cstdint>
+#include <utility>
 
 #include "absl/base/thread_annotations.h"
+#include "absl/container/inlined_vector.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
+#include "iree/base/ref_ptr.h"
 #include "iree/base/status.h"
+#include "iree/base/target_platform.h"
 #include "iree/hal/fence.h"
 
+#if !defined(IREE_PLATFORM_WINDOWS)
+#include "iree/base/wait_handle.h"
+#endif  // !IREE_PLATFORM_WINDOWS
+
 namespace iree {
 namespace hal {
 
-// TODO(b/140026716): add WaitHandle support for better multi-wait.
 // Simple host-only fence semaphore implemented with a mutex.
+// Waiters that need to multiplex fences with other wait sources can request a
+// WaitHandle for a particular value with OnValue; the handles are backed by
+// fds (eventfd where available) and can be used with WaitHandle::WaitAny or
+// added to an external poll/epoll set. WaitHandles are not yet available on
+// Windows and there OnValue is omitted and WaitAnyFence blocks on a condvar.
 //
 // Thread-safe (as instances may be imported and used by others).
 class HostFence final : public Fence {
@@ -37,6 +49,12 @@ class HostFence final : public Fence {
   static Status WaitForFences(absl::Span<const FenceValue> fences,
                               bool wait_all, absl::Time deadline);
 
+  // Waits for any one of the fences to reach or exceed its given value.
+  // Returns the index of a fence that was signaled. If a fence fails while
+  // waiting its failure status is returned.
+  static StatusOr<int> WaitAnyFence(absl::Span<const FenceValue> fences,
+                                    absl::Time deadline);
+
   explicit HostFence(uint64_t initial_value);
   ~HostFence() override;
 
@@ -46,6 +64,14 @@ class HostFence final : public Fence {
   Status Signal(uint64_t value);
   Status Fail(Status status);
 
+  // Returns a WaitHandle that is signaled once the fence reaches or exceeds
+  // |value| or fails. Waiters on the same value share a single event. Note
+  // that the handle only indicates that the fence may be queried; callers must
+  // check status() to distinguish success from failure.
+#if !defined(IREE_PLATFORM_WINDOWS)
+  WaitHandle OnValue(uint64_t value);
+#endif  // !IREE_PLATFORM_WINDOWS
+
  private:
   // The mutex is not required to query the value; this lets us quickly check if
   // a required value has been exceeded. The mutex is only used to update and
@@ -56,6 +82,13 @@ class HostFence final : public Fence {
   // changes.
   mutable absl::Mutex mutex_;
   Status status_ ABSL_GUARDED_BY(mutex_);
+
+#if !defined(IREE_PLATFORM_WINDOWS)
+  // Events for values that have not yet been reached sorted by ascending value.
+  // Events are set and dropped as soon as the fence reaches their value.
+  absl::InlinedVector<std::pair<uint64_t, ref_ptr<ManualResetEvent>>, 4>
+      value_events_ ABSL_GUARDED_BY(mutex_);
+#endif  // !IREE_PLATFORM_WINDOWS
 };
 
 }  // namespace hal
@@ -20,8 +20,13 @@
 #include "absl/time/time.h"
 #include "iree/base/status.h"
 #include "iree/base/status_matchers.h"
+#include "iree/base/target_platform.h"
 #include "iree/testing/gtest.h"
 
+#if !defined(IREE_PLATFORM_WINDOWS)
+#include "iree/base/wait_handle.h"
+#endif  // !IREE_PLATFORM_WINDOWS
+
 namespace iree {
 namespace hal {
 namespace {
@@ -142,6 +147,113 @@ TEST(HostFenceTest, FailNotifies) {
   ASSERT_TRUE(got_failure);
 }
 
+// Tests waiting for any fence when one has already been signaled.
+TEST(HostFenceTest, WaitAnyAlreadySignaled) {
+  HostFence fence0(1u);
+  HostFence fence1(2u);
+  ASSERT_OK_AND_ASSIGN(int index,
+                       HostFence::WaitAnyFence({{&fence0, 2u}, {&fence1, 2u}},
+                                               absl::InfinitePast()));
+  EXPECT_EQ(1, index);
+  EXPECT_OK(HostFence::WaitForFences({{&fence0, 2u}, {&fence1, 2u}},
+                                     /*wait_all=*/false,
+                                     absl::InfinitePast()));
+  EXPECT_TRUE(IsDeadlineExceeded(HostFence::WaitForFences(
+      {{&fence0, 2u}, {&fence1, 2u}}, /*wait_all=*/true,
+      absl::InfinitePast())));
+}
+
+// Tests waiting for any fence when none have been signaled.
+TEST(HostFenceTest, WaitAnyUnsignaled) {
+  HostFence fence0(1u);
+  HostFence fence1(2u);
+  EXPECT_TRUE(IsDeadlineExceeded(
+      HostFence::WaitAnyFence({{&fence0, 2u}, {&fence1, 3u}},
+                              absl::Now() + absl::Milliseconds(1))
+          .status()));
+}
+
+// Tests that a wait for any fence wakes when another thread signals one.
+TEST(HostFenceTest, WaitAnyWakes) {
+  HostFence fence0(0u);
+  HostFence fence1(0u);
+  std::thread thread([&]() { ASSERT_OK(fence1.Signal(5u)); });
+  ASSERT_OK_AND_ASSIGN(int index,
+                       HostFence::WaitAnyFence({{&fence0, 1u}, {&fence1, 5u}},
+                                               absl::InfiniteFuture()));
+  EXPECT_EQ(1, index);
+  thread.join();
+}
+
+// Tests that a fence failing while waiting for any returns its error.
+TEST(HostFenceTest, WaitAnyFailure) {
+  HostFence fence0(0u);
+  HostFence fence1(0u);
+  std::thread thread(
+      [&]() { ASSERT_OK(fence0.Fail(UnknownErrorBuilder(IREE_LOC))); });
+  EXPECT_TRUE(IsUnknown(HostFence::WaitAnyFence({{&fence0, 1u}, {&fence1, 1u}},
+                                                absl::InfiniteFuture())
+                            .status()));
+  thread.join();
+}
+
+#if !defined(IREE_PLATFORM_WINDOWS)
+
+// Tests that value wait handles are signaled once the value is reached.
+TEST(HostFenceTest, OnValue) {
+  HostFence fence(1u);
+  auto reached_handle = fence.OnValue(1u);
+  ASSERT_OK_AND_ASSIGN(bool reached, reached_handle.TryWait());
+  EXPECT_TRUE(reached);
+
+  auto pending_handle0 = fence.OnValue(2u);
+  auto pending_handle1 = fence.OnValue(3u);
+  ASSERT_OK_AND_ASSIGN(bool signaled, pending_handle0.TryWait());
+  EXPECT_FALSE(signaled);
+  ASSERT_OK(fence.Signal(2u));
+  EXPECT_OK(pending_handle0.Wait(absl::InfinitePast()));
+  ASSERT_OK_AND_ASSIGN(signaled, pending_handle1.TryWait());
+  EXPECT_FALSE(signaled);
+  ASSERT_OK(fence.Signal(10u));
+  EXPECT_OK(pending_handle1.Wait(absl::InfinitePast()));
+}
+
+// Tests that waiters on the same value share an event.
+TEST(HostFenceTest, OnValueCoalesced) {
+  HostFence fence(0u);
+  auto handle0 = fence.OnValue(4u);
+  auto handle1 = fence.OnValue(4u);
+  auto handle2 = fence.OnValue(5u);
+  EXPECT_EQ(handle0.object(), handle1.object());
+  EXPECT_NE(handle0.object(), handle2.object());
+  EXPECT_NE(handle0.unique_id(), handle1.unique_id());
+}
+
+// Tests that value wait handles can be multiplexed with other handles.
+TEST(HostFenceTest, OnValueWaitAny) {
+  HostFence fence(0u);
+  ManualResetEvent event;
+  auto fence_handle = fence.OnValue(1u);
+  auto event_handle = event.OnSet();
+  std::thread thread([&]() { ASSERT_OK(fence.Signal(1u)); });
+  ASSERT_OK_AND_ASSIGN(
+      int index, WaitHandle::WaitAny({&event_handle, &fence_handle},
+                                     absl::InfiniteFuture()));
+  EXPECT_EQ(1, index);
+  thread.join();
+}
+
+// Tests that value wait handles are signaled when the fence fails.
+TEST(HostFenceTest, OnValueFailure) {
+  HostFence fence(0u);
+  auto handle = fence.OnValue(1u);
+  ASSERT_OK(fence.Fail(UnknownErrorBuilder(IREE_LOC)));
+  EXPECT_OK(handle.Wait(absl::InfinitePast()));
+  EXPECT_TRUE(IsUnknown(fence.status()));
+}
+
+#endif  // !IREE_PLATFORM_WINDOWS
+
 }  // namespace
 }  // namespace hal
 }  // namespace iree
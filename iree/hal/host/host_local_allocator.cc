@@ -14,10 +14,18 @@
 
 #include "iree/hal/host/host_local_allocator.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstdlib>
+#include <cstring>
 #include <string>
 #include <utility>
+#include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "iree/base/source_location.h"
 #include "iree/base/status.h"
 #include "iree/base/tracing.h"
@@ -26,7 +34,368 @@
 namespace iree {
 namespace hal {
 
-HostLocalAllocator::HostLocalAllocator() = default;
+namespace {
+
+// Smallest size class; all allocations are at least this large.
+constexpr size_t kMinPooledSize = 64;
+
+// Four size classes per power of two from kMinPooledSize to kMaxPooledSize.
+constexpr int kSizeClassCount = 81;
+
+int CountLeadingZeros(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_clzll(value);
+#else
+  int count = 0;
+  for (uint64_t bit = 1ull << 63; bit && !(value & bit); bit >>= 1) ++count;
+  return count;
+#endif  // __GNUC__ || __clang__
+}
+
+// Returns the size class that |allocation_size| rounds up to, or -1 if the
+// size is too large to be pooled.
+int SizeClassForSize(size_t allocation_size) {
+  if (allocation_size <= kMinPooledSize) return 0;
+  if (allocation_size > HostLocalAllocator::kMaxPooledSize) return -1;
+  // Sizes in (2^log2, 2^(log2+1)] are split into four classes.
+  int log2 = 63 - CountLeadingZeros(allocation_size - 1);
+  int shift = log2 - 2;
+  size_t step_count = (allocation_size + (size_t{1} << shift) - 1) >> shift;
+  return 1 + (log2 - 6) * 4 + static_cast<int>(step_count - 5);
+}
+
+size_t SizeForSizeClass(int size_class) {
+  if (size_class == 0) return kMinPooledSize;
+  int log2 = 6 + (size_class - 1) / 4;
+  size_t step_count = 5 + (size_class - 1) % 4;
+  return step_count << (log2 - 2);
+}
+
+}  // namespace
+
+// Shared pool state. Kept alive by the allocator and by each outstanding
+// pooled buffer.
+class HostLocalAllocator::Pool {
+ public:
+  class PooledBuffer;
+
+  explicit Pool(Options options) : options_(options) {}
+
+  ~Pool();
+
+  const Options& options() const { return options_; }
+
+  // Returns a block of |size_class| that is at least |allocation_size| bytes,
+  // zeroed if required by the allocation mode.
+  void* Acquire(int size_class, size_t allocation_size);
+
+  // Returns |block| to the pool.
+  void Release(void* block, int size_class);
+
+  Stats stats() const;
+  void Trim();
+
+ private:
+  // Free blocks of this pool cached by one thread. Shared between the thread
+  // and the pool so that neither keeps the other alive: the thread returns the
+  // blocks to the pool when it exits and the pool frees them if it is
+  // destroyed first. The mutex is only contended when the pool is trimmed or
+  // destroyed and must be acquired before the pool mutex.
+  struct ThreadCache {
+    absl::Mutex mutex;
+    // Null once the pool has been destroyed or the thread has exited.
+    Pool* pool ABSL_GUARDED_BY(mutex) = nullptr;
+    std::array<std::vector<void*>, kSizeClassCount> blocks
+        ABSL_GUARDED_BY(mutex);
+  };
+  class ThreadCacheList;
+
+  // Returns the cache of the calling thread for this pool, creating it on
+  // first use.
+  ThreadCache* thread_cache();
+  // Moves all blocks in |cache| into the shared free lists.
+  void FlushThreadCache(ThreadCache* cache)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(cache->mutex);
+  // Flushes |cache| and unregisters it from the pool.
+  void DetachThreadCache(ThreadCache* cache)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(cache->mutex);
+
+  void AddInUse(size_t size);
+  // Moves blocks into the shared free lists (or frees them if over budget).
+  void ReleaseShared(absl::Span<void* const> blocks, int size_class);
+
+  static std::atomic<uint64_t> next_id_;
+  // Unique for the lifetime of the process so that thread caches of destroyed
+  // pools are never mistaken for those of new pools at the same address.
+  const uint64_t id_ = next_id_++;
+  const Options options_;
+
+  std::atomic<int64_t> allocation_count_{0};
+  std::atomic<int64_t> pool_hit_count_{0};
+  std::atomic<size_t> bytes_in_use_{0};
+  std::atomic<size_t> bytes_cached_{0};
+  std::atomic<size_t> high_water_mark_{0};
+
+  mutable absl::Mutex mutex_;
+  std::array<std::vector<void*>, kSizeClassCount> free_lists_
+      ABSL_GUARDED_BY(mutex_);
+  // Caches of all threads that have used the pool and not yet exited.
+  std::vector<std::shared_ptr<ThreadCache>> thread_caches_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+// static
+std::atomic<uint64_t> HostLocalAllocator::Pool::next_id_{0};
+
+// The caches of the calling thread for each live pool it has used.
+class HostLocalAllocator::Pool::ThreadCacheList {
+ public:
+  static ThreadCacheList* Get() {
+    static thread_local ThreadCacheList list;
+    return &list;
+  }
+
+  ~ThreadCacheList() {
+    for (auto& entry : entries_) {
+      absl::MutexLock lock(&entry.cache->mutex);
+      if (entry.cache->pool) {
+        entry.cache->pool->DetachThreadCache(entry.cache.get());
+      }
+    }
+  }
+
+  ThreadCache* Find(uint64_t pool_id) {
+    for (auto& entry : entries_) {
+      if (entry.pool_id == pool_id) return entry.cache.get();
+    }
+    return nullptr;
+  }
+
+  void Add(uint64_t pool_id, std::shared_ptr<ThreadCache> cache) {
+    // Drop the caches of destroyed pools.
+    entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+                                  [](const Entry& entry) {
+                                    absl::MutexLock lock(&entry.cache->mutex);
+                                    return entry.cache->pool == nullptr;
+                                  }),
+                   entries_.end());
+    entries_.push_back({pool_id, std::move(cache)});
+  }
+
+ private:
+  struct Entry {
+    uint64_t pool_id;
+    std::shared_ptr<ThreadCache> cache;
+  };
+  std::vector<Entry> entries_;
+};
+
+HostLocalAllocator::Pool::~Pool() {
+  // Threads that are still running hold caches that can no longer be returned.
+  std::vector<std::shared_ptr<ThreadCache>> thread_caches;
+  {
+    absl::MutexLock lock(&mutex_);
+    thread_caches.swap(thread_caches_);
+  }
+  for (auto& cache : thread_caches) {
+    absl::MutexLock lock(&cache->mutex);
+    // A thread exiting concurrently may have already detached the cache.
+    if (!cache->pool) continue;
+    for (auto& blocks : cache->blocks) {
+      for (void* block : blocks) std::free(block);
+      blocks.clear();
+    }
+    cache->pool = nullptr;
+  }
+
+  absl::MutexLock lock(&mutex_);
+  for (auto& free_list : free_lists_) {
+    for (void* block : free_list) std::free(block);
+  }
+}
+
+HostLocalAllocator::Pool::ThreadCache*
+HostLocalAllocator::Pool::thread_cache() {
+  auto* list = ThreadCacheList::Get();
+  if (auto* cache = list->Find(id_)) return cache;
+  auto cache = std::make_shared<ThreadCache>();
+  {
+    absl::MutexLock lock(&cache->mutex);
+    cache->pool = this;
+  }
+  {
+    absl::MutexLock lock(&mutex_);
+    thread_caches_.push_back(cache);
+  }
+  list->Add(id_, cache);
+  return cache.get();
+}
+
+void HostLocalAllocator::Pool::FlushThreadCache(ThreadCache* cache) {
+  for (int i = 0; i < kSizeClassCount; ++i) {
+    if (cache->blocks[i].empty()) continue;
+    ReleaseShared(cache->blocks[i], i);
+    cache->blocks[i].clear();
+  }
+}
+
+void HostLocalAllocator::Pool::DetachThreadCache(ThreadCache* cache) {
+  FlushThreadCache(cache);
+  cache->pool = nullptr;
+  absl::MutexLock lock(&mutex_);
+  auto it = std::find_if(
+      thread_caches_.begin(), thread_caches_.end(),
+      [cache](const std::shared_ptr<ThreadCache>& thread_cache) {
+        return thread_cache.get() == cache;
+      });
+  if (it != thread_caches_.end()) thread_caches_.erase(it);
+}
+
+void HostLocalAllocator::Pool::AddInUse(size_t size) {
+  size_t in_use = bytes_in_use_.fetch_add(size) + size;
+  size_t high_water_mark = high_water_mark_.load(std::memory_order_relaxed);
+  while (in_use > high_water_mark &&
+         !high_water_mark_.compare_exchange_weak(high_water_mark, in_use)) {
+  }
+}
+
+void* HostLocalAllocator::Pool::Acquire(int size_class,
+                                        size_t allocation_size) {
+  size_t block_size = SizeForSizeClass(size_class);
+  bool zero_contents =
+      options_.allocation_mode & IREE_ALLOCATION_MODE_ZERO_CONTENTS;
+  ++allocation_count_;
+  AddInUse(block_size);
+
+  void* block = nullptr;
+  auto* cache = thread_cache();
+  {
+    absl::MutexLock lock(&cache->mutex);
+    auto& cached_blocks = cache->blocks[size_class];
+    if (!cached_blocks.empty()) {
+      block = cached_blocks.back();
+      cached_blocks.pop_back();
+    }
+  }
+  if (!block) {
+    absl::MutexLock lock(&mutex_);
+    auto& free_list = free_lists_[size_class];
+    if (!free_list.empty()) {
+      block = free_list.back();
+      free_list.pop_back();
+    }
+  }
+
+  if (block) {
+    ++pool_hit_count_;
+    bytes_cached_ -= block_size;
+    if (zero_contents) std::memset(block, 0, allocation_size);
+    return block;
+  }
+
+  // Fresh memory from calloc may already be zeroed by the system.
+  block = zero_contents ? std::calloc(1, block_size) : std::malloc(block_size);
+  if (!block) bytes_in_use_ -= block_size;
+  return block;
+}
+
+void HostLocalAllocator::Pool::Release(void* block, int size_class) {
+  size_t block_size = SizeForSizeClass(size_class);
+  bytes_in_use_ -= block_size;
+  bytes_cached_ += block_size;
+
+  auto* cache = thread_cache();
+  absl::MutexLock lock(&cache->mutex);
+  auto& cached_blocks = cache->blocks[size_class];
+  if (cached_blocks.size() <
+      static_cast<size_t>(options_.thread_cache_block_count)) {
+    cached_blocks.push_back(block);
+    return;
+  }
+  ReleaseShared({&block, 1}, size_class);
+}
+
+void HostLocalAllocator::Pool::ReleaseShared(absl::Span<void* const> blocks,
+                                             int size_class) {
+  size_t block_size = SizeForSizeClass(size_class);
+  absl::MutexLock lock(&mutex_);
+  for (void* block : blocks) {
+    if (bytes_cached_.load() > options_.max_cached_bytes) {
+      bytes_cached_ -= block_size;
+      std::free(block);
+    } else {
+      free_lists_[size_class].push_back(block);
+    }
+  }
+}
+
+HostLocalAllocator::Stats HostLocalAllocator::Pool::stats() const {
+  Stats stats;
+  stats.allocation_count = allocation_count_.load();
+  stats.pool_hit_count = pool_hit_count_.load();
+  stats.bytes_in_use = bytes_in_use_.load();
+  stats.bytes_cached = bytes_cached_.load();
+  stats.high_water_mark = high_water_mark_.load();
+  return stats;
+}
+
+void HostLocalAllocator::Pool::Trim() {
+  IREE_TRACE_SCOPE0("HostLocalAllocator::Trim");
+
+  // Return the blocks cached by each thread so that they can be trimmed too.
+  std::vector<std::shared_ptr<ThreadCache>> thread_caches;
+  {
+    absl::MutexLock lock(&mutex_);
+    thread_caches = thread_caches_;
+  }
+  for (auto& cache : thread_caches) {
+    absl::MutexLock lock(&cache->mutex);
+    if (cache->pool) FlushThreadCache(cache.get());
+  }
+
+  // Retain enough to grow back to the high-water mark without allocating.
+  size_t in_use = bytes_in_use_.load();
+  size_t high_water_mark = high_water_mark_.exchange(in_use);
+  size_t target_cached_bytes =
+      high_water_mark > in_use ? high_water_mark - in_use : 0;
+
+  // Release the largest blocks first as they are the least likely to fit.
+  absl::MutexLock lock(&mutex_);
+  for (int i = kSizeClassCount - 1; i >= 0; --i) {
+    size_t block_size = SizeForSizeClass(i);
+    auto& free_list = free_lists_[i];
+    while (!free_list.empty() && bytes_cached_.load() > target_cached_bytes) {
+      std::free(free_list.back());
+      free_list.pop_back();
+      bytes_cached_ -= block_size;
+    }
+  }
+}
+
+// A host buffer whose memory is returned to the pool when released.
+class HostLocalAllocator::Pool::PooledBuffer final : public HostBuffer {
+ public:
+  PooledBuffer(Allocator* allocator, MemoryTypeBitfield memory_type,
+               BufferUsageBitfield usage, device_size_t allocation_size,
+               std::shared_ptr<Pool> pool, int size_class, void* block)
+      : HostBuffer(allocator, memory_type, MemoryAccess::kAll, usage,
+                   allocation_size, block, /*owns_data=*/false),
+        pool_(std::move(pool)),
+        size_class_(size_class),
+        block_(block) {}
+
+  ~PooledBuffer() override { pool_->Release(block_, size_class_); }
+
+ private:
+  std::shared_ptr<Pool> pool_;
+  int size_class_;
+  void* block_;
+};
+
+HostLocalAllocator::HostLocalAllocator() : HostLocalAllocator(Options{}) {}
+
+HostLocalAllocator::HostLocalAllocator(Options options)
+    : pool_(std::make_shared<Pool>(options)) {}
 
 HostLocalAllocator::~HostLocalAllocator() = default;
 
@@ -95,17 +464,64 @@ StatusOr<ref_ptr<Buffer>> HostLocalAllocator::Allocate(
   // Make compatible with our requirements.
   RETURN_IF_ERROR(MakeCompatible(&memory_type, &buffer_usage));
 
-  void* malloced_data = std::calloc(1, allocation_size);
-  if (!malloced_data) {
+  int size_class = SizeClassForSize(allocation_size);
+  if (size_class < 0) {
+    // Too large to pool; allocate directly.
+    bool zero_contents =
+        pool_->options().allocation_mode & IREE_ALLOCATION_MODE_ZERO_CONTENTS;
+    void* malloced_data = zero_contents ? std::calloc(1, allocation_size)
+                                        : std::malloc(allocation_size);
+    if (!malloced_data) {
+      return ResourceExhaustedErrorBuilder(IREE_LOC)
+             << "Failed to malloc " << allocation_size << " bytes";
+    }
+    return make_ref<HostBuffer>(this, memory_type, MemoryAccess::kAll,
+                                buffer_usage, allocation_size, malloced_data,
+                                /*owns_data=*/true);
+  }
+
+  void* block = pool_->Acquire(size_class, allocation_size);
+  if (!block) {
     return ResourceExhaustedErrorBuilder(IREE_LOC)
-           << "Failed to malloc " << allocation_size << " bytes";
+           << "Failed to malloc " << SizeForSizeClass(size_class) << " bytes";
+  }
+  return make_ref<Pool::PooledBuffer>(this, memory_type, buffer_usage,
+                                      allocation_size, pool_, size_class,
+                                      block);
+}
+
+StatusOr<ref_ptr<Buffer>> HostLocalAllocator::WrapMutable(
+    MemoryTypeBitfield memory_type, MemoryAccessBitfield allowed_access,
+    BufferUsageBitfield buffer_usage, void* data, size_t data_length) {
+  return WrapMutableWithRelease(memory_type, allowed_access, buffer_usage, data,
+                                data_length, nullptr);
+}
+
+StatusOr<ref_ptr<Buffer>> HostLocalAllocator::WrapMutableWithRelease(
+    MemoryTypeBitfield memory_type, MemoryAccessBitfield allowed_access,
+    BufferUsageBitfield buffer_usage, void* data, size_t data_length,
+    std::function<void()> release_fn) {
+  IREE_TRACE_SCOPE0("HostLocalAllocator::WrapMutable");
+
+  if (!CanAllocate(memory_type, buffer_usage, data_length)) {
+    return FailedPreconditionErrorBuilder(IREE_LOC)
+           << "Wrapping not supported; memory_type="
+           << MemoryTypeString(memory_type)
+           << ", buffer_usage=" << BufferUsageString(buffer_usage);
   }
 
-  auto buffer =
-      make_ref<HostBuffer>(this, memory_type, MemoryAccess::kAll, buffer_usage,
-                           allocation_size, malloced_data, true);
-  return buffer;
+  // Make compatible with our requirements.
+  RETURN_IF_ERROR(MakeCompatible(&memory_type, &buffer_usage));
+
+  return make_ref<HostBuffer>(this, memory_type, allowed_access, buffer_usage,
+                              data_length, data, std::move(release_fn));
 }
 
+HostLocalAllocator::Stats HostLocalAllocator::stats() const {
+  return pool_->stats();
+}
+
+void HostLocalAllocator::Trim() { pool_->Trim(); }
+
 }  // namespace hal
 }  // namespace iree
@@ -16,8 +16,11 @@
 #define IREE_HAL_HOST_LOCAL_ALLOCATOR_H_
 
 #include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
 
+#include "iree/base/api.h"
 #include "iree/base/status.h"
 #include "iree/hal/allocator.h"
 #include "iree/hal/buffer.h"
@@ -25,16 +28,57 @@
 namespace iree {
 namespace hal {
 
-// An allocator implementation that allocates buffers from host memory.
-// This can be used for drivers that do not have a memory space of their own.
+// An allocator for host-local buffers that recycles memory through size-class
+// pools.
 //
-// Buffers allocated will have be MemoryType::kHostLocal | kDeviceVisible as
-// the 'device' in the case of a host-local queue *is* the host. To keep code
-// written initially for a host-local queue working when other queues are used
-// the allocator only works with buffers that are kDeviceVisible.
+// Allocation sizes are rounded up to one of a fixed set of size classes (four
+// per power of two, bounding waste to 25%) and released buffers return their
+// memory to a free list for that class. Steady-state workloads that allocate
+// the same sizes on every invocation are then served without touching the
+// system allocator. Each thread keeps a small cache of blocks per size class
+// for each allocator it uses to avoid contention on the shared free lists.
+// Allocations larger than kMaxPooledSize bypass the pools.
+//
+// Buffers may outlive the allocator; the pools, including the blocks cached by
+// each thread, are freed once the allocator and all buffers allocated from it
+// have been released. Thread caches do not keep the pools alive.
+//
+// Thread-safe.
 class HostLocalAllocator : public Allocator {
  public:
+  // Largest allocation size served from the pools.
+  static constexpr size_t kMaxPooledSize = 64 * 1024 * 1024;
+
+  struct Options {
+    // IREE_ALLOCATION_MODE_ZERO_CONTENTS zeros the contents of all buffers
+    // prior to returning them. Without it recycled memory is returned with
+    // undefined contents and callers must fully initialize it.
+    iree_allocation_mode_t allocation_mode = IREE_ALLOCATION_MODE_ZERO_CONTENTS;
+
+    // Maximum total bytes of free memory retained by the pools. Memory released
+    // beyond this is returned to the system immediately.
+    size_t max_cached_bytes = 256 * 1024 * 1024;
+
+    // Maximum number of free blocks of each size class cached per thread for
+    // this allocator.
+    int thread_cache_block_count = 4;
+  };
+
+  struct Stats {
+    // Total number of pooled allocations made.
+    int64_t allocation_count = 0;
+    // Number of allocations served from recycled memory.
+    int64_t pool_hit_count = 0;
+    // Bytes held by live buffers (rounded up to their size class).
+    size_t bytes_in_use = 0;
+    // Bytes of free memory retained by the pools (including thread caches).
+    size_t bytes_cached = 0;
+    // Peak bytes_in_use since creation or the last Trim.
+    size_t high_water_mark = 0;
+  };
+
   HostLocalAllocator();
+  explicit HostLocalAllocator(Options options);
   ~HostLocalAllocator() override;
 
   bool CanUseBufferLike(Allocator* source_allocator,
@@ -52,6 +96,33 @@ class HostLocalAllocator : public Allocator {
   StatusOr<ref_ptr<Buffer>> Allocate(MemoryTypeBitfield memory_type,
                                      BufferUsageBitfield buffer_usage,
                                      size_t allocation_size) override;
+
+  // Wrapped host memory is used in-place by the host executables and never
+  // enters the pools.
+  StatusOr<ref_ptr<Buffer>> WrapMutable(MemoryTypeBitfield memory_type,
+                                        MemoryAccessBitfield allowed_access,
+                                        BufferUsageBitfield buffer_usage,
+                                        void* data,
+                                        size_t data_length) override;
+  StatusOr<ref_ptr<Buffer>> WrapMutableWithRelease(
+      MemoryTypeBitfield memory_type, MemoryAccessBitfield allowed_access,
+      BufferUsageBitfield buffer_usage, void* data, size_t data_length,
+      std::function<void()> release_fn) override;
+
+  // Returns a snapshot of the allocator statistics.
+  Stats stats() const;
+
+  // Releases cached memory not required to satisfy the peak usage observed
+  // since the last trim (the high-water mark) and resets the mark. Calling this
+  // periodically (such as between inference requests) allows the pools to
+  // shrink after a transient spike while retaining enough memory for the
+  // steady state. Blocks cached by all threads are returned to the pools first
+  // so that they can be released too.
+  void Trim();
+
+ private:
+  class Pool;
+  std::shared_ptr<Pool> pool_;
 };
 
 }  // namespace hal
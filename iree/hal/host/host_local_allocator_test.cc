@@ -0,0 +1,268 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/hal/host/host_local_allocator.h"
+
+#include <cstdint>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/synchronization/notification.h"
+#include "iree/base/status.h"
+#include "iree/base/status_matchers.h"
+#include "iree/testing/gtest.h"
+
+namespace iree {
+namespace hal {
+namespace {
+
+const MemoryTypeBitfield kMemoryType =
+    MemoryType::kHostLocal | MemoryType::kDeviceVisible;
+const BufferUsageBitfield kBufferUsage = BufferUsage::kAll;
+
+// Returns the first |length| bytes of |buffer|.
+std::vector<uint8_t> ReadContents(Buffer* buffer, size_t length) {
+  std::vector<uint8_t> contents(length);
+  CHECK_OK(buffer->ReadData(0, contents.data(), length));
+  return contents;
+}
+
+// Tests that released memory is recycled for allocations of the same size.
+TEST(HostLocalAllocatorTest, RecyclesMemory) {
+  HostLocalAllocator allocator;
+  ASSERT_OK_AND_ASSIGN(auto buffer0,
+                       allocator.Allocate(kMemoryType, kBufferUsage, 1000));
+  EXPECT_EQ(1000, buffer0->byte_length());
+  EXPECT_EQ(1, allocator.stats().allocation_count);
+  EXPECT_EQ(0, allocator.stats().pool_hit_count);
+  EXPECT_EQ(1024, allocator.stats().bytes_in_use);
+  buffer0.reset();
+  EXPECT_EQ(0, allocator.stats().bytes_in_use);
+  EXPECT_EQ(1024, allocator.stats().bytes_cached);
+
+  // Any size in the same size class reuses the block.
+  ASSERT_OK_AND_ASSIGN(auto buffer1,
+                       allocator.Allocate(kMemoryType, kBufferUsage, 900));
+  EXPECT_EQ(900, buffer1->byte_length());
+  EXPECT_EQ(2, allocator.stats().allocation_count);
+  EXPECT_EQ(1, allocator.stats().pool_hit_count);
+  EXPECT_EQ(0, allocator.stats().bytes_cached);
+
+  // Sizes in another class do not.
+  ASSERT_OK_AND_ASSIGN(auto buffer2,
+                       allocator.Allocate(kMemoryType, kBufferUsage, 4000));
+  EXPECT_EQ(1, allocator.stats().pool_hit_count);
+  EXPECT_EQ(1024 + 4096, allocator.stats().bytes_in_use);
+}
+
+// Tests that recycled memory is zeroed when requested.
+TEST(HostLocalAllocatorTest, ZeroContents) {
+  HostLocalAllocator allocator;
+  ASSERT_OK_AND_ASSIGN(auto buffer0,
+                       allocator.Allocate(kMemoryType, kBufferUsage, 128));
+  EXPECT_EQ(std::vector<uint8_t>(128, 0), ReadContents(buffer0.get(), 128));
+  uint8_t pattern = 0xCD;
+  EXPECT_OK(buffer0->Fill8(0, kWholeBuffer, pattern));
+  buffer0.reset();
+
+  ASSERT_OK_AND_ASSIGN(auto buffer1,
+                       allocator.Allocate(kMemoryType, kBufferUsage, 128));
+  EXPECT_EQ(1, allocator.stats().pool_hit_count);
+  EXPECT_EQ(std::vector<uint8_t>(128, 0), ReadContents(buffer1.get(), 128));
+}
+
+// Tests that recycled memory is returned as-is when zeroing is not requested.
+TEST(HostLocalAllocatorTest, NoZeroContents) {
+  HostLocalAllocator::Options options;
+  options.allocation_mode = static_cast<iree_allocation_mode_t>(0);
+  HostLocalAllocator allocator(options);
+  ASSERT_OK_AND_ASSIGN(auto buffer0,
+                       allocator.Allocate(kMemoryType, kBufferUsage, 128));
+  uint8_t pattern = 0xCD;
+  EXPECT_OK(buffer0->Fill8(0, kWholeBuffer, pattern));
+  buffer0.reset();
+
+  ASSERT_OK_AND_ASSIGN(auto buffer1,
+                       allocator.Allocate(kMemoryType, kBufferUsage, 128));
+  EXPECT_EQ(std::vector<uint8_t>(128, pattern),
+            ReadContents(buffer1.get(), 128));
+}
+
+// Tests that allocations too large for the pools are not cached.
+TEST(HostLocalAllocatorTest, LargeAllocationsBypassPool) {
+  HostLocalAllocator allocator;
+  ASSERT_OK_AND_ASSIGN(
+      auto buffer, allocator.Allocate(kMemoryType, kBufferUsage,
+                                      HostLocalAllocator::kMaxPooledSize + 1));
+  EXPECT_EQ(0, allocator.stats().allocation_count);
+  buffer.reset();
+  EXPECT_EQ(0, allocator.stats().bytes_cached);
+}
+
+// Tests that the pools do not retain more than the configured budget.
+TEST(HostLocalAllocatorTest, MaxCachedBytes) {
+  HostLocalAllocator::Options options;
+  options.max_cached_bytes = 4096;
+  options.thread_cache_block_count = 0;
+  HostLocalAllocator allocator(options);
+  std::vector<ref_ptr<Buffer>> buffers;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_OK_AND_ASSIGN(auto buffer,
+                         allocator.Allocate(kMemoryType, kBufferUsage, 2048));
+    buffers.push_back(std::move(buffer));
+  }
+  buffers.clear();
+  EXPECT_EQ(0, allocator.stats().bytes_in_use);
+  EXPECT_LE(allocator.stats().bytes_cached, 4096);
+}
+
+// Tests that trimming retains only what is needed to reach the high-water mark.
+TEST(HostLocalAllocatorTest, Trim) {
+  HostLocalAllocator allocator;
+  std::vector<ref_ptr<Buffer>> buffers;
+  for (int i = 0; i < 8; ++i) {
+    ASSERT_OK_AND_ASSIGN(auto buffer,
+                         allocator.Allocate(kMemoryType, kBufferUsage, 1024));
+    buffers.push_back(std::move(buffer));
+  }
+  EXPECT_EQ(8 * 1024, allocator.stats().high_water_mark);
+  buffers.clear();
+
+  // The peak usage since creation is retained.
+  allocator.Trim();
+  EXPECT_EQ(8 * 1024, allocator.stats().bytes_cached);
+  EXPECT_EQ(0, allocator.stats().high_water_mark);
+
+  // Steady-state usage is now lower so the excess is released.
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_OK_AND_ASSIGN(auto buffer,
+                         allocator.Allocate(kMemoryType, kBufferUsage, 1024));
+    buffers.push_back(std::move(buffer));
+  }
+  buffers.clear();
+  allocator.Trim();
+  EXPECT_EQ(2 * 1024, allocator.stats().bytes_cached);
+  allocator.Trim();
+  EXPECT_EQ(0, allocator.stats().bytes_cached);
+}
+
+// Tests that buffers may be released on other threads and after the allocator.
+TEST(HostLocalAllocatorTest, BufferLifetime) {
+  std::vector<ref_ptr<Buffer>> buffers;
+  {
+    HostLocalAllocator allocator;
+    for (int i = 0; i < 16; ++i) {
+      ASSERT_OK_AND_ASSIGN(auto buffer,
+                           allocator.Allocate(kMemoryType, kBufferUsage, 256));
+      buffers.push_back(std::move(buffer));
+    }
+    std::thread thread([&buffers]() { buffers.resize(8); });
+    thread.join();
+    EXPECT_EQ(8 * 256, allocator.stats().bytes_in_use);
+  }
+  buffers.clear();
+}
+
+// Tests that each allocator has its own thread cache so that alternating
+// between allocators on one thread does not flush them.
+TEST(HostLocalAllocatorTest, ThreadCachePerAllocator) {
+  // Blocks that leave the thread caches are freed immediately.
+  HostLocalAllocator::Options options;
+  options.max_cached_bytes = 0;
+  HostLocalAllocator allocator0(options);
+  HostLocalAllocator allocator1(options);
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_OK_AND_ASSIGN(auto buffer0,
+                         allocator0.Allocate(kMemoryType, kBufferUsage, 128));
+    ASSERT_OK_AND_ASSIGN(auto buffer1,
+                         allocator1.Allocate(kMemoryType, kBufferUsage, 128));
+  }
+  EXPECT_EQ(1, allocator0.stats().pool_hit_count);
+  EXPECT_EQ(1, allocator1.stats().pool_hit_count);
+}
+
+// Tests that trimming releases blocks cached by other threads.
+TEST(HostLocalAllocatorTest, TrimOtherThreadCaches) {
+  HostLocalAllocator allocator;
+  absl::Notification released;
+  absl::Notification trimmed;
+  std::thread thread([&]() {
+    {
+      ASSERT_OK_AND_ASSIGN(auto buffer,
+                           allocator.Allocate(kMemoryType, kBufferUsage, 1024));
+    }
+    released.Notify();
+    trimmed.WaitForNotification();
+  });
+  released.WaitForNotification();
+  EXPECT_EQ(1024, allocator.stats().bytes_cached);
+  allocator.Trim();
+  allocator.Trim();
+  EXPECT_EQ(0, allocator.stats().bytes_cached);
+  trimmed.Notify();
+  thread.join();
+}
+
+// Tests that thread caches do not keep the pools alive and that blocks cached
+// by threads outliving the allocator are freed with it.
+TEST(HostLocalAllocatorTest, ThreadCacheOutlivesAllocator) {
+  auto allocator = absl::make_unique<HostLocalAllocator>();
+  absl::Notification released;
+  absl::Notification destroyed;
+  std::thread thread([&]() {
+    {
+      ASSERT_OK_AND_ASSIGN(
+          auto buffer, allocator->Allocate(kMemoryType, kBufferUsage, 1024));
+    }
+    released.Notify();
+    destroyed.WaitForNotification();
+
+    // A new allocator (possibly at the same address) starts with an empty
+    // cache.
+    HostLocalAllocator new_allocator;
+    ASSERT_OK_AND_ASSIGN(
+        auto buffer, new_allocator.Allocate(kMemoryType, kBufferUsage, 1024));
+    EXPECT_EQ(0, new_allocator.stats().pool_hit_count);
+  });
+  released.WaitForNotification();
+  allocator.reset();
+  destroyed.Notify();
+  thread.join();
+}
+
+// Tests that wrapped host memory is used in-place and released with the buffer.
+TEST(HostLocalAllocatorTest, WrapMutableWithRelease) {
+  HostLocalAllocator allocator;
+  std::vector<uint8_t> data(100, 0xAB);
+  int release_count = 0;
+  ASSERT_OK_AND_ASSIGN(
+      auto buffer, allocator.WrapMutableWithRelease(
+                       kMemoryType, MemoryAccess::kAll, kBufferUsage,
+                       data.data(), data.size(),
+                       [&release_count]() { ++release_count; }));
+  EXPECT_EQ(100, buffer->byte_length());
+  EXPECT_EQ(0, allocator.stats().bytes_in_use);
+  uint8_t pattern = 0xCD;
+  EXPECT_OK(buffer->Fill8(0, 10, pattern));
+  EXPECT_EQ(pattern, data[0]);
+  EXPECT_EQ(0xAB, data[10]);
+  EXPECT_EQ(0, release_count);
+  buffer.reset();
+  EXPECT_EQ(1, release_count);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
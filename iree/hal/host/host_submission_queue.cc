@@ -16,6 +16,7 @@
 
 #include <atomic>
 #include <cstdint>
+#include <utility>
 
 #include "absl/synchronization/mutex.h"
 #include "iree/base/status.h"
@@ -24,6 +25,33 @@
 namespace iree {
 namespace hal {
 
+namespace {
+
+// Process-wide synchronization state shared by all host semaphores and
+// submission queues. absl::Mutex re-evaluates the conditions of all waiters
+// whenever it is released and so any state change made while holding it wakes
+// exactly the waiters whose conditions it may affect.
+struct HostSyncState {
+  absl::Mutex mutex;
+  // Only modified while holding |mutex|; atomic so that conditions may read
+  // it without thread-safety annotations.
+  std::atomic<uint64_t> epoch{0};
+};
+
+HostSyncState* host_sync_state() {
+  static HostSyncState* state = new HostSyncState();
+  return state;
+}
+
+// Advances the epoch to wake any threads waiting for state changes.
+void NotifyStateChanged() {
+  auto* state = host_sync_state();
+  absl::MutexLock lock(&state->mutex);
+  state->epoch.fetch_add(1, std::memory_order_release);
+}
+
+}  // namespace
+
 HostBinarySemaphore::HostBinarySemaphore(bool initial_value) {
   State state = {0};
   state.signaled = initial_value ? 1 : 0;
@@ -58,6 +86,9 @@ Status HostBinarySemaphore::EndSignaling() {
   new_state.signal_pending = 0;
   new_state.signaled = 1;
   state_.compare_exchange_strong(old_state, new_state);
+
+  // Queues waiting on the semaphore may now be able to make progress.
+  NotifyStateChanged();
   return OkStatus();
 }
 
@@ -88,6 +119,127 @@ Status HostBinarySemaphore::EndWaiting() {
   return OkStatus();
 }
 
+// static
+Status HostTimelineSemaphore::WaitAllSemaphores(
+    absl::Span<const SemaphoreValue> semaphores, absl::Time deadline) {
+  IREE_TRACE_SCOPE0("HostTimelineSemaphore::WaitAllSemaphores");
+  auto* state = host_sync_state();
+  absl::MutexLock lock(&state->mutex);
+  if (!state->mutex.AwaitWithDeadline(
+          absl::Condition(
+              +[](absl::Span<const SemaphoreValue>* semaphores) {
+                for (auto& semaphore_value : *semaphores) {
+                  auto* semaphore = reinterpret_cast<HostTimelineSemaphore*>(
+                      semaphore_value.first);
+                  if (!semaphore->IsReached(semaphore_value.second)) {
+                    return false;
+                  }
+                }
+                return true;
+              },
+              &semaphores),
+          deadline)) {
+    return DeadlineExceededErrorBuilder(IREE_LOC)
+           << "Deadline exceeded waiting for semaphores";
+  }
+  for (auto& semaphore_value : semaphores) {
+    auto* semaphore =
+        reinterpret_cast<HostTimelineSemaphore*>(semaphore_value.first);
+    RETURN_IF_ERROR(semaphore->status_);
+  }
+  return OkStatus();
+}
+
+// static
+StatusOr<int> HostTimelineSemaphore::WaitAnySemaphore(
+    absl::Span<const SemaphoreValue> semaphores, absl::Time deadline) {
+  IREE_TRACE_SCOPE0("HostTimelineSemaphore::WaitAnySemaphore");
+  struct WaitState {
+    absl::Span<const SemaphoreValue> semaphores;
+    int reached_index;
+  } wait_state = {semaphores, -1};
+  auto* state = host_sync_state();
+  absl::MutexLock lock(&state->mutex);
+  if (!state->mutex.AwaitWithDeadline(
+          absl::Condition(
+              +[](WaitState* wait_state) {
+                for (int i = 0; i < wait_state->semaphores.size(); ++i) {
+                  auto& semaphore_value = wait_state->semaphores[i];
+                  auto* semaphore = reinterpret_cast<HostTimelineSemaphore*>(
+                      semaphore_value.first);
+                  if (semaphore->IsReached(semaphore_value.second)) {
+                    wait_state->reached_index = i;
+                    return true;
+                  }
+                }
+                return false;
+              },
+              &wait_state),
+          deadline)) {
+    return DeadlineExceededErrorBuilder(IREE_LOC)
+           << "Deadline exceeded waiting for semaphores";
+  }
+  auto* semaphore = reinterpret_cast<HostTimelineSemaphore*>(
+      semaphores[wait_state.reached_index].first);
+  RETURN_IF_ERROR(semaphore->status_);
+  return wait_state.reached_index;
+}
+
+HostTimelineSemaphore::HostTimelineSemaphore(uint64_t initial_value)
+    : value_(initial_value) {}
+
+HostTimelineSemaphore::~HostTimelineSemaphore() = default;
+
+StatusOr<uint64_t> HostTimelineSemaphore::Query() {
+  uint64_t value = value_.load(std::memory_order_acquire);
+  if (value == UINT64_MAX) {
+    auto* state = host_sync_state();
+    absl::MutexLock lock(&state->mutex);
+    RETURN_IF_ERROR(status_);
+  }
+  return value;
+}
+
+Status HostTimelineSemaphore::Signal(uint64_t value) {
+  auto* state = host_sync_state();
+  absl::MutexLock lock(&state->mutex);
+  RETURN_IF_ERROR(status_);
+  uint64_t current_value = value_.load(std::memory_order_acquire);
+  if (value <= current_value) {
+    return InvalidArgumentErrorBuilder(IREE_LOC)
+           << "Semaphore values must be monotonically increasing; current="
+           << current_value << ", new=" << value;
+  }
+  value_.store(value, std::memory_order_release);
+  state->epoch.fetch_add(1, std::memory_order_release);
+  return OkStatus();
+}
+
+Status HostTimelineSemaphore::Advance(uint64_t value) {
+  auto* state = host_sync_state();
+  absl::MutexLock lock(&state->mutex);
+  RETURN_IF_ERROR(status_);
+  if (value > value_.load(std::memory_order_acquire)) {
+    value_.store(value, std::memory_order_release);
+    state->epoch.fetch_add(1, std::memory_order_release);
+  }
+  return OkStatus();
+}
+
+Status HostTimelineSemaphore::Wait(uint64_t value, absl::Time deadline) {
+  IREE_TRACE_SCOPE0("HostTimelineSemaphore::Wait");
+  return WaitAllSemaphores({{this, value}}, deadline);
+}
+
+Status HostTimelineSemaphore::Fail(Status status) {
+  auto* state = host_sync_state();
+  absl::MutexLock lock(&state->mutex);
+  status_ = std::move(status);
+  value_.store(UINT64_MAX, std::memory_order_release);
+  state->epoch.fetch_add(1, std::memory_order_release);
+  return OkStatus();
+}
+
 HostSubmissionQueue::HostSubmissionQueue() = default;
 
 HostSubmissionQueue::~HostSubmissionQueue() = default;
@@ -101,8 +253,14 @@ bool HostSubmissionQueue::IsBatchReady(const PendingBatch& batch) const {
         return false;
       }
     } else {
-      // TODO(b/140141417): implement timeline semaphores.
-      return false;
+      // Failed semaphores are reported as reached so that the batch will be
+      // processed and fail.
+      auto& timeline_value = absl::get<1>(wait_point);
+      auto* timeline_semaphore =
+          reinterpret_cast<HostTimelineSemaphore*>(timeline_value.first);
+      if (!timeline_semaphore->IsReached(timeline_value.second)) {
+        return false;
+      }
     }
   }
   return true;
@@ -128,20 +286,16 @@ Status HostSubmissionQueue::Enqueue(absl::Span<const SubmissionBatch> batches,
         auto* binary_semaphore = reinterpret_cast<HostBinarySemaphore*>(
             absl::get<0>(semaphore_value));
         RETURN_IF_ERROR(binary_semaphore->BeginWaiting());
-      } else {
-        // TODO(b/140141417): implement timeline semaphores.
-        return UnimplementedErrorBuilder(IREE_LOC) << "Timeline semaphores NYI";
       }
+      // Timeline semaphores may be waited on in any order.
     }
     for (auto& semaphore_value : batch.signal_semaphores) {
       if (semaphore_value.index() == 0) {
         auto* binary_semaphore = reinterpret_cast<HostBinarySemaphore*>(
             absl::get<0>(semaphore_value));
         RETURN_IF_ERROR(binary_semaphore->BeginSignaling());
-      } else {
-        // TODO(b/140141417): implement timeline semaphores.
-        return UnimplementedErrorBuilder(IREE_LOC) << "Timeline semaphores NYI";
       }
+      // Timeline semaphores may be signaled in any order.
     }
   }
 
@@ -159,6 +313,9 @@ Status HostSubmissionQueue::Enqueue(absl::Span<const SubmissionBatch> batches,
   }
   list_.push_back(std::move(submission));
 
+  // Wake the queue (and any others) to process the new work.
+  NotifyStateChanged();
+
   return OkStatus();
 }
 
@@ -189,6 +346,9 @@ Status HostSubmissionQueue::ProcessBatches(ExecuteFn execute_fn) {
         // Batch can run! Process now and remove it from the list so we don't
         // try to run it again.
         auto batch_status = ProcessBatch(batch, execute_fn);
+        if (!batch_status.ok()) {
+          FailSignalSemaphores(batch, batch_status);
+        }
         submission->pending_batches.erase(submission->pending_batches.begin() +
                                           i);
         if (batch_status.ok()) {
@@ -212,6 +372,11 @@ Status HostSubmissionQueue::ProcessBatches(ExecuteFn execute_fn) {
       }
       if (restart_iteration) break;
     }
+    if (!restart_iteration) {
+      // All remaining batches are blocked on semaphores; return to the caller
+      // so that it can wait for them to be signaled.
+      break;
+    }
   }
 
   if (!permanent_error_.ok()) {
@@ -235,8 +400,10 @@ Status HostSubmissionQueue::ProcessBatch(const PendingBatch& batch,
           reinterpret_cast<HostBinarySemaphore*>(absl::get<0>(semaphore_value));
       RETURN_IF_ERROR(binary_semaphore->EndWaiting());
     } else {
-      // TODO(b/140141417): implement timeline semaphores.
-      return UnimplementedErrorBuilder(IREE_LOC) << "Timeline semaphores NYI";
+      // The payload may have only been reached due to a failure.
+      auto* timeline_semaphore = reinterpret_cast<HostTimelineSemaphore*>(
+          absl::get<1>(semaphore_value).first);
+      RETURN_IF_ERROR(timeline_semaphore->Query().status());
     }
   }
 
@@ -250,8 +417,10 @@ Status HostSubmissionQueue::ProcessBatch(const PendingBatch& batch,
           reinterpret_cast<HostBinarySemaphore*>(absl::get<0>(semaphore_value));
       RETURN_IF_ERROR(binary_semaphore->EndSignaling());
     } else {
-      // TODO(b/140141417): implement timeline semaphores.
-      return UnimplementedErrorBuilder(IREE_LOC) << "Timeline semaphores NYI";
+      auto& timeline_value = absl::get<1>(semaphore_value);
+      auto* timeline_semaphore =
+          reinterpret_cast<HostTimelineSemaphore*>(timeline_value.first);
+      RETURN_IF_ERROR(timeline_semaphore->Advance(timeline_value.second));
     }
   }
 
@@ -262,8 +431,15 @@ Status HostSubmissionQueue::CompleteSubmission(Submission* submission,
                                                Status status) {
   IREE_TRACE_SCOPE0("HostSubmissionQueue::CompleteSubmission");
 
-  // It's safe to drop any remaining batches - their semaphores will never be
-  // signaled but that's fine as we should be the only thing relying on them.
+  // It's safe to drop any remaining batches - their binary semaphores will
+  // never be signaled but that's fine as we should be the only thing relying on
+  // them. Timeline semaphores may be waited on by other queues or the host and
+  // are failed instead.
+  if (!status.ok()) {
+    for (auto& batch : submission->pending_batches) {
+      FailSignalSemaphores(batch, status);
+    }
+  }
   submission->pending_batches.clear();
 
   // Signal the fence.
@@ -286,9 +462,41 @@ void HostSubmissionQueue::FailAllPending(Status status) {
   }
 }
 
+// static
+void HostSubmissionQueue::FailSignalSemaphores(const PendingBatch& batch,
+                                               const Status& status) {
+  for (auto& semaphore_value : batch.signal_semaphores) {
+    if (semaphore_value.index() == 1) {
+      auto* timeline_semaphore = reinterpret_cast<HostTimelineSemaphore*>(
+          absl::get<1>(semaphore_value).first);
+      timeline_semaphore->Fail(status).IgnoreError();
+    }
+  }
+}
+
 void HostSubmissionQueue::SignalShutdown() {
   IREE_TRACE_SCOPE0("HostSubmissionQueue::SignalShutdown");
   has_shutdown_ = true;
+  NotifyStateChanged();
+}
+
+// static
+uint64_t HostSubmissionQueue::CurrentEpoch() {
+  return host_sync_state()->epoch.load(std::memory_order_acquire);
+}
+
+// static
+void HostSubmissionQueue::AwaitEpochChange(uint64_t epoch) {
+  IREE_TRACE_SCOPE0("HostSubmissionQueue::AwaitEpochChange");
+  auto* state = host_sync_state();
+  std::pair<HostSyncState*, uint64_t> wait_state = {state, epoch};
+  absl::MutexLock lock(&state->mutex);
+  state->mutex.Await(absl::Condition(
+      +[](std::pair<HostSyncState*, uint64_t>* wait_state) {
+        return wait_state->first->epoch.load(std::memory_order_acquire) !=
+               wait_state->second;
+      },
+      &wait_state));
 }
 
 }  // namespace hal
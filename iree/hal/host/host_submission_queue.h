@@ -15,9 +15,15 @@
 #ifndef IREE_HAL_HOST_HOST_SUBMISSION_QUEUE_H_
 #define IREE_HAL_HOST_HOST_SUBMISSION_QUEUE_H_
 
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
 #include "absl/base/thread_annotations.h"
 #include "absl/container/inlined_vector.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "iree/base/intrusive_list.h"
 #include "iree/base/status.h"
 #include "iree/hal/command_queue.h"
@@ -67,11 +73,56 @@ class HostBinarySemaphore final : public BinarySemaphore {
 };
 
 // Simple host-only timeline semaphore implemented with a mutex.
+// All host semaphores share the process-wide synchronization mutex (see
+// HostSubmissionQueue::CurrentEpoch) so that waits on multiple semaphores and
+// queues blocked on semaphores signaled by other queues can be woken without
+// each semaphore tracking its waiters.
 //
 // Thread-safe (as instances may be imported and used by others).
 class HostTimelineSemaphore final : public TimelineSemaphore {
  public:
-  // TODO(b/140141417): implement timeline semaphores.
+  using SemaphoreValue = std::pair<TimelineSemaphore*, uint64_t>;
+
+  // Blocks until all |semaphores| reach or exceed the given values or the
+  // |deadline| elapses.
+  static Status WaitAllSemaphores(absl::Span<const SemaphoreValue> semaphores,
+                                  absl::Time deadline);
+
+  // Blocks until at least one of the |semaphores| reaches or exceeds its value
+  // or the |deadline| elapses. Returns the index of a reached semaphore.
+  static StatusOr<int> WaitAnySemaphore(
+      absl::Span<const SemaphoreValue> semaphores, absl::Time deadline);
+
+  explicit HostTimelineSemaphore(uint64_t initial_value);
+  ~HostTimelineSemaphore() override;
+
+  StatusOr<uint64_t> Query() override;
+  Status Signal(uint64_t value) override;
+  Status Wait(uint64_t value, absl::Time deadline) override;
+
+  // Sets the semaphore to a permanently failed state with the given |status|.
+  // All current and future waiters will receive the status.
+  Status Fail(Status status);
+
+ private:
+  friend class HostSubmissionQueue;
+
+  // Returns true if the payload has reached |value| or the semaphore failed.
+  bool IsReached(uint64_t value) const {
+    return value_.load(std::memory_order_acquire) >= value;
+  }
+
+  // Sets the payload to the maximum of |value| and the current payload as done
+  // by queue signal operations.
+  Status Advance(uint64_t value);
+
+  // The payload is read without the shared mutex so that readiness checks are
+  // cheap; it is only updated while holding the mutex so that waiters are
+  // notified. Failure is indicated by UINT64_MAX.
+  std::atomic<uint64_t> value_{0};
+
+  // Failure status guarded by the shared host synchronization mutex.
+  Status status_;
 };
 
 // A queue managing CommandQueue submissions that uses host-local
@@ -116,6 +167,18 @@ class HostSubmissionQueue {
   // to complete but future enqueues will fail.
   void SignalShutdown();
 
+  // Returns the process-wide host synchronization epoch. The epoch advances
+  // whenever any host semaphore changes state or any queue receives new work
+  // or is shut down. Queue threads capture the epoch before processing and
+  // then use AwaitEpochChange to sleep until they may be able to make
+  // progress, which allows batches blocked on semaphores signaled by other
+  // queues (or the host) to be scheduled as soon as their dependencies
+  // resolve.
+  static uint64_t CurrentEpoch();
+
+  // Blocks the caller until the epoch differs from |epoch|.
+  static void AwaitEpochChange(uint64_t epoch);
+
  private:
   // A submitted command buffer batch and its synchronization information.
   struct PendingBatch {
@@ -140,10 +203,16 @@ class HostSubmissionQueue {
   // Completes a submission by signaling the fence with the given |status|.
   Status CompleteSubmission(Submission* submission, Status status);
 
-  // Fails all pending submissions with the given status.
+  // Fails all pending submissions with the given status. Timeline semaphores
+  // that would have been signaled by the pending batches are failed as well so
+  // that work on other queues waiting on them is not blocked forever.
   // Errors that occur during this process are silently ignored.
   void FailAllPending(Status status);
 
+  // Fails the timeline semaphores signaled by |batch|.
+  static void FailSignalSemaphores(const PendingBatch& batch,
+                                   const Status& status);
+
   // True to exit the thread after all submissions complete.
   bool has_shutdown_ = false;
 
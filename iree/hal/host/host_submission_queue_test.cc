@@ -14,14 +14,179 @@
 
 #include "iree/hal/host/host_submission_queue.h"
 
+#include <cstdint>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "iree/base/status.h"
+#include "iree/base/status_matchers.h"
+#include "iree/hal/host/host_fence.h"
+#include "iree/hal/testing/mock_command_buffer.h"
 #include "iree/testing/gtest.h"
 
 namespace iree {
 namespace hal {
 namespace {
 
-TEST(HostSubmissionQueueTest, TBD) {
-  // TODO(benvanik): test!
+using testing::MockCommandBuffer;
+
+ref_ptr<CommandBuffer> MakeCommandBuffer() {
+  return make_ref<MockCommandBuffer>(nullptr, CommandBufferMode::kOneShot,
+                                     CommandCategory::kDispatch);
+}
+
+// Tests host-side query and signal of timeline semaphores.
+TEST(HostTimelineSemaphoreTest, QueryAndSignal) {
+  HostTimelineSemaphore semaphore(5u);
+  ASSERT_OK_AND_ASSIGN(uint64_t value, semaphore.Query());
+  EXPECT_EQ(5u, value);
+  EXPECT_OK(semaphore.Signal(7u));
+  ASSERT_OK_AND_ASSIGN(value, semaphore.Query());
+  EXPECT_EQ(7u, value);
+
+  // Values must be monotonically increasing.
+  EXPECT_TRUE(IsInvalidArgument(semaphore.Signal(7u)));
+  EXPECT_TRUE(IsInvalidArgument(semaphore.Signal(6u)));
+}
+
+// Tests waiting on values that have been reached and those that have not.
+TEST(HostTimelineSemaphoreTest, Wait) {
+  HostTimelineSemaphore semaphore(2u);
+  EXPECT_OK(semaphore.Wait(1u, absl::InfinitePast()));
+  EXPECT_OK(semaphore.Wait(2u, absl::InfinitePast()));
+  EXPECT_TRUE(IsDeadlineExceeded(semaphore.Wait(3u, absl::InfinitePast())));
+  EXPECT_TRUE(IsDeadlineExceeded(
+      semaphore.Wait(3u, absl::Now() + absl::Milliseconds(10))));
+
+  std::thread thread([&semaphore]() {
+    absl::SleepFor(absl::Milliseconds(10));
+    CHECK_OK(semaphore.Signal(4u));
+  });
+  EXPECT_OK(semaphore.Wait(3u, absl::InfiniteFuture()));
+  thread.join();
+}
+
+// Tests waiting on multiple semaphores.
+TEST(HostTimelineSemaphoreTest, MultiWait) {
+  HostTimelineSemaphore semaphore_a(0u);
+  HostTimelineSemaphore semaphore_b(0u);
+  EXPECT_TRUE(IsDeadlineExceeded(HostTimelineSemaphore::WaitAnySemaphore(
+                                     {{&semaphore_a, 1u}, {&semaphore_b, 1u}},
+                                     absl::InfinitePast())
+                                     .status()));
+
+  std::thread thread([&]() {
+    absl::SleepFor(absl::Milliseconds(10));
+    CHECK_OK(semaphore_b.Signal(1u));
+    absl::SleepFor(absl::Milliseconds(10));
+    CHECK_OK(semaphore_a.Signal(1u));
+  });
+  ASSERT_OK_AND_ASSIGN(int index, HostTimelineSemaphore::WaitAnySemaphore(
+                                      {{&semaphore_a, 1u}, {&semaphore_b, 1u}},
+                                      absl::InfiniteFuture()));
+  EXPECT_EQ(1, index);
+  EXPECT_OK(HostTimelineSemaphore::WaitAllSemaphores(
+      {{&semaphore_a, 1u}, {&semaphore_b, 1u}}, absl::InfiniteFuture()));
+  thread.join();
+}
+
+// Tests that failures are propagated to waiters.
+TEST(HostTimelineSemaphoreTest, Fail) {
+  HostTimelineSemaphore semaphore(0u);
+  std::thread thread([&semaphore]() {
+    absl::SleepFor(absl::Milliseconds(10));
+    CHECK_OK(semaphore.Fail(DataLossErrorBuilder(IREE_LOC)));
+  });
+  EXPECT_TRUE(IsDataLoss(semaphore.Wait(1u, absl::InfiniteFuture())));
+  thread.join();
+  EXPECT_TRUE(IsDataLoss(semaphore.Query().status()));
+  EXPECT_TRUE(IsDataLoss(semaphore.Signal(2u)));
+}
+
+// Tests that batches are scheduled as their timeline dependencies resolve
+// regardless of submission order.
+TEST(HostSubmissionQueueTest, TimelineOutOfOrder) {
+  auto cmd_buffer_0 = MakeCommandBuffer();
+  auto cmd_buffer_1 = MakeCommandBuffer();
+  HostTimelineSemaphore semaphore(0u);
+  HostFence fence_0(0u);
+  HostFence fence_1(0u);
+  HostSubmissionQueue queue;
+
+  // Submission 0 waits on a payload that submission 1 signals.
+  SemaphoreValue wait_value = std::make_pair(
+      static_cast<TimelineSemaphore*>(&semaphore), static_cast<uint64_t>(2));
+  SemaphoreValue signal_value = std::make_pair(
+      static_cast<TimelineSemaphore*>(&semaphore), static_cast<uint64_t>(2));
+  CommandBuffer* cmd_buffer_0_ptr = cmd_buffer_0.get();
+  CommandBuffer* cmd_buffer_1_ptr = cmd_buffer_1.get();
+  ASSERT_OK(queue.Enqueue({{{wait_value}, {cmd_buffer_0_ptr}, {}}},
+                          {&fence_0, 1u}));
+  ASSERT_OK(queue.Enqueue({{{}, {cmd_buffer_1_ptr}, {signal_value}}},
+                          {&fence_1, 1u}));
+
+  std::vector<CommandBuffer*> executed;
+  auto execute_fn = [&](absl::Span<CommandBuffer* const> command_buffers) {
+    executed.insert(executed.end(), command_buffers.begin(),
+                    command_buffers.end());
+    return OkStatus();
+  };
+  ASSERT_OK(queue.ProcessBatches(execute_fn));
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ((std::vector<CommandBuffer*>{cmd_buffer_1_ptr, cmd_buffer_0_ptr}),
+            executed);
+  ASSERT_OK_AND_ASSIGN(uint64_t value, semaphore.Query());
+  EXPECT_EQ(2u, value);
+}
+
+// Tests that batches waiting on host signals remain pending until signaled.
+TEST(HostSubmissionQueueTest, TimelineHostSignal) {
+  auto cmd_buffer = MakeCommandBuffer();
+  HostTimelineSemaphore semaphore(0u);
+  HostFence fence(0u);
+  HostSubmissionQueue queue;
+  SemaphoreValue wait_value = std::make_pair(
+      static_cast<TimelineSemaphore*>(&semaphore), static_cast<uint64_t>(1));
+  CommandBuffer* cmd_buffer_ptr = cmd_buffer.get();
+  ASSERT_OK(
+      queue.Enqueue({{{wait_value}, {cmd_buffer_ptr}, {}}}, {&fence, 1u}));
+
+  int execute_count = 0;
+  auto execute_fn = [&](absl::Span<CommandBuffer* const> command_buffers) {
+    ++execute_count;
+    return OkStatus();
+  };
+  uint64_t epoch = HostSubmissionQueue::CurrentEpoch();
+  ASSERT_OK(queue.ProcessBatches(execute_fn));
+  EXPECT_EQ(0, execute_count);
+  EXPECT_FALSE(queue.empty());
+
+  ASSERT_OK(semaphore.Signal(1u));
+  HostSubmissionQueue::AwaitEpochChange(epoch);
+  ASSERT_OK(queue.ProcessBatches(execute_fn));
+  EXPECT_EQ(1, execute_count);
+  EXPECT_TRUE(queue.empty());
+}
+
+// Tests that failed batches fail the timeline semaphores they would signal.
+TEST(HostSubmissionQueueTest, TimelineFailure) {
+  auto cmd_buffer = MakeCommandBuffer();
+  HostTimelineSemaphore semaphore(0u);
+  HostFence fence(0u);
+  HostSubmissionQueue queue;
+  SemaphoreValue signal_value = std::make_pair(
+      static_cast<TimelineSemaphore*>(&semaphore), static_cast<uint64_t>(1));
+  CommandBuffer* cmd_buffer_ptr = cmd_buffer.get();
+  ASSERT_OK(
+      queue.Enqueue({{{}, {cmd_buffer_ptr}, {signal_value}}}, {&fence, 1u}));
+  auto status = queue.ProcessBatches(
+      [](absl::Span<CommandBuffer* const> command_buffers) {
+        return DataLossErrorBuilder(IREE_LOC);
+      });
+  EXPECT_TRUE(IsDataLoss(status));
+  EXPECT_TRUE(IsDataLoss(semaphore.Wait(1u, absl::InfiniteFuture())));
 }
 
 }  // namespace
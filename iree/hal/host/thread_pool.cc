@@ -0,0 +1,302 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/hal/host/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+
+#include "iree/base/logging.h"
+#include "iree/base/source_location.h"
+#include "iree/base/tracing.h"
+
+namespace iree {
+namespace hal {
+
+namespace {
+
+// Tile ranges are stored as a packed [begin, end) pair so that the owner and
+// thieves can update them with a single CAS.
+uint64_t PackRange(int32_t begin, int32_t end) {
+  return (static_cast<uint64_t>(static_cast<uint32_t>(begin)) << 32) |
+         static_cast<uint32_t>(end);
+}
+
+void UnpackRange(uint64_t range, int32_t* begin, int32_t* end) {
+  *begin = static_cast<int32_t>(range >> 32);
+  *end = static_cast<int32_t>(range & 0xFFFFFFFFu);
+}
+
+int32_t CeilDiv(int32_t value, int32_t divisor) {
+  return (value + divisor - 1) / divisor;
+}
+
+}  // namespace
+
+// State for a single in-flight ParallelFor.
+// Jobs live on the stack of the thread calling ParallelFor and that thread
+// waits for all attached workers to detach before returning.
+struct ThreadPool::Job {
+  Job(Workload workload, Workload tile_size, Workload tile_counts,
+      int32_t tile_count, int slot_count, const TileFunction* fn)
+      : workload(workload),
+        tile_size(tile_size),
+        tile_counts(tile_counts),
+        tile_count(tile_count),
+        slot_count(slot_count),
+        fn(fn),
+        ranges(new std::atomic<uint64_t>[slot_count]) {
+    // Evenly distribute contiguous tile ranges across all slots.
+    for (int i = 0; i < slot_count; ++i) {
+      int32_t begin = static_cast<int32_t>(
+          static_cast<int64_t>(tile_count) * i / slot_count);
+      int32_t end = static_cast<int32_t>(
+          static_cast<int64_t>(tile_count) * (i + 1) / slot_count);
+      ranges[i].store(PackRange(begin, end), std::memory_order_relaxed);
+    }
+  }
+
+  // Pops the next tile from the front of the given slot.
+  bool PopFront(int slot, int32_t* out_tile) {
+    uint64_t range = ranges[slot].load(std::memory_order_acquire);
+    while (true) {
+      int32_t begin, end;
+      UnpackRange(range, &begin, &end);
+      if (begin >= end) return false;
+      if (ranges[slot].compare_exchange_weak(range, PackRange(begin + 1, end),
+                                             std::memory_order_acq_rel)) {
+        *out_tile = begin;
+        return true;
+      }
+    }
+  }
+
+  // Steals the back half of the remaining tiles in the given slot.
+  bool StealBack(int slot, int32_t* out_begin, int32_t* out_end) {
+    uint64_t range = ranges[slot].load(std::memory_order_acquire);
+    while (true) {
+      int32_t begin, end;
+      UnpackRange(range, &begin, &end);
+      if (begin >= end) return false;
+      int32_t mid = begin + (end - begin) / 2;
+      if (ranges[slot].compare_exchange_weak(range, PackRange(begin, mid),
+                                             std::memory_order_acq_rel)) {
+        *out_begin = mid;
+        *out_end = end;
+        return true;
+      }
+    }
+  }
+
+  void RunTile(int32_t tile_index) {
+    if (failed.load(std::memory_order_relaxed)) return;
+    int32_t x = tile_index % tile_counts[0];
+    int32_t y = (tile_index / tile_counts[0]) % tile_counts[1];
+    int32_t z = tile_index / (tile_counts[0] * tile_counts[1]);
+    Tile tile;
+    tile.origin = {x * tile_size[0], y * tile_size[1], z * tile_size[2]};
+    for (int i = 0; i < 3; ++i) {
+      tile.size[i] = std::min(tile_size[i], workload[i] - tile.origin[i]);
+    }
+    auto tile_status = (*fn)(tile);
+    if (!tile_status.ok()) {
+      absl::MutexLock lock(&status_mutex);
+      if (status.ok()) status = std::move(tile_status);
+      failed.store(true, std::memory_order_relaxed);
+    }
+  }
+
+  const Workload workload;
+  const Workload tile_size;
+  const Workload tile_counts;
+  const int32_t tile_count;
+  const int slot_count;
+  const TileFunction* fn;
+
+  // Packed [begin, end) tile ranges, one per participating thread.
+  std::unique_ptr<std::atomic<uint64_t>[]> ranges;
+
+  // Next unclaimed slot. Slot 0 is always owned by the calling thread.
+  // Guarded by the pool mutex.
+  int next_slot = 1;
+  // Total number of workers currently executing tiles from this job.
+  // Guarded by the pool mutex.
+  int attached_workers = 0;
+
+  std::atomic<bool> failed{false};
+  absl::Mutex status_mutex;
+  Status status ABSL_GUARDED_BY(status_mutex);
+};
+
+// static
+int ThreadPool::DefaultWorkerCount() {
+  int hardware_concurrency =
+      static_cast<int>(std::thread::hardware_concurrency());
+  return std::max(0, hardware_concurrency - 1);
+}
+
+ThreadPool::ThreadPool() : ThreadPool(Options{}) {}
+
+ThreadPool::ThreadPool(Options options) : options_(options) {
+  IREE_TRACE_SCOPE0("ThreadPool::ctor");
+  if (options_.deterministic) return;
+  int worker_count = options_.worker_count < 0 ? DefaultWorkerCount()
+                                               : options_.worker_count;
+  workers_.reserve(worker_count);
+  for (int i = 0; i < worker_count; ++i) {
+    workers_.emplace_back([this]() { WorkerMain(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  IREE_TRACE_SCOPE0("ThreadPool::dtor");
+  {
+    absl::MutexLock lock(&mutex_);
+    CHECK(pending_jobs_.empty()) << "Thread pool destroyed while in use";
+    shutdown_ = true;
+  }
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::WorkerMain() {
+  IREE_TRACE_THREAD_ENABLE("ThreadPoolWorker");
+  while (true) {
+    Job* job = nullptr;
+    int slot = 0;
+    {
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(absl::Condition(
+          +[](ThreadPool* pool) ABSL_NO_THREAD_SAFETY_ANALYSIS {
+            return pool->shutdown_ || !pool->pending_jobs_.empty();
+          },
+          this));
+      if (pending_jobs_.empty()) {
+        // Shutdown requested and no work remains.
+        return;
+      }
+
+      // Claim the next slot of the oldest job. Once all slots have been
+      // claimed there is no reason for other workers to look at it.
+      job = pending_jobs_.front();
+      slot = job->next_slot++;
+      ++job->attached_workers;
+      if (job->next_slot >= job->slot_count) {
+        pending_jobs_.erase(pending_jobs_.begin());
+      }
+    }
+
+    ExecuteJob(job, slot);
+
+    absl::MutexLock lock(&mutex_);
+    --job->attached_workers;
+  }
+}
+
+// static
+void ThreadPool::ExecuteJob(Job* job, int slot) {
+  IREE_TRACE_SCOPE0("ThreadPool::ExecuteJob");
+  while (true) {
+    // Drain our own range front-to-back to keep locality.
+    int32_t tile_index = 0;
+    while (job->PopFront(slot, &tile_index)) {
+      job->RunTile(tile_index);
+    }
+
+    // Try to steal from the other slots, starting with our neighbor so that
+    // thieves spread out instead of all hitting the same victim.
+    bool stole_work = false;
+    for (int i = 1; i < job->slot_count; ++i) {
+      int victim = (slot + i) % job->slot_count;
+      int32_t begin, end;
+      if (job->StealBack(victim, &begin, &end)) {
+        job->ranges[slot].store(PackRange(begin, end),
+                                std::memory_order_release);
+        stole_work = true;
+        break;
+      }
+    }
+    if (!stole_work) return;
+  }
+}
+
+Status ThreadPool::ParallelFor(Workload workload, Workload tile_size,
+                               const TileFunction& fn) {
+  IREE_TRACE_SCOPE0("ThreadPool::ParallelFor");
+
+  Workload tile_counts;
+  int64_t tile_count = 1;
+  for (int i = 0; i < 3; ++i) {
+    if (workload[i] < 0 || tile_size[i] <= 0) {
+      return InvalidArgumentErrorBuilder(IREE_LOC)
+             << "Invalid workload " << workload[i] << " with tile size "
+             << tile_size[i] << " in dimension " << i;
+    }
+    tile_counts[i] = CeilDiv(workload[i], tile_size[i]);
+    tile_count *= tile_counts[i];
+  }
+  if (tile_count == 0) return OkStatus();
+  if (tile_count > std::numeric_limits<int32_t>::max()) {
+    return InvalidArgumentErrorBuilder(IREE_LOC)
+           << "Workload tile count " << tile_count << " exceeds limits";
+  }
+
+  int slot_count =
+      static_cast<int>(std::min<int64_t>(concurrency(), tile_count));
+  Job job(workload, tile_size, tile_counts, static_cast<int32_t>(tile_count),
+          slot_count, &fn);
+  if (slot_count == 1) {
+    // Deterministic mode, no workers, or a single tile: run inline in order.
+    ExecuteJob(&job, 0);
+    absl::MutexLock lock(&job.status_mutex);
+    return std::move(job.status);
+  }
+
+  {
+    absl::MutexLock lock(&mutex_);
+    pending_jobs_.push_back(&job);
+  }
+
+  ExecuteJob(&job, 0);
+
+  {
+    // Ensure no new workers attach and wait for the attached ones to finish
+    // their in-flight tiles. No unclaimed tiles remain once ExecuteJob on our
+    // slot has returned.
+    absl::MutexLock lock(&mutex_);
+    auto it = std::find(pending_jobs_.begin(), pending_jobs_.end(), &job);
+    if (it != pending_jobs_.end()) pending_jobs_.erase(it);
+    mutex_.Await(absl::Condition(
+        +[](Job* job) { return job->attached_workers == 0; }, &job));
+  }
+
+  absl::MutexLock lock(&job.status_mutex);
+  return std::move(job.status);
+}
+
+Status ThreadPool::ParallelFor(
+    int32_t count, int32_t grain_size,
+    const std::function<Status(int32_t begin, int32_t end)>& fn) {
+  return ParallelFor({count, 1, 1}, {grain_size, 1, 1},
+                     [&fn](const Tile& tile) {
+                       return fn(tile.origin[0],
+                                 tile.origin[0] + tile.size[0]);
+                     });
+}
+
+}  // namespace hal
+}  // namespace iree
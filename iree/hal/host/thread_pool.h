@@ -0,0 +1,128 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef IREE_HAL_HOST_THREAD_POOL_H_
+#define IREE_HAL_HOST_THREAD_POOL_H_
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "iree/base/status.h"
+
+namespace iree {
+namespace hal {
+
+// Work-stealing thread pool for executing tiled workloads on the host.
+//
+// Work is submitted as an X/Y/Z grid that is split into tiles of a caller-
+// specified size. Each participating thread starts with a contiguous range of
+// tiles and once exhausted steals half of the remaining range of another
+// participant. This keeps neighboring tiles on the same thread (for cache
+// locality) while still balancing uneven tile costs.
+//
+// The thread calling ParallelFor always participates in the work. Because of
+// this a pool with zero workers simply runs all tiles inline and nested
+// ParallelFor calls (such as from within a tile) cannot deadlock.
+//
+// When created in deterministic mode no worker threads are created and all
+// tiles are executed in order on the calling thread. Use this for tests and
+// when debugging to get reproducible execution order and error reporting.
+//
+// Thread-safe. Multiple threads may issue ParallelFor calls concurrently and
+// the workers will service all of them.
+class ThreadPool final {
+ public:
+  struct Options {
+    // Total number of background worker threads. -1 will select a count based
+    // on the host hardware concurrency (leaving one core for the caller).
+    int worker_count = -1;
+
+    // Executes all tiles in order on the calling thread.
+    bool deterministic = false;
+  };
+
+  // X, Y, and Z counts (or offsets) within a workload grid.
+  using Workload = std::array<int32_t, 3>;
+
+  // A single tile of a ParallelFor workload.
+  struct Tile {
+    // XYZ offset of the tile within the workload.
+    Workload origin;
+    // XYZ size of the tile. Tiles on the trailing edge of the workload may be
+    // smaller than the requested tile size.
+    Workload size;
+  };
+
+  // Function executed for each tile. Returning an error will cause any tiles
+  // that have not yet started to be skipped.
+  using TileFunction = std::function<Status(const Tile& tile)>;
+
+  // Returns the worker count used when Options::worker_count is -1.
+  static int DefaultWorkerCount();
+
+  ThreadPool();
+  explicit ThreadPool(Options options);
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  ~ThreadPool();
+
+  // Total number of background worker threads.
+  int worker_count() const { return static_cast<int>(workers_.size()); }
+
+  // Total number of threads that may concurrently execute tiles of a single
+  // ParallelFor (the workers plus the caller).
+  int concurrency() const { return worker_count() + 1; }
+
+  // True if all tiles are executed in order on the calling thread.
+  bool deterministic() const { return options_.deterministic; }
+
+  // Splits |workload| into tiles of |tile_size| and executes |fn| for each.
+  // Blocks until all tiles have completed. Returns the first error returned by
+  // any tile, if any.
+  Status ParallelFor(Workload workload, Workload tile_size,
+                     const TileFunction& fn);
+
+  // Executes |fn| for each [begin, end) range of at most |grain_size| within
+  // [0, count). Convenience for 1-D workloads.
+  Status ParallelFor(
+      int32_t count, int32_t grain_size,
+      const std::function<Status(int32_t begin, int32_t end)>& fn);
+
+ private:
+  struct Job;
+
+  // Thread entry point for each worker thread.
+  void WorkerMain();
+
+  // Runs tiles from |job| using |slot| as the initial tile range until no work
+  // remains in any slot.
+  static void ExecuteJob(Job* job, int slot);
+
+  Options options_;
+  std::vector<std::thread> workers_;
+
+  absl::Mutex mutex_;
+  bool shutdown_ ABSL_GUARDED_BY(mutex_) = false;
+  std::vector<Job*> pending_jobs_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace hal
+}  // namespace iree
+
+#endif  // IREE_HAL_HOST_THREAD_POOL_H_
@@ -0,0 +1,147 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/hal/host/thread_pool.h"
+
+#include <atomic>
+#include <vector>
+
+#include "iree/base/status.h"
+#include "iree/base/status_matchers.h"
+#include "iree/testing/gtest.h"
+
+namespace iree {
+namespace hal {
+namespace {
+
+using Tile = ThreadPool::Tile;
+
+// Tests that an empty workload never calls the tile function.
+TEST(ThreadPoolTest, EmptyWorkload) {
+  ThreadPool pool(ThreadPool::Options{2, false});
+  EXPECT_OK(pool.ParallelFor({0, 4, 4}, {1, 1, 1}, [](const Tile& tile) {
+    ADD_FAILURE() << "Tile function should not be called";
+    return OkStatus();
+  }));
+}
+
+// Tests that invalid tile sizes are rejected.
+TEST(ThreadPoolTest, InvalidTileSize) {
+  ThreadPool pool(ThreadPool::Options{0, false});
+  EXPECT_TRUE(IsInvalidArgument(pool.ParallelFor(
+      {4, 4, 4}, {0, 1, 1}, [](const Tile& tile) { return OkStatus(); })));
+}
+
+// Tests that deterministic pools run tiles in XYZ order on the caller.
+TEST(ThreadPoolTest, DeterministicOrder) {
+  ThreadPool pool(ThreadPool::Options{4, true});
+  EXPECT_EQ(0, pool.worker_count());
+  std::vector<ThreadPool::Workload> origins;
+  EXPECT_OK(pool.ParallelFor({4, 3, 2}, {2, 2, 1}, [&](const Tile& tile) {
+    origins.push_back(tile.origin);
+    return OkStatus();
+  }));
+  std::vector<ThreadPool::Workload> expected_origins = {
+      {0, 0, 0}, {2, 0, 0}, {0, 2, 0}, {2, 2, 0},
+      {0, 0, 1}, {2, 0, 1}, {0, 2, 1}, {2, 2, 1},
+  };
+  EXPECT_EQ(expected_origins, origins);
+}
+
+// Tests that edge tiles are clamped to the workload size.
+TEST(ThreadPoolTest, EdgeTilesClamped) {
+  ThreadPool pool(ThreadPool::Options{0, true});
+  std::vector<ThreadPool::Workload> sizes;
+  EXPECT_OK(pool.ParallelFor({5, 1, 1}, {2, 4, 4}, [&](const Tile& tile) {
+    sizes.push_back(tile.size);
+    return OkStatus();
+  }));
+  std::vector<ThreadPool::Workload> expected_sizes = {
+      {2, 1, 1}, {2, 1, 1}, {1, 1, 1}};
+  EXPECT_EQ(expected_sizes, sizes);
+}
+
+// Tests that every element of a large workload is visited exactly once when
+// running across many workers.
+TEST(ThreadPoolTest, VisitsEachElementOnce) {
+  ThreadPool pool(ThreadPool::Options{4, false});
+  ThreadPool::Workload workload = {37, 19, 5};
+  std::vector<std::atomic<int>> visits(workload[0] * workload[1] * workload[2]);
+  for (auto& visit : visits) visit = 0;
+  EXPECT_OK(pool.ParallelFor(workload, {4, 3, 1}, [&](const Tile& tile) {
+    for (int z = tile.origin[2]; z < tile.origin[2] + tile.size[2]; ++z) {
+      for (int y = tile.origin[1]; y < tile.origin[1] + tile.size[1]; ++y) {
+        for (int x = tile.origin[0]; x < tile.origin[0] + tile.size[0]; ++x) {
+          ++visits[(z * workload[1] + y) * workload[0] + x];
+        }
+      }
+    }
+    return OkStatus();
+  }));
+  for (auto& visit : visits) {
+    EXPECT_EQ(1, visit.load());
+  }
+}
+
+// Tests the 1-D convenience form.
+TEST(ThreadPoolTest, ParallelFor1D) {
+  ThreadPool pool(ThreadPool::Options{3, false});
+  std::atomic<int64_t> sum{0};
+  EXPECT_OK(pool.ParallelFor(1000, 7, [&](int32_t begin, int32_t end) {
+    EXPECT_LE(end - begin, 7);
+    for (int32_t i = begin; i < end; ++i) sum += i;
+    return OkStatus();
+  }));
+  EXPECT_EQ(999 * 1000 / 2, sum.load());
+}
+
+// Tests that nested ParallelFor calls from within tiles complete.
+TEST(ThreadPoolTest, Nested) {
+  ThreadPool pool(ThreadPool::Options{2, false});
+  std::atomic<int> count{0};
+  EXPECT_OK(pool.ParallelFor(8, 1, [&](int32_t begin, int32_t end) {
+    return pool.ParallelFor(8, 1, [&](int32_t begin, int32_t end) {
+      ++count;
+      return OkStatus();
+    });
+  }));
+  EXPECT_EQ(64, count.load());
+}
+
+// Tests that tile errors are propagated to the caller.
+TEST(ThreadPoolTest, PropagatesErrors) {
+  ThreadPool pool(ThreadPool::Options{2, false});
+  EXPECT_TRUE(IsUnknown(
+      pool.ParallelFor(64, 1, [](int32_t begin, int32_t end) -> Status {
+        if (begin == 13) return UnknownErrorBuilder(IREE_LOC) << "Tile failed";
+        return OkStatus();
+      })));
+}
+
+// Tests that deterministic pools stop at the first failing tile.
+TEST(ThreadPoolTest, DeterministicStopsAtFirstError) {
+  ThreadPool pool(ThreadPool::Options{0, true});
+  int last_begin = -1;
+  EXPECT_TRUE(IsUnknown(
+      pool.ParallelFor(64, 1, [&](int32_t begin, int32_t end) -> Status {
+        last_begin = begin;
+        if (begin == 13) return UnknownErrorBuilder(IREE_LOC) << "Tile failed";
+        return OkStatus();
+      })));
+  EXPECT_EQ(13, last_begin);
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
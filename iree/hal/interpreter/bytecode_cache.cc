@@ -23,8 +23,9 @@
 namespace iree {
 namespace hal {
 
-BytecodeCache::BytecodeCache(hal::Allocator* allocator)
-    : allocator_(allocator) {}
+BytecodeCache::BytecodeCache(hal::Allocator* allocator,
+                             ThreadPool* thread_pool)
+    : allocator_(allocator), thread_pool_(thread_pool) {}
 
 BytecodeCache::~BytecodeCache() = default;
 
@@ -45,7 +46,8 @@ StatusOr<ref_ptr<Executable>> BytecodeCache::PrepareExecutable(
       AllBitsSet(mode, ExecutableCachingMode::kAliasProvidedData);
   ASSIGN_OR_RETURN(
       auto executable,
-      BytecodeExecutable::Load(allocator_, spec, !allow_aliasing_data));
+      BytecodeExecutable::Load(allocator_, thread_pool_, spec,
+                               !allow_aliasing_data));
 
   return executable;
 }
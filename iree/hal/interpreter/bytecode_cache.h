@@ -18,13 +18,14 @@
 #include "iree/hal/allocator.h"
 #include "iree/hal/executable.h"
 #include "iree/hal/executable_cache.h"
+#include "iree/hal/host/thread_pool.h"
 
 namespace iree {
 namespace hal {
 
 class BytecodeCache final : public ExecutableCache {
  public:
-  explicit BytecodeCache(hal::Allocator* allocator);
+  BytecodeCache(hal::Allocator* allocator, ThreadPool* thread_pool);
   ~BytecodeCache() override;
 
   bool CanPrepareFormat(ExecutableFormat format) const override;
@@ -34,6 +35,7 @@ class BytecodeCache final : public ExecutableCache {
 
  private:
   hal::Allocator* allocator_;
+  ThreadPool* thread_pool_;
 };
 
 }  // namespace hal
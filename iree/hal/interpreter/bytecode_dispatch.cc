@@ -104,6 +104,8 @@ Status Dispatch(hal::Allocator* allocator,
     ASSIGN_OR_RETURN(auto* new_stack_frame, stack->PushFrame(target_function));
     new_stack_frame->mutable_registers()->buffer_views.resize(
         function_def->bytecode()->local_count());
+    RETURN_IF_ERROR(stack->ReserveFrameScratch(
+        allocator, function_def->bytecode()->scratch_size()));
     RETURN_IF_ERROR(
         reader.CopyInputsAndSwitchStackFrame(old_stack_frame, new_stack_frame));
   });
@@ -252,6 +254,34 @@ Status Dispatch(hal::Allocator* allocator,
     }
   });
 
+  DISPATCH_CORE_OPCODE(kAllocStatic, {
+    ASSIGN_OR_RETURN(auto scratch_offset, reader.ReadInt32());
+    ASSIGN_OR_RETURN(auto type, reader.ReadType());
+    size_t element_size = type.element_size();
+
+    size_t element_count = 0;
+    ASSIGN_OR_RETURN(auto shape, reader.ReadShapePieces(&element_count));
+    size_t allocation_size = element_size * element_count;
+
+    ASSIGN_OR_RETURN(auto* dst_local, reader.ReadLocal());
+    dst_local->element_size = element_size;
+    dst_local->shape = shape;
+
+    // The compiler has planned the allocation into the frame scratch memory
+    // such that it does not overlap any other live allocation.
+    const auto& scratch_buffer =
+        stack->current_frame()->registers().scratch_buffer;
+    if (!scratch_buffer) {
+      return FailedPreconditionErrorBuilder(IREE_LOC)
+             << "Static allocation in a function without scratch memory";
+    }
+    ASSIGN_OR_RETURN(dst_local->buffer,
+                     Buffer::Subspan(scratch_buffer, scratch_offset,
+                                     allocation_size));
+    // Scratch memory is reused; match the zeroed contents of heap allocations.
+    RETURN_IF_ERROR(dst_local->buffer->Fill8(uint8_t{0}));
+  });
+
   DISPATCH_CORE_OPCODE(kAllocHeap, {
     ASSIGN_OR_RETURN(auto heap_type, reader.ReadInt32());
     ASSIGN_OR_RETURN(auto type, reader.ReadType());
@@ -449,7 +479,7 @@ Status Dispatch(hal::Allocator* allocator,
     ASSIGN_OR_RETURN(auto* dst_local, reader.ReadLocal());
     RETURN_IF_ERROR(ApplyUnaryOpIU<kernels::Transpose>(
         src_local, dst_local, src_local->shape,
-        absl::MakeConstSpan(perm_data)));
+        absl::MakeConstSpan(perm_data), kernel_runtime_state->thread_pool));
   });
 
   DISPATCH_CORE_OPCODE(kReverse, {
@@ -685,22 +715,26 @@ Status Dispatch(hal::Allocator* allocator,
       case 1:
         RETURN_IF_ERROR(ApplyMatMulOpI<int8_t>(
             mat_mul_state, lhs_local, rhs_local, bias_local,
-            multiplier_mantissa_local, multiplier_exponent_local, dst_local));
+            multiplier_mantissa_local, multiplier_exponent_local, dst_local,
+            kernel_runtime_state->thread_pool));
         break;
       case 2:
         RETURN_IF_ERROR(ApplyMatMulOpI<int16_t>(
             mat_mul_state, lhs_local, rhs_local, bias_local,
-            multiplier_mantissa_local, multiplier_exponent_local, dst_local));
+            multiplier_mantissa_local, multiplier_exponent_local, dst_local,
+            kernel_runtime_state->thread_pool));
         break;
       case 4:
         RETURN_IF_ERROR(ApplyMatMulOpI<int32_t>(
             mat_mul_state, lhs_local, rhs_local, bias_local,
-            multiplier_mantissa_local, multiplier_exponent_local, dst_local));
+            multiplier_mantissa_local, multiplier_exponent_local, dst_local,
+            kernel_runtime_state->thread_pool));
         break;
       case 8:
         RETURN_IF_ERROR(ApplyMatMulOpI<int64_t>(
             mat_mul_state, lhs_local, rhs_local, bias_local,
-            multiplier_mantissa_local, multiplier_exponent_local, dst_local));
+            multiplier_mantissa_local, multiplier_exponent_local, dst_local,
+            kernel_runtime_state->thread_pool));
         break;
       default:
         return UnimplementedErrorBuilder(IREE_LOC)
@@ -719,11 +753,13 @@ Status Dispatch(hal::Allocator* allocator,
     switch (lhs_local->element_size) {
       case 4:
         RETURN_IF_ERROR(ApplyMatMulOpF<float>(
-            mat_mul_state, lhs_local, rhs_local, bias_local, dst_local));
+            mat_mul_state, lhs_local, rhs_local, bias_local, dst_local,
+            kernel_runtime_state->thread_pool));
         break;
       case 8:
         RETURN_IF_ERROR(ApplyMatMulOpF<double>(
-            mat_mul_state, lhs_local, rhs_local, bias_local, dst_local));
+            mat_mul_state, lhs_local, rhs_local, bias_local, dst_local,
+            kernel_runtime_state->thread_pool));
         break;
       default:
         return UnimplementedErrorBuilder(IREE_LOC)
@@ -739,7 +775,7 @@ Status Dispatch(hal::Allocator* allocator,
     // TODO(scotttodd): validate
     RETURN_IF_ERROR(ApplyBinaryOpIS<kernels::ReduceSum>(
         src_local, init_local, dst_local, dimension, src_local->shape,
-        dst_local->shape));
+        dst_local->shape, kernel_runtime_state->thread_pool));
   });
 
   DISPATCH_FLOAT_OPCODE(kReduceSumF, {
@@ -750,7 +786,7 @@ Status Dispatch(hal::Allocator* allocator,
     // TODO(scotttodd): validate
     RETURN_IF_ERROR(ApplyBinaryOpF<kernels::ReduceSum>(
         src_local, init_local, dst_local, dimension, src_local->shape,
-        dst_local->shape));
+        dst_local->shape, kernel_runtime_state->thread_pool));
   });
 
   DISPATCH_CORE_OPCODE(kReduceMinI, {
@@ -761,7 +797,7 @@ Status Dispatch(hal::Allocator* allocator,
     // TODO(scotttodd): validate
     RETURN_IF_ERROR(ApplyBinaryOpIS<kernels::ReduceMin>(
         src_local, init_local, dst_local, dimension, src_local->shape,
-        dst_local->shape));
+        dst_local->shape, kernel_runtime_state->thread_pool));
   });
 
   DISPATCH_FLOAT_OPCODE(kReduceMinF, {
@@ -772,7 +808,7 @@ Status Dispatch(hal::Allocator* allocator,
     // TODO(scotttodd): validate
     RETURN_IF_ERROR(ApplyBinaryOpF<kernels::ReduceMin>(
         src_local, init_local, dst_local, dimension, src_local->shape,
-        dst_local->shape));
+        dst_local->shape, kernel_runtime_state->thread_pool));
   });
 
   DISPATCH_CORE_OPCODE(kReduceMaxI, {
@@ -783,7 +819,7 @@ Status Dispatch(hal::Allocator* allocator,
     // TODO(scotttodd): validate
     RETURN_IF_ERROR(ApplyBinaryOpIS<kernels::ReduceMax>(
         src_local, init_local, dst_local, dimension, src_local->shape,
-        dst_local->shape));
+        dst_local->shape, kernel_runtime_state->thread_pool));
   });
 
   DISPATCH_FLOAT_OPCODE(kReduceMaxF, {
@@ -794,7 +830,7 @@ Status Dispatch(hal::Allocator* allocator,
     // TODO(scotttodd): validate
     RETURN_IF_ERROR(ApplyBinaryOpF<kernels::ReduceMax>(
         src_local, init_local, dst_local, dimension, src_local->shape,
-        dst_local->shape));
+        dst_local->shape, kernel_runtime_state->thread_pool));
   });
 
 _dispatch_unhandled:
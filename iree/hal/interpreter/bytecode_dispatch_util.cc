@@ -42,8 +42,21 @@ Status ValidateElementwiseUnaryOp(BufferView* src_local,
 
 Status ValidateElementwiseBinaryOp(BufferView* lhs_local, BufferView* rhs_local,
                                    BufferView* dst_local) {
-  // TODO(benvanik): validate shapes.
-  return OkStatus();
+  if (lhs_local->element_size != rhs_local->element_size) {
+    return InvalidArgumentErrorBuilder(IREE_LOC)
+           << "Operand element sizes differ: " << lhs_local->element_size
+           << " vs " << rhs_local->element_size;
+  }
+  // Operands with as many elements as the result are applied elementwise
+  // as-is; anything else must broadcast to the result shape.
+  int element_count = dst_local->shape.element_count();
+  if (lhs_local->shape.element_count() == element_count &&
+      rhs_local->shape.element_count() == element_count) {
+    return OkStatus();
+  }
+  return kernels::impl::ComputeBroadcastLayout(
+             lhs_local->shape, rhs_local->shape, dst_local->shape)
+      .status();
 }
 
 Status ValidateElementwiseTernaryOp(BufferView* a_local, BufferView* b_local,
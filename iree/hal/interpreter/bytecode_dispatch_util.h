@@ -105,8 +105,10 @@ Status ApplyComparisonOp(BufferView* lhs_local, BufferView* rhs_local,
                    rhs_local->buffer->MapMemory<T>(MemoryAccess::kRead));
   ASSIGN_OR_RETURN(auto dst_buffer, dst_local->buffer->MapMemory<uint8_t>(
                                         MemoryAccess::kDiscardWrite));
-  return KERNEL::Execute(lhs_buffer.contents(), rhs_buffer.contents(),
-                         dst_buffer.mutable_contents());
+  return kernels::BroadcastBinary<KERNEL>::Execute(
+      lhs_buffer.contents(), rhs_buffer.contents(),
+      dst_buffer.mutable_contents(), lhs_local->shape, rhs_local->shape,
+      dst_local->shape);
 }
 
 template <typename KERNEL, typename... ARGS>
@@ -357,7 +359,7 @@ Status ApplyMatMulOpI(kernels::MatMul::RuntimeState* runtime_state,
                       BufferView* bias_local,
                       BufferView* multiplier_mantissa_local,
                       BufferView* multiplier_exponent_local,
-                      BufferView* dst_local) {
+                      BufferView* dst_local, ThreadPool* thread_pool) {
   kernels::MatMul::Buffers<T, ACC> buffers;
   ASSIGN_OR_RETURN(auto lhs_buffer,
                    lhs_local->buffer->MapMemory<T>(MemoryAccess::kRead));
@@ -367,6 +369,8 @@ Status ApplyMatMulOpI(kernels::MatMul::RuntimeState* runtime_state,
                    rhs_local->buffer->MapMemory<T>(MemoryAccess::kRead));
   buffers.rhs_buffer = rhs_buffer.contents();
   buffers.rhs_shape = rhs_local->shape;
+  buffers.rhs_constant_buffer =
+      kernels::MatMul::ConstantRhsBuffer(rhs_local->buffer.get());
   MappedMemory<ACC> bias_buffer;
   if (bias_local && bias_local->buffer && !bias_local->shape.empty()) {
     if (bias_local->element_size != sizeof(ACC)) {
@@ -389,13 +393,14 @@ Status ApplyMatMulOpI(kernels::MatMul::RuntimeState* runtime_state,
                                         MemoryAccess::kDiscardWrite));
   buffers.dst_buffer = dst_buffer.mutable_contents();
   buffers.dst_shape = dst_local->shape;
-  return kernels::MatMul::Execute(runtime_state, buffers);
+  return kernels::MatMul::Execute(runtime_state, buffers, thread_pool);
 }
 
 template <typename T>
 Status ApplyMatMulOpF(kernels::MatMul::RuntimeState* runtime_state,
                       BufferView* lhs_local, BufferView* rhs_local,
-                      BufferView* bias_local, BufferView* dst_local) {
+                      BufferView* bias_local, BufferView* dst_local,
+                      ThreadPool* thread_pool) {
   kernels::MatMul::Buffers<T, T> buffers;
   ASSIGN_OR_RETURN(auto lhs_buffer,
                    lhs_local->buffer->MapMemory<T>(MemoryAccess::kRead));
@@ -405,6 +410,8 @@ Status ApplyMatMulOpF(kernels::MatMul::RuntimeState* runtime_state,
                    rhs_local->buffer->MapMemory<T>(MemoryAccess::kRead));
   buffers.rhs_buffer = rhs_buffer.contents();
   buffers.rhs_shape = rhs_local->shape;
+  buffers.rhs_constant_buffer =
+      kernels::MatMul::ConstantRhsBuffer(rhs_local->buffer.get());
   MappedMemory<T> bias_buffer;
   if (bias_local && bias_local->buffer && !bias_local->shape.empty()) {
     ASSIGN_OR_RETURN(bias_buffer,
@@ -415,7 +422,7 @@ Status ApplyMatMulOpF(kernels::MatMul::RuntimeState* runtime_state,
                                         MemoryAccess::kDiscardWrite));
   buffers.dst_buffer = dst_buffer.mutable_contents();
   buffers.dst_shape = dst_local->shape;
-  return kernels::MatMul::Execute(runtime_state, buffers);
+  return kernels::MatMul::Execute(runtime_state, buffers, thread_pool);
 }
 
 template <typename KERNEL>
@@ -448,7 +455,9 @@ Status DispatchElementwiseBinaryOpIS(BytecodeReader* reader) {
   ASSIGN_OR_RETURN(auto* rhs_local, reader->ReadLocal());
   ASSIGN_OR_RETURN(auto* dst_local, reader->ReadLocal());
   RETURN_IF_ERROR(ValidateElementwiseBinaryOp(lhs_local, rhs_local, dst_local));
-  return ApplyBinaryOpIS<KERNEL>(lhs_local, rhs_local, dst_local);
+  return ApplyBinaryOpIS<kernels::BroadcastBinary<KERNEL>>(
+      lhs_local, rhs_local, dst_local, lhs_local->shape, rhs_local->shape,
+      dst_local->shape);
 }
 
 template <typename KERNEL>
@@ -457,7 +466,9 @@ Status DispatchElementwiseBinaryOpIU(BytecodeReader* reader) {
   ASSIGN_OR_RETURN(auto* rhs_local, reader->ReadLocal());
   ASSIGN_OR_RETURN(auto* dst_local, reader->ReadLocal());
   RETURN_IF_ERROR(ValidateElementwiseBinaryOp(lhs_local, rhs_local, dst_local));
-  return ApplyBinaryOpIU<KERNEL>(lhs_local, rhs_local, dst_local);
+  return ApplyBinaryOpIU<kernels::BroadcastBinary<KERNEL>>(
+      lhs_local, rhs_local, dst_local, lhs_local->shape, rhs_local->shape,
+      dst_local->shape);
 }
 
 template <typename KERNEL>
@@ -466,7 +477,9 @@ Status DispatchElementwiseBinaryOpF(BytecodeReader* reader) {
   ASSIGN_OR_RETURN(auto* rhs_local, reader->ReadLocal());
   ASSIGN_OR_RETURN(auto* dst_local, reader->ReadLocal());
   RETURN_IF_ERROR(ValidateElementwiseBinaryOp(lhs_local, rhs_local, dst_local));
-  return ApplyBinaryOpF<KERNEL>(lhs_local, rhs_local, dst_local);
+  return ApplyBinaryOpF<kernels::BroadcastBinary<KERNEL>>(
+      lhs_local, rhs_local, dst_local, lhs_local->shape, rhs_local->shape,
+      dst_local->shape);
 }
 
 template <typename KERNEL>
@@ -23,7 +23,8 @@ namespace hal {
 
 // static
 StatusOr<ref_ptr<BytecodeExecutable>> BytecodeExecutable::Load(
-    hal::Allocator* allocator, ExecutableSpec spec, bool allow_aliasing_data) {
+    hal::Allocator* allocator, ThreadPool* thread_pool, ExecutableSpec spec,
+    bool allow_aliasing_data) {
   // Allocate the executable now.
   // We do this here so that if we need to clone the data we are passing that
   // to the VM loader instead of the data we may not have access to later.
@@ -33,8 +34,8 @@ StatusOr<ref_ptr<BytecodeExecutable>> BytecodeExecutable::Load(
   // Create the executable module.
   auto module_def =
       ::flatbuffers::GetRoot<ModuleDef>(executable->executable_data().data());
-  ASSIGN_OR_RETURN(auto module,
-                   InterpreterModule::FromDef(allocator, *module_def));
+  ASSIGN_OR_RETURN(auto module, InterpreterModule::FromDef(
+                                    allocator, thread_pool, *module_def));
   executable->module_ = add_ref(module);
 
   return executable;
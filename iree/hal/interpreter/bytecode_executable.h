@@ -22,6 +22,7 @@
 #include "iree/hal/allocator.h"
 #include "iree/hal/executable.h"
 #include "iree/hal/executable_spec.h"
+#include "iree/hal/host/thread_pool.h"
 #include "iree/hal/interpreter/interpreter_module.h"
 
 namespace iree {
@@ -30,6 +31,7 @@ namespace hal {
 class BytecodeExecutable final : public Executable {
  public:
   static StatusOr<ref_ptr<BytecodeExecutable>> Load(hal::Allocator* allocator,
+                                                    ThreadPool* thread_pool,
                                                     ExecutableSpec spec,
                                                     bool allow_aliasing_data);
 
@@ -37,9 +37,12 @@
 #include <cstdint>
 
 #include "absl/types/span.h"
+#include "iree/base/ref_ptr.h"
 #include "iree/base/shape.h"
 #include "iree/base/status.h"
 #include "iree/base/tracing.h"
+#include "iree/hal/buffer.h"
+#include "iree/hal/host/thread_pool.h"
 
 namespace iree {
 namespace hal {
@@ -82,6 +85,19 @@ struct CompareGE {
                         absl::Span<uint8_t> dst_buffer);
 };
 
+// Applies the elementwise binary KERNEL with numpy-style broadcasting of the
+// operands to |dst_shape|. Operands broadcast along outer dimensions are read
+// with stride 0 and the kernel runs on contiguous innermost runs, so no
+// broadcast operand is materialized at full size.
+template <typename KERNEL>
+struct BroadcastBinary {
+  template <typename T, typename DST_T>
+  static Status Execute(absl::Span<const T> lhs_buffer,
+                        absl::Span<const T> rhs_buffer,
+                        absl::Span<DST_T> dst_buffer, const Shape& lhs_shape,
+                        const Shape& rhs_shape, const Shape& dst_shape);
+};
+
 struct Copy {
   template <int element_size>
   static Status Execute(absl::Span<const uint8_t> src_buffer,
@@ -100,11 +116,14 @@ struct Select {
                         absl::Span<T> dst_buffer);
 };
 
+// Permutes the dimensions of |src_buffer|. If |thread_pool| is provided large
+// transposes are split across its threads.
 struct Transpose {
   template <typename T>
   static Status Execute(absl::Span<const T> src_buffer,
                         absl::Span<T> dst_buffer, const Shape& src_shape,
-                        absl::Span<const int32_t> perm);
+                        absl::Span<const int32_t> perm,
+                        ThreadPool* thread_pool = nullptr);
 };
 
 struct Pad {
@@ -339,11 +358,27 @@ struct MatMul {
     // for per-channel.
     absl::Span<const ACC> multiplier_mantissa_buffer;
     absl::Span<const int32_t> multiplier_exponent_buffer;
+
+    // Allocated buffer containing |rhs_buffer| if its contents are immutable
+    // (such as module constants). The RHS may then be packed once and reused
+    // across executions; the packed form retains the buffer.
+    ref_ptr<Buffer> rhs_constant_buffer;
   };
 
+  // Returns the allocation backing |rhs| for use as
+  // Buffers::rhs_constant_buffer if it has been marked as holding constant
+  // contents, or nullptr if the RHS may change between executions.
+  static ref_ptr<Buffer> ConstantRhsBuffer(Buffer* rhs) {
+    if (!rhs->has_constant_contents()) return nullptr;
+    return add_ref(rhs->allocated_buffer());
+  }
+
+  // If |thread_pool| is provided the destination columns are split across its
+  // threads.
   template <typename T, typename ACC>
   static Status Execute(RuntimeState* runtime_state,
-                        const Buffers<T, ACC>& buffers);
+                        const Buffers<T, ACC>& buffers,
+                        ThreadPool* thread_pool = nullptr);
 
   // Simple 2D transpose, borrowed from TFLite. This is temporary to get RUY
   // on an optimized path until proper compiler support for layout and
@@ -364,16 +399,23 @@ struct MatMul {
 };
 
 struct RuntimeState {
+  // Thread pool kernels may use to split their work across threads.
+  // May be nullptr in which case kernels must execute on the calling thread.
+  ThreadPool* thread_pool = nullptr;
+
   std::unique_ptr<MatMul::RuntimeState> mat_mul_state =
       MatMul::CreateRuntimeState();
 };
 
+// Reductions along a single dimension. If |thread_pool| is provided large
+// reductions are split across its threads.
 struct ReduceSum {
   template <typename T>
   static Status Execute(absl::Span<const T> src_buffer,
                         absl::Span<const T> init_buffer,
                         absl::Span<T> dst_buffer, int32_t dimension,
-                        const Shape& src_shape, const Shape& dst_shape);
+                        const Shape& src_shape, const Shape& dst_shape,
+                        ThreadPool* thread_pool = nullptr);
 };
 
 struct ReduceMin {
@@ -381,7 +423,8 @@ struct ReduceMin {
   static Status Execute(absl::Span<const T> src_buffer,
                         absl::Span<const T> init_buffer,
                         absl::Span<T> dst_buffer, int32_t dimension,
-                        const Shape& src_shape, const Shape& dst_shape);
+                        const Shape& src_shape, const Shape& dst_shape,
+                        ThreadPool* thread_pool = nullptr);
 };
 
 struct ReduceMax {
@@ -389,7 +432,8 @@ struct ReduceMax {
   static Status Execute(absl::Span<const T> src_buffer,
                         absl::Span<const T> init_buffer,
                         absl::Span<T> dst_buffer, int32_t dimension,
-                        const Shape& src_shape, const Shape& dst_shape);
+                        const Shape& src_shape, const Shape& dst_shape,
+                        ThreadPool* thread_pool = nullptr);
 };
 
 }  // namespace kernels
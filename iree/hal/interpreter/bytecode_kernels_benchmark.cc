@@ -0,0 +1,473 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/container/inlined_vector.h"
+#include "benchmark/benchmark.h"
+#include "iree/base/logging.h"
+#include "iree/base/shape.h"
+#include "iree/hal/host/thread_pool.h"
+#include "iree/hal/interpreter/bytecode_kernels.h"
+
+namespace iree {
+namespace hal {
+namespace kernels {
+namespace {
+
+// The original recursive reduction that visits one element per call.
+// Retained here as the baseline the blocked kernels are measured against.
+template <typename T>
+void LegacyReduceDimension(absl::Span<const T> src_buffer,
+                           absl::Span<T> dst_buffer, const Shape& src_shape,
+                           absl::Span<const int32_t> reduce_dims,
+                           absl::Span<const int> dst_strides, int dim,
+                           absl::Span<int> src_indices, size_t flat_src_i,
+                           size_t src_stride) {
+  if (dim < 0) {
+    size_t dst_size = src_shape.size() - reduce_dims.size();
+    absl::InlinedVector<int, 8> dst_indices;
+    for (size_t i = 0; i < src_indices.size(); ++i) {
+      if (std::find(std::begin(reduce_dims), std::end(reduce_dims), i) ==
+          std::end(reduce_dims)) {
+        dst_indices.push_back(src_indices[i]);
+      }
+    }
+    size_t dst_i = 0;
+    for (size_t i = 0; i < dst_indices.size(); ++i) {
+      dst_i += dst_indices[i] * dst_strides[dst_size - 1 - i];
+    }
+    dst_buffer[dst_i] += src_buffer[flat_src_i];
+    return;
+  }
+  for (size_t dim_i = 0; dim_i < src_shape[dim]; ++dim_i) {
+    src_indices[dim] = dim_i;
+    LegacyReduceDimension<T>(src_buffer, dst_buffer, src_shape, reduce_dims,
+                             dst_strides, dim - 1, src_indices,
+                             flat_src_i + dim_i * src_stride,
+                             src_stride * src_shape[dim]);
+  }
+}
+
+template <typename T>
+void LegacyReduceSum(absl::Span<const T> src_buffer, T init_value,
+                     absl::Span<T> dst_buffer, int32_t dimension,
+                     const Shape& src_shape, const Shape& dst_shape) {
+  std::fill_n(dst_buffer.data(), dst_buffer.size(), init_value);
+  absl::InlinedVector<int, 8> dst_strides;
+  size_t dst_stride = 1;
+  for (int dim_i = dst_shape.size() - 1; dim_i >= 0; --dim_i) {
+    dst_strides.push_back(dst_stride);
+    dst_stride *= dst_shape[dim_i];
+  }
+  absl::InlinedVector<int, 8> src_indices(src_shape.size(), 0);
+  LegacyReduceDimension<T>(src_buffer, dst_buffer, src_shape, {dimension},
+                           absl::MakeSpan(dst_strides), src_shape.size() - 1,
+                           absl::MakeSpan(src_indices), 0, 1);
+}
+
+enum class ReduceImpl {
+  kLegacy,
+  kBlocked,
+  kBlockedParallel,
+};
+
+// Arguments are: reduced dimension, implementation, and then the rank-3
+// source shape.
+void BM_ReduceSum(benchmark::State& state) {
+  int32_t dimension = state.range(0);
+  auto impl = static_cast<ReduceImpl>(state.range(1));
+  std::vector<int> src_dims;
+  std::vector<int> dst_dims;
+  for (int i = 0; i < 3; ++i) {
+    src_dims.push_back(state.range(2 + i));
+    if (i != dimension) dst_dims.push_back(state.range(2 + i));
+  }
+  Shape src_shape(src_dims);
+  Shape dst_shape(dst_dims);
+  std::vector<float> src_buffer(src_shape.element_count(), 1.0f);
+  std::vector<float> init_buffer = {0.0f};
+  std::vector<float> dst_buffer(src_shape.element_count() /
+                                src_shape[dimension]);
+
+  ThreadPool thread_pool;
+  for (auto _ : state) {
+    switch (impl) {
+      case ReduceImpl::kLegacy:
+        LegacyReduceSum<float>(src_buffer, init_buffer[0],
+                               absl::MakeSpan(dst_buffer), dimension,
+                               src_shape, dst_shape);
+        break;
+      case ReduceImpl::kBlocked:
+        CHECK_OK(ReduceSum::Execute<float>(src_buffer, init_buffer,
+                                           absl::MakeSpan(dst_buffer),
+                                           dimension, src_shape, dst_shape));
+        break;
+      case ReduceImpl::kBlockedParallel:
+        CHECK_OK(ReduceSum::Execute<float>(
+            src_buffer, init_buffer, absl::MakeSpan(dst_buffer), dimension,
+            src_shape, dst_shape, &thread_pool));
+        break;
+    }
+    benchmark::DoNotOptimize(dst_buffer.data());
+  }
+  state.SetBytesProcessed(state.iterations() * src_buffer.size() *
+                          sizeof(float));
+}
+
+void ReduceSumArguments(benchmark::internal::Benchmark* b) {
+  for (int impl = 0; impl < 3; ++impl) {
+    // Full reduction of a long vector.
+    b->Args({2, impl, 1, 1, 1 << 22});
+    // Innermost (row) reduction.
+    b->Args({2, impl, 1, 1024, 1024});
+    // Outermost (column) reduction.
+    b->Args({1, impl, 1, 1024, 1024});
+    // Middle dimension of an NHWC-style tensor.
+    b->Args({1, impl, 8, 256, 512});
+  }
+}
+
+BENCHMARK(BM_ReduceSum)->Apply(ReduceSumArguments)->UseRealTime();
+
+// The original transpose that divides out the index of every element.
+template <typename T>
+void LegacyTranspose(absl::Span<const T> src_buffer, absl::Span<T> dst_buffer,
+                     const Shape& src_shape, absl::Span<const int32_t> perm) {
+  int rank = src_shape.size();
+  absl::InlinedVector<int, 8> src_strides(rank);
+  absl::InlinedVector<int, 8> dst_strides(rank);
+  size_t src_stride = 1;
+  size_t dst_stride = 1;
+  for (int dim_i = rank - 1; dim_i >= 0; --dim_i) {
+    src_strides[dim_i] = src_stride;
+    dst_strides[dim_i] = dst_stride;
+    src_stride *= src_shape[dim_i];
+    dst_stride *= src_shape[perm[dim_i]];
+  }
+  for (size_t dst_i = 0; dst_i < dst_buffer.size(); ++dst_i) {
+    size_t src_i = 0;
+    size_t t = dst_i;
+    for (int dim_i = 0; dim_i < rank; ++dim_i) {
+      size_t ratio = t / dst_strides[dim_i];
+      t -= ratio * dst_strides[dim_i];
+      src_i += ratio * src_strides[perm[dim_i]];
+    }
+    dst_buffer[dst_i] = src_buffer[src_i];
+  }
+}
+
+enum class TransposeImpl {
+  kLegacy,
+  kTiled,
+  kTiledParallel,
+};
+
+template <typename T>
+void RunTranspose(benchmark::State& state, TransposeImpl impl,
+                  const Shape& src_shape, absl::Span<const int32_t> perm) {
+  std::vector<T> src_buffer(src_shape.element_count(), 1);
+  std::vector<T> dst_buffer(src_buffer.size());
+  ThreadPool thread_pool;
+  for (auto _ : state) {
+    switch (impl) {
+      case TransposeImpl::kLegacy:
+        LegacyTranspose<T>(src_buffer, absl::MakeSpan(dst_buffer), src_shape,
+                           perm);
+        break;
+      case TransposeImpl::kTiled:
+        CHECK_OK(Transpose::Execute<T>(src_buffer, absl::MakeSpan(dst_buffer),
+                                       src_shape, perm));
+        break;
+      case TransposeImpl::kTiledParallel:
+        CHECK_OK(Transpose::Execute<T>(src_buffer, absl::MakeSpan(dst_buffer),
+                                       src_shape, perm, &thread_pool));
+        break;
+    }
+    benchmark::DoNotOptimize(dst_buffer.data());
+  }
+  state.SetBytesProcessed(state.iterations() * src_buffer.size() * sizeof(T));
+}
+
+// Arguments are: implementation, element size in bytes, and then the rank-4
+// source shape followed by the rank-4 permutation.
+void BM_Transpose(benchmark::State& state) {
+  auto impl = static_cast<TransposeImpl>(state.range(0));
+  int element_size = state.range(1);
+  std::vector<int> src_dims;
+  std::vector<int32_t> perm;
+  for (int i = 0; i < 4; ++i) {
+    src_dims.push_back(state.range(2 + i));
+    perm.push_back(state.range(6 + i));
+  }
+  Shape src_shape(src_dims);
+  switch (element_size) {
+    case 1:
+      RunTranspose<uint8_t>(state, impl, src_shape, perm);
+      break;
+    case 2:
+      RunTranspose<uint16_t>(state, impl, src_shape, perm);
+      break;
+    case 4:
+      RunTranspose<uint32_t>(state, impl, src_shape, perm);
+      break;
+    case 8:
+      RunTranspose<uint64_t>(state, impl, src_shape, perm);
+      break;
+  }
+}
+
+void TransposeArguments(benchmark::internal::Benchmark* b) {
+  for (int impl = 0; impl < 3; ++impl) {
+    for (int element_size : {1, 4}) {
+      // Plain 2-D matrix transpose.
+      b->Args({impl, element_size, 1, 1, 1024, 1024, 0, 1, 3, 2});
+      // NHWC -> NCHW.
+      b->Args({impl, element_size, 8, 64, 64, 64, 0, 3, 1, 2});
+      // NCHW -> NHWC.
+      b->Args({impl, element_size, 8, 64, 64, 64, 0, 2, 3, 1});
+      // Outer dimensions swapped with the innermost dimension unmoved.
+      b->Args({impl, element_size, 1, 128, 64, 256, 0, 2, 1, 3});
+    }
+  }
+}
+
+BENCHMARK(BM_Transpose)->Apply(TransposeArguments)->UseRealTime();
+
+// The original pad that classifies every destination element individually.
+template <typename T>
+void LegacyPad(absl::Span<const T> src_buffer, T padding_value,
+               absl::Span<T> dst_buffer, const Shape& dst_shape,
+               absl::Span<const int32_t> edge_padding_low,
+               absl::Span<const int32_t> edge_padding_high,
+               absl::Span<const int32_t> interior_padding) {
+  absl::InlinedVector<int, 8> dst_indices(dst_shape.size(), 0);
+  const T* src_ptr = src_buffer.begin();
+  T* dst_ptr = dst_buffer.begin();
+  while (dst_ptr != dst_buffer.end()) {
+    bool is_padding = false;
+    for (int i = 0; i < dst_indices.size(); ++i) {
+      auto index = dst_indices[i];
+      if (index < edge_padding_low[i] ||
+          index >= dst_shape[i] - edge_padding_high[i] ||
+          (index - edge_padding_low[i]) % (interior_padding[i] + 1) != 0) {
+        is_padding = true;
+        break;
+      }
+    }
+    *dst_ptr++ = is_padding ? padding_value : *src_ptr++;
+    for (int i = dst_indices.size() - 1; i >= 0; --i) {
+      if (++dst_indices[i] < dst_shape[i]) break;
+      dst_indices[i] = 0;
+    }
+  }
+}
+
+enum class RunImpl {
+  kLegacy,
+  kRuns,
+};
+
+// Arguments are: implementation, interior padding, and then the rank-4 NHWC
+// source shape. H and W are padded by 1 on each edge.
+void BM_Pad(benchmark::State& state) {
+  auto impl = static_cast<RunImpl>(state.range(0));
+  int32_t interior = state.range(1);
+  std::vector<int> src_dims;
+  for (int i = 0; i < 4; ++i) src_dims.push_back(state.range(2 + i));
+  Shape src_shape(src_dims);
+  std::vector<int32_t> edge_padding_low = {0, 1, 1, 0};
+  std::vector<int32_t> edge_padding_high = {0, 1, 1, 0};
+  std::vector<int32_t> interior_padding = {0, interior, interior, 0};
+  std::vector<int> dst_dims;
+  for (int i = 0; i < 4; ++i) {
+    dst_dims.push_back(src_dims[i] + edge_padding_low[i] +
+                       edge_padding_high[i] +
+                       (src_dims[i] - 1) * interior_padding[i]);
+  }
+  Shape dst_shape(dst_dims);
+  std::vector<float> src_buffer(src_shape.element_count(), 1.0f);
+  std::vector<float> padding_value = {0.0f};
+  std::vector<float> dst_buffer(dst_shape.element_count());
+
+  for (auto _ : state) {
+    switch (impl) {
+      case RunImpl::kLegacy:
+        LegacyPad<float>(src_buffer, padding_value[0],
+                         absl::MakeSpan(dst_buffer), dst_shape,
+                         edge_padding_low, edge_padding_high,
+                         interior_padding);
+        break;
+      case RunImpl::kRuns:
+        CHECK_OK(Pad::Execute<float>(src_buffer, padding_value,
+                                     absl::MakeSpan(dst_buffer), src_shape,
+                                     dst_shape, edge_padding_low,
+                                     edge_padding_high, interior_padding));
+        break;
+    }
+    benchmark::DoNotOptimize(dst_buffer.data());
+  }
+  state.SetBytesProcessed(state.iterations() * dst_buffer.size() *
+                          sizeof(float));
+}
+
+void PadArguments(benchmark::internal::Benchmark* b) {
+  for (int impl = 0; impl < 2; ++impl) {
+    // RGB image.
+    b->Args({impl, 0, 1, 224, 224, 3});
+    // Feature map.
+    b->Args({impl, 0, 1, 56, 56, 64});
+    // Feature map dilated by interior padding.
+    b->Args({impl, 1, 1, 56, 56, 64});
+  }
+}
+
+BENCHMARK(BM_Pad)->Apply(PadArguments)->UseRealTime();
+
+// The original reverse that looks up every dimension of every element.
+template <typename T>
+void LegacyReverse(absl::Span<const T> src_buffer, absl::Span<T> dst_buffer,
+                   const Shape& src_shape,
+                   absl::Span<const int32_t> dimensions) {
+  int rank = src_shape.size();
+  absl::InlinedVector<int, 8> strides(rank);
+  size_t stride = 1;
+  for (int dim_i = rank - 1; dim_i >= 0; --dim_i) {
+    strides[dim_i] = stride;
+    stride *= src_shape[dim_i];
+  }
+  absl::flat_hash_set<int32_t> dims_set(dimensions.begin(), dimensions.end());
+  for (size_t dst_i = 0; dst_i < dst_buffer.size(); ++dst_i) {
+    size_t src_i = 0;
+    size_t t = dst_i;
+    for (int dim_i = 0; dim_i < rank; ++dim_i) {
+      size_t ratio = t / strides[dim_i];
+      t -= ratio * strides[dim_i];
+      bool do_reverse = dims_set.contains(dim_i);
+      src_i += (do_reverse ? (src_shape[dim_i] - 1 - ratio) : ratio) *
+               strides[dim_i];
+    }
+    dst_buffer[dst_i] = src_buffer[src_i];
+  }
+}
+
+// Arguments are: implementation, a bitmask of the reversed dimensions, and
+// then the rank-4 NHWC source shape.
+void BM_Reverse(benchmark::State& state) {
+  auto impl = static_cast<RunImpl>(state.range(0));
+  int reverse_mask = state.range(1);
+  std::vector<int> src_dims;
+  std::vector<int32_t> dimensions;
+  for (int i = 0; i < 4; ++i) {
+    src_dims.push_back(state.range(2 + i));
+    if (reverse_mask & (1 << i)) dimensions.push_back(i);
+  }
+  Shape src_shape(src_dims);
+  std::vector<float> src_buffer(src_shape.element_count(), 1.0f);
+  std::vector<float> dst_buffer(src_buffer.size());
+
+  for (auto _ : state) {
+    switch (impl) {
+      case RunImpl::kLegacy:
+        LegacyReverse<float>(src_buffer, absl::MakeSpan(dst_buffer),
+                             src_shape, dimensions);
+        break;
+      case RunImpl::kRuns:
+        CHECK_OK(Reverse::Execute<float>(
+            src_buffer, absl::MakeSpan(dst_buffer), src_shape, dimensions));
+        break;
+    }
+    benchmark::DoNotOptimize(dst_buffer.data());
+  }
+  state.SetBytesProcessed(state.iterations() * dst_buffer.size() *
+                          sizeof(float));
+}
+
+void ReverseArguments(benchmark::internal::Benchmark* b) {
+  for (int impl = 0; impl < 2; ++impl) {
+    // Vertical flip (H).
+    b->Args({impl, 0b0010, 1, 224, 224, 3});
+    // Horizontal flip (W).
+    b->Args({impl, 0b0100, 1, 224, 224, 3});
+    // Channel order swap (C).
+    b->Args({impl, 0b1000, 1, 224, 224, 3});
+  }
+}
+
+BENCHMARK(BM_Reverse)->Apply(ReverseArguments)->UseRealTime();
+
+enum class BroadcastImpl {
+  kMaterialized,
+  kBroadcast,
+};
+
+// Arguments are: implementation, rows, columns, and whether the rhs is a
+// row vector (broadcast along rows) or a column vector (broadcast along
+// columns). The materialized variant expands the rhs to the full shape first
+// as a separate broadcast/tile op would.
+void BM_BroadcastAdd(benchmark::State& state) {
+  auto impl = static_cast<BroadcastImpl>(state.range(0));
+  int rows = state.range(1);
+  int cols = state.range(2);
+  bool row_vector = state.range(3);
+  Shape dst_shape = {rows, cols};
+  Shape rhs_shape = row_vector ? Shape{cols} : Shape{rows, 1};
+  std::vector<float> lhs_buffer(dst_shape.element_count(), 1.0f);
+  std::vector<float> rhs_buffer(rhs_shape.element_count(), 2.0f);
+  std::vector<float> expanded_rhs_buffer(dst_shape.element_count());
+  std::vector<float> dst_buffer(dst_shape.element_count());
+
+  for (auto _ : state) {
+    switch (impl) {
+      case BroadcastImpl::kMaterialized:
+        for (int i = 0; i < rows; ++i) {
+          for (int j = 0; j < cols; ++j) {
+            expanded_rhs_buffer[i * cols + j] =
+                rhs_buffer[row_vector ? j : i];
+          }
+        }
+        CHECK_OK(Add::Execute<float>(lhs_buffer, expanded_rhs_buffer,
+                                     absl::MakeSpan(dst_buffer)));
+        break;
+      case BroadcastImpl::kBroadcast:
+        CHECK_OK(BroadcastBinary<Add>::Execute<float>(
+            lhs_buffer, rhs_buffer, absl::MakeSpan(dst_buffer), dst_shape,
+            rhs_shape, dst_shape));
+        break;
+    }
+    benchmark::DoNotOptimize(dst_buffer.data());
+  }
+  state.SetBytesProcessed(state.iterations() * dst_buffer.size() *
+                          sizeof(float));
+}
+
+void BroadcastAddArguments(benchmark::internal::Benchmark* b) {
+  for (int impl = 0; impl < 2; ++impl) {
+    // Bias add.
+    b->Args({impl, 1024, 1024, 1});
+    // Per-row scale.
+    b->Args({impl, 1024, 1024, 0});
+    // Narrow rows (channels).
+    b->Args({impl, 64 * 1024, 16, 1});
+  }
+}
+
+BENCHMARK(BM_BroadcastAdd)->Apply(BroadcastAddArguments)->UseRealTime();
+
+}  // namespace
+}  // namespace kernels
+}  // namespace hal
+}  // namespace iree
@@ -15,10 +15,22 @@
 #ifndef IREE_HAL_INTERPRETER_BYTECODE_KERNELS_GENERIC_H_
 #define IREE_HAL_INTERPRETER_BYTECODE_KERNELS_GENERIC_H_
 
-#include "absl/container/flat_hash_set.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <vector>
+
 #include "absl/container/inlined_vector.h"
 #include "absl/types/span.h"
 #include "iree/base/status.h"
+#include "iree/hal/host/thread_pool.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif  // __SSE2__ / __ARM_NEON
 
 namespace iree {
 namespace hal {
@@ -84,6 +96,171 @@ Status CompareGE::Execute(absl::Span<const T> lhs_buffer,
   return OkStatus();
 }
 
+namespace impl {
+
+// A dimension of a broadcasting elementwise op. Strides are in elements and
+// are 0 along dimensions where the operand is broadcast.
+struct BroadcastDimension {
+  size_t extent;
+  size_t lhs_stride;
+  size_t rhs_stride;
+};
+
+using BroadcastLayout = absl::InlinedVector<BroadcastDimension, 6>;
+
+// Computes the dimensions of a numpy-style broadcast of |lhs_shape| and
+// |rhs_shape| to |dst_shape|. Shapes are aligned on their innermost dimension
+// and operand dimensions must either match the destination or be 1. Unit
+// destination dimensions are dropped and adjacent dimensions broadcast the
+// same way for both operands are merged.
+inline StatusOr<BroadcastLayout> ComputeBroadcastLayout(
+    const Shape& lhs_shape, const Shape& rhs_shape, const Shape& dst_shape) {
+  int rank = dst_shape.size();
+  if (lhs_shape.size() > rank || rhs_shape.size() > rank) {
+    return InvalidArgumentErrorBuilder(IREE_LOC)
+           << "Cannot broadcast " << lhs_shape << " and " << rhs_shape
+           << " to " << dst_shape;
+  }
+  BroadcastLayout layout;
+  size_t lhs_stride = 1;
+  size_t rhs_stride = 1;
+  for (int i = rank - 1; i >= 0; --i) {
+    int lhs_dim = i - (rank - lhs_shape.size());
+    int rhs_dim = i - (rank - rhs_shape.size());
+    int lhs_extent = lhs_dim >= 0 ? lhs_shape[lhs_dim] : 1;
+    int rhs_extent = rhs_dim >= 0 ? rhs_shape[rhs_dim] : 1;
+    int extent = dst_shape[i];
+    if ((lhs_extent != extent && lhs_extent != 1) ||
+        (rhs_extent != extent && rhs_extent != 1)) {
+      return InvalidArgumentErrorBuilder(IREE_LOC)
+             << "Cannot broadcast " << lhs_shape << " and " << rhs_shape
+             << " to " << dst_shape;
+    }
+    if (extent == 1) continue;
+    BroadcastDimension dim = {static_cast<size_t>(extent),
+                              lhs_extent == 1 ? 0 : lhs_stride,
+                              rhs_extent == 1 ? 0 : rhs_stride};
+    lhs_stride *= lhs_extent;
+    rhs_stride *= rhs_extent;
+    if (!layout.empty() &&
+        (layout.back().lhs_stride == 0) == (dim.lhs_stride == 0) &&
+        (layout.back().rhs_stride == 0) == (dim.rhs_stride == 0)) {
+      layout.back().extent *= dim.extent;
+    } else {
+      layout.push_back(dim);
+    }
+  }
+  std::reverse(layout.begin(), layout.end());
+  return layout;
+}
+
+// Elements per block when an operand is broadcast along the innermost
+// dimension. The expanded block stays resident in L1 while the kernel runs.
+constexpr size_t kBroadcastBlockSize = 1024;
+
+}  // namespace impl
+
+template <typename KERNEL>
+template <typename T, typename DST_T>
+Status BroadcastBinary<KERNEL>::Execute(absl::Span<const T> lhs_buffer,
+                                        absl::Span<const T> rhs_buffer,
+                                        absl::Span<DST_T> dst_buffer,
+                                        const Shape& lhs_shape,
+                                        const Shape& rhs_shape,
+                                        const Shape& dst_shape) {
+  size_t element_count = dst_shape.element_count();
+  if (static_cast<size_t>(lhs_shape.element_count()) == element_count &&
+      static_cast<size_t>(rhs_shape.element_count()) == element_count) {
+    return KERNEL::Execute(lhs_buffer, rhs_buffer, dst_buffer);
+  }
+  ASSIGN_OR_RETURN(auto layout, impl::ComputeBroadcastLayout(
+                                    lhs_shape, rhs_shape, dst_shape));
+  if (element_count == 0) return OkStatus();
+  if (layout.empty()) layout.push_back({1, 0, 0});
+
+  // The innermost dimension is handed to the kernel as contiguous runs. An
+  // operand broadcast along it is expanded into a block-sized buffer that is
+  // only refilled when the broadcast value changes.
+  const auto inner = layout.back();
+  layout.pop_back();
+  bool lhs_expand = inner.lhs_stride == 0;
+  bool rhs_expand = inner.rhs_stride == 0;
+
+  // Short rows of an operand repeated along the next dimension (such as a
+  // bias add over few channels) are instead tiled into a block of rows so that
+  // the kernel runs over several rows at once.
+  size_t row_count = 1;
+  size_t run_rows = 1;
+  if (!lhs_expand && !rhs_expand && !layout.empty() &&
+      inner.extent <= impl::kBroadcastBlockSize / 2) {
+    const auto next = layout.back();
+    layout.pop_back();
+    lhs_expand = next.lhs_stride == 0;
+    rhs_expand = next.rhs_stride == 0;
+    row_count = next.extent;
+    run_rows = std::min(row_count, impl::kBroadcastBlockSize / inner.extent);
+  }
+  size_t block_size = run_rows * inner.extent;
+  if (lhs_expand || rhs_expand) {
+    block_size = std::min(block_size, impl::kBroadcastBlockSize);
+  }
+  auto expand = [&](absl::Span<const T> buffer, size_t offset,
+                    std::vector<T>* block) {
+    if (run_rows == 1) {
+      std::fill(block->begin(), block->end(), buffer[offset]);
+      return;
+    }
+    for (size_t row = 0; row < run_rows; ++row) {
+      std::copy_n(buffer.data() + offset, inner.extent,
+                  block->data() + row * inner.extent);
+    }
+  };
+  std::vector<T> lhs_block(lhs_expand ? block_size : 0);
+  std::vector<T> rhs_block(rhs_expand ? block_size : 0);
+  size_t lhs_block_offset = ~size_t(0);
+  size_t rhs_block_offset = ~size_t(0);
+
+  absl::InlinedVector<size_t, 6> indices(layout.size(), 0);
+  size_t lhs_offset = 0;
+  size_t rhs_offset = 0;
+  for (size_t dst_offset = 0; dst_offset < element_count;
+       dst_offset += row_count * inner.extent) {
+    if (lhs_expand && lhs_offset != lhs_block_offset) {
+      expand(lhs_buffer, lhs_offset, &lhs_block);
+      lhs_block_offset = lhs_offset;
+    }
+    if (rhs_expand && rhs_offset != rhs_block_offset) {
+      expand(rhs_buffer, rhs_offset, &rhs_block);
+      rhs_block_offset = rhs_offset;
+    }
+    for (size_t row = 0; row < row_count; row += run_rows) {
+      size_t run_offset = row * inner.extent;
+      size_t run_length = std::min(run_rows, row_count - row) * inner.extent;
+      for (size_t begin = 0; begin < run_length; begin += block_size) {
+        size_t count = std::min(block_size, run_length - begin);
+        size_t offset = run_offset + begin;
+        RETURN_IF_ERROR(KERNEL::Execute(
+            lhs_expand ? absl::MakeConstSpan(lhs_block.data(), count)
+                       : lhs_buffer.subspan(lhs_offset + offset, count),
+            rhs_expand ? absl::MakeConstSpan(rhs_block.data(), count)
+                       : rhs_buffer.subspan(rhs_offset + offset, count),
+            dst_buffer.subspan(dst_offset + offset, count)));
+      }
+    }
+
+    // Advance the outer dimensions.
+    for (int i = layout.size() - 1; i >= 0; --i) {
+      lhs_offset += layout[i].lhs_stride;
+      rhs_offset += layout[i].rhs_stride;
+      if (++indices[i] < layout[i].extent) break;
+      lhs_offset -= layout[i].extent * layout[i].lhs_stride;
+      rhs_offset -= layout[i].extent * layout[i].rhs_stride;
+      indices[i] = 0;
+    }
+  }
+  return OkStatus();
+}
+
 namespace impl {
 inline absl::InlinedVector<size_t, 6> ComputeCopyStrides(const Shape& shape,
                                                          size_t element_size) {
@@ -124,6 +301,50 @@ inline void CopyRegion(absl::Span<const uint8_t> src_buffer,
                 length);
   }
 }
+
+// A loop over one dimension of a strided copy. Strides may be in bytes or
+// elements (as chosen by the user) and may be negative.
+struct StridedLoop {
+  ptrdiff_t extent;
+  ptrdiff_t src_stride;
+  ptrdiff_t dst_stride;
+};
+
+// Walks the source and destination offsets of a nest of loops starting at the
+// linear |index| without dividing per step. Kernels use this for all but the
+// innermost dimensions and handle each innermost row as a contiguous run.
+class StridedLoopIterator {
+ public:
+  StridedLoopIterator(absl::Span<const StridedLoop> loops, size_t index)
+      : loops_(loops), indices_(loops.size()) {
+    for (int i = loops_.size() - 1; i >= 0; --i) {
+      indices_[i] = index % loops_[i].extent;
+      index /= loops_[i].extent;
+      src_offset_ += indices_[i] * loops_[i].src_stride;
+      dst_offset_ += indices_[i] * loops_[i].dst_stride;
+    }
+  }
+
+  ptrdiff_t src_offset() const { return src_offset_; }
+  ptrdiff_t dst_offset() const { return dst_offset_; }
+
+  void Next() {
+    for (int i = loops_.size() - 1; i >= 0; --i) {
+      src_offset_ += loops_[i].src_stride;
+      dst_offset_ += loops_[i].dst_stride;
+      if (++indices_[i] < loops_[i].extent) return;
+      src_offset_ -= loops_[i].extent * loops_[i].src_stride;
+      dst_offset_ -= loops_[i].extent * loops_[i].dst_stride;
+      indices_[i] = 0;
+    }
+  }
+
+ private:
+  absl::Span<const StridedLoop> loops_;
+  absl::InlinedVector<ptrdiff_t, 6> indices_;
+  ptrdiff_t src_offset_ = 0;
+  ptrdiff_t dst_offset_ = 0;
+};
 }  // namespace impl
 
 // TODO(benvanik): replace with a real implementation once copy is defined.
@@ -166,59 +387,524 @@ Status Select::Execute(absl::Span<const uint8_t> cond_buffer,
   return OkStatus();
 }
 
-template <typename T>
-Status Transpose::Execute(absl::Span<const T> src_buffer,
-                          absl::Span<T> dst_buffer, const Shape& src_shape,
-                          absl::Span<const int32_t> perm) {
-  // This implementation is .... not fast.
+namespace impl {
+
+// Transposes are canonicalized by dropping unit dimensions and merging
+// dimensions that remain adjacent and in order in the output. The result is
+// the minimal set of source |dims| and the |perm| of them producing the output.
+struct TransposeLayout {
+  absl::InlinedVector<size_t, 6> dims;
+  absl::InlinedVector<int, 6> perm;
+};
+
+inline TransposeLayout ComputeTransposeLayout(const Shape& src_shape,
+                                              absl::Span<const int32_t> perm) {
   int rank = src_shape.size();
-  absl::InlinedVector<int, 8> src_strides(rank);
-  absl::InlinedVector<int, 8> dst_strides(rank);
-  size_t src_stride = 1;
-  size_t dst_stride = 1;
-  for (int dim_i = rank - 1; dim_i >= 0; --dim_i) {
-    src_strides[dim_i] = src_stride;
-    dst_strides[dim_i] = dst_stride;
-    src_stride *= src_shape[dim_i];
-    dst_stride *= src_shape[perm[dim_i]];
+  // Index of each source dimension once unit dimensions are dropped.
+  absl::InlinedVector<int, 6> squeezed_dims(rank, -1);
+  int squeezed_rank = 0;
+  for (int i = 0; i < rank; ++i) {
+    if (src_shape[i] != 1) squeezed_dims[i] = squeezed_rank++;
   }
-  for (size_t dst_i = 0; dst_i < dst_buffer.size(); ++dst_i) {
-    size_t src_i = 0;
-    size_t t = dst_i;
-    for (int dim_i = 0; dim_i < rank; ++dim_i) {
-      size_t ratio = t / dst_strides[dim_i];
-      t -= ratio * dst_strides[dim_i];
-      src_i += ratio * src_strides[perm[dim_i]];
+
+  // Runs of squeezed source dimensions in output order as (first, size).
+  absl::InlinedVector<std::pair<int, size_t>, 6> runs;
+  int last_dim = -1;
+  for (int i = 0; i < rank; ++i) {
+    int dim = squeezed_dims[perm[i]];
+    if (dim == -1) continue;
+    if (!runs.empty() && dim == last_dim + 1) {
+      runs.back().second *= src_shape[perm[i]];
+    } else {
+      runs.push_back({dim, static_cast<size_t>(src_shape[perm[i]])});
     }
-    dst_buffer[dst_i] = src_buffer[src_i];
+    last_dim = dim;
   }
-  return OkStatus();
+
+  // Each run becomes a single dimension in source order.
+  int run_count = runs.size();
+  absl::InlinedVector<int, 6> order(run_count);
+  for (int i = 0; i < run_count; ++i) order[i] = i;
+  std::sort(order.begin(), order.end(), [&runs](int lhs, int rhs) {
+    return runs[lhs].first < runs[rhs].first;
+  });
+  TransposeLayout layout;
+  layout.dims.resize(run_count);
+  layout.perm.resize(run_count);
+  for (int i = 0; i < run_count; ++i) {
+    layout.dims[i] = runs[order[i]].second;
+    layout.perm[order[i]] = i;
+  }
+  return layout;
 }
 
-namespace impl {
-inline void IncrementShapeIndex(absl::Span<int32_t> indices,
-                                const Shape& shape) {
-  for (int i = indices.size() - 1; i >= 0; --i) {
-    if (++indices[i] < shape[i]) return;
-    indices[i] = 0;
+// Transposes a square tile of elements of |element_size| bytes such that
+// dst[j][i] = src[i][j]. Strides are in bytes. Specialized below with SIMD
+// register transposes when available.
+template <size_t element_size>
+struct TransposeTile {
+  static constexpr size_t size() {
+    return element_size == 1 ? 8 : std::max<size_t>(1, 16 / element_size);
+  }
+
+  static inline void Run(const uint8_t* src, size_t src_stride, uint8_t* dst,
+                         size_t dst_stride) {
+    for (size_t i = 0; i < size(); ++i) {
+      for (size_t j = 0; j < size(); ++j) {
+        std::memcpy(dst + j * dst_stride + i * element_size,
+                    src + i * src_stride + j * element_size, element_size);
+      }
+    }
+  }
+};
+
+#if defined(__SSE2__)
+
+template <>
+inline void TransposeTile<1>::Run(const uint8_t* src, size_t src_stride,
+                                  uint8_t* dst, size_t dst_stride) {
+  __m128i r[8];
+  for (int i = 0; i < 8; ++i) {
+    r[i] = _mm_loadl_epi64(
+        reinterpret_cast<const __m128i*>(src + i * src_stride));
+  }
+  __m128i a0 = _mm_unpacklo_epi8(r[0], r[1]);
+  __m128i a1 = _mm_unpacklo_epi8(r[2], r[3]);
+  __m128i a2 = _mm_unpacklo_epi8(r[4], r[5]);
+  __m128i a3 = _mm_unpacklo_epi8(r[6], r[7]);
+  __m128i b0 = _mm_unpacklo_epi16(a0, a1);
+  __m128i b1 = _mm_unpackhi_epi16(a0, a1);
+  __m128i b2 = _mm_unpacklo_epi16(a2, a3);
+  __m128i b3 = _mm_unpackhi_epi16(a2, a3);
+  // Each register holds two output rows.
+  __m128i c[4] = {
+      _mm_unpacklo_epi32(b0, b2),
+      _mm_unpackhi_epi32(b0, b2),
+      _mm_unpacklo_epi32(b1, b3),
+      _mm_unpackhi_epi32(b1, b3),
+  };
+  for (int i = 0; i < 4; ++i) {
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + (2 * i) * dst_stride),
+                     c[i]);
+    _mm_storel_epi64(
+        reinterpret_cast<__m128i*>(dst + (2 * i + 1) * dst_stride),
+        _mm_unpackhi_epi64(c[i], c[i]));
   }
 }
 
-inline bool IsPadding(absl::Span<const int32_t> indices, const Shape& shape,
-                      absl::Span<const int32_t> edge_padding_low,
-                      absl::Span<const int32_t> edge_padding_high,
-                      absl::Span<const int32_t> interior_padding) {
-  for (int i = 0; i < indices.size(); ++i) {
-    auto index = indices[i];
-    if (index < edge_padding_low[i] ||
-        index >= shape[i] - edge_padding_high[i] ||
-        (index - edge_padding_low[i]) % (interior_padding[i] + 1) != 0) {
-      return true;
+template <>
+inline void TransposeTile<2>::Run(const uint8_t* src, size_t src_stride,
+                                  uint8_t* dst, size_t dst_stride) {
+  __m128i r[8];
+  for (int i = 0; i < 8; ++i) {
+    r[i] = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(src + i * src_stride));
+  }
+  __m128i a0 = _mm_unpacklo_epi16(r[0], r[1]);
+  __m128i a1 = _mm_unpackhi_epi16(r[0], r[1]);
+  __m128i a2 = _mm_unpacklo_epi16(r[2], r[3]);
+  __m128i a3 = _mm_unpackhi_epi16(r[2], r[3]);
+  __m128i a4 = _mm_unpacklo_epi16(r[4], r[5]);
+  __m128i a5 = _mm_unpackhi_epi16(r[4], r[5]);
+  __m128i a6 = _mm_unpacklo_epi16(r[6], r[7]);
+  __m128i a7 = _mm_unpackhi_epi16(r[6], r[7]);
+  __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+  __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+  __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+  __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+  __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+  __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+  __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+  __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+  __m128i c[8] = {
+      _mm_unpacklo_epi64(b0, b4), _mm_unpackhi_epi64(b0, b4),
+      _mm_unpacklo_epi64(b1, b5), _mm_unpackhi_epi64(b1, b5),
+      _mm_unpacklo_epi64(b2, b6), _mm_unpackhi_epi64(b2, b6),
+      _mm_unpacklo_epi64(b3, b7), _mm_unpackhi_epi64(b3, b7),
+  };
+  for (int i = 0; i < 8; ++i) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * dst_stride), c[i]);
+  }
+}
+
+template <>
+inline void TransposeTile<4>::Run(const uint8_t* src, size_t src_stride,
+                                  uint8_t* dst, size_t dst_stride) {
+  __m128i r[4];
+  for (int i = 0; i < 4; ++i) {
+    r[i] = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(src + i * src_stride));
+  }
+  __m128i a0 = _mm_unpacklo_epi32(r[0], r[1]);
+  __m128i a1 = _mm_unpacklo_epi32(r[2], r[3]);
+  __m128i a2 = _mm_unpackhi_epi32(r[0], r[1]);
+  __m128i a3 = _mm_unpackhi_epi32(r[2], r[3]);
+  __m128i c[4] = {
+      _mm_unpacklo_epi64(a0, a1),
+      _mm_unpackhi_epi64(a0, a1),
+      _mm_unpacklo_epi64(a2, a3),
+      _mm_unpackhi_epi64(a2, a3),
+  };
+  for (int i = 0; i < 4; ++i) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * dst_stride), c[i]);
+  }
+}
+
+template <>
+inline void TransposeTile<8>::Run(const uint8_t* src, size_t src_stride,
+                                  uint8_t* dst, size_t dst_stride) {
+  __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+  __m128i r1 =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + src_stride));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),
+                   _mm_unpacklo_epi64(r0, r1));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + dst_stride),
+                   _mm_unpackhi_epi64(r0, r1));
+}
+
+#elif defined(__ARM_NEON)
+
+template <>
+inline void TransposeTile<1>::Run(const uint8_t* src, size_t src_stride,
+                                  uint8_t* dst, size_t dst_stride) {
+  uint8x8_t r[8];
+  for (int i = 0; i < 8; ++i) r[i] = vld1_u8(src + i * src_stride);
+  uint8x8x2_t t01 = vtrn_u8(r[0], r[1]);
+  uint8x8x2_t t23 = vtrn_u8(r[2], r[3]);
+  uint8x8x2_t t45 = vtrn_u8(r[4], r[5]);
+  uint8x8x2_t t67 = vtrn_u8(r[6], r[7]);
+  uint16x4x2_t u02 = vtrn_u16(vreinterpret_u16_u8(t01.val[0]),
+                              vreinterpret_u16_u8(t23.val[0]));
+  uint16x4x2_t u13 = vtrn_u16(vreinterpret_u16_u8(t01.val[1]),
+                              vreinterpret_u16_u8(t23.val[1]));
+  uint16x4x2_t u46 = vtrn_u16(vreinterpret_u16_u8(t45.val[0]),
+                              vreinterpret_u16_u8(t67.val[0]));
+  uint16x4x2_t u57 = vtrn_u16(vreinterpret_u16_u8(t45.val[1]),
+                              vreinterpret_u16_u8(t67.val[1]));
+  // Output rows (i, i + 4) for i in [0, 4).
+  uint32x2x2_t v[4] = {
+      vtrn_u32(vreinterpret_u32_u16(u02.val[0]),
+               vreinterpret_u32_u16(u46.val[0])),
+      vtrn_u32(vreinterpret_u32_u16(u13.val[0]),
+               vreinterpret_u32_u16(u57.val[0])),
+      vtrn_u32(vreinterpret_u32_u16(u02.val[1]),
+               vreinterpret_u32_u16(u46.val[1])),
+      vtrn_u32(vreinterpret_u32_u16(u13.val[1]),
+               vreinterpret_u32_u16(u57.val[1])),
+  };
+  for (int i = 0; i < 4; ++i) {
+    vst1_u8(dst + i * dst_stride, vreinterpret_u8_u32(v[i].val[0]));
+    vst1_u8(dst + (i + 4) * dst_stride, vreinterpret_u8_u32(v[i].val[1]));
+  }
+}
+
+template <>
+inline void TransposeTile<2>::Run(const uint8_t* src, size_t src_stride,
+                                  uint8_t* dst, size_t dst_stride) {
+  uint16x8_t r[8];
+  for (int i = 0; i < 8; ++i) {
+    r[i] = vreinterpretq_u16_u8(vld1q_u8(src + i * src_stride));
+  }
+  uint16x8x2_t t01 = vtrnq_u16(r[0], r[1]);
+  uint16x8x2_t t23 = vtrnq_u16(r[2], r[3]);
+  uint16x8x2_t t45 = vtrnq_u16(r[4], r[5]);
+  uint16x8x2_t t67 = vtrnq_u16(r[6], r[7]);
+  uint32x4x2_t u0 = vtrnq_u32(vreinterpretq_u32_u16(t01.val[0]),
+                              vreinterpretq_u32_u16(t23.val[0]));
+  uint32x4x2_t u1 = vtrnq_u32(vreinterpretq_u32_u16(t01.val[1]),
+                              vreinterpretq_u32_u16(t23.val[1]));
+  uint32x4x2_t u2 = vtrnq_u32(vreinterpretq_u32_u16(t45.val[0]),
+                              vreinterpretq_u32_u16(t67.val[0]));
+  uint32x4x2_t u3 = vtrnq_u32(vreinterpretq_u32_u16(t45.val[1]),
+                              vreinterpretq_u32_u16(t67.val[1]));
+  uint32x4_t c[8] = {
+      vcombine_u32(vget_low_u32(u0.val[0]), vget_low_u32(u2.val[0])),
+      vcombine_u32(vget_low_u32(u1.val[0]), vget_low_u32(u3.val[0])),
+      vcombine_u32(vget_low_u32(u0.val[1]), vget_low_u32(u2.val[1])),
+      vcombine_u32(vget_low_u32(u1.val[1]), vget_low_u32(u3.val[1])),
+      vcombine_u32(vget_high_u32(u0.val[0]), vget_high_u32(u2.val[0])),
+      vcombine_u32(vget_high_u32(u1.val[0]), vget_high_u32(u3.val[0])),
+      vcombine_u32(vget_high_u32(u0.val[1]), vget_high_u32(u2.val[1])),
+      vcombine_u32(vget_high_u32(u1.val[1]), vget_high_u32(u3.val[1])),
+  };
+  for (int i = 0; i < 8; ++i) {
+    vst1q_u8(dst + i * dst_stride, vreinterpretq_u8_u32(c[i]));
+  }
+}
+
+template <>
+inline void TransposeTile<4>::Run(const uint8_t* src, size_t src_stride,
+                                  uint8_t* dst, size_t dst_stride) {
+  uint32x4_t r[4];
+  for (int i = 0; i < 4; ++i) {
+    r[i] = vreinterpretq_u32_u8(vld1q_u8(src + i * src_stride));
+  }
+  uint32x4x2_t t01 = vtrnq_u32(r[0], r[1]);
+  uint32x4x2_t t23 = vtrnq_u32(r[2], r[3]);
+  uint32x4_t c[4] = {
+      vcombine_u32(vget_low_u32(t01.val[0]), vget_low_u32(t23.val[0])),
+      vcombine_u32(vget_low_u32(t01.val[1]), vget_low_u32(t23.val[1])),
+      vcombine_u32(vget_high_u32(t01.val[0]), vget_high_u32(t23.val[0])),
+      vcombine_u32(vget_high_u32(t01.val[1]), vget_high_u32(t23.val[1])),
+  };
+  for (int i = 0; i < 4; ++i) {
+    vst1q_u8(dst + i * dst_stride, vreinterpretq_u8_u32(c[i]));
+  }
+}
+
+template <>
+inline void TransposeTile<8>::Run(const uint8_t* src, size_t src_stride,
+                                  uint8_t* dst, size_t dst_stride) {
+  uint64x2_t r0 = vreinterpretq_u64_u8(vld1q_u8(src));
+  uint64x2_t r1 = vreinterpretq_u64_u8(vld1q_u8(src + src_stride));
+  vst1q_u8(dst, vreinterpretq_u8_u64(
+                    vcombine_u64(vget_low_u64(r0), vget_low_u64(r1))));
+  vst1q_u8(dst + dst_stride,
+           vreinterpretq_u8_u64(
+               vcombine_u64(vget_high_u64(r0), vget_high_u64(r1))));
+}
+
+#endif  // __SSE2__ / __ARM_NEON
+
+// Transposes a |rows| x |cols| region element by element.
+template <size_t element_size>
+inline void TransposeScalar(const uint8_t* src, size_t src_stride,
+                            uint8_t* dst, size_t dst_stride, size_t rows,
+                            size_t cols) {
+  for (size_t i = 0; i < rows; ++i) {
+    for (size_t j = 0; j < cols; ++j) {
+      std::memcpy(dst + j * dst_stride + i * element_size,
+                  src + i * src_stride + j * element_size, element_size);
     }
   }
+}
 
-  return false;
+// Rows and columns per cache block when transposing a plane. A block of the
+// source and of the destination together stay within L1 for all element sizes.
+constexpr size_t kTransposeBlockSize = 32;
+
+// Transposes a |rows| x |cols| plane such that dst[j][i] = src[i][j] by
+// walking cache blocks of tiles. Strides are in bytes.
+template <size_t element_size>
+inline void TransposePlane(const uint8_t* src, size_t src_stride,
+                           uint8_t* dst, size_t dst_stride, size_t rows,
+                           size_t cols) {
+  using Tile = TransposeTile<element_size>;
+  const size_t tile_size = Tile::size();
+  for (size_t i0 = 0; i0 < rows; i0 += kTransposeBlockSize) {
+    size_t i1 = std::min(rows, i0 + kTransposeBlockSize);
+    for (size_t j0 = 0; j0 < cols; j0 += kTransposeBlockSize) {
+      size_t j1 = std::min(cols, j0 + kTransposeBlockSize);
+      size_t i = i0;
+      for (; i + tile_size <= i1; i += tile_size) {
+        size_t j = j0;
+        for (; j + tile_size <= j1; j += tile_size) {
+          Tile::Run(src + i * src_stride + j * element_size, src_stride,
+                    dst + j * dst_stride + i * element_size, dst_stride);
+        }
+        TransposeScalar<element_size>(
+            src + i * src_stride + j * element_size, src_stride,
+            dst + j * dst_stride + i * element_size, dst_stride, tile_size,
+            j1 - j);
+      }
+      TransposeScalar<element_size>(
+          src + i * src_stride + j0 * element_size, src_stride,
+          dst + j0 * dst_stride + i * element_size, dst_stride, i1 - i,
+          j1 - j0);
+    }
+  }
 }
+
+// Elements below which transposes run inline on the calling thread and the
+// approximate number of elements handled by each parallel work item.
+constexpr size_t kTransposeParallelThreshold = 64 * 1024;
+constexpr size_t kTransposeParallelGrain = 16 * 1024;
+
+template <size_t element_size>
+Status GenericTranspose(const uint8_t* src, size_t src_size, uint8_t* dst,
+                        size_t dst_size, const Shape& src_shape,
+                        absl::Span<const int32_t> perm,
+                        ThreadPool* thread_pool) {
+  int rank = src_shape.size();
+  if (static_cast<int>(perm.size()) != rank) {
+    return InvalidArgumentErrorBuilder(IREE_LOC)
+           << "Transpose permutation has " << perm.size()
+           << " dimensions but the source has rank " << rank;
+  }
+  absl::InlinedVector<bool, 6> seen(rank, false);
+  for (int32_t dim : perm) {
+    if (dim < 0 || dim >= rank || seen[dim]) {
+      return InvalidArgumentErrorBuilder(IREE_LOC)
+             << "Invalid transpose permutation for rank " << rank;
+    }
+    seen[dim] = true;
+  }
+  size_t element_count = src_shape.element_count();
+  if (src_size != element_count || dst_size != element_count) {
+    return InvalidArgumentErrorBuilder(IREE_LOC)
+           << "Transpose of " << element_count << " elements has source size "
+           << src_size << " and destination size " << dst_size;
+  }
+  if (element_count == 0) return OkStatus();
+
+  auto layout = ComputeTransposeLayout(src_shape, perm);
+  int layout_rank = layout.dims.size();
+  if (layout_rank <= 1) {
+    // Only unit dimensions moved; the data is unchanged.
+    std::memcpy(dst, src, element_count * element_size);
+    return OkStatus();
+  }
+
+  // Byte strides of the source dimensions in each buffer.
+  absl::InlinedVector<ptrdiff_t, 6> src_strides(layout_rank);
+  absl::InlinedVector<ptrdiff_t, 6> dst_strides(layout_rank);
+  ptrdiff_t src_stride = element_size;
+  ptrdiff_t dst_stride = element_size;
+  for (int i = layout_rank - 1; i >= 0; --i) {
+    src_strides[i] = src_stride;
+    src_stride *= layout.dims[i];
+    dst_strides[layout.perm[i]] = dst_stride;
+    dst_stride *= layout.dims[layout.perm[i]];
+  }
+  bool parallel = thread_pool && thread_pool->concurrency() > 1 &&
+                  element_count >= kTransposeParallelThreshold;
+
+  // The source dimensions that end up innermost in the destination and that
+  // are innermost in the source.
+  int dst_inner_dim = layout.perm[layout_rank - 1];
+  int src_inner_dim = layout_rank - 1;
+  if (dst_inner_dim == src_inner_dim) {
+    // The innermost dimension is unmoved and each contiguous row is copied.
+    absl::InlinedVector<StridedLoop, 6> loops;
+    size_t row_count = 1;
+    for (int i = 0; i < layout_rank - 1; ++i) {
+      int dim = layout.perm[i];
+      loops.push_back({static_cast<ptrdiff_t>(layout.dims[dim]),
+                       src_strides[dim], dst_strides[dim]});
+      row_count *= layout.dims[dim];
+    }
+    size_t row_length = layout.dims[src_inner_dim] * element_size;
+    auto copy_rows = [&](size_t row_begin, size_t row_end) {
+      StridedLoopIterator it(loops, row_begin);
+      for (size_t row = row_begin; row < row_end; ++row, it.Next()) {
+        std::memcpy(dst + it.dst_offset(), src + it.src_offset(), row_length);
+      }
+    };
+    if (!parallel) {
+      copy_rows(0, row_count);
+      return OkStatus();
+    }
+    int32_t grain = static_cast<int32_t>(std::max<size_t>(
+        1, kTransposeParallelGrain / layout.dims[src_inner_dim]));
+    return thread_pool->ParallelFor(static_cast<int32_t>(row_count), grain,
+                                    [&](int32_t begin, int32_t end) {
+                                      copy_rows(begin, end);
+                                      return OkStatus();
+                                    });
+  }
+  size_t rows = layout.dims[dst_inner_dim];
+  size_t cols = layout.dims[src_inner_dim];
+
+  // All remaining dimensions select planes in destination order.
+  absl::InlinedVector<StridedLoop, 6> loops;
+  size_t plane_count = 1;
+  for (int i = 0; i < layout_rank; ++i) {
+    int dim = layout.perm[i];
+    if (dim == dst_inner_dim || dim == src_inner_dim) continue;
+    loops.push_back({static_cast<ptrdiff_t>(layout.dims[dim]),
+                     src_strides[dim], dst_strides[dim]});
+    plane_count *= layout.dims[dim];
+  }
+  auto transpose_rows = [&](const StridedLoopIterator& it, size_t row_begin,
+                            size_t row_end) {
+    TransposePlane<element_size>(
+        src + it.src_offset() + row_begin * src_strides[dst_inner_dim],
+        src_strides[dst_inner_dim],
+        dst + it.dst_offset() + row_begin * element_size,
+        dst_strides[src_inner_dim], row_end - row_begin, cols);
+  };
+  if (!parallel) {
+    StridedLoopIterator it(loops, 0);
+    for (size_t plane = 0; plane < plane_count; ++plane, it.Next()) {
+      transpose_rows(it, 0, rows);
+    }
+    return OkStatus();
+  }
+
+  // Split planes into blocks of rows so that small plane counts still spread
+  // across all threads.
+  size_t row_block_size =
+      kTransposeBlockSize *
+      std::max<size_t>(1,
+                       kTransposeParallelGrain / (kTransposeBlockSize * cols));
+  size_t row_block_count = (rows + row_block_size - 1) / row_block_size;
+  return thread_pool->ParallelFor(
+      {static_cast<int32_t>(row_block_count),
+       static_cast<int32_t>(plane_count), 1},
+      {1, 1, 1}, [&](const ThreadPool::Tile& tile) {
+        StridedLoopIterator it(loops, tile.origin[1]);
+        size_t row_begin = tile.origin[0] * row_block_size;
+        transpose_rows(it, row_begin,
+                       std::min(rows, row_begin + row_block_size));
+        return OkStatus();
+      });
+}
+
+}  // namespace impl
+
+template <typename T>
+Status Transpose::Execute(absl::Span<const T> src_buffer,
+                          absl::Span<T> dst_buffer, const Shape& src_shape,
+                          absl::Span<const int32_t> perm,
+                          ThreadPool* thread_pool) {
+  return impl::GenericTranspose<sizeof(T)>(
+      reinterpret_cast<const uint8_t*>(src_buffer.data()), src_buffer.size(),
+      reinterpret_cast<uint8_t*>(dst_buffer.data()), dst_buffer.size(),
+      src_shape, perm, thread_pool);
+}
+
+namespace impl {
+
+// The source indices of one dimension kept by a pad. Source index k lands at
+// destination index low + k * (interior + 1); with negative edge padding the
+// leading and trailing source indices fall outside the destination and are
+// dropped.
+struct PadDimension {
+  // First source index that is kept.
+  ptrdiff_t src_begin = 0;
+  // Number of source indices kept.
+  ptrdiff_t count = 0;
+  // Destination index of |src_begin|.
+  ptrdiff_t dst_begin = 0;
+  // Distance between destination indices of adjacent source indices.
+  ptrdiff_t step = 1;
+};
+
+inline StatusOr<PadDimension> ComputePadDimension(ptrdiff_t src_extent,
+                                                  ptrdiff_t dst_extent,
+                                                  ptrdiff_t low,
+                                                  ptrdiff_t high,
+                                                  ptrdiff_t interior) {
+  ptrdiff_t expected_extent = low + high + src_extent;
+  if (src_extent > 0) expected_extent += (src_extent - 1) * interior;
+  if (interior < 0 || expected_extent != dst_extent) {
+    return InvalidArgumentErrorBuilder(IREE_LOC)
+           << "Padding (" << low << ", " << high << ", " << interior
+           << ") of extent " << src_extent << " does not produce extent "
+           << dst_extent;
+  }
+  PadDimension dim;
+  dim.step = interior + 1;
+  dim.src_begin = low >= 0 ? 0 : (-low + dim.step - 1) / dim.step;
+  ptrdiff_t src_end =
+      dst_extent > low
+          ? std::min(src_extent, (dst_extent - 1 - low) / dim.step + 1)
+          : 0;
+  dim.count = std::max<ptrdiff_t>(0, src_end - dim.src_begin);
+  dim.dst_begin = low + dim.src_begin * dim.step;
+  return dim;
+}
+
 }  // namespace impl
 
 template <typename T>
@@ -229,37 +915,86 @@ Status Pad::Execute(absl::Span<const T> src_buffer,
                     absl::Span<const int32_t> edge_padding_low,
                     absl::Span<const int32_t> edge_padding_high,
                     absl::Span<const int32_t> interior_padding) {
-  // This implementation is not at all fast, as it iterates every index in the
-  // destination buffer individually. Potential improvements:
-  // 1. Fill the dst buffer with padded value initially. Only need to iterate
-  //    through source buffer and can exit early.
-  // 2. Use striding to advance through larger swaths of the buffer with a
-  //    memcpy from src and filling (or skipping) padded incides. Especially
-  //    useful when e.g. entire rows are padded.
-
-  // TODO(b/140836672) support negative padding
-
   if (padding_value_buffer.size() != 1) {
     return InvalidArgumentErrorBuilder(IREE_LOC)
            << "Padding value buffer is larger than one element.";
   }
-  auto padding_value = padding_value_buffer.front();
+  const T padding_value = padding_value_buffer.front();
+  int rank = src_shape.size();
+  if (dst_shape.size() != rank ||
+      static_cast<int>(edge_padding_low.size()) != rank ||
+      static_cast<int>(edge_padding_high.size()) != rank ||
+      static_cast<int>(interior_padding.size()) != rank) {
+    return InvalidArgumentErrorBuilder(IREE_LOC)
+           << "Padding rank does not match source rank " << rank;
+  }
+  absl::InlinedVector<impl::PadDimension, 6> dims(rank);
+  for (int i = 0; i < rank; ++i) {
+    ASSIGN_OR_RETURN(dims[i], impl::ComputePadDimension(
+                                  src_shape[i], dst_shape[i],
+                                  edge_padding_low[i], edge_padding_high[i],
+                                  interior_padding[i]));
+  }
+  const T* src = src_buffer.data();
+  T* dst = dst_buffer.data();
+
+  // Trailing dimensions without padding are contiguous in both buffers and
+  // copied as a single chunk per kept source index of the innermost padded
+  // dimension.
+  int inner_dim = rank - 1;
+  ptrdiff_t chunk = 1;
+  while (inner_dim >= 0 && edge_padding_low[inner_dim] == 0 &&
+         edge_padding_high[inner_dim] == 0 &&
+         interior_padding[inner_dim] == 0) {
+    chunk *= src_shape[inner_dim--];
+  }
+  if (inner_dim < 0) {
+    std::memcpy(dst, src, dst_buffer.size() * sizeof(T));
+    return OkStatus();
+  }
 
-  absl::InlinedVector<int, 8> dst_indices(src_shape.size(), 0);
+  // Outer loops visit the rows of kept source elements in order.
+  absl::InlinedVector<impl::StridedLoop, 6> loops(inner_dim);
+  ptrdiff_t src_offset = dims[inner_dim].src_begin * chunk;
+  ptrdiff_t dst_offset = dims[inner_dim].dst_begin * chunk;
+  ptrdiff_t src_stride = src_shape[inner_dim] * chunk;
+  ptrdiff_t dst_stride = dst_shape[inner_dim] * chunk;
+  ptrdiff_t row_count = 1;
+  for (int i = inner_dim - 1; i >= 0; --i) {
+    loops[i] = {dims[i].count, src_stride, dst_stride * dims[i].step};
+    src_offset += dims[i].src_begin * src_stride;
+    dst_offset += dims[i].dst_begin * dst_stride;
+    src_stride *= src_shape[i];
+    dst_stride *= dst_shape[i];
+    row_count *= dims[i].count;
+  }
+  const auto& row = dims[inner_dim];
+  if (row_count == 0 || row.count == 0) {
+    std::fill(dst, dst + dst_buffer.size(), padding_value);
+    return OkStatus();
+  }
 
-  const T* src_ptr = src_buffer.begin();
-  T* dst_ptr = dst_buffer.begin();
-  while (dst_ptr != dst_buffer.end()) {
-    if (impl::IsPadding(dst_indices, dst_shape, edge_padding_low,
-                        edge_padding_high, interior_padding)) {
-      *dst_ptr++ = padding_value;
-    } else {
-      DCHECK(src_ptr != src_buffer.end());
-      *dst_ptr++ = *src_ptr++;
+  // Destination rows are visited in increasing order so everything between
+  // the copied runs is padding and is filled as a single run.
+  T* dst_cursor = dst;
+  impl::StridedLoopIterator it(loops, 0);
+  for (ptrdiff_t r = 0; r < row_count; ++r, it.Next()) {
+    const T* src_row = src + src_offset + it.src_offset();
+    T* dst_row = dst + dst_offset + it.dst_offset();
+    if (row.step == 1) {
+      std::fill(dst_cursor, dst_row, padding_value);
+      std::memcpy(dst_row, src_row, row.count * chunk * sizeof(T));
+      dst_cursor = dst_row + row.count * chunk;
+      continue;
+    }
+    for (ptrdiff_t k = 0; k < row.count; ++k) {
+      T* dst_chunk = dst_row + k * row.step * chunk;
+      std::fill(dst_cursor, dst_chunk, padding_value);
+      std::memcpy(dst_chunk, src_row + k * chunk, chunk * sizeof(T));
+      dst_cursor = dst_chunk + chunk;
     }
-    impl::IncrementShapeIndex(absl::MakeSpan(dst_indices), dst_shape);
   }
-
+  std::fill(dst_cursor, dst + dst_buffer.size(), padding_value);
   return OkStatus();
 }
 
@@ -267,26 +1002,63 @@ template <typename T>
 Status Reverse::Execute(absl::Span<const T> src_buffer,
                         absl::Span<T> dst_buffer, const Shape& src_shape,
                         absl::Span<const int32_t> dimensions) {
-  // This implementation is not fast either
   int rank = src_shape.size();
-  absl::InlinedVector<int, 8> strides(rank);
-  size_t stride = 1;
-  for (int dim_i = rank - 1; dim_i >= 0; --dim_i) {
-    strides[dim_i] = stride;
-    stride *= src_shape[dim_i];
+  absl::InlinedVector<bool, 6> reversed(rank, false);
+  for (int32_t dim : dimensions) {
+    if (dim < 0 || dim >= rank) {
+      return InvalidArgumentErrorBuilder(IREE_LOC)
+             << "Reverse dimension " << dim << " out of range for rank "
+             << rank;
+    }
+    reversed[dim] = true;
   }
-  absl::flat_hash_set<int32_t> dims_set(dimensions.begin(), dimensions.end());
-  for (size_t dst_i = 0; dst_i < dst_buffer.size(); ++dst_i) {
-    size_t src_i = 0;
-    size_t t = dst_i;
-    for (int dim_i = 0; dim_i < rank; ++dim_i) {
-      size_t ratio = t / strides[dim_i];
-      t -= ratio * strides[dim_i];
-      bool do_reverse = dims_set.contains(dim_i);
-      src_i += (do_reverse ? (src_shape[dim_i] - 1 - ratio) : ratio) *
-               strides[dim_i];
+  if (dst_buffer.empty()) return OkStatus();
+
+  // Adjacent dimensions that are both reversed (or both not) behave as one
+  // flattened dimension.
+  absl::InlinedVector<std::pair<ptrdiff_t, bool>, 6> dims;
+  for (int i = 0; i < rank; ++i) {
+    if (src_shape[i] == 1) continue;
+    if (!dims.empty() && dims.back().second == reversed[i]) {
+      dims.back().first *= src_shape[i];
+    } else {
+      dims.push_back({src_shape[i], reversed[i]});
+    }
+  }
+  const T* src = src_buffer.data();
+  T* dst = dst_buffer.data();
+  if (dims.empty()) {
+    std::memcpy(dst, src, dst_buffer.size() * sizeof(T));
+    return OkStatus();
+  }
+
+  // Reversed outer dimensions walk the source backwards from their last index.
+  ptrdiff_t row_length = dims.back().first;
+  bool reverse_row = dims.back().second;
+  absl::InlinedVector<impl::StridedLoop, 6> loops(dims.size() - 1);
+  ptrdiff_t src_offset = 0;
+  ptrdiff_t stride = row_length;
+  for (int i = loops.size() - 1; i >= 0; --i) {
+    ptrdiff_t extent = dims[i].first;
+    if (dims[i].second) {
+      loops[i] = {extent, -stride, stride};
+      src_offset += (extent - 1) * stride;
+    } else {
+      loops[i] = {extent, stride, stride};
+    }
+    stride *= extent;
+  }
+
+  size_t row_count = dst_buffer.size() / row_length;
+  impl::StridedLoopIterator it(loops, 0);
+  for (size_t r = 0; r < row_count; ++r, it.Next()) {
+    const T* src_row = src + src_offset + it.src_offset();
+    T* dst_row = dst + it.dst_offset();
+    if (reverse_row) {
+      std::reverse_copy(src_row, src_row + row_length, dst_row);
+    } else {
+      std::memcpy(dst_row, src_row, row_length * sizeof(T));
     }
-    dst_buffer[dst_i] = src_buffer[src_i];
   }
   return OkStatus();
 }
@@ -594,99 +1366,178 @@ struct MaxKernel {
   }
 };
 
+// Reductions view the source as [outer, reduce, inner] where |reduce| is the
+// dimension being reduced and the destination as [outer, inner].
+struct ReductionLayout {
+  size_t outer = 1;
+  size_t reduce = 1;
+  size_t inner = 1;
+};
+
+inline ReductionLayout ComputeReductionLayout(const Shape& src_shape,
+                                              int32_t dimension) {
+  ReductionLayout layout;
+  for (int i = 0; i < dimension; ++i) layout.outer *= src_shape[i];
+  layout.reduce = src_shape[dimension];
+  for (int i = dimension + 1; i < src_shape.size(); ++i) {
+    layout.inner *= src_shape[i];
+  }
+  return layout;
+}
+
+// Number of independent accumulators used when reducing contiguous runs.
+// Splitting the dependency chain lets the compiler keep the accumulators in
+// SIMD registers.
+constexpr int kReduceLanes = 8;
+
+// Reduces |count| contiguous elements of |src| into |value|.
 template <typename T, typename KernelImpl>
-inline void ReduceDimension(absl::Span<const T> src_buffer,
-                            absl::Span<T> dst_buffer, const Shape& src_shape,
-                            absl::Span<const int32_t> reduce_dims,
-                            absl::Span<const int> dst_strides, int dim,
-                            absl::Span<int> src_indices, size_t flat_src_i,
-                            size_t src_stride) {
-  if (dim < 0) {
-    // Base case of the recursion - figure out which elements should be acted
-    // upon and apply the reduction kernel to them.
-
-    // Derive destination indices from source indices.
-    // For example,
-    //     reduce_dims: [1, 2]
-    //     src_indices: [2, 1, 3, 0]
-    //                      ^  ^
-    //                      |  |
-    //                      |----- remove these dimensions
-    //     dst_indices: [2, 0]
-    //
-    // TODO(scotttodd): Clean this up somehow, share across recursion levels?
-    size_t dst_size = src_shape.size() - reduce_dims.size();
-    absl::InlinedVector<int, 8> dst_indices;
-    for (size_t i = 0; i < src_indices.size(); ++i) {
-      if (std::find(std::begin(reduce_dims), std::end(reduce_dims), i) ==
-          std::end(reduce_dims)) {
-        dst_indices.push_back(src_indices[i]);
+inline T ReduceContiguous(const T* src, size_t count, T value) {
+  size_t i = 0;
+  if (count >= 2 * kReduceLanes) {
+    T acc[kReduceLanes];
+    for (int l = 0; l < kReduceLanes; ++l) acc[l] = src[l];
+    for (i = kReduceLanes; i + kReduceLanes <= count; i += kReduceLanes) {
+      for (int l = 0; l < kReduceLanes; ++l) {
+        KernelImpl()(&acc[l], src[i + l]);
       }
     }
-    // Compute the flattened index into dst_buffer at [dst_indices].
-    size_t dst_i = 0;
-    for (size_t i = 0; i < dst_indices.size(); ++i) {
-      dst_i += dst_indices[i] * dst_strides[dst_size - 1 - i];
-    }
+    for (int l = 0; l < kReduceLanes; ++l) KernelImpl()(&value, acc[l]);
+  }
+  for (; i < count; ++i) KernelImpl()(&value, src[i]);
+  return value;
+}
 
-    // Flattened src and dst indices have been computed, invoke the kernel.
-    KernelImpl()(&dst_buffer[dst_i], src_buffer[flat_src_i]);
-    return;
+// Accumulates |reduce| rows of |inner| elements of |src| into the columns
+// [inner_begin, inner_end) of |dst|. The inner loop is contiguous in both the
+// source and destination and vectorizes.
+template <typename T, typename KernelImpl>
+inline void ReduceStrided(const T* src, size_t reduce, size_t inner,
+                          size_t inner_begin, size_t inner_end, T* dst) {
+  for (size_t r = 0; r < reduce; ++r) {
+    const T* src_row = src + r * inner;
+    for (size_t i = inner_begin; i < inner_end; ++i) {
+      KernelImpl()(&dst[i], src_row[i]);
+    }
   }
+}
 
-  // Iterate through the current dimension in the source shape, recursing
-  // down one dimension at a time.
-  //
-  // This touches each element in the source buffer once, tracking complete
-  // dimensions within the shaped source buffer and using them to compute
-  // the corresponding indices (shaped and flattened) within the destination
-  // buffer. Each element in the destination buffer will be touched multiple
-  // times.
-  //
-  // Note that cache coherency isn't considered here, and some computations
-  // are redundant, so this could be optimized substantially.
-  for (size_t dim_i = 0; dim_i < src_shape[dim]; ++dim_i) {
-    src_indices[dim] = dim_i;
+// Elements below which reductions run inline on the calling thread; the cost
+// of waking workers dominates for small tensors.
+constexpr size_t kReduceParallelThreshold = 64 * 1024;
 
-    // Recurse down to the next dimension (e.g. 2 -> 1 -> 0 -> base case)
-    //   * Add the current stride to flat_src_i
-    //   * Multiply src_stride by this dimension's shape
-    ReduceDimension<T, KernelImpl>(src_buffer, dst_buffer, src_shape,
-                                   reduce_dims, dst_strides, dim - 1,
-                                   src_indices, flat_src_i + dim_i * src_stride,
-                                   src_stride * src_shape[dim]);
-  }
+// Columns processed per block in strided reductions. The destination block
+// stays resident in L1 while all reduction rows stream through it.
+template <typename T>
+constexpr size_t ReduceInnerBlockSize() {
+  return (16 * 1024) / sizeof(T);
 }
 
 template <typename T, typename KernelImpl>
 Status GenericReduce(absl::Span<const T> src_buffer,
                      absl::Span<const T> init_buffer, absl::Span<T> dst_buffer,
                      int32_t dimension, const Shape& src_shape,
-                     const Shape& dst_shape) {
-  // Initialize using init_buffer, which is expected to be a scalar.
-  std::fill_n(dst_buffer.data(), dst_buffer.size(), init_buffer[0]);
-
-  // Precompute destination strides.
-  int dst_rank = dst_shape.size();
-  absl::InlinedVector<int, 8> dst_strides;
-  size_t dst_stride = 1;
-  for (int dim_i = dst_rank - 1; dim_i >= 0; --dim_i) {
-    dst_strides.push_back(dst_stride);
-    dst_stride *= dst_shape[dim_i];
+                     const Shape& dst_shape, ThreadPool* thread_pool) {
+  if (dimension < 0 || dimension >= static_cast<int32_t>(src_shape.size())) {
+    return InvalidArgumentErrorBuilder(IREE_LOC)
+           << "Reduction dimension " << dimension << " out of range for rank "
+           << src_shape.size();
+  }
+  auto layout = ComputeReductionLayout(src_shape, dimension);
+  if (dst_buffer.size() != layout.outer * layout.inner) {
+    return InvalidArgumentErrorBuilder(IREE_LOC)
+           << "Reduction destination has " << dst_buffer.size()
+           << " elements but expected " << layout.outer * layout.inner;
   }
 
-  // Call the helper (recursive) function, starting with:
-  //   * source index [0, 0, ..., 0]
-  //   * the innermost dimension (last in the shape)
-  //   * flat_src_i of 0 (corresponds to [0, 0, ..., 0] above)
-  //   * source stride 1
-  absl::InlinedVector<int, 8> src_indices(src_shape.size(), 0);
-  ReduceDimension<T, KernelImpl>(src_buffer, dst_buffer, src_shape, {dimension},
-                                 absl::MakeSpan(dst_strides),
-                                 src_shape.size() - 1,
-                                 absl::MakeSpan(src_indices), 0, 1);
+  // Initialize using init_buffer, which is expected to be a scalar.
+  const T init_value = init_buffer[0];
+  std::fill_n(dst_buffer.data(), dst_buffer.size(), init_value);
+  if (layout.reduce == 0) return OkStatus();
+
+  const T* src = src_buffer.data();
+  T* dst = dst_buffer.data();
+  bool parallel = thread_pool && thread_pool->concurrency() > 1 &&
+                  src_buffer.size() >= kReduceParallelThreshold;
+
+  if (layout.inner == 1) {
+    // Innermost dimension reduction: each destination element is the
+    // reduction of a contiguous run of |reduce| source elements.
+    if (!parallel) {
+      for (size_t o = 0; o < layout.outer; ++o) {
+        dst[o] = ReduceContiguous<T, KernelImpl>(src + o * layout.reduce,
+                                                 layout.reduce, init_value);
+      }
+      return OkStatus();
+    }
+    if (layout.outer >= static_cast<size_t>(thread_pool->concurrency())) {
+      // Enough rows to keep every thread busy.
+      int32_t grain = static_cast<int32_t>(std::max<size_t>(
+          1, kReduceParallelThreshold / 4 / layout.reduce));
+      return thread_pool->ParallelFor(
+          static_cast<int32_t>(layout.outer), grain,
+          [&](int32_t begin, int32_t end) {
+            for (int32_t o = begin; o < end; ++o) {
+              dst[o] = ReduceContiguous<T, KernelImpl>(
+                  src + o * layout.reduce, layout.reduce, init_value);
+            }
+            return OkStatus();
+          });
+    }
+    // Few long rows: split each row into chunks, reduce the chunks in
+    // parallel, and then combine the partial results.
+    size_t chunk_count = std::min<size_t>(
+        thread_pool->concurrency() * 4,
+        std::max<size_t>(1, layout.reduce / (kReduceParallelThreshold / 4)));
+    size_t chunk_size = (layout.reduce + chunk_count - 1) / chunk_count;
+    chunk_count = (layout.reduce + chunk_size - 1) / chunk_size;
+    std::vector<T> partials(layout.outer * chunk_count);
+    RETURN_IF_ERROR(thread_pool->ParallelFor(
+        {static_cast<int32_t>(chunk_count), static_cast<int32_t>(layout.outer),
+         1},
+        {1, 1, 1}, [&](const ThreadPool::Tile& tile) {
+          size_t c = tile.origin[0];
+          size_t o = tile.origin[1];
+          size_t begin = c * chunk_size;
+          size_t count = std::min(chunk_size, layout.reduce - begin);
+          const T* chunk = src + o * layout.reduce + begin;
+          partials[o * chunk_count + c] =
+              ReduceContiguous<T, KernelImpl>(chunk + 1, count - 1, chunk[0]);
+          return OkStatus();
+        }));
+    for (size_t o = 0; o < layout.outer; ++o) {
+      dst[o] = ReduceContiguous<T, KernelImpl>(
+          partials.data() + o * chunk_count, chunk_count, init_value);
+    }
+    return OkStatus();
+  }
 
-  return OkStatus();
+  // Outer/middle dimension reduction: stream whole rows of the reduced
+  // dimension into a cache-sized block of destination columns.
+  const size_t block_size = ReduceInnerBlockSize<T>();
+  const size_t block_count = (layout.inner + block_size - 1) / block_size;
+  auto reduce_block = [&](size_t o, size_t block) {
+    size_t inner_begin = block * block_size;
+    size_t inner_end = std::min(layout.inner, inner_begin + block_size);
+    ReduceStrided<T, KernelImpl>(src + o * layout.reduce * layout.inner,
+                                 layout.reduce, layout.inner, inner_begin,
+                                 inner_end, dst + o * layout.inner);
+  };
+  if (!parallel) {
+    for (size_t o = 0; o < layout.outer; ++o) {
+      for (size_t block = 0; block < block_count; ++block) {
+        reduce_block(o, block);
+      }
+    }
+    return OkStatus();
+  }
+  return thread_pool->ParallelFor(
+      {static_cast<int32_t>(block_count), static_cast<int32_t>(layout.outer),
+       1},
+      {1, 1, 1}, [&](const ThreadPool::Tile& tile) {
+        reduce_block(tile.origin[1], tile.origin[0]);
+        return OkStatus();
+      });
 }
 
 }  // namespace impl
@@ -695,27 +1546,36 @@ template <typename T>
 Status ReduceSum::Execute(absl::Span<const T> src_buffer,
                           absl::Span<const T> init_buffer,
                           absl::Span<T> dst_buffer, int32_t dimension,
-                          const Shape& src_shape, const Shape& dst_shape) {
-  return impl::GenericReduce<T, impl::SumKernel>(
-      src_buffer, init_buffer, dst_buffer, dimension, src_shape, dst_shape);
+                          const Shape& src_shape, const Shape& dst_shape,
+                          ThreadPool* thread_pool) {
+  return impl::GenericReduce<T, impl::SumKernel>(src_buffer, init_buffer,
+                                                dst_buffer, dimension,
+                                                src_shape, dst_shape,
+                                                thread_pool);
 }
 
 template <typename T>
 Status ReduceMin::Execute(absl::Span<const T> src_buffer,
                           absl::Span<const T> init_buffer,
                           absl::Span<T> dst_buffer, int32_t dimension,
-                          const Shape& src_shape, const Shape& dst_shape) {
-  return impl::GenericReduce<T, impl::MinKernel>(
-      src_buffer, init_buffer, dst_buffer, dimension, src_shape, dst_shape);
+                          const Shape& src_shape, const Shape& dst_shape,
+                          ThreadPool* thread_pool) {
+  return impl::GenericReduce<T, impl::MinKernel>(src_buffer, init_buffer,
+                                                dst_buffer, dimension,
+                                                src_shape, dst_shape,
+                                                thread_pool);
 }
 
 template <typename T>
 Status ReduceMax::Execute(absl::Span<const T> src_buffer,
                           absl::Span<const T> init_buffer,
                           absl::Span<T> dst_buffer, int32_t dimension,
-                          const Shape& src_shape, const Shape& dst_shape) {
-  return impl::GenericReduce<T, impl::MaxKernel>(
-      src_buffer, init_buffer, dst_buffer, dimension, src_shape, dst_shape);
+                          const Shape& src_shape, const Shape& dst_shape,
+                          ThreadPool* thread_pool) {
+  return impl::GenericReduce<T, impl::MaxKernel>(src_buffer, init_buffer,
+                                                dst_buffer, dimension,
+                                                src_shape, dst_shape,
+                                                thread_pool);
 }
 
 }  // namespace kernels
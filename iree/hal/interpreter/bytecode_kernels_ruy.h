@@ -15,12 +15,22 @@
 #ifndef IREE_HAL_INTERPRETER_BYTECODE_KERNELS_RUY_H_
 #define IREE_HAL_INTERPRETER_BYTECODE_KERNELS_RUY_H_
 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
 #include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
 #include "iree/base/status.h"
 #include "iree/hal/buffer_view.h"
 #include "tensorflow/lite/experimental/ruy/context.h"
 #include "tensorflow/lite/experimental/ruy/ruy.h"
+#include "tensorflow/lite/experimental/ruy/ruy_advanced.h"
 
 namespace iree {
 namespace hal {
@@ -29,8 +39,96 @@ namespace kernels {
 // TODO(benvanik): something more clever for making this shareable.
 // Maybe a factory fn based on the impl selected?
 struct MatMul::RuntimeState {
-  // TODO(benvanik): share the thread pool but keep context per-fiber?
-  ruy::Context context;
+  // Minimum number of RHS columns computed by a single tile.
+  static constexpr int kMinColumnBlock = 16;
+  // Maximum number of constant RHS matrices kept prepacked. The least recently
+  // used are evicted beyond that.
+  static constexpr int kMaxPackedRhsCount = 64;
+
+  // A constant RHS matrix packed by column blocks. Each block can be used by
+  // a tile independently of the others.
+  struct PackedRhs {
+    int element_size = 0;
+    int rows = 0;
+    int cols = 0;
+    int block_cols = 0;
+    std::vector<ruy::PrepackedMatrix> blocks;
+    std::vector<std::unique_ptr<uint8_t[]>> storage;
+
+    // Allocation function for ruy::PrePackForMul owning the storage.
+    void* Allocate(std::size_t size) {
+      // ruy requires packed data to be aligned to its kernel vector size.
+      constexpr std::size_t kAlignment = 64;
+      storage.emplace_back(new uint8_t[size + kAlignment]);
+      auto address = reinterpret_cast<uintptr_t>(storage.back().get());
+      return reinterpret_cast<void*>((address + kAlignment - 1) &
+                                     ~(kAlignment - 1));
+    }
+  };
+
+  // A cached PackedRhs and the buffer it was packed from. Retaining the buffer
+  // keeps its contents alive so that they cannot be freed and the address
+  // reused for other contents while the entry exists.
+  struct PackedRhsEntry {
+    ref_ptr<Buffer> buffer;
+    std::shared_ptr<const PackedRhs> packed_rhs;
+    // Value of use_counter when the entry was last used.
+    uint64_t last_use = 0;
+  };
+  using PackedRhsKey = std::pair<const Buffer*, const void*>;
+
+  // ruy contexts are not thread-safe; each concurrently executing tile
+  // acquires its own from this pool. ruy itself runs single-threaded as the
+  // work is split across the shared interpreter ThreadPool instead.
+  std::unique_ptr<ruy::Context> AcquireContext() {
+    {
+      absl::MutexLock lock(&mutex);
+      if (!free_contexts.empty()) {
+        auto context = std::move(free_contexts.back());
+        free_contexts.pop_back();
+        return context;
+      }
+    }
+    auto context = absl::make_unique<ruy::Context>();
+    context->max_num_threads = 1;
+    return context;
+  }
+  void ReleaseContext(std::unique_ptr<ruy::Context> context) {
+    absl::MutexLock lock(&mutex);
+    free_contexts.push_back(std::move(context));
+  }
+
+  // Returns the number of prepacked constant RHS matrices currently held.
+  size_t packed_rhs_count() {
+    absl::MutexLock lock(&mutex);
+    return packed_rhs.size();
+  }
+
+  // Moves the least recently used entries into |evicted_entries| until at most
+  // kMaxPackedRhsCount remain. The evicted entries should be destroyed after
+  // releasing the lock as doing so may release the last reference to their
+  // buffers.
+  void EvictPackedRhs(std::vector<PackedRhsEntry>* evicted_entries)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex) {
+    while (packed_rhs.size() > kMaxPackedRhsCount) {
+      auto oldest_it = packed_rhs.begin();
+      for (auto it = packed_rhs.begin(); it != packed_rhs.end(); ++it) {
+        if (it->second.last_use < oldest_it->second.last_use) oldest_it = it;
+      }
+      evicted_entries->push_back(std::move(oldest_it->second));
+      packed_rhs.erase(oldest_it);
+    }
+  }
+
+  absl::Mutex mutex;
+  std::vector<std::unique_ptr<ruy::Context>> free_contexts
+      ABSL_GUARDED_BY(mutex);
+  // Prepacked constant RHS matrices keyed by the allocated buffer and the
+  // address of the matrix within it. The packed matrices are immutable once
+  // inserted and shared with in-flight calls.
+  absl::flat_hash_map<PackedRhsKey, PackedRhsEntry> packed_rhs
+      ABSL_GUARDED_BY(mutex);
+  uint64_t use_counter ABSL_GUARDED_BY(mutex) = 0;
 };
 
 inline std::unique_ptr<MatMul::RuntimeState> MatMul::CreateRuntimeState() {
@@ -129,57 +227,33 @@ void MatMul::Transpose2D(int d0, int d1, const T* input_data, T* output_data) {
 
 template <typename T, typename ACC>
 Status MatMul::Execute(RuntimeState* runtime_state,
-                       const Buffers<T, ACC>& buffers) {
+                       const Buffers<T, ACC>& buffers,
+                       ThreadPool* thread_pool) {
   // Note that it is important to invoke RUY in RCC mode (LHS=Row Major,
   // RHS=Col Major, Result=Col Major), which necessitates some transposes. This
   // is not a long term solution and is just to get it on the optimized paths
   // until the compiler can reason properly about layout and pre-packing, which
-  // is the anticipated future state. This is doing (A * B^T)^T.
-  // If needed, it can also be re-arranged to (B * A^T).
-  T* a_data;
-  int a_d0, a_d1;
-  T* b_data;
-  int b_d0, b_d1;
-  T* r_data;
-  int r_d0, r_d1;
-
-  bool transpose_dst = false;
-  T* temp1_buffer = nullptr;
-  T* temp2_buffer = nullptr;
-  {
-    // Do (A * B^T)^T
-    IREE_TRACE_SCOPE0("MatMul#TransposeRhs");
-    // A = LHS
-    a_d0 = buffers.lhs_shape[0];
-    a_d1 = buffers.lhs_shape[1];
-    a_data = const_cast<T*>(buffers.lhs_buffer.data());
-    // B = RHS^T
-    b_d0 = buffers.rhs_shape[0];
-    b_d1 = buffers.rhs_shape[1];
-    b_data = temp1_buffer = new T[b_d0 * b_d1];
-    Transpose2D(b_d0, b_d1, buffers.rhs_buffer.data(), b_data);
-    // R
-    transpose_dst = true;
-    r_d0 = buffers.dst_shape[0];
-    r_d1 = buffers.dst_shape[1];
-    r_data = temp2_buffer = new T[r_d0 * r_d1];
-  }
-
-  ruy::Matrix<T> a_matrix;
-  ruy::MakeSimpleLayout(a_d0, a_d1, ruy::Order::kRowMajor, &a_matrix.layout);
-  a_matrix.data.set(a_data);
-
-  ruy::Matrix<T> b_matrix;
-  ruy::MakeSimpleLayout(b_d0, b_d1, ruy::Order::kColMajor, &b_matrix.layout);
-  b_matrix.data.set(b_data);
+  // is the anticipated future state.
+  //
+  // A = LHS [M, K] row major
+  // B = RHS [K, N] col major (transposed from the row major RHS)
+  // R = A * B [M, N] col major (transposed into the row major DST)
+  //
+  // As B and R are col major each block of columns is contiguous and the work
+  // is split across the thread pool by column blocks of N.
+  const int m = buffers.lhs_shape[0];
+  const int k = buffers.lhs_shape[1];
+  const int n = buffers.rhs_shape[1];
+  const T* a_data = buffers.lhs_buffer.data();
 
-  ruy::Matrix<T> r_matrix;
-  ruy::MakeSimpleLayout(r_d0, r_d1, ruy::Order::kColMajor, &r_matrix.layout);
-  r_matrix.data.set(r_data);
+  int concurrency = thread_pool ? thread_pool->concurrency() : 1;
+  int block_cols =
+      std::max(RuntimeState::kMinColumnBlock,
+               (((n + concurrency - 1) / concurrency) + 7) & ~7);
+  block_cols = std::min(block_cols, std::max(n, 1));
 
   ruy::BasicSpec<ACC, T> spec;
   spec.bias = buffers.bias_buffer.data();
-
   if (buffers.multiplier_mantissa_buffer.size() == 1) {
     spec.multiplier_fixedpoint = buffers.multiplier_mantissa_buffer[0];
     spec.multiplier_exponent = buffers.multiplier_exponent_buffer[0];
@@ -190,17 +264,135 @@ Status MatMul::Execute(RuntimeState* runtime_state,
         buffers.multiplier_exponent_buffer.data();
   }
 
-  ruy::Mul<ruy::kAllPaths>(a_matrix, b_matrix, spec, &runtime_state->context,
-                           &r_matrix);
+  ruy::Matrix<T> a_matrix;
+  ruy::MakeSimpleLayout(m, k, ruy::Order::kRowMajor, &a_matrix.layout);
+  a_matrix.data.set(a_data);
+
+  // Sets up the B and R matrices for the columns [begin, end).
+  auto make_column_block = [&](const T* b_data, T* r_data, int begin, int end,
+                               ruy::Matrix<T>* b_matrix,
+                               ruy::Matrix<T>* r_matrix) {
+    ruy::MakeSimpleLayout(k, end - begin, ruy::Order::kColMajor,
+                          &b_matrix->layout);
+    b_matrix->data.set(b_data + static_cast<size_t>(begin) * k);
+    ruy::MakeSimpleLayout(m, end - begin, ruy::Order::kColMajor,
+                          &r_matrix->layout);
+    r_matrix->data.set(r_data + static_cast<size_t>(begin) * m);
+  };
 
-  if (transpose_dst) {
+  // Runs |fn| for each column block, in parallel if possible.
+  auto for_each_column_block =
+      [&](const std::function<Status(int32_t, int32_t)>& fn) -> Status {
+    if (!thread_pool || n <= block_cols) return fn(0, n);
+    return thread_pool->ParallelFor(n, block_cols, fn);
+  };
+
+  std::unique_ptr<T[]> r_temp(new T[static_cast<size_t>(m) * n]);
+  T* r_data = r_temp.get();
+
+  // Look up (or create) the packed form of constant RHS matrices so that the
+  // transpose and packing only happen the first time they are used.
+  std::shared_ptr<const RuntimeState::PackedRhs> packed_rhs;
+  if (buffers.rhs_constant_buffer) {
+    RuntimeState::PackedRhsKey key(buffers.rhs_constant_buffer.get(),
+                                   buffers.rhs_buffer.data());
+    {
+      absl::MutexLock lock(&runtime_state->mutex);
+      auto it = runtime_state->packed_rhs.find(key);
+      if (it != runtime_state->packed_rhs.end()) {
+        auto& entry = it->second;
+        const auto& cached_rhs = *entry.packed_rhs;
+        // The same constant may be used with different shapes or split into
+        // different column blocks, in which case it is packed again.
+        if (cached_rhs.element_size == sizeof(T) && cached_rhs.rows == k &&
+            cached_rhs.cols == n && cached_rhs.block_cols == block_cols) {
+          entry.last_use = ++runtime_state->use_counter;
+          packed_rhs = entry.packed_rhs;
+        }
+      }
+    }
+    if (!packed_rhs) {
+      IREE_TRACE_SCOPE0("MatMul#PackRhs");
+      std::unique_ptr<T[]> b_temp(new T[static_cast<size_t>(k) * n]);
+      Transpose2D(k, n, buffers.rhs_buffer.data(), b_temp.get());
+      auto new_packed_rhs = std::make_shared<RuntimeState::PackedRhs>();
+      new_packed_rhs->element_size = sizeof(T);
+      new_packed_rhs->rows = k;
+      new_packed_rhs->cols = n;
+      new_packed_rhs->block_cols = block_cols;
+      new_packed_rhs->blocks.reserve((n + block_cols - 1) / block_cols);
+      auto context = runtime_state->AcquireContext();
+      for (int begin = 0; begin < n; begin += block_cols) {
+        int end = std::min(begin + block_cols, n);
+        ruy::Matrix<T> b_matrix;
+        ruy::Matrix<T> r_matrix;
+        make_column_block(b_temp.get(), r_data, begin, end, &b_matrix,
+                          &r_matrix);
+        new_packed_rhs->blocks.emplace_back();
+        ruy::PrePackForMul<ruy::kAllPaths>(
+            a_matrix, b_matrix, spec, context.get(), &r_matrix,
+            /*prepacked_lhs=*/nullptr, &new_packed_rhs->blocks.back(),
+            [&new_packed_rhs](std::size_t size) {
+              return new_packed_rhs->Allocate(size);
+            });
+      }
+      runtime_state->ReleaseContext(std::move(context));
+      packed_rhs = std::move(new_packed_rhs);
+
+      std::vector<RuntimeState::PackedRhsEntry> evicted_entries;
+      absl::MutexLock lock(&runtime_state->mutex);
+      auto& entry = runtime_state->packed_rhs[key];
+      entry.buffer = add_ref(buffers.rhs_constant_buffer);
+      entry.packed_rhs = packed_rhs;
+      entry.last_use = ++runtime_state->use_counter;
+      runtime_state->EvictPackedRhs(&evicted_entries);
+    }
+  }
+
+  if (packed_rhs) {
+    IREE_TRACE_SCOPE0("MatMul#MulWithPrepacked");
+    RETURN_IF_ERROR(for_each_column_block([&](int32_t begin, int32_t end) {
+      auto context = runtime_state->AcquireContext();
+      ruy::Matrix<T> b_matrix;
+      ruy::Matrix<T> r_matrix;
+      // The RHS data is not read when prepacked; only its layout is used.
+      make_column_block(buffers.rhs_buffer.data(), r_data, begin, end,
+                        &b_matrix, &r_matrix);
+      auto* prepacked = const_cast<ruy::PrepackedMatrix*>(
+          &packed_rhs->blocks[begin / block_cols]);
+      ruy::MulWithPrepacked<ruy::kAllPaths>(a_matrix, b_matrix, spec,
+                                            context.get(), &r_matrix,
+                                            /*prepacked_lhs=*/nullptr,
+                                            prepacked);
+      runtime_state->ReleaseContext(std::move(context));
+      return OkStatus();
+    }));
+  } else {
+    std::unique_ptr<T[]> b_temp(new T[static_cast<size_t>(k) * n]);
+    {
+      IREE_TRACE_SCOPE0("MatMul#TransposeRhs");
+      Transpose2D(k, n, buffers.rhs_buffer.data(), b_temp.get());
+    }
+    IREE_TRACE_SCOPE0("MatMul#Mul");
+    RETURN_IF_ERROR(for_each_column_block([&](int32_t begin, int32_t end) {
+      auto context = runtime_state->AcquireContext();
+      ruy::Matrix<T> b_matrix;
+      ruy::Matrix<T> r_matrix;
+      make_column_block(b_temp.get(), r_data, begin, end, &b_matrix,
+                        &r_matrix);
+      ruy::Mul<ruy::kAllPaths>(a_matrix, b_matrix, spec, context.get(),
+                               &r_matrix);
+      runtime_state->ReleaseContext(std::move(context));
+      return OkStatus();
+    }));
+  }
+
+  {
     IREE_TRACE_SCOPE0("MatMul#TransposeDst");
     // Dims reversed because it is written in col major and the transpose
     // treats the dims as row major.
-    Transpose2D(r_d1, r_d0, r_data, buffers.dst_buffer.data());
+    Transpose2D(n, m, r_data, buffers.dst_buffer.data());
   }
-  delete[] temp1_buffer;
-  delete[] temp2_buffer;
 
   return OkStatus();
 }
@@ -14,8 +14,14 @@
 
 #include "iree/hal/interpreter/bytecode_kernels.h"
 
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
 #include "iree/base/memory.h"
 #include "iree/base/status_matchers.h"
+#include "iree/hal/heap_buffer.h"
+#include "iree/hal/host/thread_pool.h"
 #include "iree/testing/gtest.h"
 
 namespace iree {
@@ -33,6 +39,104 @@ std::vector<T> MakeIota(int size) {
   return v;
 }
 
+TEST(BroadcastBinary, SameShape) {
+  Shape shape = {2, 3};
+  auto lhs_buffer = MakeIota<int32_t>(shape.element_count());
+  auto rhs_buffer = MakeIota<int32_t>(shape.element_count());
+  std::vector<int32_t> dst_buffer(shape.element_count(), 0);
+  std::vector<int32_t> expected_dst = {2, 4, 6, 8, 10, 12};
+
+  EXPECT_OK(BroadcastBinary<Add>::Execute<int32_t>(
+      lhs_buffer, rhs_buffer, absl::MakeSpan(dst_buffer), shape, shape,
+      shape));
+  EXPECT_EQ(dst_buffer, expected_dst);
+}
+
+TEST(BroadcastBinary, InnerVector) {
+  Shape lhs_shape = {2, 3};
+  Shape rhs_shape = {3};
+  auto lhs_buffer = MakeIota<int32_t>(lhs_shape.element_count());
+  std::vector<int32_t> rhs_buffer = {10, 20, 30};
+  std::vector<int32_t> dst_buffer(lhs_shape.element_count(), 0);
+  std::vector<int32_t> expected_dst = {11, 22, 33, 14, 25, 36};
+
+  EXPECT_OK(BroadcastBinary<Add>::Execute<int32_t>(
+      lhs_buffer, rhs_buffer, absl::MakeSpan(dst_buffer), lhs_shape,
+      rhs_shape, lhs_shape));
+  EXPECT_EQ(dst_buffer, expected_dst);
+}
+
+TEST(BroadcastBinary, OuterVector) {
+  Shape lhs_shape = {2, 1};
+  Shape rhs_shape = {2, 3};
+  std::vector<int32_t> lhs_buffer = {10, 20};
+  auto rhs_buffer = MakeIota<int32_t>(rhs_shape.element_count());
+  std::vector<int32_t> dst_buffer(rhs_shape.element_count(), 0);
+  std::vector<int32_t> expected_dst = {9, 8, 7, 16, 15, 14};
+
+  EXPECT_OK(BroadcastBinary<Sub>::Execute<int32_t>(
+      lhs_buffer, rhs_buffer, absl::MakeSpan(dst_buffer), lhs_shape,
+      rhs_shape, rhs_shape));
+  EXPECT_EQ(dst_buffer, expected_dst);
+}
+
+TEST(BroadcastBinary, BothOperands) {
+  Shape lhs_shape = {3, 1};
+  Shape rhs_shape = {1, 2};
+  Shape dst_shape = {3, 2};
+  std::vector<float> lhs_buffer = {1.0f, 2.0f, 3.0f};
+  std::vector<float> rhs_buffer = {10.0f, 100.0f};
+  std::vector<float> dst_buffer(dst_shape.element_count(), 0.0f);
+  std::vector<float> expected_dst = {10.0f, 100.0f, 20.0f,
+                                     200.0f, 30.0f, 300.0f};
+
+  EXPECT_OK(BroadcastBinary<Mul>::Execute<float>(
+      lhs_buffer, rhs_buffer, absl::MakeSpan(dst_buffer), lhs_shape,
+      rhs_shape, dst_shape));
+  EXPECT_EQ(dst_buffer, expected_dst);
+}
+
+TEST(BroadcastBinary, ScalarComparison) {
+  Shape lhs_shape = {2, 2, 2};
+  Shape rhs_shape = {};
+  auto lhs_buffer = MakeIota<int32_t>(lhs_shape.element_count());
+  std::vector<int32_t> rhs_buffer = {4};
+  std::vector<uint8_t> dst_buffer(lhs_shape.element_count(), 0);
+  std::vector<uint8_t> expected_dst = {1, 1, 1, 0, 0, 0, 0, 0};
+
+  EXPECT_OK(BroadcastBinary<CompareLT>::Execute<int32_t>(
+      lhs_buffer, rhs_buffer, absl::MakeSpan(dst_buffer), lhs_shape,
+      rhs_shape, lhs_shape));
+  EXPECT_EQ(dst_buffer, expected_dst);
+}
+
+TEST(BroadcastBinary, LongBroadcastRow) {
+  // Rows longer than the expansion block are processed in multiple blocks.
+  Shape lhs_shape = {2, 1};
+  Shape rhs_shape = {2, 3000};
+  std::vector<int32_t> lhs_buffer = {1, 2};
+  std::vector<int32_t> rhs_buffer(rhs_shape.element_count(), 5);
+  std::vector<int32_t> dst_buffer(rhs_shape.element_count(), 0);
+  std::vector<int32_t> expected_dst(rhs_shape.element_count(), 6);
+  std::fill(expected_dst.begin() + 3000, expected_dst.end(), 7);
+
+  EXPECT_OK(BroadcastBinary<Add>::Execute<int32_t>(
+      lhs_buffer, rhs_buffer, absl::MakeSpan(dst_buffer), lhs_shape,
+      rhs_shape, rhs_shape));
+  EXPECT_EQ(dst_buffer, expected_dst);
+}
+
+TEST(BroadcastBinary, IncompatibleShapes) {
+  Shape lhs_shape = {2, 3};
+  Shape rhs_shape = {2};
+  std::vector<int32_t> lhs_buffer(lhs_shape.element_count(), 0);
+  std::vector<int32_t> rhs_buffer(rhs_shape.element_count(), 0);
+  std::vector<int32_t> dst_buffer(lhs_shape.element_count(), 0);
+  EXPECT_TRUE(IsInvalidArgument(BroadcastBinary<Add>::Execute<int32_t>(
+      lhs_buffer, rhs_buffer, absl::MakeSpan(dst_buffer), lhs_shape,
+      rhs_shape, lhs_shape)));
+}
+
 TEST(Copy, WholeBuffer) {
   Shape src_shape = {2, 2};
   auto src_buffer = MakeIota<uint8_t>(4);
@@ -364,6 +468,106 @@ TEST(Pad, HighRank) {
   EXPECT_EQ(dst_buffer, expected_dst);
 }
 
+TEST(Pad, NegativePadding) {
+  Shape src_shape = {3, 4};
+  auto src_buffer = MakeIota<uint16_t>(src_shape.element_count());
+  std::vector<uint16_t> pad_value_buffer = {0};
+  std::vector<int32_t> edge_padding_low = {-1, 1};
+  std::vector<int32_t> edge_padding_high = {0, -2};
+  std::vector<int32_t> interior_padding = {0, 0};
+  Shape dst_shape = {2, 3};
+  std::vector<uint16_t> dst_buffer(dst_shape.element_count(), UINT16_MAX);
+  // clang-format off
+  std::vector<uint16_t> expected_dst = {0, 5,  6,
+                                        0, 9, 10};
+  // clang-format on
+
+  EXPECT_OK(Pad::Execute<uint16_t>(
+      src_buffer, pad_value_buffer, absl::MakeSpan(dst_buffer), src_shape,
+      dst_shape, edge_padding_low, edge_padding_high, interior_padding));
+  EXPECT_EQ(dst_buffer, expected_dst);
+}
+
+TEST(Pad, NegativeAndInteriorPadding) {
+  Shape src_shape = {5};
+  auto src_buffer = MakeIota<uint16_t>(src_shape.element_count());
+  std::vector<uint16_t> pad_value_buffer = {0};
+  std::vector<int32_t> edge_padding_low = {-2};
+  std::vector<int32_t> edge_padding_high = {-1};
+  std::vector<int32_t> interior_padding = {1};
+  Shape dst_shape = {6};
+  std::vector<uint16_t> dst_buffer(dst_shape.element_count(), UINT16_MAX);
+  std::vector<uint16_t> expected_dst = {2, 0, 3, 0, 4, 0};
+
+  EXPECT_OK(Pad::Execute<uint16_t>(
+      src_buffer, pad_value_buffer, absl::MakeSpan(dst_buffer), src_shape,
+      dst_shape, edge_padding_low, edge_padding_high, interior_padding));
+  EXPECT_EQ(dst_buffer, expected_dst);
+}
+
+TEST(Pad, MismatchedShape) {
+  Shape src_shape = {2, 3};
+  auto src_buffer = MakeIota<uint16_t>(src_shape.element_count());
+  std::vector<uint16_t> pad_value_buffer = {0};
+  std::vector<int32_t> edge_padding_low = {0, 1};
+  std::vector<int32_t> edge_padding_high = {0, 1};
+  std::vector<int32_t> interior_padding = {0, 0};
+  Shape dst_shape = {2, 4};
+  std::vector<uint16_t> dst_buffer(dst_shape.element_count(), UINT16_MAX);
+
+  EXPECT_TRUE(IsInvalidArgument(Pad::Execute<uint16_t>(
+      src_buffer, pad_value_buffer, absl::MakeSpan(dst_buffer), src_shape,
+      dst_shape, edge_padding_low, edge_padding_high, interior_padding)));
+}
+
+TEST(Reverse, InnerDimension) {
+  Shape src_shape = {2, 3};
+  auto src_buffer = MakeIota<uint16_t>(src_shape.element_count());
+  std::vector<int32_t> dimensions = {1};
+  std::vector<uint16_t> dst_buffer(src_shape.element_count(), UINT16_MAX);
+  std::vector<uint16_t> expected_dst = {3, 2, 1, 6, 5, 4};
+
+  EXPECT_OK(Reverse::Execute<uint16_t>(src_buffer, absl::MakeSpan(dst_buffer),
+                                       src_shape, dimensions));
+  EXPECT_EQ(dst_buffer, expected_dst);
+}
+
+TEST(Reverse, OuterDimension) {
+  Shape src_shape = {2, 3};
+  auto src_buffer = MakeIota<uint16_t>(src_shape.element_count());
+  std::vector<int32_t> dimensions = {0};
+  std::vector<uint16_t> dst_buffer(src_shape.element_count(), UINT16_MAX);
+  std::vector<uint16_t> expected_dst = {4, 5, 6, 1, 2, 3};
+
+  EXPECT_OK(Reverse::Execute<uint16_t>(src_buffer, absl::MakeSpan(dst_buffer),
+                                       src_shape, dimensions));
+  EXPECT_EQ(dst_buffer, expected_dst);
+}
+
+TEST(Reverse, AlternatingDimensions) {
+  Shape src_shape = {2, 1, 3, 2};
+  auto src_buffer = MakeIota<uint16_t>(src_shape.element_count());
+  std::vector<int32_t> dimensions = {0, 1, 3};
+  std::vector<uint16_t> dst_buffer(src_shape.element_count(), UINT16_MAX);
+  // clang-format off
+  std::vector<uint16_t> expected_dst = { 8,  7, 10,  9, 12, 11,
+                                         2,  1,  4,  3,  6,  5};
+  // clang-format on
+
+  EXPECT_OK(Reverse::Execute<uint16_t>(src_buffer, absl::MakeSpan(dst_buffer),
+                                       src_shape, dimensions));
+  EXPECT_EQ(dst_buffer, expected_dst);
+}
+
+TEST(Reverse, InvalidDimension) {
+  Shape src_shape = {2, 3};
+  auto src_buffer = MakeIota<uint16_t>(src_shape.element_count());
+  std::vector<int32_t> dimensions = {2};
+  std::vector<uint16_t> dst_buffer(src_shape.element_count(), UINT16_MAX);
+  EXPECT_TRUE(IsInvalidArgument(Reverse::Execute<uint16_t>(
+      src_buffer, absl::MakeSpan(dst_buffer), src_shape, dimensions)));
+}
+
 TEST(ReduceSum, Scalar) {
   Shape src_shape = {5};
   int32_t dimension = 0;
@@ -400,6 +604,374 @@ TEST(ReduceMin, TwoDimensionsToOne) {
   }
 }
 
+TEST(ReduceMax, InnerDimension) {
+  Shape src_shape = {2, 3};
+  int32_t dimension = 1;
+  Shape dst_shape = {2};
+  std::vector<int32_t> src_buffer = {3, 9, 1, -4, -2, -8};
+  std::vector<int32_t> init_buffer = {std::numeric_limits<int32_t>::min()};
+  std::vector<int32_t> dst_buffer(dst_shape.element_count(), 0);
+  std::vector<int32_t> expected_dst = {9, -2};
+
+  EXPECT_OK(ReduceMax::Execute<int32_t>(src_buffer, init_buffer,
+                                        absl::MakeSpan(dst_buffer), dimension,
+                                        src_shape, dst_shape));
+  EXPECT_EQ(dst_buffer, expected_dst);
+}
+
+TEST(ReduceSum, InvalidDimension) {
+  Shape src_shape = {2, 3};
+  Shape dst_shape = {2};
+  std::vector<int32_t> src_buffer(src_shape.element_count(), 1);
+  std::vector<int32_t> init_buffer = {0};
+  std::vector<int32_t> dst_buffer(dst_shape.element_count(), 0);
+  EXPECT_TRUE(IsInvalidArgument(ReduceSum::Execute<int32_t>(
+      src_buffer, init_buffer, absl::MakeSpan(dst_buffer), 2, src_shape,
+      dst_shape)));
+}
+
+// Reference reduction used to verify the blocked/parallel paths.
+template <typename T>
+std::vector<T> ReferenceReduceSum(const std::vector<T>& src,
+                                  const Shape& src_shape, int32_t dimension,
+                                  T init_value) {
+  int outer = 1, inner = 1;
+  for (int i = 0; i < dimension; ++i) outer *= src_shape[i];
+  for (int i = dimension + 1; i < src_shape.size(); ++i) inner *= src_shape[i];
+  int reduce = src_shape[dimension];
+  std::vector<T> dst(outer * inner, init_value);
+  for (int o = 0; o < outer; ++o) {
+    for (int r = 0; r < reduce; ++r) {
+      for (int i = 0; i < inner; ++i) {
+        dst[o * inner + i] += src[(o * reduce + r) * inner + i];
+      }
+    }
+  }
+  return dst;
+}
+
+class ReduceSumShapeTest
+    : public ::testing::TestWithParam<std::tuple<std::vector<int>, int>> {};
+
+TEST_P(ReduceSumShapeTest, MatchesReference) {
+  const auto& dims = std::get<0>(GetParam());
+  int32_t dimension = std::get<1>(GetParam());
+  Shape src_shape(dims);
+  std::vector<int> dst_dims;
+  for (int i = 0; i < dims.size(); ++i) {
+    if (i != dimension) dst_dims.push_back(dims[i]);
+  }
+  Shape dst_shape(dst_dims);
+  std::vector<int64_t> src_buffer(src_shape.element_count());
+  for (int i = 0; i < src_buffer.size(); ++i) src_buffer[i] = (i * 7) % 13 - 6;
+  std::vector<int64_t> init_buffer = {3};
+  auto expected_dst =
+      ReferenceReduceSum<int64_t>(src_buffer, src_shape, dimension, 3);
+
+  std::vector<int64_t> dst_buffer(expected_dst.size());
+  EXPECT_OK(ReduceSum::Execute<int64_t>(src_buffer, init_buffer,
+                                        absl::MakeSpan(dst_buffer), dimension,
+                                        src_shape, dst_shape));
+  EXPECT_EQ(expected_dst, dst_buffer);
+
+  ThreadPool thread_pool(ThreadPool::Options{3, false});
+  std::vector<int64_t> parallel_dst_buffer(expected_dst.size());
+  EXPECT_OK(ReduceSum::Execute<int64_t>(
+      src_buffer, init_buffer, absl::MakeSpan(parallel_dst_buffer), dimension,
+      src_shape, dst_shape, &thread_pool));
+  EXPECT_EQ(expected_dst, parallel_dst_buffer);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    ReduceSumShapes, ReduceSumShapeTest,
+    ::testing::Values(std::make_tuple(std::vector<int>{37}, 0),
+                      std::make_tuple(std::vector<int>{300000}, 0),
+                      std::make_tuple(std::vector<int>{2, 100000}, 1),
+                      std::make_tuple(std::vector<int>{1000, 130}, 1),
+                      std::make_tuple(std::vector<int>{130, 1000}, 0),
+                      std::make_tuple(std::vector<int>{3, 5000, 7}, 1),
+                      std::make_tuple(std::vector<int>{8, 3, 9000}, 1)));
+
+TEST(Transpose, TwoDimensions) {
+  Shape src_shape = {2, 3};
+  std::vector<int32_t> perm = {1, 0};
+  std::vector<uint16_t> src_buffer = MakeIota<uint16_t>(6);
+  std::vector<uint16_t> dst_buffer(6, 0);
+  std::vector<uint16_t> expected_dst = {1, 4, 2, 5, 3, 6};
+
+  EXPECT_OK(Transpose::Execute<uint16_t>(src_buffer, absl::MakeSpan(dst_buffer),
+                                         src_shape, perm));
+  EXPECT_EQ(dst_buffer, expected_dst);
+}
+
+TEST(Transpose, InvalidPermutation) {
+  Shape src_shape = {2, 3};
+  std::vector<int32_t> perm = {1, 1};
+  std::vector<int32_t> src_buffer(6, 0);
+  std::vector<int32_t> dst_buffer(6, 0);
+  EXPECT_TRUE(IsInvalidArgument(Transpose::Execute<int32_t>(
+      src_buffer, absl::MakeSpan(dst_buffer), src_shape, perm)));
+}
+
+// Reference transpose used to verify the tiled/parallel paths.
+template <typename T>
+std::vector<T> ReferenceTranspose(const std::vector<T>& src,
+                                  const Shape& src_shape,
+                                  const std::vector<int32_t>& perm) {
+  int rank = src_shape.size();
+  std::vector<T> dst(src.size());
+  std::vector<int> dst_index(rank, 0);
+  for (size_t dst_i = 0; dst_i < dst.size(); ++dst_i) {
+    size_t src_i = 0;
+    for (int i = 0; i < rank; ++i) {
+      int src_index = 0;
+      for (int j = 0; j < rank; ++j) {
+        if (perm[j] == i) src_index = dst_index[j];
+      }
+      src_i = src_i * src_shape[i] + src_index;
+    }
+    dst[dst_i] = src[src_i];
+    for (int i = rank - 1; i >= 0; --i) {
+      if (++dst_index[i] < src_shape[perm[i]]) break;
+      dst_index[i] = 0;
+    }
+  }
+  return dst;
+}
+
+template <typename T>
+void ExpectTransposeMatchesReference(const Shape& src_shape,
+                                     const std::vector<int32_t>& perm) {
+  std::vector<T> src_buffer(src_shape.element_count());
+  for (int i = 0; i < src_buffer.size(); ++i) {
+    src_buffer[i] = static_cast<T>(i * 31 + 7);
+  }
+  auto expected_dst = ReferenceTranspose<T>(src_buffer, src_shape, perm);
+
+  std::vector<T> dst_buffer(expected_dst.size());
+  EXPECT_OK(Transpose::Execute<T>(src_buffer, absl::MakeSpan(dst_buffer),
+                                  src_shape, perm));
+  EXPECT_EQ(expected_dst, dst_buffer);
+
+  ThreadPool thread_pool(ThreadPool::Options{3, false});
+  std::vector<T> parallel_dst_buffer(expected_dst.size());
+  EXPECT_OK(Transpose::Execute<T>(src_buffer,
+                                  absl::MakeSpan(parallel_dst_buffer),
+                                  src_shape, perm, &thread_pool));
+  EXPECT_EQ(expected_dst, parallel_dst_buffer);
+}
+
+class TransposeShapeTest
+    : public ::testing::TestWithParam<
+          std::tuple<std::vector<int>, std::vector<int32_t>>> {};
+
+TEST_P(TransposeShapeTest, MatchesReference) {
+  Shape src_shape(std::get<0>(GetParam()));
+  const auto& perm = std::get<1>(GetParam());
+  ExpectTransposeMatchesReference<uint8_t>(src_shape, perm);
+  ExpectTransposeMatchesReference<uint16_t>(src_shape, perm);
+  ExpectTransposeMatchesReference<uint32_t>(src_shape, perm);
+  ExpectTransposeMatchesReference<uint64_t>(src_shape, perm);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    TransposeShapes, TransposeShapeTest,
+    ::testing::Values(
+        std::make_tuple(std::vector<int>{}, std::vector<int32_t>{}),
+        std::make_tuple(std::vector<int>{37}, std::vector<int32_t>{0}),
+        std::make_tuple(std::vector<int>{1, 5, 1},
+                        std::vector<int32_t>{2, 1, 0}),
+        std::make_tuple(std::vector<int>{4, 5, 6},
+                        std::vector<int32_t>{0, 1, 2}),
+        std::make_tuple(std::vector<int>{67, 45}, std::vector<int32_t>{1, 0}),
+        std::make_tuple(std::vector<int>{3, 17, 13, 9},
+                        std::vector<int32_t>{0, 3, 1, 2}),
+        std::make_tuple(std::vector<int>{3, 9, 17, 13},
+                        std::vector<int32_t>{0, 2, 3, 1}),
+        std::make_tuple(std::vector<int>{7, 1, 11, 5},
+                        std::vector<int32_t>{2, 1, 0, 3}),
+        std::make_tuple(std::vector<int>{300, 2, 301},
+                        std::vector<int32_t>{2, 1, 0}),
+        std::make_tuple(std::vector<int>{2, 600, 130},
+                        std::vector<int32_t>{0, 2, 1}),
+        std::make_tuple(std::vector<int>{40, 30, 70},
+                        std::vector<int32_t>{1, 0, 2})));
+
+// Returns a row major [rows, cols] matrix with small integral values so that
+// float results are exact.
+std::vector<float> MakeMatrix(int rows, int cols, int seed) {
+  std::vector<float> matrix(rows * cols);
+  for (int i = 0; i < matrix.size(); ++i) {
+    matrix[i] = static_cast<float>((i * 7 + seed * 13) % 11 - 5);
+  }
+  return matrix;
+}
+
+std::vector<float> ReferenceMatMul(const std::vector<float>& lhs,
+                                   const std::vector<float>& rhs, int m, int k,
+                                   int n) {
+  std::vector<float> dst(m * n, 0.0f);
+  for (int i = 0; i < m; ++i) {
+    for (int j = 0; j < n; ++j) {
+      for (int p = 0; p < k; ++p) {
+        dst[i * n + j] += lhs[i * k + p] * rhs[p * n + j];
+      }
+    }
+  }
+  return dst;
+}
+
+// Multiplies |lhs| [m, k] by the contents of |rhs| [k, n]. As in the
+// interpreter the RHS is treated as a constant if |rhs| has been marked as
+// having constant contents.
+StatusOr<std::vector<float>> ExecuteMatMul(MatMul::RuntimeState* runtime_state,
+                                           ThreadPool* thread_pool,
+                                           const std::vector<float>& lhs,
+                                           Buffer* rhs, int m, int k, int n) {
+  ASSIGN_OR_RETURN(auto rhs_mapping,
+                   rhs->MapMemory<float>(MemoryAccess::kRead));
+  std::vector<float> dst(m * n, -1.0f);
+  MatMul::Buffers<float, float> buffers;
+  buffers.lhs_shape = {m, k};
+  buffers.lhs_buffer = lhs;
+  buffers.rhs_shape = {k, n};
+  buffers.rhs_buffer = rhs_mapping.contents();
+  buffers.dst_shape = {m, n};
+  buffers.dst_buffer = absl::MakeSpan(dst);
+  buffers.rhs_constant_buffer = MatMul::ConstantRhsBuffer(rhs);
+  RETURN_IF_ERROR(MatMul::Execute(runtime_state, buffers, thread_pool));
+  return dst;
+}
+
+ref_ptr<Buffer> AllocateMatrix(const std::vector<float>& matrix,
+                               MemoryAccessBitfield allowed_access) {
+  return HeapBuffer::AllocateCopy(BufferUsage::kAll, allowed_access,
+                                  absl::MakeConstSpan(matrix));
+}
+
+// Allocates |matrix| as the allocate_const path does for module constants.
+ref_ptr<Buffer> AllocateConstantMatrix(const std::vector<float>& matrix) {
+  auto buffer = AllocateMatrix(matrix, MemoryAccess::kRead);
+  buffer->MarkConstantContents();
+  return buffer;
+}
+
+TEST(MatMul, SingleColumnBlock) {
+  auto runtime_state = MatMul::CreateRuntimeState();
+  auto lhs = MakeMatrix(3, 4, 0);
+  auto rhs = MakeMatrix(4, 5, 1);
+  auto rhs_buffer = AllocateMatrix(rhs, MemoryAccess::kAll);
+  ASSERT_OK_AND_ASSIGN(auto dst,
+                       ExecuteMatMul(runtime_state.get(), nullptr, lhs,
+                                     rhs_buffer.get(), 3, 4, 5));
+  EXPECT_EQ(ReferenceMatMul(lhs, rhs, 3, 4, 5), dst);
+  EXPECT_EQ(0, runtime_state->packed_rhs_count());
+}
+
+TEST(MatMul, ParallelColumnBlocks) {
+  auto runtime_state = MatMul::CreateRuntimeState();
+  ThreadPool thread_pool(ThreadPool::Options{3, false});
+  for (int n : {1, 17, 37, 100, 257}) {
+    auto lhs = MakeMatrix(9, 7, n);
+    auto rhs = MakeMatrix(7, n, n + 1);
+    auto rhs_buffer = AllocateMatrix(rhs, MemoryAccess::kAll);
+    ASSERT_OK_AND_ASSIGN(auto dst,
+                         ExecuteMatMul(runtime_state.get(), &thread_pool, lhs,
+                                       rhs_buffer.get(), 9, 7, n));
+    EXPECT_EQ(ReferenceMatMul(lhs, rhs, 9, 7, n), dst) << "n=" << n;
+  }
+  EXPECT_EQ(0, runtime_state->packed_rhs_count());
+}
+
+// Read-only buffers that are not constants (such as imported host arrays) may
+// still be changed by their owner between calls and must not be cached.
+TEST(MatMul, ReadOnlyRhsNotPrepacked) {
+  auto runtime_state = MatMul::CreateRuntimeState();
+  auto lhs = MakeMatrix(9, 7, 0);
+  auto rhs = MakeMatrix(7, 100, 1);
+  auto rhs_buffer = HeapBuffer::Wrap(MemoryType::kHostLocal, BufferUsage::kAll,
+                                     absl::MakeConstSpan(rhs));
+  ASSERT_OK_AND_ASSIGN(auto dst,
+                       ExecuteMatMul(runtime_state.get(), nullptr, lhs,
+                                     rhs_buffer.get(), 9, 7, 100));
+  EXPECT_EQ(ReferenceMatMul(lhs, rhs, 9, 7, 100), dst);
+  EXPECT_EQ(0, runtime_state->packed_rhs_count());
+
+  // The owner changing the contents is observed by the next execution.
+  auto other_rhs = MakeMatrix(7, 100, 2);
+  std::copy(other_rhs.begin(), other_rhs.end(), rhs.begin());
+  ASSERT_OK_AND_ASSIGN(dst, ExecuteMatMul(runtime_state.get(), nullptr, lhs,
+                                          rhs_buffer.get(), 9, 7, 100));
+  EXPECT_EQ(ReferenceMatMul(lhs, other_rhs, 9, 7, 100), dst);
+  EXPECT_EQ(0, runtime_state->packed_rhs_count());
+}
+
+TEST(MatMul, PrepackedConstant) {
+  auto runtime_state = MatMul::CreateRuntimeState();
+  ThreadPool thread_pool(ThreadPool::Options{3, false});
+  auto lhs = MakeMatrix(9, 7, 0);
+  auto rhs = MakeMatrix(7, 100, 1);
+  auto expected_dst = ReferenceMatMul(lhs, rhs, 9, 7, 100);
+  auto rhs_buffer = AllocateConstantMatrix(rhs);
+  for (ThreadPool* pool : {&thread_pool, &thread_pool,
+                           static_cast<ThreadPool*>(nullptr), &thread_pool}) {
+    ASSERT_OK_AND_ASSIGN(auto dst,
+                         ExecuteMatMul(runtime_state.get(), pool, lhs,
+                                       rhs_buffer.get(), 9, 7, 100));
+    EXPECT_EQ(expected_dst, dst);
+    EXPECT_EQ(1, runtime_state->packed_rhs_count());
+  }
+}
+
+TEST(MatMul, PrepackedConstantRepackedForNewShape) {
+  auto runtime_state = MatMul::CreateRuntimeState();
+  auto lhs = MakeMatrix(3, 8, 0);
+  auto rhs = MakeMatrix(8, 6, 1);
+  auto rhs_buffer = AllocateConstantMatrix(rhs);
+  ASSERT_OK_AND_ASSIGN(auto dst,
+                       ExecuteMatMul(runtime_state.get(), nullptr, lhs,
+                                     rhs_buffer.get(), 3, 8, 6));
+  EXPECT_EQ(ReferenceMatMul(lhs, rhs, 3, 8, 6), dst);
+
+  // The same contents reinterpreted as a [6, 8] matrix.
+  auto other_lhs = MakeMatrix(3, 6, 2);
+  ASSERT_OK_AND_ASSIGN(auto other_dst,
+                       ExecuteMatMul(runtime_state.get(), nullptr, other_lhs,
+                                     rhs_buffer.get(), 3, 6, 8));
+  EXPECT_EQ(ReferenceMatMul(other_lhs, rhs, 3, 6, 8), other_dst);
+  EXPECT_EQ(1, runtime_state->packed_rhs_count());
+}
+
+TEST(MatMul, PrepackedConstantsEvicted) {
+  auto runtime_state = MatMul::CreateRuntimeState();
+  auto lhs = MakeMatrix(4, 8, 0);
+  auto first_rhs = MakeMatrix(8, 16, 1);
+  auto first_rhs_buffer = AllocateConstantMatrix(first_rhs);
+  ASSERT_OK_AND_ASSIGN(auto dst,
+                       ExecuteMatMul(runtime_state.get(), nullptr, lhs,
+                                     first_rhs_buffer.get(), 4, 8, 16));
+  EXPECT_EQ(ReferenceMatMul(lhs, first_rhs, 4, 8, 16), dst);
+
+  // Constants released by their users may be freed and their memory reused
+  // once evicted. New constants are still packed after the cache fills.
+  for (int i = 0; i < MatMul::RuntimeState::kMaxPackedRhsCount + 8; ++i) {
+    auto rhs = MakeMatrix(8, 16, i + 2);
+    auto rhs_buffer = AllocateConstantMatrix(rhs);
+    ASSERT_OK_AND_ASSIGN(dst, ExecuteMatMul(runtime_state.get(), nullptr, lhs,
+                                            rhs_buffer.get(), 4, 8, 16));
+    EXPECT_EQ(ReferenceMatMul(lhs, rhs, 4, 8, 16), dst) << "i=" << i;
+  }
+  EXPECT_EQ(MatMul::RuntimeState::kMaxPackedRhsCount,
+            runtime_state->packed_rhs_count());
+
+  // The first constant was evicted and is packed again.
+  ASSERT_OK_AND_ASSIGN(dst, ExecuteMatMul(runtime_state.get(), nullptr, lhs,
+                                          first_rhs_buffer.get(), 4, 8, 16));
+  EXPECT_EQ(ReferenceMatMul(lhs, first_rhs, 4, 8, 16), dst);
+  EXPECT_EQ(MatMul::RuntimeState::kMaxPackedRhsCount,
+            runtime_state->packed_rhs_count());
+}
+
 }  // namespace
 }  // namespace kernels
 }  // namespace hal
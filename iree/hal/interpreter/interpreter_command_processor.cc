@@ -45,6 +45,10 @@ Status InterpreterCommandProcessor::Dispatch(
                                             Function::Linkage::kExport,
                                             dispatch_request.entry_point));
 
+  // NOTE: interpreter executables operate on whole buffers and do not observe
+  // workgroup IDs, so the dispatch workload cannot be split here without
+  // redundantly recomputing the results. Instead kernels split their own work
+  // across the device ThreadPool (see kernels::RuntimeState::thread_pool).
   Stack stack;
 
   // TODO(benvanik): avoid this by directly referencing the bindings.
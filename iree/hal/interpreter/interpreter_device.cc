@@ -96,8 +96,14 @@ class UnsynchronizedCommandQueue final : public CommandQueue {
 
 }  // namespace
 
-InterpreterDevice::InterpreterDevice(DeviceInfo device_info)
-    : Device(std::move(device_info)) {
+InterpreterDevice::InterpreterDevice(
+    DeviceInfo device_info, ThreadPool::Options thread_pool_options,
+    HostLocalAllocator::Options allocator_options)
+    : Device(std::move(device_info)),
+      thread_pool_(thread_pool_options),
+      allocator_(allocator_options) {
+  kernel_runtime_state_.thread_pool = &thread_pool_;
+
   // We currently only expose a single command queue.
   auto command_queue = absl::make_unique<UnsynchronizedCommandQueue>(
       &allocator_, "cpu0",
@@ -113,7 +119,7 @@ InterpreterDevice::InterpreterDevice(DeviceInfo device_info)
 InterpreterDevice::~InterpreterDevice() = default;
 
 ref_ptr<ExecutableCache> InterpreterDevice::CreateExecutableCache() {
-  return make_ref<BytecodeCache>(&allocator_);
+  return make_ref<BytecodeCache>(&allocator_, &thread_pool_);
 }
 
 StatusOr<ref_ptr<CommandBuffer>> InterpreterDevice::CreateCommandBuffer(
@@ -138,10 +144,7 @@ StatusOr<ref_ptr<BinarySemaphore>> InterpreterDevice::CreateBinarySemaphore(
 StatusOr<ref_ptr<TimelineSemaphore>> InterpreterDevice::CreateTimelineSemaphore(
     uint64_t initial_value) {
   IREE_TRACE_SCOPE0("InterpreterDevice::CreateTimelineSemaphore");
-
-  // TODO(b/140141417): implement timeline semaphores.
-  return UnimplementedErrorBuilder(IREE_LOC)
-         << "Timeline semaphores not yet implemented";
+  return make_ref<HostTimelineSemaphore>(initial_value);
 }
 
 StatusOr<ref_ptr<Fence>> InterpreterDevice::CreateFence(
@@ -159,7 +162,7 @@ Status InterpreterDevice::WaitAllFences(absl::Span<const FenceValue> fences,
 StatusOr<int> InterpreterDevice::WaitAnyFence(
     absl::Span<const FenceValue> fences, absl::Time deadline) {
   IREE_TRACE_SCOPE0("InterpreterDevice::WaitAnyFence");
-  return HostFence::WaitForFences(fences, /*wait_all=*/false, deadline);
+  return HostFence::WaitAnyFence(fences, deadline);
 }
 
 Status InterpreterDevice::WaitIdle(absl::Time deadline) {
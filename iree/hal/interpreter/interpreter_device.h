@@ -20,6 +20,7 @@
 #include "iree/base/memory.h"
 #include "iree/hal/device.h"
 #include "iree/hal/host/host_local_allocator.h"
+#include "iree/hal/host/thread_pool.h"
 #include "iree/hal/interpreter/bytecode_kernels.h"
 
 namespace iree {
@@ -27,9 +28,14 @@ namespace hal {
 
 class InterpreterDevice final : public Device {
  public:
-  explicit InterpreterDevice(DeviceInfo device_info);
+  InterpreterDevice(DeviceInfo device_info,
+                    ThreadPool::Options thread_pool_options,
+                    HostLocalAllocator::Options allocator_options);
   ~InterpreterDevice() override;
 
+  // Thread pool shared by all executables prepared for the device.
+  ThreadPool* thread_pool() { return &thread_pool_; }
+
   kernels::RuntimeState* kernel_runtime_state() {
     return &kernel_runtime_state_;
   }
@@ -66,6 +72,7 @@ class InterpreterDevice final : public Device {
   Status WaitIdle(absl::Time deadline) override;
 
  private:
+  ThreadPool thread_pool_;
   kernels::RuntimeState kernel_runtime_state_;
   mutable HostLocalAllocator allocator_;
   mutable absl::InlinedVector<std::unique_ptr<CommandQueue>, 1> command_queues_;
@@ -37,7 +37,8 @@ DeviceInfo GetDefaultDeviceInfo() {
 
 }  // namespace
 
-InterpreterDriver::InterpreterDriver() : Driver("interpreter") {}
+InterpreterDriver::InterpreterDriver(Options options)
+    : Driver("interpreter"), options_(std::move(options)) {}
 
 InterpreterDriver::~InterpreterDriver() = default;
 
@@ -54,7 +55,9 @@ StatusOr<ref_ptr<Device>> InterpreterDriver::CreateDefaultDevice() {
 
 StatusOr<ref_ptr<Device>> InterpreterDriver::CreateDevice(
     DriverDeviceID device_id) {
-  auto device = make_ref<InterpreterDevice>(GetDefaultDeviceInfo());
+  auto device = make_ref<InterpreterDevice>(GetDefaultDeviceInfo(),
+                                            options_.thread_pool_options,
+                                            options_.allocator_options);
   return device;
 }
 
@@ -16,13 +16,23 @@
 #define IREE_HAL_INTERPRETER_INTERPRETER_DRIVER_H_
 
 #include "iree/hal/driver.h"
+#include "iree/hal/host/host_local_allocator.h"
+#include "iree/hal/host/thread_pool.h"
 
 namespace iree {
 namespace hal {
 
 class InterpreterDriver final : public Driver {
  public:
-  InterpreterDriver();
+  struct Options {
+    // Options for the thread pool each device uses to execute kernels.
+    ThreadPool::Options thread_pool_options;
+
+    // Options for the allocator each device uses for its buffers.
+    HostLocalAllocator::Options allocator_options;
+  };
+
+  explicit InterpreterDriver(Options options);
   ~InterpreterDriver() override;
 
   StatusOr<std::vector<DeviceInfo>> EnumerateAvailableDevices() override;
@@ -30,6 +40,9 @@ class InterpreterDriver final : public Driver {
   StatusOr<ref_ptr<Device>> CreateDefaultDevice() override;
 
   StatusOr<ref_ptr<Device>> CreateDevice(DriverDeviceID device_id) override;
+
+ private:
+  Options options_;
 };
 
 }  // namespace hal
@@ -14,17 +14,40 @@
 
 #include <memory>
 
+#include "absl/flags/flag.h"
+#include "iree/base/api.h"
 #include "iree/base/init.h"
 #include "iree/base/status.h"
 #include "iree/hal/driver_registry.h"
 #include "iree/hal/interpreter/interpreter_driver.h"
 
+ABSL_FLAG(int32_t, interpreter_worker_count, -1,
+          "Number of worker threads used to execute interpreter kernels. "
+          "-1 selects a count based on the host hardware concurrency.");
+ABSL_FLAG(bool, interpreter_deterministic, false,
+          "Executes all interpreter kernel work in order on the dispatching "
+          "thread for reproducible results.");
+ABSL_FLAG(bool, interpreter_zero_buffers, false,
+          "Zeros the contents of all buffers allocated by the interpreter. "
+          "Interpreter kernels fully initialize the buffers they produce so "
+          "this is only needed to debug reads of uninitialized memory.");
+
 namespace iree {
 namespace hal {
 namespace {
 
 StatusOr<ref_ptr<Driver>> CreateInterpreterDriver() {
-  return make_ref<InterpreterDriver>();
+  InterpreterDriver::Options options;
+  options.thread_pool_options.worker_count =
+      absl::GetFlag(FLAGS_interpreter_worker_count);
+  options.thread_pool_options.deterministic =
+      absl::GetFlag(FLAGS_interpreter_deterministic);
+  // Recycled buffers keep their previous contents unless zeroing is requested.
+  options.allocator_options.allocation_mode =
+      absl::GetFlag(FLAGS_interpreter_zero_buffers)
+          ? IREE_ALLOCATION_MODE_ZERO_CONTENTS
+          : static_cast<iree_allocation_mode_t>(0);
+  return make_ref<InterpreterDriver>(std::move(options));
 }
 
 }  // namespace
@@ -158,14 +158,15 @@ Status InterpreterModule::ValidateArgType(const BufferView& arg,
 
 // static
 StatusOr<ref_ptr<InterpreterModule>> InterpreterModule::FromDef(
-    hal::Allocator* allocator, const ModuleDef& module_def) {
+    hal::Allocator* allocator, ThreadPool* thread_pool,
+    const ModuleDef& module_def) {
   ASSIGN_OR_RETURN(auto module_file, ModuleFile::Create(&module_def, []() {}));
   if (module_file->root() == nullptr) {
     return InvalidArgumentErrorBuilder(IREE_LOC) << "No root ModuleDef present";
   }
 
-  auto module =
-      assign_ref(new InterpreterModule(allocator, std::move(module_file)));
+  auto module = assign_ref(
+      new InterpreterModule(allocator, thread_pool, std::move(module_file)));
 
   // TODO(benvanik): validate internals here? or make explicit?
 
@@ -173,10 +174,13 @@ StatusOr<ref_ptr<InterpreterModule>> InterpreterModule::FromDef(
 }
 
 InterpreterModule::InterpreterModule(hal::Allocator* allocator,
+                                     ThreadPool* thread_pool,
                                      ref_ptr<ModuleFile> module_file)
     : allocator_(allocator),
       module_file_(std::move(module_file)),
-      module_def_(*module_file_->root()) {}
+      module_def_(*module_file_->root()) {
+  kernel_runtime_state_.thread_pool = thread_pool;
+}
 
 StatusOr<int32_t> InterpreterModule::MapFunctionOrdinal(
     Function::Linkage linkage, int32_t ordinal) const {
@@ -244,6 +248,8 @@ Status InterpreterModule::Execute(
                    GetFunctionDef(function.linkage(), function.ordinal()));
   auto* registers = callee_stack_frame->mutable_registers();
   registers->buffer_views.resize(function_def->bytecode()->local_count());
+  RETURN_IF_ERROR(stack->ReserveFrameScratch(
+      allocator_, function_def->bytecode()->scratch_size()));
 
   // Marshal input arguments.
   for (int i = 0; i < arguments.size(); ++i) {
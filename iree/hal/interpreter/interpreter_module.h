@@ -25,6 +25,7 @@
 #include "iree/base/status.h"
 #include "iree/hal/allocator.h"
 #include "iree/hal/buffer_view.h"
+#include "iree/hal/host/thread_pool.h"
 #include "iree/hal/interpreter/bytecode_kernels.h"
 #include "iree/hal/interpreter/bytecode_tables_interpreter.h"
 #include "iree/schemas/interpreter_module_def_generated.h"
@@ -79,7 +80,8 @@ class InterpreterModule final : public RefObject<InterpreterModule> {
   static Status ValidateStructure(const ModuleDef& module_def);
 
   static StatusOr<ref_ptr<InterpreterModule>> FromDef(
-      hal::Allocator* allocator, const ModuleDef& module_def);
+      hal::Allocator* allocator, ThreadPool* thread_pool,
+      const ModuleDef& module_def);
 
   const ModuleDef& def() const { return module_def_; }
   const FunctionTableDef& function_table_def() const {
@@ -102,7 +104,8 @@ class InterpreterModule final : public RefObject<InterpreterModule> {
   static Status ValidateArgType(const hal::BufferView& arg,
                                 const MemRefTypeDef& expected_type);
 
-  InterpreterModule(hal::Allocator* allocator, ref_ptr<ModuleFile> module_file);
+  InterpreterModule(hal::Allocator* allocator, ThreadPool* thread_pool,
+                    ref_ptr<ModuleFile> module_file);
 
   StatusOr<int32_t> MapFunctionOrdinal(Function::Linkage linkage,
                                        int32_t ordinal) const;
@@ -14,6 +14,7 @@
 
 #include "iree/hal/interpreter/stack.h"
 
+#include <algorithm>
 #include <iterator>
 
 #include "iree/base/status.h"
@@ -21,6 +22,14 @@
 namespace iree {
 namespace hal {
 
+namespace {
+
+// Alignment of each frame reservation within the scratch arena.
+// The compiler aligns allocations within a frame to the same boundary.
+constexpr device_size_t kScratchAlignment = 16;
+
+}  // namespace
+
 constexpr int Stack::kMaxStackDepth;
 
 Stack::Stack() = default;
@@ -32,6 +41,7 @@ StatusOr<StackFrame*> Stack::PushFrame(Function function) {
     return InternalErrorBuilder(IREE_LOC)
            << "Max stack depth of " << kMaxStackDepth << " exceeded";
   }
+  scratch_arena_bases_[stack_depth_] = scratch_arena_top_;
   frames_[stack_depth_++] = StackFrame(function);
 
   // TODO(benvanik): WTF scope enter.
@@ -48,6 +58,35 @@ Status Stack::PopFrame() {
 
   --stack_depth_;
   frames_[stack_depth_] = {};
+  scratch_arena_top_ = scratch_arena_bases_[stack_depth_];
+  return OkStatus();
+}
+
+Status Stack::ReserveFrameScratch(hal::Allocator* allocator,
+                                  device_size_t byte_length) {
+  auto* frame = current_frame();
+  if (!frame) {
+    return FailedPreconditionErrorBuilder(IREE_LOC)
+           << "No frame to reserve scratch memory for";
+  }
+  if (byte_length == 0) return OkStatus();
+
+  device_size_t offset = (scratch_arena_top_ + kScratchAlignment - 1) &
+                         ~(kScratchAlignment - 1);
+  if (!scratch_arena_ || offset + byte_length > scratch_arena_->byte_length()) {
+    // Frames still referencing the old arena keep it alive until popped.
+    device_size_t arena_size = offset + byte_length;
+    if (scratch_arena_) {
+      arena_size = std::max(arena_size, scratch_arena_->byte_length() * 2);
+    }
+    ASSIGN_OR_RETURN(
+        scratch_arena_,
+        allocator->Allocate(MemoryType::kHostLocal | MemoryType::kDeviceVisible,
+                            BufferUsage::kAll, arena_size));
+  }
+  ASSIGN_OR_RETURN(frame->mutable_registers()->scratch_buffer,
+                   Buffer::Subspan(scratch_arena_, offset, byte_length));
+  scratch_arena_top_ = offset + byte_length;
   return OkStatus();
 }
 
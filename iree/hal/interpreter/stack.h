@@ -15,11 +15,15 @@
 #ifndef IREE_HAL_INTERPRETER_STACK_H_
 #define IREE_HAL_INTERPRETER_STACK_H_
 
+#include <array>
 #include <functional>
 #include <vector>
 
 #include "absl/types/span.h"
+#include "iree/base/ref_ptr.h"
 #include "iree/base/status.h"
+#include "iree/hal/allocator.h"
+#include "iree/hal/buffer.h"
 #include "iree/hal/buffer_view.h"
 #include "iree/hal/interpreter/interpreter_module.h"
 
@@ -30,6 +34,10 @@ namespace hal {
 // Register table used within a stack frame.
 struct Registers {
   std::vector<hal::BufferView> buffer_views;
+
+  // Scratch memory holding the statically planned allocations of the frame.
+  // Reserved from the Stack scratch arena when the frame is entered.
+  ref_ptr<hal::Buffer> scratch_buffer;
 };
 
 using SourceOffset = uint64_t;
@@ -120,9 +128,22 @@ class Stack final {
   StatusOr<StackFrame*> PushFrame(Function function);
   Status PopFrame();
 
+  // Reserves |byte_length| bytes of scratch memory for the current frame and
+  // stores it in the frame scratch_buffer register until the frame is popped.
+  // All frames are carved from a single arena owned by the stack that is
+  // allocated from |allocator| on first use and only reallocated if a deeper
+  // call chain needs more than it has.
+  Status ReserveFrameScratch(hal::Allocator* allocator,
+                             device_size_t byte_length);
+
  private:
   std::array<StackFrame, kMaxStackDepth> frames_;
   int stack_depth_ = 0;
+
+  ref_ptr<hal::Buffer> scratch_arena_;
+  device_size_t scratch_arena_top_ = 0;
+  // scratch_arena_top_ at the time each frame was pushed.
+  std::array<device_size_t, kMaxStackDepth> scratch_arena_bases_;
 };
 
 }  // namespace hal
@@ -0,0 +1,285 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/hal/persistent_executable_cache.h"
+
+#include <algorithm>
+#include <tuple>
+#include <utility>
+
+#include "iree/base/logging.h"
+#include "iree/base/source_location.h"
+#include "iree/base/tracing.h"
+
+namespace iree {
+namespace hal {
+
+namespace {
+
+// Serialized form, with all fields little-endian:
+//   uint32_t magic ('IEXC')
+//   uint32_t version
+//   uint32_t entry_count
+//   uint32_t reserved
+//   entry_count times:
+//     uint32_t format
+//     uint32_t mode
+//     uint64_t hash_code
+//     uint64_t data_length
+//     uint8_t data[data_length], zero padded to a multiple of 8 bytes
+constexpr uint32_t kMagic = MakeExecutableFormatID("IEXC");
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = 16;
+constexpr size_t kEntryHeaderSize = 24;
+
+// Clears the mode bits that do not change the prepared executable and are
+// ignored when looking up executables.
+ExecutableCachingModeBitfield StripHintModes(
+    ExecutableCachingModeBitfield mode) {
+  return mode & ~(ExecutableCachingMode::kAliasProvidedData |
+                  ExecutableCachingMode::kAllowPersistentCaching);
+}
+
+size_t AlignTo8(size_t value) { return (value + 7) & ~static_cast<size_t>(7); }
+
+void AppendLittleEndian(std::vector<uint8_t>* data, uint64_t value,
+                        int byte_count) {
+  for (int i = 0; i < byte_count; ++i) {
+    data->push_back(static_cast<uint8_t>(value >> (i * 8)));
+  }
+}
+
+uint64_t ReadLittleEndian(const uint8_t* data, int byte_count) {
+  uint64_t value = 0;
+  for (int i = 0; i < byte_count; ++i) {
+    value |= static_cast<uint64_t>(data[i]) << (i * 8);
+  }
+  return value;
+}
+
+}  // namespace
+
+PersistentExecutableCache::PersistentExecutableCache(
+    ref_ptr<ExecutableCache> wrapped_cache, bool enable_serialization,
+    size_t max_executable_count)
+    : wrapped_cache_(std::move(wrapped_cache)),
+      enable_serialization_(enable_serialization),
+      max_executable_count_(std::max<size_t>(1, max_executable_count)) {}
+
+PersistentExecutableCache::~PersistentExecutableCache() = default;
+
+// static
+PersistentExecutableCache::Key PersistentExecutableCache::MakeKey(
+    ExecutableCachingModeBitfield mode, const ExecutableSpec& spec) {
+  Key key;
+  key.format = spec.format;
+  key.mode = static_cast<uint32_t>(StripHintModes(mode));
+  key.hash_code = spec.hash_code
+                      ? spec.hash_code
+                      : ComputeExecutableHash(spec.format,
+                                              spec.executable_data);
+  return key;
+}
+
+size_t PersistentExecutableCache::executable_count() const {
+  absl::MutexLock lock(&mutex_);
+  return entries_.size();
+}
+
+void PersistentExecutableCache::Trim() {
+  absl::MutexLock lock(&mutex_);
+  entries_.clear();
+}
+
+void PersistentExecutableCache::EvictEntries() {
+  while (entries_.size() > max_executable_count_) {
+    auto oldest_it = entries_.begin();
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+      if (it->second.last_use < oldest_it->second.last_use) oldest_it = it;
+    }
+    entries_.erase(oldest_it);
+  }
+}
+
+bool PersistentExecutableCache::CanPrepareFormat(
+    ExecutableFormat format) const {
+  return wrapped_cache_->CanPrepareFormat(format);
+}
+
+StatusOr<ref_ptr<Executable>> PersistentExecutableCache::PrepareExecutable(
+    ExecutableCachingModeBitfield mode, const ExecutableSpec& spec) {
+  IREE_TRACE_SCOPE0("PersistentExecutableCache::PrepareExecutable");
+  Key key = MakeKey(mode, spec);
+  bool persistent =
+      enable_serialization_ &&
+      AllBitsSet(mode, ExecutableCachingMode::kAllowPersistentCaching);
+
+  {
+    absl::MutexLock lock(&mutex_);
+    auto it = entries_.find(key);
+    if (it != entries_.end() &&
+        it->second.data_length == spec.executable_data.size()) {
+      auto& entry = it->second;
+      entry.last_use = ++use_counter_;
+      if (persistent && entry.data.empty()) {
+        entry.data.assign(spec.executable_data.begin(),
+                          spec.executable_data.end());
+      }
+      return add_ref(entry.executable);
+    }
+  }
+
+  // Prepare outside of the lock as it may take a while. If another thread
+  // prepares the same executable in the meantime we use whichever finishes
+  // first so that all callers share a single executable.
+  ASSIGN_OR_RETURN(auto executable,
+                   wrapped_cache_->PrepareExecutable(mode, spec));
+
+  absl::MutexLock lock(&mutex_);
+  auto& entry = entries_[key];
+  entry.last_use = ++use_counter_;
+  if (entry.executable &&
+      entry.data_length == spec.executable_data.size()) {
+    return add_ref(entry.executable);
+  } else if (entry.executable) {
+    // 64-bit hash collision; keep the newer executable.
+    LOG(WARNING) << "Executable hash collision on " << std::hex
+                 << key.hash_code;
+  }
+  entry.executable = add_ref(executable);
+  entry.data_length = spec.executable_data.size();
+  if (persistent) {
+    entry.data.assign(spec.executable_data.begin(),
+                      spec.executable_data.end());
+  } else {
+    entry.data.clear();
+  }
+  EvictEntries();
+  return executable;
+}
+
+StatusOr<std::vector<uint8_t>> PersistentExecutableCache::Serialize() const {
+  IREE_TRACE_SCOPE0("PersistentExecutableCache::Serialize");
+  if (!enable_serialization_) {
+    return FailedPreconditionErrorBuilder(IREE_LOC)
+           << "Executable cache was created without serialization enabled";
+  }
+  absl::MutexLock lock(&mutex_);
+
+  // Sort entries so that the same set of executables always produces the same
+  // bytes regardless of the order they were prepared in.
+  std::vector<std::pair<Key, const Entry*>> persistent_entries;
+  for (const auto& it : entries_) {
+    if (it.second.data.empty()) continue;
+    persistent_entries.emplace_back(it.first, &it.second);
+  }
+  std::sort(persistent_entries.begin(), persistent_entries.end(),
+            [](const std::pair<Key, const Entry*>& lhs,
+               const std::pair<Key, const Entry*>& rhs) {
+              return std::tie(lhs.first.hash_code, lhs.first.format,
+                              lhs.first.mode) <
+                     std::tie(rhs.first.hash_code, rhs.first.format,
+                              rhs.first.mode);
+            });
+
+  size_t total_size = kHeaderSize;
+  for (const auto& it : persistent_entries) {
+    total_size += kEntryHeaderSize + AlignTo8(it.second->data.size());
+  }
+  std::vector<uint8_t> data;
+  data.reserve(total_size);
+  AppendLittleEndian(&data, kMagic, 4);
+  AppendLittleEndian(&data, kVersion, 4);
+  AppendLittleEndian(&data, persistent_entries.size(), 4);
+  AppendLittleEndian(&data, 0, 4);
+  for (const auto& it : persistent_entries) {
+    const auto& entry_data = it.second->data;
+    AppendLittleEndian(&data, it.first.format, 4);
+    AppendLittleEndian(&data, it.first.mode, 4);
+    AppendLittleEndian(&data, it.first.hash_code, 8);
+    AppendLittleEndian(&data, entry_data.size(), 8);
+    data.insert(data.end(), entry_data.begin(), entry_data.end());
+    data.resize(AlignTo8(data.size()), 0);
+  }
+  return data;
+}
+
+Status PersistentExecutableCache::Deserialize(absl::Span<const uint8_t> data) {
+  IREE_TRACE_SCOPE0("PersistentExecutableCache::Deserialize");
+
+  if (data.size() < kHeaderSize ||
+      ReadLittleEndian(data.data(), 4) != kMagic) {
+    return InvalidArgumentErrorBuilder(IREE_LOC)
+           << "Data is not a serialized executable cache";
+  }
+  uint32_t version = ReadLittleEndian(data.data() + 4, 4);
+  if (version != kVersion) {
+    return FailedPreconditionErrorBuilder(IREE_LOC)
+           << "Unsupported executable cache version " << version
+           << "; expected " << kVersion;
+  }
+  uint32_t entry_count = ReadLittleEndian(data.data() + 8, 4);
+
+  // Validate all entries before preparing any so that corrupt data does not
+  // leave the cache partially populated.
+  std::vector<std::pair<ExecutableCachingModeBitfield, ExecutableSpec>> specs;
+  specs.reserve(std::min<size_t>(entry_count, data.size() / kEntryHeaderSize));
+  size_t offset = kHeaderSize;
+  for (uint32_t i = 0; i < entry_count; ++i) {
+    if (data.size() - offset < kEntryHeaderSize) {
+      return DataLossErrorBuilder(IREE_LOC)
+             << "Executable cache entry " << i << " header truncated";
+    }
+    const uint8_t* entry_header = data.data() + offset;
+    ExecutableSpec spec;
+    spec.format = ReadLittleEndian(entry_header + 0, 4);
+    auto mode = static_cast<ExecutableCachingModeBitfield>(
+        ReadLittleEndian(entry_header + 4, 4));
+    spec.hash_code = ReadLittleEndian(entry_header + 8, 8);
+    uint64_t data_length = ReadLittleEndian(entry_header + 16, 8);
+    offset += kEntryHeaderSize;
+    if (data_length > data.size() - offset) {
+      return DataLossErrorBuilder(IREE_LOC)
+             << "Executable cache entry " << i << " data truncated";
+    }
+    spec.executable_data = data.subspan(offset, data_length);
+    if (ComputeExecutableHash(spec.format, spec.executable_data) !=
+        spec.hash_code) {
+      return DataLossErrorBuilder(IREE_LOC)
+             << "Executable cache entry " << i << " is corrupt";
+    }
+    offset = std::min(data.size(), offset + AlignTo8(data_length));
+    specs.emplace_back(mode, spec);
+  }
+
+  for (const auto& it : specs) {
+    const auto& spec = it.second;
+    if (!CanPrepareFormat(spec.format)) continue;
+    // The data is only valid for the duration of this call so the wrapped
+    // cache must not alias it.
+    auto mode = StripHintModes(it.first) |
+                ExecutableCachingMode::kAllowPersistentCaching;
+    auto executable_or = PrepareExecutable(mode, spec);
+    if (!executable_or.ok()) {
+      // The executable may have been produced for a different version of the
+      // runtime. It will be prepared again if it is ever used.
+      LOG(WARNING) << "Unable to prepare cached executable: "
+                   << executable_or.status();
+    }
+  }
+  return OkStatus();
+}
+
+}  // namespace hal
+}  // namespace iree
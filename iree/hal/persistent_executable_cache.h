@@ -0,0 +1,123 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef IREE_HAL_PERSISTENT_EXECUTABLE_CACHE_H_
+#define IREE_HAL_PERSISTENT_EXECUTABLE_CACHE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "iree/base/ref_ptr.h"
+#include "iree/base/status.h"
+#include "iree/hal/executable.h"
+#include "iree/hal/executable_cache.h"
+
+namespace iree {
+namespace hal {
+
+// An executable cache that memoizes the executables prepared by another
+// (usually device-specific) cache keyed by the hash of their contents.
+// Preparing the same executable again - such as from another context sharing
+// the cache - returns the previously prepared executable without calling into
+// the wrapped cache.
+//
+// When serialization is enabled the data of executables prepared with
+// ExecutableCachingMode::kAllowPersistentCaching is retained so that they can
+// be serialized and loaded by a future process. The serialized form contains
+// the executable data and not any backend-specific prepared form; backends
+// that have their own persistent caches (such as the Vulkan pipeline cache)
+// make preparing the loaded executables cheap.
+//
+// At most |max_executable_count| executables are held; the least recently
+// prepared are evicted beyond that. Evicted executables remain valid for as
+// long as their users hold references to them.
+//
+// Thread-safe.
+class PersistentExecutableCache final : public ExecutableCache {
+ public:
+  static constexpr size_t kDefaultMaxExecutableCount = 256;
+
+  explicit PersistentExecutableCache(
+      ref_ptr<ExecutableCache> wrapped_cache,
+      bool enable_serialization = false,
+      size_t max_executable_count = kDefaultMaxExecutableCount);
+  ~PersistentExecutableCache() override;
+
+  // Returns the number of executables currently held by the cache.
+  size_t executable_count() const;
+
+  // Drops all executables held by the cache. Executables still referenced
+  // elsewhere remain valid but will be prepared again if requested.
+  void Trim();
+
+  bool CanPrepareFormat(ExecutableFormat format) const override;
+
+  StatusOr<ref_ptr<Executable>> PrepareExecutable(
+      ExecutableCachingModeBitfield mode, const ExecutableSpec& spec) override;
+
+  // Fails with FailedPrecondition if serialization was not enabled.
+  StatusOr<std::vector<uint8_t>> Serialize() const override;
+
+  Status Deserialize(absl::Span<const uint8_t> data) override;
+
+ private:
+  struct Key {
+    ExecutableFormat format;
+    uint32_t mode;
+    uint64_t hash_code;
+
+    bool operator==(const Key& other) const {
+      return format == other.format && mode == other.mode &&
+             hash_code == other.hash_code;
+    }
+    template <typename H>
+    friend H AbslHashValue(H h, const Key& key) {
+      return H::combine(std::move(h), key.format, key.mode, key.hash_code);
+    }
+  };
+
+  struct Entry {
+    ref_ptr<Executable> executable;
+    size_t data_length = 0;
+    // A copy of the executable data if it may be persisted; otherwise empty.
+    std::vector<uint8_t> data;
+    // Value of use_counter_ when the entry was last prepared.
+    uint64_t last_use = 0;
+  };
+
+  // Returns the key for an executable prepared with |mode| and |spec|.
+  static Key MakeKey(ExecutableCachingModeBitfield mode,
+                     const ExecutableSpec& spec);
+
+  // Evicts the least recently used entries until at most
+  // max_executable_count_ remain.
+  void EvictEntries() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  ref_ptr<ExecutableCache> wrapped_cache_;
+  const bool enable_serialization_;
+  const size_t max_executable_count_;
+
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<Key, Entry> entries_ ABSL_GUARDED_BY(mutex_);
+  uint64_t use_counter_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace hal
+}  // namespace iree
+
+#endif  // IREE_HAL_PERSISTENT_EXECUTABLE_CACHE_H_
@@ -0,0 +1,286 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/hal/persistent_executable_cache.h"
+
+#include <vector>
+
+#include "iree/base/status_matchers.h"
+#include "iree/testing/gtest.h"
+
+namespace iree {
+namespace hal {
+namespace {
+
+using ::iree::testing::status::StatusIs;
+
+constexpr ExecutableFormat kSupportedFormat = MakeExecutableFormatID("TEST");
+constexpr ExecutableFormat kOtherFormat = MakeExecutableFormatID("OTHR");
+
+class TestExecutable final : public Executable {
+ public:
+  bool supports_debugging() const override { return false; }
+};
+
+// Prepares a new executable on every call and counts the calls.
+class TestExecutableCache final : public ExecutableCache {
+ public:
+  int prepare_count() const { return prepare_count_; }
+
+  bool CanPrepareFormat(ExecutableFormat format) const override {
+    return format == kSupportedFormat;
+  }
+
+  StatusOr<ref_ptr<Executable>> PrepareExecutable(
+      ExecutableCachingModeBitfield mode, const ExecutableSpec& spec) override {
+    ++prepare_count_;
+    return make_ref<TestExecutable>();
+  }
+
+ private:
+  int prepare_count_ = 0;
+};
+
+ExecutableSpec MakeSpec(const std::vector<uint8_t>& data,
+                        ExecutableFormat format = kSupportedFormat) {
+  ExecutableSpec spec;
+  spec.format = format;
+  spec.executable_data = data;
+  return spec;
+}
+
+TEST(ExecutableHashTest, Stable) {
+  std::vector<uint8_t> data = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+  uint64_t hash = ComputeExecutableHash(kSupportedFormat, data);
+  EXPECT_NE(0, hash);
+  EXPECT_EQ(hash, ComputeExecutableHash(kSupportedFormat, data));
+  EXPECT_NE(hash, ComputeExecutableHash(kOtherFormat, data));
+  data.back() ^= 1;
+  EXPECT_NE(hash, ComputeExecutableHash(kSupportedFormat, data));
+  data.push_back(0);
+  EXPECT_NE(ComputeExecutableHash(kSupportedFormat,
+                                  absl::MakeConstSpan(data).subspan(0, 11)),
+            ComputeExecutableHash(kSupportedFormat, data));
+}
+
+TEST(PersistentExecutableCacheTest, Memoizes) {
+  auto test_cache = make_ref<TestExecutableCache>();
+  PersistentExecutableCache cache(add_ref(test_cache));
+  std::vector<uint8_t> data_a = {1, 2, 3};
+  std::vector<uint8_t> data_b = {4, 5, 6};
+
+  ASSERT_OK_AND_ASSIGN(auto executable_a, cache.PrepareExecutable(
+                                              ExecutableCachingMode::kDefault,
+                                              MakeSpec(data_a)));
+  ASSERT_OK_AND_ASSIGN(auto executable_b, cache.PrepareExecutable(
+                                              ExecutableCachingMode::kDefault,
+                                              MakeSpec(data_b)));
+  EXPECT_NE(executable_a.get(), executable_b.get());
+  EXPECT_EQ(2, test_cache->prepare_count());
+
+  // Same contents at a different address hit the cache.
+  std::vector<uint8_t> data_a_copy = data_a;
+  ASSERT_OK_AND_ASSIGN(auto executable_a_again,
+                       cache.PrepareExecutable(ExecutableCachingMode::kDefault,
+                                               MakeSpec(data_a_copy)));
+  EXPECT_EQ(executable_a.get(), executable_a_again.get());
+  EXPECT_EQ(2, test_cache->prepare_count());
+
+  // Modes that change the prepared executable miss.
+  ASSERT_OK_AND_ASSIGN(
+      auto executable_a_debug,
+      cache.PrepareExecutable(ExecutableCachingMode::kDefault |
+                                  ExecutableCachingMode::kEnableDebugging,
+                              MakeSpec(data_a)));
+  EXPECT_NE(executable_a.get(), executable_a_debug.get());
+  EXPECT_EQ(3, test_cache->prepare_count());
+  EXPECT_EQ(3, cache.executable_count());
+}
+
+TEST(PersistentExecutableCacheTest, SerializeRoundTrip) {
+  std::vector<uint8_t> data_a = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+  std::vector<uint8_t> data_b = {10, 11};
+  std::vector<uint8_t> data_c = {12};
+
+  std::vector<uint8_t> serialized;
+  {
+    PersistentExecutableCache cache(make_ref<TestExecutableCache>(),
+                                    /*enable_serialization=*/true);
+    ASSERT_OK(cache
+                  .PrepareExecutable(ExecutableCachingMode::kDefault,
+                                     MakeSpec(data_a))
+                  .status());
+    ASSERT_OK(cache
+                  .PrepareExecutable(ExecutableCachingMode::kDefault,
+                                     MakeSpec(data_b))
+                  .status());
+    // Not persisted.
+    ASSERT_OK(cache
+                  .PrepareExecutable(ExecutableCachingMode::kAllowOptimization,
+                                     MakeSpec(data_c))
+                  .status());
+    ASSERT_OK_AND_ASSIGN(serialized, cache.Serialize());
+  }
+
+  auto test_cache = make_ref<TestExecutableCache>();
+  PersistentExecutableCache cache(add_ref(test_cache),
+                                  /*enable_serialization=*/true);
+  ASSERT_OK(cache.Deserialize(serialized));
+  EXPECT_EQ(2, test_cache->prepare_count());
+  EXPECT_EQ(2, cache.executable_count());
+
+  ASSERT_OK(cache
+                .PrepareExecutable(ExecutableCachingMode::kDefault,
+                                   MakeSpec(data_a))
+                .status());
+  ASSERT_OK(cache
+                .PrepareExecutable(ExecutableCachingMode::kDefault,
+                                   MakeSpec(data_b))
+                .status());
+  EXPECT_EQ(2, test_cache->prepare_count());
+
+  // Serializing again produces the same bytes.
+  ASSERT_OK_AND_ASSIGN(auto reserialized, cache.Serialize());
+  EXPECT_EQ(serialized, reserialized);
+}
+
+TEST(PersistentExecutableCacheTest, SerializeRequiresEnable) {
+  PersistentExecutableCache cache(make_ref<TestExecutableCache>());
+  std::vector<uint8_t> data = {1, 2, 3};
+  ASSERT_OK(cache
+                .PrepareExecutable(ExecutableCachingMode::kDefault,
+                                   MakeSpec(data))
+                .status());
+  EXPECT_THAT(cache.Serialize().status(),
+              StatusIs(StatusCode::kFailedPrecondition));
+}
+
+TEST(PersistentExecutableCacheTest, EvictsLeastRecentlyUsed) {
+  auto test_cache = make_ref<TestExecutableCache>();
+  PersistentExecutableCache cache(add_ref(test_cache),
+                                  /*enable_serialization=*/false,
+                                  /*max_executable_count=*/2);
+  std::vector<uint8_t> data_a = {1};
+  std::vector<uint8_t> data_b = {2};
+  std::vector<uint8_t> data_c = {3};
+  auto prepare = [&](const std::vector<uint8_t>& data) {
+    return cache.PrepareExecutable(ExecutableCachingMode::kDefault,
+                                   MakeSpec(data));
+  };
+
+  ASSERT_OK_AND_ASSIGN(auto executable_a, prepare(data_a));
+  ASSERT_OK(prepare(data_b).status());
+  // Touch a so that b is the least recently used.
+  ASSERT_OK(prepare(data_a).status());
+  ASSERT_OK(prepare(data_c).status());
+  EXPECT_EQ(3, test_cache->prepare_count());
+  EXPECT_EQ(2, cache.executable_count());
+
+  // a and c are still cached while b must be prepared again.
+  ASSERT_OK_AND_ASSIGN(auto executable_a_again, prepare(data_a));
+  EXPECT_EQ(executable_a.get(), executable_a_again.get());
+  ASSERT_OK(prepare(data_c).status());
+  EXPECT_EQ(3, test_cache->prepare_count());
+  ASSERT_OK(prepare(data_b).status());
+  EXPECT_EQ(4, test_cache->prepare_count());
+  EXPECT_EQ(2, cache.executable_count());
+}
+
+TEST(PersistentExecutableCacheTest, Trim) {
+  auto test_cache = make_ref<TestExecutableCache>();
+  PersistentExecutableCache cache(add_ref(test_cache));
+  std::vector<uint8_t> data = {1, 2, 3};
+  ASSERT_OK_AND_ASSIGN(auto executable,
+                       cache.PrepareExecutable(ExecutableCachingMode::kDefault,
+                                               MakeSpec(data)));
+  cache.Trim();
+  EXPECT_EQ(0, cache.executable_count());
+
+  // The executable we hold remains valid and a new one is prepared.
+  EXPECT_FALSE(executable->supports_debugging());
+  ASSERT_OK_AND_ASSIGN(auto executable_again,
+                       cache.PrepareExecutable(ExecutableCachingMode::kDefault,
+                                               MakeSpec(data)));
+  EXPECT_NE(executable.get(), executable_again.get());
+  EXPECT_EQ(2, test_cache->prepare_count());
+}
+
+TEST(PersistentExecutableCacheTest, DeserializeSkipsUnsupportedFormats) {
+  std::vector<uint8_t> data = {1, 2, 3};
+  std::vector<uint8_t> serialized;
+  {
+    // A cache for another device that supports other formats.
+    class OtherExecutableCache final : public ExecutableCache {
+     public:
+      bool CanPrepareFormat(ExecutableFormat format) const override {
+        return true;
+      }
+      StatusOr<ref_ptr<Executable>> PrepareExecutable(
+          ExecutableCachingModeBitfield mode,
+          const ExecutableSpec& spec) override {
+        return make_ref<TestExecutable>();
+      }
+    };
+    PersistentExecutableCache cache(make_ref<OtherExecutableCache>(),
+                                    /*enable_serialization=*/true);
+    ASSERT_OK(cache
+                  .PrepareExecutable(ExecutableCachingMode::kDefault,
+                                     MakeSpec(data, kOtherFormat))
+                  .status());
+    ASSERT_OK_AND_ASSIGN(serialized, cache.Serialize());
+  }
+
+  auto test_cache = make_ref<TestExecutableCache>();
+  PersistentExecutableCache cache(add_ref(test_cache));
+  ASSERT_OK(cache.Deserialize(serialized));
+  EXPECT_EQ(0, test_cache->prepare_count());
+  EXPECT_EQ(0, cache.executable_count());
+}
+
+TEST(PersistentExecutableCacheTest, DeserializeInvalid) {
+  std::vector<uint8_t> data = {1, 2, 3, 4};
+  std::vector<uint8_t> serialized;
+  {
+    PersistentExecutableCache cache(make_ref<TestExecutableCache>(),
+                                    /*enable_serialization=*/true);
+    ASSERT_OK(cache
+                  .PrepareExecutable(ExecutableCachingMode::kDefault,
+                                     MakeSpec(data))
+                  .status());
+    ASSERT_OK_AND_ASSIGN(serialized, cache.Serialize());
+  }
+
+  auto test_cache = make_ref<TestExecutableCache>();
+  PersistentExecutableCache cache(add_ref(test_cache));
+  EXPECT_THAT(cache.Deserialize({}), StatusIs(StatusCode::kInvalidArgument));
+
+  auto bad_version = serialized;
+  bad_version[4] = 2;
+  EXPECT_THAT(cache.Deserialize(bad_version),
+              StatusIs(StatusCode::kFailedPrecondition));
+
+  auto truncated = serialized;
+  truncated.resize(truncated.size() - 8);
+  EXPECT_THAT(cache.Deserialize(truncated), StatusIs(StatusCode::kDataLoss));
+
+  auto corrupt = serialized;
+  corrupt[16 + 24] ^= 1;
+  EXPECT_THAT(cache.Deserialize(corrupt), StatusIs(StatusCode::kDataLoss));
+
+  EXPECT_EQ(0, test_cache->prepare_count());
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace iree
@@ -15,7 +15,12 @@
 #ifndef IREE_HAL_SEMAPHORE_H_
 #define IREE_HAL_SEMAPHORE_H_
 
+#include <cstdint>
+#include <utility>
+
+#include "absl/time/time.h"
 #include "absl/types/variant.h"
+#include "iree/base/status.h"
 #include "iree/hal/resource.h"
 
 namespace iree {
@@ -45,8 +50,24 @@ class BinarySemaphore : public Semaphore {
 // efficient due to system-level coalescing.
 class TimelineSemaphore : public Semaphore {
  public:
-  // TODO(benvanik): add value query support.
-  // TODO(benvanik): add host-side signal/wait.
+  // Queries the current payload of the semaphore. As the payload is
+  // monotonically increasing it is guaranteed that the value is at least equal
+  // to the previous result of a Query call.
+  //
+  // Returns the failure status if the semaphore has been set to a permanently
+  // failed state by an asynchronous error.
+  virtual StatusOr<uint64_t> Query() = 0;
+
+  // Signals the semaphore to the given payload value from the host.
+  // The value must be greater than the current payload.
+  virtual Status Signal(uint64_t value) = 0;
+
+  // Blocks the caller until the payload reaches or exceeds |value| or the
+  // |deadline| elapses.
+  //
+  // Returns DEADLINE_EXCEEDED if the |deadline| elapses without the payload
+  // having been reached.
+  virtual Status Wait(uint64_t value, absl::Time deadline) = 0;
 };
 
 // A reference to a strongly-typed semaphore and associated information.
@@ -168,6 +168,10 @@ VulkanDriver::Options ConvertDriverOptions(
       GetInstanceExtensibilitySpec(options.features);
   driver_options.device_extensibility =
       GetDeviceExtensibilitySpec(options.features);
+  if (options.pipeline_cache_dir.data) {
+    driver_options.pipeline_cache_dir = std::string(
+        options.pipeline_cache_dir.data, options.pipeline_cache_dir.size);
+  }
   return driver_options;
 }
 
@@ -63,6 +63,10 @@ typedef struct {
 
   // Vulkan features to request.
   iree_hal_vulkan_features_t features;
+
+  // Directory used to persist compiled pipelines across runs.
+  // Disabled if empty.
+  iree_string_view_t pipeline_cache_dir = {nullptr, 0};
 } iree_hal_vulkan_driver_options_t;
 
 // A set of queues within a specific queue family on a VkDevice.
@@ -49,11 +49,27 @@ Status DescriptorSetGroup::Reset() {
 DescriptorPoolCache::DescriptorPoolCache(ref_ptr<VkDeviceHandle> logical_device)
     : logical_device_(std::move(logical_device)) {}
 
+DescriptorPoolCache::~DescriptorPoolCache() { Trim(); }
+
 StatusOr<DescriptorPool> DescriptorPoolCache::AcquireDescriptorPool(
     VkDescriptorType descriptor_type, int max_descriptor_count) {
   IREE_TRACE_SCOPE0("DescriptorPoolCache::AcquireDescriptorPool");
 
-  // TODO(benvanik): lookup in cache.
+  DescriptorPool descriptor_pool;
+  descriptor_pool.descriptor_type = descriptor_type;
+  descriptor_pool.max_descriptor_count = max_descriptor_count;
+  descriptor_pool.handle = VK_NULL_HANDLE;
+
+  {
+    // Pools were reset when released so we can hand them out directly.
+    absl::MutexLock lock(&mutex_);
+    auto it = unused_pools_.find({descriptor_type, max_descriptor_count});
+    if (it != unused_pools_.end() && !it->second.empty()) {
+      descriptor_pool.handle = it->second.back();
+      it->second.pop_back();
+      return descriptor_pool;
+    }
+  }
 
   VkDescriptorPoolCreateInfo create_info;
   create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -66,11 +82,6 @@ StatusOr<DescriptorPool> DescriptorPoolCache::AcquireDescriptorPool(
   create_info.poolSizeCount = pool_sizes.size();
   create_info.pPoolSizes = pool_sizes.data();
 
-  DescriptorPool descriptor_pool;
-  descriptor_pool.descriptor_type = descriptor_type;
-  descriptor_pool.max_descriptor_count = max_descriptor_count;
-  descriptor_pool.handle = VK_NULL_HANDLE;
-
   VK_RETURN_IF_ERROR(syms().vkCreateDescriptorPool(
       *logical_device_, &create_info, logical_device_->allocator(),
       &descriptor_pool.handle));
@@ -82,19 +93,62 @@ Status DescriptorPoolCache::ReleaseDescriptorPools(
     absl::Span<DescriptorPool> descriptor_pools) {
   IREE_TRACE_SCOPE0("DescriptorPoolCache::ReleaseDescriptorPools");
 
-  for (const auto& descriptor_pool : descriptor_pools) {
-    // Always reset immediately. We could do this on allocation instead however
-    // this leads to better errors when using the validation layers as we'll
-    // throw if there are in-flight command buffers using the sets in the pool.
-    VK_RETURN_IF_ERROR(syms().vkResetDescriptorPool(*logical_device_,
-                                                    descriptor_pool.handle, 0));
+  // Always reset immediately. We could do this on allocation instead however
+  // this leads to better errors when using the validation layers as we'll
+  // throw if there are in-flight command buffers using the sets in the pool.
+  // Pools that fail to reset are destroyed instead of being recycled and the
+  // first failure is returned after all pools have been released.
+  Status status;
+  absl::InlinedVector<bool, 8> reset_ok(descriptor_pools.size());
+  for (size_t i = 0; i < descriptor_pools.size(); ++i) {
+    auto reset_status = VkResultToStatus(syms().vkResetDescriptorPool(
+        *logical_device_, descriptor_pools[i].handle, 0));
+    reset_ok[i] = reset_status.ok();
+    if (status.ok()) status = std::move(reset_status);
+  }
 
-    // TODO(benvanik): release to cache.
-    syms().vkDestroyDescriptorPool(*logical_device_, descriptor_pool.handle,
+  // Keep the pools for reuse unless we already have enough of the same kind.
+  absl::InlinedVector<VkDescriptorPool, 8> excess_pools;
+  {
+    absl::MutexLock lock(&mutex_);
+    for (size_t i = 0; i < descriptor_pools.size(); ++i) {
+      const auto& descriptor_pool = descriptor_pools[i];
+      if (!reset_ok[i]) {
+        excess_pools.push_back(descriptor_pool.handle);
+        continue;
+      }
+      auto& unused_pools = unused_pools_[{
+          descriptor_pool.descriptor_type,
+          descriptor_pool.max_descriptor_count}];
+      if (unused_pools.size() < static_cast<size_t>(kMaxUnusedPoolsPerBucket)) {
+        unused_pools.push_back(descriptor_pool.handle);
+      } else {
+        excess_pools.push_back(descriptor_pool.handle);
+      }
+    }
+  }
+  for (auto handle : excess_pools) {
+    syms().vkDestroyDescriptorPool(*logical_device_, handle,
                                    logical_device_->allocator());
   }
 
-  return OkStatus();
+  return status;
+}
+
+void DescriptorPoolCache::Trim() {
+  IREE_TRACE_SCOPE0("DescriptorPoolCache::Trim");
+
+  absl::flat_hash_map<BucketKey, std::vector<VkDescriptorPool>> unused_pools;
+  {
+    absl::MutexLock lock(&mutex_);
+    std::swap(unused_pools, unused_pools_);
+  }
+  for (const auto& it : unused_pools) {
+    for (auto handle : it.second) {
+      syms().vkDestroyDescriptorPool(*logical_device_, handle,
+                                     logical_device_->allocator());
+    }
+  }
 }
 
 }  // namespace vulkan
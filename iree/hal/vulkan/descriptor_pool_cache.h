@@ -15,8 +15,15 @@
 #ifndef IREE_HAL_VULKAN_DESCRIPTOR_POOL_CACHE_H_
 #define IREE_HAL_VULKAN_DESCRIPTOR_POOL_CACHE_H_
 
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/inlined_vector.h"
+#include "absl/synchronization/mutex.h"
 #include "iree/base/ref_ptr.h"
+#include "iree/base/status.h"
 #include "iree/hal/vulkan/dynamic_symbols.h"
 #include "iree/hal/vulkan/handle_util.h"
 
@@ -72,9 +79,21 @@ class DescriptorSetGroup final {
 // resources. After the descriptors in the pool are no longer used (all
 // command buffers using descriptor sets allocated from the pool have retired)
 // the pool is returned here to be reused in the future.
+//
+// Unused pools are kept per descriptor type and max_descriptor_count so that
+// steady-state recording does not create or destroy any pools. At most
+// kMaxUnusedPoolsPerBucket unused pools are kept for each; Trim can be used to
+// release all of them (such as when the application is idle).
+//
+// Thread-safe.
 class DescriptorPoolCache final : public RefObject<DescriptorPoolCache> {
  public:
+  // Maximum number of unused pools of each type and size kept for reuse.
+  // This should cover the number of command buffers in-flight at a time.
+  static constexpr int kMaxUnusedPoolsPerBucket = 16;
+
   explicit DescriptorPoolCache(ref_ptr<VkDeviceHandle> logical_device);
+  ~DescriptorPoolCache();
 
   const ref_ptr<VkDeviceHandle>& logical_device() const {
     return logical_device_;
@@ -92,8 +111,18 @@ class DescriptorPoolCache final : public RefObject<DescriptorPoolCache> {
   // immediately and must no longer be in use by any in-flight command.
   Status ReleaseDescriptorPools(absl::Span<DescriptorPool> descriptor_pools);
 
+  // Destroys all unused descriptor pools.
+  void Trim();
+
  private:
+  using BucketKey = std::pair<VkDescriptorType, int>;
+
   ref_ptr<VkDeviceHandle> logical_device_;
+
+  absl::Mutex mutex_;
+  // Reset pools available for reuse keyed by descriptor type and count.
+  absl::flat_hash_map<BucketKey, std::vector<VkDescriptorPool>> unused_pools_
+      ABSL_GUARDED_BY(mutex_);
 };
 
 }  // namespace vulkan
@@ -0,0 +1,158 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/hal/vulkan/descriptor_pool_cache.h"
+
+#include <cstdint>
+#include <set>
+#include <vector>
+
+#include "iree/base/status_matchers.h"
+#include "iree/testing/gtest.h"
+
+namespace iree {
+namespace hal {
+namespace vulkan {
+namespace {
+
+using ::iree::testing::status::StatusIs;
+
+constexpr VkDescriptorType kDescriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+
+// Tracks the descriptor pools created through the stubbed symbols below.
+struct FakeDevice {
+  int create_count = 0;
+  int destroy_count = 0;
+  int reset_count = 0;
+  // Pools that fail to reset.
+  std::set<VkDescriptorPool> failing_pools;
+  std::set<VkDescriptorPool> live_pools;
+};
+FakeDevice* fake_device = nullptr;
+
+VKAPI_ATTR VkResult VKAPI_CALL
+FakeCreateDescriptorPool(VkDevice device,
+                         const VkDescriptorPoolCreateInfo* create_info,
+                         const VkAllocationCallbacks* allocator,
+                         VkDescriptorPool* out_descriptor_pool) {
+  *out_descriptor_pool = reinterpret_cast<VkDescriptorPool>(
+      static_cast<uintptr_t>(++fake_device->create_count));
+  fake_device->live_pools.insert(*out_descriptor_pool);
+  return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL
+FakeDestroyDescriptorPool(VkDevice device, VkDescriptorPool descriptor_pool,
+                          const VkAllocationCallbacks* allocator) {
+  ++fake_device->destroy_count;
+  EXPECT_EQ(1, fake_device->live_pools.erase(descriptor_pool));
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL FakeResetDescriptorPool(
+    VkDevice device, VkDescriptorPool descriptor_pool, uint32_t flags) {
+  ++fake_device->reset_count;
+  EXPECT_EQ(1, fake_device->live_pools.count(descriptor_pool));
+  return fake_device->failing_pools.count(descriptor_pool)
+             ? VK_ERROR_OUT_OF_HOST_MEMORY
+             : VK_SUCCESS;
+}
+
+class DescriptorPoolCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    fake_device = &fake_device_;
+    auto syms = make_ref<DynamicSymbols>();
+    syms->vkCreateDescriptorPool = FakeCreateDescriptorPool;
+    syms->vkDestroyDescriptorPool = FakeDestroyDescriptorPool;
+    syms->vkResetDescriptorPool = FakeResetDescriptorPool;
+    cache_ = make_ref<DescriptorPoolCache>(make_ref<VkDeviceHandle>(
+        syms, DeviceExtensions{}, /*owns_device=*/false));
+  }
+
+  void TearDown() override {
+    cache_.reset();
+    EXPECT_TRUE(fake_device_.live_pools.empty());
+    EXPECT_EQ(fake_device_.create_count, fake_device_.destroy_count);
+    fake_device = nullptr;
+  }
+
+  FakeDevice fake_device_;
+  ref_ptr<DescriptorPoolCache> cache_;
+};
+
+TEST_F(DescriptorPoolCacheTest, RecyclesPools) {
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_OK_AND_ASSIGN(auto pool_a,
+                         cache_->AcquireDescriptorPool(kDescriptorType, 8));
+    ASSERT_OK_AND_ASSIGN(auto pool_b,
+                         cache_->AcquireDescriptorPool(kDescriptorType, 16));
+    ASSERT_OK_AND_ASSIGN(auto pool_c,
+                         cache_->AcquireDescriptorPool(kDescriptorType, 8));
+    EXPECT_NE(pool_a.handle, pool_c.handle);
+    EXPECT_EQ(16, pool_b.max_descriptor_count);
+    DescriptorSetGroup group(add_ref(cache_), {pool_a, pool_b, pool_c});
+    ASSERT_OK(group.Reset());
+  }
+  EXPECT_EQ(3, fake_device_.create_count);
+  EXPECT_EQ(0, fake_device_.destroy_count);
+  EXPECT_EQ(300, fake_device_.reset_count);
+}
+
+TEST_F(DescriptorPoolCacheTest, DestroysExcessPools) {
+  constexpr int kPoolCount = DescriptorPoolCache::kMaxUnusedPoolsPerBucket + 4;
+  std::vector<DescriptorPool> pools;
+  for (int i = 0; i < kPoolCount; ++i) {
+    ASSERT_OK_AND_ASSIGN(auto pool,
+                         cache_->AcquireDescriptorPool(kDescriptorType, 8));
+    pools.push_back(pool);
+  }
+  ASSERT_OK(cache_->ReleaseDescriptorPools(absl::MakeSpan(pools)));
+  EXPECT_EQ(4, fake_device_.destroy_count);
+
+  cache_->Trim();
+  EXPECT_EQ(kPoolCount, fake_device_.destroy_count);
+}
+
+TEST_F(DescriptorPoolCacheTest, DestroysPoolsFailingReset) {
+  std::vector<DescriptorPool> pools;
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_OK_AND_ASSIGN(auto pool,
+                         cache_->AcquireDescriptorPool(kDescriptorType, 8));
+    pools.push_back(pool);
+  }
+  fake_device_.failing_pools.insert(pools[1].handle);
+
+  // All pools are released and only the one that failed is destroyed.
+  EXPECT_THAT(cache_->ReleaseDescriptorPools(absl::MakeSpan(pools)),
+              StatusIs(StatusCode::kResourceExhausted));
+  EXPECT_EQ(3, fake_device_.reset_count);
+  EXPECT_EQ(1, fake_device_.destroy_count);
+  EXPECT_EQ(0, fake_device_.live_pools.count(pools[1].handle));
+
+  // The others are reused.
+  std::vector<DescriptorPool> reacquired_pools;
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_OK_AND_ASSIGN(auto pool,
+                         cache_->AcquireDescriptorPool(kDescriptorType, 8));
+    EXPECT_NE(pools[1].handle, pool.handle);
+    reacquired_pools.push_back(pool);
+  }
+  EXPECT_EQ(3, fake_device_.create_count);
+  ASSERT_OK(cache_->ReleaseDescriptorPools(absl::MakeSpan(reacquired_pools)));
+}
+
+}  // namespace
+}  // namespace vulkan
+}  // namespace hal
+}  // namespace iree
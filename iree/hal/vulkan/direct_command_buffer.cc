@@ -345,6 +345,11 @@ Status DirectCommandBuffer::CopyBuffer(Buffer* source_buffer,
                                        device_size_t target_offset,
                                        device_size_t length) {
   IREE_TRACE_SCOPE0("DirectCommandBuffer::CopyBuffer");
+
+  // Zero-length copies are invalid in Vulkan but are valid in the HAL (such
+  // as copying an empty slice around a tensor update).
+  if (length == 0) return OkStatus();
+
   ASSIGN_OR_RETURN(auto* source_device_buffer, CastBuffer(source_buffer));
   ASSIGN_OR_RETURN(auto* target_device_buffer, CastBuffer(target_buffer));
 
@@ -0,0 +1,267 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/hal/vulkan/persistent_pipeline_cache.h"
+
+#include <atomic>
+#include <cstring>
+
+#include "absl/strings/str_cat.h"
+#include "iree/base/file_io.h"
+#include "iree/base/file_path.h"
+#include "iree/base/logging.h"
+#include "iree/base/source_location.h"
+#include "iree/base/target_platform.h"
+#include "iree/base/tracing.h"
+#include "iree/hal/vulkan/status_util.h"
+
+#if defined(IREE_PLATFORM_WINDOWS)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif  // IREE_PLATFORM_WINDOWS
+
+namespace iree {
+namespace hal {
+namespace vulkan {
+
+namespace {
+
+// Size of VkPipelineCacheHeaderVersionOne:
+//   uint32_t headerSize;
+//   uint32_t headerVersion;
+//   uint32_t vendorID;
+//   uint32_t deviceID;
+//   uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+constexpr size_t kHeaderVersionOneSize = 16 + VK_UUID_SIZE;
+
+// Header fields are always little-endian regardless of the host.
+uint32_t ReadHeaderField(const uint8_t* data) {
+  return static_cast<uint32_t>(data[0]) |
+         (static_cast<uint32_t>(data[1]) << 8) |
+         (static_cast<uint32_t>(data[2]) << 16) |
+         (static_cast<uint32_t>(data[3]) << 24);
+}
+
+// Returns a path next to |path| that no other process or cache in this
+// process will write to.
+std::string MakeTempPath(const std::string& path) {
+  static std::atomic<int> next_id{0};
+#if defined(IREE_PLATFORM_WINDOWS)
+  int pid = ::_getpid();
+#else
+  int pid = static_cast<int>(::getpid());
+#endif  // IREE_PLATFORM_WINDOWS
+  return absl::StrCat(path, ".", pid, ".", next_id++, ".tmp");
+}
+
+StatusOr<VkPipelineCache> CreatePipelineCache(
+    const ref_ptr<VkDeviceHandle>& logical_device,
+    absl::Span<const uint8_t> initial_data) {
+  VkPipelineCacheCreateInfo create_info;
+  create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  create_info.pNext = nullptr;
+  create_info.flags = 0;
+  create_info.initialDataSize = initial_data.size();
+  create_info.pInitialData = initial_data.data();
+  VkPipelineCache pipeline_cache = VK_NULL_HANDLE;
+  VK_RETURN_IF_ERROR(logical_device->syms()->vkCreatePipelineCache(
+      *logical_device, &create_info, logical_device->allocator(),
+      &pipeline_cache));
+  return pipeline_cache;
+}
+
+absl::Span<const uint8_t> AsBytes(const std::string& data) {
+  return absl::MakeConstSpan(reinterpret_cast<const uint8_t*>(data.data()),
+                             data.size());
+}
+
+}  // namespace
+
+Status ValidatePipelineCacheData(absl::Span<const uint8_t> data,
+                                 const VkPhysicalDeviceProperties& properties) {
+  if (data.size() < kHeaderVersionOneSize) {
+    return FailedPreconditionErrorBuilder(IREE_LOC)
+           << "Pipeline cache data of " << data.size()
+           << " bytes is too small to contain a header";
+  }
+  uint32_t header_size = ReadHeaderField(data.data() + 0);
+  uint32_t header_version = ReadHeaderField(data.data() + 4);
+  uint32_t vendor_id = ReadHeaderField(data.data() + 8);
+  uint32_t device_id = ReadHeaderField(data.data() + 12);
+  const uint8_t* uuid = data.data() + 16;
+  if (header_size < kHeaderVersionOneSize || header_size > data.size()) {
+    return FailedPreconditionErrorBuilder(IREE_LOC)
+           << "Pipeline cache header size " << header_size << " is invalid";
+  }
+  if (header_version != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) {
+    return FailedPreconditionErrorBuilder(IREE_LOC)
+           << "Unsupported pipeline cache header version " << header_version;
+  }
+  if (vendor_id != properties.vendorID || device_id != properties.deviceID) {
+    return FailedPreconditionErrorBuilder(IREE_LOC)
+           << "Pipeline cache is for device " << std::hex << vendor_id << ":"
+           << device_id << " but this device is " << properties.vendorID
+           << ":" << properties.deviceID;
+  }
+  if (std::memcmp(uuid, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+    return FailedPreconditionErrorBuilder(IREE_LOC)
+           << "Pipeline cache UUID does not match the driver";
+  }
+  return OkStatus();
+}
+
+std::string GetPipelineCacheFileName(
+    const VkPhysicalDeviceProperties& properties) {
+  std::string file_name = "vulkan_pipeline_cache_";
+  for (int i = 0; i < VK_UUID_SIZE; ++i) {
+    absl::StrAppend(&file_name, absl::Hex(properties.pipelineCacheUUID[i],
+                                          absl::kZeroPad2));
+  }
+  absl::StrAppend(&file_name, ".bin");
+  return file_name;
+}
+
+// static
+StatusOr<ref_ptr<PersistentPipelineCache>> PersistentPipelineCache::Create(
+    VkPhysicalDevice physical_device,
+    const ref_ptr<VkDeviceHandle>& logical_device,
+    const std::string& cache_dir) {
+  IREE_TRACE_SCOPE0("PersistentPipelineCache::Create");
+
+  VkPhysicalDeviceProperties properties;
+  logical_device->syms()->vkGetPhysicalDeviceProperties(physical_device,
+                                                        &properties);
+
+  // Load the data saved by a previous run, if any. Failing to load is not an
+  // error as we can always recompile the pipelines.
+  std::string path;
+  std::string saved_data;
+  if (!cache_dir.empty()) {
+    path =
+        file_path::JoinPaths(cache_dir, GetPipelineCacheFileName(properties));
+    auto saved_data_or = file_io::GetFileContents(path);
+    if (saved_data_or.ok()) {
+      saved_data = std::move(saved_data_or).ValueOrDie();
+      auto status = ValidatePipelineCacheData(AsBytes(saved_data), properties);
+      if (!status.ok()) {
+        LOG(WARNING) << "Ignoring pipeline cache " << path << ": " << status;
+        saved_data.clear();
+      }
+    } else if (!IsNotFound(saved_data_or.status())) {
+      LOG(WARNING) << "Unable to read pipeline cache " << path << ": "
+                   << saved_data_or.status();
+    }
+  }
+
+  auto pipeline_cache_or =
+      CreatePipelineCache(logical_device, AsBytes(saved_data));
+  if (!pipeline_cache_or.ok() && !saved_data.empty()) {
+    // Drivers may still reject data that passed validation (such as if it is
+    // corrupt); start over with an empty cache.
+    LOG(WARNING) << "Driver rejected pipeline cache " << path << ": "
+                 << pipeline_cache_or.status();
+    saved_data.clear();
+    pipeline_cache_or = CreatePipelineCache(logical_device, {});
+  }
+  ASSIGN_OR_RETURN(auto pipeline_cache, std::move(pipeline_cache_or));
+  if (!saved_data.empty()) {
+    DVLOG(1) << "Loaded " << saved_data.size() << "b pipeline cache from "
+             << path;
+  }
+
+  return assign_ref(new PersistentPipelineCache(
+      logical_device, properties, pipeline_cache, std::move(path),
+      std::move(saved_data)));
+}
+
+PersistentPipelineCache::PersistentPipelineCache(
+    const ref_ptr<VkDeviceHandle>& logical_device,
+    VkPhysicalDeviceProperties properties, VkPipelineCache pipeline_cache,
+    std::string path, std::string saved_data)
+    : logical_device_(add_ref(logical_device)),
+      properties_(properties),
+      pipeline_cache_(pipeline_cache),
+      path_(std::move(path)),
+      saved_data_(std::move(saved_data)) {}
+
+PersistentPipelineCache::~PersistentPipelineCache() {
+  IREE_TRACE_SCOPE0("PersistentPipelineCache::dtor");
+  auto status = Save();
+  if (!status.ok()) {
+    LOG(WARNING) << "Unable to save pipeline cache " << path_ << ": "
+                 << status;
+  }
+  syms()->vkDestroyPipelineCache(*logical_device_, pipeline_cache_,
+                                 logical_device_->allocator());
+}
+
+StatusOr<std::string> PersistentPipelineCache::Serialize() const {
+  IREE_TRACE_SCOPE0("PersistentPipelineCache::Serialize");
+  // Pipelines may be added from other threads between querying the size and
+  // reading the data, in which case we get VK_INCOMPLETE and try again.
+  std::string data;
+  VkResult result = VK_INCOMPLETE;
+  while (result == VK_INCOMPLETE) {
+    size_t data_size = 0;
+    VK_RETURN_IF_ERROR(syms()->vkGetPipelineCacheData(
+        *logical_device_, pipeline_cache_, &data_size, nullptr));
+    data.resize(data_size);
+    result = syms()->vkGetPipelineCacheData(*logical_device_, pipeline_cache_,
+                                            &data_size, &data[0]);
+    VK_RETURN_IF_ERROR(result);
+    data.resize(data_size);
+  }
+  return data;
+}
+
+Status PersistentPipelineCache::Merge(absl::Span<const uint8_t> data) {
+  IREE_TRACE_SCOPE0("PersistentPipelineCache::Merge");
+  RETURN_IF_ERROR(ValidatePipelineCacheData(data, properties_));
+  ASSIGN_OR_RETURN(auto source_cache,
+                   CreatePipelineCache(logical_device_, data));
+  VkResult result = syms()->vkMergePipelineCaches(
+      *logical_device_, pipeline_cache_, 1, &source_cache);
+  syms()->vkDestroyPipelineCache(*logical_device_, source_cache,
+                                 logical_device_->allocator());
+  return VkResultToStatus(result);
+}
+
+Status PersistentPipelineCache::Save() {
+  if (path_.empty()) return OkStatus();
+  IREE_TRACE_SCOPE0("PersistentPipelineCache::Save");
+  ASSIGN_OR_RETURN(auto data, Serialize());
+
+  absl::MutexLock lock(&mutex_);
+  if (data == saved_data_) return OkStatus();
+
+  // Write to a temporary file first so that a crash never leaves a partially
+  // written cache behind. The temporary file is unique so that processes
+  // sharing the cache directory never interleave their writes; the last one
+  // to move its file into place wins.
+  std::string temp_path = MakeTempPath(path_);
+  Status status = file_io::SetFileContents(temp_path, data);
+  if (status.ok()) status = file_io::MoveFile(temp_path, path_);
+  if (!status.ok()) {
+    file_io::DeleteFile(temp_path).IgnoreError();
+    return status;
+  }
+  DVLOG(1) << "Saved " << data.size() << "b pipeline cache to " << path_;
+  saved_data_ = std::move(data);
+  return OkStatus();
+}
+
+}  // namespace vulkan
+}  // namespace hal
+}  // namespace iree
@@ -0,0 +1,103 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef IREE_HAL_VULKAN_PERSISTENT_PIPELINE_CACHE_H_
+#define IREE_HAL_VULKAN_PERSISTENT_PIPELINE_CACHE_H_
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "iree/base/ref_ptr.h"
+#include "iree/base/status.h"
+#include "iree/hal/vulkan/handle_util.h"
+
+namespace iree {
+namespace hal {
+namespace vulkan {
+
+// Returns OK if |data| starts with a VkPipelineCacheHeaderVersionOne header
+// that was produced by the driver and device described by |properties|.
+// Drivers are required to ignore incompatible data but not all do so safely,
+// so we check before handing any data to the driver.
+Status ValidatePipelineCacheData(absl::Span<const uint8_t> data,
+                                 const VkPhysicalDeviceProperties& properties);
+
+// Returns the file name used to persist the pipeline cache of a device.
+// Includes the pipelineCacheUUID so that different devices and driver versions
+// sharing a cache directory do not overwrite each other's data.
+std::string GetPipelineCacheFileName(
+    const VkPhysicalDeviceProperties& properties);
+
+// A device-wide VkPipelineCache that can be seeded from and saved to serialized
+// cache data so that pipelines compiled in previous runs need not be compiled
+// again. All PipelineCache executable caches created by a device share it.
+//
+// Thread-safe: the VkPipelineCache is internally synchronized by the driver.
+class PersistentPipelineCache final
+    : public RefObject<PersistentPipelineCache> {
+ public:
+  // Creates a pipeline cache for |logical_device|.
+  // If |cache_dir| is not empty then the cache is loaded from a file in that
+  // directory (if present and compatible) and saved back to it on Save and
+  // destruction.
+  static StatusOr<ref_ptr<PersistentPipelineCache>> Create(
+      VkPhysicalDevice physical_device,
+      const ref_ptr<VkDeviceHandle>& logical_device,
+      const std::string& cache_dir);
+
+  ~PersistentPipelineCache();
+
+  VkPipelineCache handle() const { return pipeline_cache_; }
+
+  // Returns the current contents of the cache in the driver's serialized form.
+  StatusOr<std::string> Serialize() const;
+
+  // Merges previously serialized cache |data| into the cache.
+  // Data from other devices or driver versions is rejected with
+  // FailedPreconditionError.
+  Status Merge(absl::Span<const uint8_t> data);
+
+  // Saves the cache to its file, if it has one and the contents have changed
+  // since they were last loaded or saved.
+  Status Save();
+
+ private:
+  PersistentPipelineCache(const ref_ptr<VkDeviceHandle>& logical_device,
+                          VkPhysicalDeviceProperties properties,
+                          VkPipelineCache pipeline_cache, std::string path,
+                          std::string saved_data);
+
+  const ref_ptr<DynamicSymbols>& syms() const {
+    return logical_device_->syms();
+  }
+
+  ref_ptr<VkDeviceHandle> logical_device_;
+  VkPhysicalDeviceProperties properties_;
+  VkPipelineCache pipeline_cache_ = VK_NULL_HANDLE;
+  std::string path_;
+
+  absl::Mutex mutex_;
+  // Contents of the file at |path_| as last loaded or saved.
+  std::string saved_data_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace vulkan
+}  // namespace hal
+}  // namespace iree
+
+#endif  // IREE_HAL_VULKAN_PERSISTENT_PIPELINE_CACHE_H_
@@ -0,0 +1,118 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/hal/vulkan/persistent_pipeline_cache.h"
+
+#include <cstring>
+#include <vector>
+
+#include "iree/base/status_matchers.h"
+#include "iree/testing/gtest.h"
+
+namespace iree {
+namespace hal {
+namespace vulkan {
+namespace {
+
+using ::iree::testing::status::StatusIs;
+
+VkPhysicalDeviceProperties GetProperties() {
+  VkPhysicalDeviceProperties properties;
+  std::memset(&properties, 0, sizeof(properties));
+  properties.vendorID = 0x1AE0;
+  properties.deviceID = 0xC0DE;
+  for (int i = 0; i < VK_UUID_SIZE; ++i) {
+    properties.pipelineCacheUUID[i] = static_cast<uint8_t>(i * 17);
+  }
+  return properties;
+}
+
+void AppendField(std::vector<uint8_t>* data, uint32_t value) {
+  for (int i = 0; i < 4; ++i) data->push_back((value >> (i * 8)) & 0xFF);
+}
+
+// Returns cache data as a driver for |properties| would produce it.
+std::vector<uint8_t> MakeCacheData(const VkPhysicalDeviceProperties& properties,
+                                   size_t payload_size = 64) {
+  std::vector<uint8_t> data;
+  AppendField(&data, 16 + VK_UUID_SIZE);
+  AppendField(&data, VK_PIPELINE_CACHE_HEADER_VERSION_ONE);
+  AppendField(&data, properties.vendorID);
+  AppendField(&data, properties.deviceID);
+  data.insert(data.end(), properties.pipelineCacheUUID,
+              properties.pipelineCacheUUID + VK_UUID_SIZE);
+  data.resize(data.size() + payload_size, 0xCD);
+  return data;
+}
+
+TEST(PersistentPipelineCacheTest, ValidData) {
+  auto properties = GetProperties();
+  EXPECT_OK(ValidatePipelineCacheData(MakeCacheData(properties), properties));
+  EXPECT_OK(ValidatePipelineCacheData(MakeCacheData(properties, 0),
+                                      properties));
+}
+
+TEST(PersistentPipelineCacheTest, TruncatedData) {
+  auto properties = GetProperties();
+  auto data = MakeCacheData(properties, 0);
+  data.pop_back();
+  EXPECT_THAT(ValidatePipelineCacheData(data, properties),
+              StatusIs(StatusCode::kFailedPrecondition));
+  EXPECT_THAT(ValidatePipelineCacheData({}, properties),
+              StatusIs(StatusCode::kFailedPrecondition));
+}
+
+TEST(PersistentPipelineCacheTest, BadHeader) {
+  auto properties = GetProperties();
+  auto bad_size = MakeCacheData(properties);
+  bad_size[0] = 8;
+  EXPECT_THAT(ValidatePipelineCacheData(bad_size, properties),
+              StatusIs(StatusCode::kFailedPrecondition));
+  auto bad_version = MakeCacheData(properties);
+  bad_version[4] = 2;
+  EXPECT_THAT(ValidatePipelineCacheData(bad_version, properties),
+              StatusIs(StatusCode::kFailedPrecondition));
+}
+
+TEST(PersistentPipelineCacheTest, MismatchedDevice) {
+  auto properties = GetProperties();
+  auto data = MakeCacheData(properties);
+
+  auto other_device = properties;
+  other_device.deviceID += 1;
+  EXPECT_THAT(ValidatePipelineCacheData(data, other_device),
+              StatusIs(StatusCode::kFailedPrecondition));
+
+  // Same device after a driver update.
+  auto other_driver = properties;
+  other_driver.pipelineCacheUUID[VK_UUID_SIZE - 1] ^= 1;
+  EXPECT_THAT(ValidatePipelineCacheData(data, other_driver),
+              StatusIs(StatusCode::kFailedPrecondition));
+}
+
+TEST(PersistentPipelineCacheTest, FileNameIncludesUUID) {
+  auto properties = GetProperties();
+  EXPECT_EQ(
+      "vulkan_pipeline_cache_00112233445566778899aabbccddeeff.bin",
+      GetPipelineCacheFileName(properties));
+  auto other_driver = properties;
+  other_driver.pipelineCacheUUID[0] = 0xFF;
+  EXPECT_NE(GetPipelineCacheFileName(properties),
+            GetPipelineCacheFileName(other_driver));
+}
+
+}  // namespace
+}  // namespace vulkan
+}  // namespace hal
+}  // namespace iree
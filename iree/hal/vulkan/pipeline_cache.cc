@@ -27,8 +27,11 @@ namespace iree {
 namespace hal {
 namespace vulkan {
 
-PipelineCache::PipelineCache(const ref_ptr<VkDeviceHandle>& logical_device)
-    : logical_device_(add_ref(logical_device)) {}
+PipelineCache::PipelineCache(
+    const ref_ptr<VkDeviceHandle>& logical_device,
+    ref_ptr<PersistentPipelineCache> persistent_cache)
+    : logical_device_(add_ref(logical_device)),
+      persistent_cache_(std::move(persistent_cache)) {}
 
 PipelineCache::~PipelineCache() {
   IREE_TRACE_SCOPE0("PipelineCache::dtor");
@@ -68,7 +71,7 @@ StatusOr<ref_ptr<Executable>> PipelineCache::PrepareExecutable(
   // Create the executable (which may itself own many pipelines).
   ASSIGN_OR_RETURN(auto executable, PipelineExecutable::Create(
                                         logical_device_,
-                                        /*pipeline_cache=*/VK_NULL_HANDLE,
+                                        persistent_cache_->handle(),
                                         pipeline_layout_entry->pipeline_layout,
                                         pipeline_layout_entry->descriptor_sets,
                                         mode, spirv_executable_def));
@@ -23,6 +23,7 @@
 #include "iree/hal/executable.h"
 #include "iree/hal/executable_cache.h"
 #include "iree/hal/vulkan/handle_util.h"
+#include "iree/hal/vulkan/persistent_pipeline_cache.h"
 #include "iree/hal/vulkan/pipeline_executable.h"
 #include "iree/schemas/spirv_executable_def_generated.h"
 
@@ -32,7 +33,10 @@ namespace vulkan {
 
 class PipelineCache final : public ExecutableCache {
  public:
-  explicit PipelineCache(const ref_ptr<VkDeviceHandle>& logical_device);
+  // All pipelines are created with the device-wide |persistent_cache| so that
+  // compilation results are shared across executable caches and runs.
+  PipelineCache(const ref_ptr<VkDeviceHandle>& logical_device,
+                ref_ptr<PersistentPipelineCache> persistent_cache);
   ~PipelineCache() override;
 
   const ref_ptr<DynamicSymbols>& syms() const {
@@ -65,6 +69,7 @@ class PipelineCache final : public ExecutableCache {
   void ClearLayoutCaches() ABSL_LOCKS_EXCLUDED(mutex_);
 
   ref_ptr<VkDeviceHandle> logical_device_;
+  ref_ptr<PersistentPipelineCache> persistent_cache_;
 
   // A "cache" of descriptor set and pipeline layouts for various values.
   // We never evict and just do a simple linear scan on lookup. This is fine for
@@ -203,7 +203,8 @@ StatusOr<ref_ptr<VulkanDevice>> VulkanDevice::Create(
     ref_ptr<Driver> driver, const DeviceInfo& device_info,
     VkPhysicalDevice physical_device,
     const ExtensibilitySpec& extensibility_spec,
-    const ref_ptr<DynamicSymbols>& syms) {
+    const ref_ptr<DynamicSymbols>& syms,
+    const std::string& pipeline_cache_dir) {
   IREE_TRACE_SCOPE0("VulkanDevice::Create");
 
   // Find the layers and extensions we need (or want) that are also available
@@ -338,11 +339,16 @@ StatusOr<ref_ptr<VulkanDevice>> VulkanDevice::Create(
   ASSIGN_OR_RETURN(auto legacy_fence_pool,
                    LegacyFencePool::Create(add_ref(logical_device)));
 
+  ASSIGN_OR_RETURN(auto pipeline_cache,
+                   PersistentPipelineCache::Create(
+                       physical_device, logical_device, pipeline_cache_dir));
+
   return assign_ref(new VulkanDevice(
       std::move(driver), device_info, physical_device,
       std::move(logical_device), std::move(allocator),
       std::move(command_queues), std::move(dispatch_command_pool),
-      std::move(transfer_command_pool), std::move(legacy_fence_pool)));
+      std::move(transfer_command_pool), std::move(legacy_fence_pool),
+      std::move(pipeline_cache)));
 }
 
 // static
@@ -351,7 +357,8 @@ StatusOr<ref_ptr<VulkanDevice>> VulkanDevice::Wrap(
     VkPhysicalDevice physical_device, VkDevice logical_device,
     const ExtensibilitySpec& extensibility_spec,
     const QueueSet& compute_queue_set, const QueueSet& transfer_queue_set,
-    const ref_ptr<DynamicSymbols>& syms) {
+    const ref_ptr<DynamicSymbols>& syms,
+    const std::string& pipeline_cache_dir) {
   IREE_TRACE_SCOPE0("VulkanDevice::Wrap");
 
   uint64_t compute_queue_count = CountOnes64(compute_queue_set.queue_indices);
@@ -409,11 +416,15 @@ StatusOr<ref_ptr<VulkanDevice>> VulkanDevice::Wrap(
   ASSIGN_OR_RETURN(auto legacy_fence_pool,
                    LegacyFencePool::Create(add_ref(device_handle)));
 
+  ASSIGN_OR_RETURN(auto pipeline_cache,
+                   PersistentPipelineCache::Create(
+                       physical_device, device_handle, pipeline_cache_dir));
+
   return assign_ref(new VulkanDevice(
       std::move(driver), device_info, physical_device, std::move(device_handle),
       std::move(allocator), std::move(command_queues),
       std::move(dispatch_command_pool), std::move(transfer_command_pool),
-      std::move(legacy_fence_pool)));
+      std::move(legacy_fence_pool), std::move(pipeline_cache)));
 }
 
 VulkanDevice::VulkanDevice(
@@ -423,7 +434,8 @@ VulkanDevice::VulkanDevice(
     absl::InlinedVector<std::unique_ptr<CommandQueue>, 4> command_queues,
     ref_ptr<VkCommandPoolHandle> dispatch_command_pool,
     ref_ptr<VkCommandPoolHandle> transfer_command_pool,
-    ref_ptr<LegacyFencePool> legacy_fence_pool)
+    ref_ptr<LegacyFencePool> legacy_fence_pool,
+    ref_ptr<PersistentPipelineCache> pipeline_cache)
     : Device(device_info),
       driver_(std::move(driver)),
       physical_device_(physical_device),
@@ -432,6 +444,7 @@ VulkanDevice::VulkanDevice(
       command_queues_(std::move(command_queues)),
       descriptor_pool_cache_(
           make_ref<DescriptorPoolCache>(add_ref(logical_device_))),
+      pipeline_cache_(std::move(pipeline_cache)),
       dispatch_command_pool_(std::move(dispatch_command_pool)),
       transfer_command_pool_(std::move(transfer_command_pool)),
       legacy_fence_pool_(std::move(legacy_fence_pool)) {
@@ -464,13 +477,18 @@ VulkanDevice::~VulkanDevice() {
   // Now that no commands are outstanding we can release all descriptor sets.
   descriptor_pool_cache_.reset();
 
+  // Release the pipeline cache, saving it if it is persistent. Executable
+  // caches may still reference it in which case it is saved when they are
+  // released.
+  pipeline_cache_.reset();
+
   // Finally, destroy the device.
   logical_device_.reset();
 }
 
 ref_ptr<ExecutableCache> VulkanDevice::CreateExecutableCache() {
   IREE_TRACE_SCOPE0("VulkanDevice::CreateExecutableCache");
-  return make_ref<PipelineCache>(logical_device_);
+  return make_ref<PipelineCache>(logical_device_, add_ref(pipeline_cache_));
 }
 
 StatusOr<ref_ptr<CommandBuffer>> VulkanDevice::CreateCommandBuffer(
@@ -19,6 +19,7 @@
 
 #include <functional>
 #include <memory>
+#include <string>
 
 #include "absl/container/inlined_vector.h"
 #include "absl/types/span.h"
@@ -31,6 +32,7 @@
 #include "iree/hal/vulkan/extensibility_util.h"
 #include "iree/hal/vulkan/handle_util.h"
 #include "iree/hal/vulkan/legacy_fence.h"
+#include "iree/hal/vulkan/persistent_pipeline_cache.h"
 
 namespace iree {
 namespace hal {
@@ -49,11 +51,15 @@ struct QueueSet {
 class VulkanDevice final : public Device {
  public:
   // Creates a device that manages its own VkDevice.
+  //
+  // If |pipeline_cache_dir| is not empty compiled pipelines are loaded from and
+  // saved to a file in that directory. See PersistentPipelineCache.
   static StatusOr<ref_ptr<VulkanDevice>> Create(
       ref_ptr<Driver> driver, const DeviceInfo& device_info,
       VkPhysicalDevice physical_device,
       const ExtensibilitySpec& extensibility_spec,
-      const ref_ptr<DynamicSymbols>& syms);
+      const ref_ptr<DynamicSymbols>& syms,
+      const std::string& pipeline_cache_dir = "");
 
   // Creates a device that wraps an externally managed VkDevice.
   static StatusOr<ref_ptr<VulkanDevice>> Wrap(
@@ -61,7 +67,8 @@ class VulkanDevice final : public Device {
       VkPhysicalDevice physical_device, VkDevice logical_device,
       const ExtensibilitySpec& extensibility_spec,
       const QueueSet& compute_queue_set, const QueueSet& transfer_queue_set,
-      const ref_ptr<DynamicSymbols>& syms);
+      const ref_ptr<DynamicSymbols>& syms,
+      const std::string& pipeline_cache_dir = "");
 
   ~VulkanDevice() override;
 
@@ -71,6 +78,13 @@ class VulkanDevice final : public Device {
 
   Allocator* allocator() const override { return allocator_.get(); }
 
+  // Device-wide pipeline cache used by all executable caches.
+  // Hosting applications can use this to save and restore compiled pipelines
+  // in their own storage.
+  PersistentPipelineCache* pipeline_cache() const {
+    return pipeline_cache_.get();
+  }
+
   absl::Span<CommandQueue*> dispatch_queues() const override {
     return absl::MakeSpan(dispatch_queues_);
   }
@@ -108,7 +122,8 @@ class VulkanDevice final : public Device {
       absl::InlinedVector<std::unique_ptr<CommandQueue>, 4> command_queues,
       ref_ptr<VkCommandPoolHandle> dispatch_command_pool,
       ref_ptr<VkCommandPoolHandle> transfer_command_pool,
-      ref_ptr<LegacyFencePool> legacy_fence_pool);
+      ref_ptr<LegacyFencePool> legacy_fence_pool,
+      ref_ptr<PersistentPipelineCache> pipeline_cache);
 
   ref_ptr<Driver> driver_;
   VkPhysicalDevice physical_device_;
@@ -121,6 +136,7 @@ class VulkanDevice final : public Device {
   mutable absl::InlinedVector<CommandQueue*, 4> transfer_queues_;
 
   ref_ptr<DescriptorPoolCache> descriptor_pool_cache_;
+  ref_ptr<PersistentPipelineCache> pipeline_cache_;
 
   ref_ptr<VkCommandPoolHandle> dispatch_command_pool_;
   ref_ptr<VkCommandPoolHandle> transfer_command_pool_;
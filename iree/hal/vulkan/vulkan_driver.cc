@@ -149,10 +149,10 @@ StatusOr<ref_ptr<VulkanDriver>> VulkanDriver::Create(
                          instance, syms, /*allocation_callbacks=*/nullptr));
   }
 
-  return assign_ref(new VulkanDriver(std::move(syms), instance,
-                                     /*owns_instance=*/true,
-                                     std::move(debug_reporter),
-                                     std::move(options.device_extensibility)));
+  return assign_ref(new VulkanDriver(
+      std::move(syms), instance, /*owns_instance=*/true,
+      std::move(debug_reporter), std::move(options.device_extensibility),
+      std::move(options.pipeline_cache_dir)));
 }
 
 // static
@@ -193,19 +193,22 @@ StatusOr<ref_ptr<VulkanDriver>> VulkanDriver::CreateUsingInstance(
 
   return assign_ref(new VulkanDriver(
       std::move(syms), instance, /*owns_instance=*/false,
-      std::move(debug_reporter), std::move(options.device_extensibility)));
+      std::move(debug_reporter), std::move(options.device_extensibility),
+      std::move(options.pipeline_cache_dir)));
 }
 
 VulkanDriver::VulkanDriver(ref_ptr<DynamicSymbols> syms, VkInstance instance,
                            bool owns_instance,
                            std::unique_ptr<DebugReporter> debug_reporter,
-                           ExtensibilitySpec device_extensibility_spec)
+                           ExtensibilitySpec device_extensibility_spec,
+                           std::string pipeline_cache_dir)
     : Driver("vulkan"),
       syms_(std::move(syms)),
       instance_(instance),
       owns_instance_(owns_instance),
       debug_reporter_(std::move(debug_reporter)),
-      device_extensibility_spec_(std::move(device_extensibility_spec)) {}
+      device_extensibility_spec_(std::move(device_extensibility_spec)),
+      pipeline_cache_dir_(std::move(pipeline_cache_dir)) {}
 
 VulkanDriver::~VulkanDriver() {
   IREE_TRACE_SCOPE0("VulkanDriver::dtor");
@@ -262,9 +265,11 @@ StatusOr<ref_ptr<Device>> VulkanDriver::CreateDevice(DriverDeviceID device_id) {
   // Attempt to create the device.
   // This may fail if the device was enumerated but is in exclusive use,
   // disabled by the system, or permission is denied.
-  ASSIGN_OR_RETURN(auto device, VulkanDevice::Create(
-                                    add_ref(this), device_info, physical_device,
-                                    device_extensibility_spec_, syms()));
+  ASSIGN_OR_RETURN(auto device,
+                   VulkanDevice::Create(add_ref(this), device_info,
+                                        physical_device,
+                                        device_extensibility_spec_, syms(),
+                                        pipeline_cache_dir_));
 
   return device;
 }
@@ -283,7 +288,8 @@ StatusOr<ref_ptr<Device>> VulkanDriver::WrapDevice(
       auto device,
       VulkanDevice::Wrap(add_ref(this), device_info, physical_device,
                          logical_device, device_extensibility_spec_,
-                         compute_queue_set, transfer_queue_set, syms()));
+                         compute_queue_set, transfer_queue_set, syms(),
+                         pipeline_cache_dir_));
   return device;
 }
 
@@ -18,6 +18,7 @@
 #include <vulkan/vulkan.h>
 
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "iree/hal/driver.h"
@@ -41,6 +42,10 @@ class VulkanDriver final : public Driver {
     // Device descriptions will be used for all devices created by the driver.
     ExtensibilitySpec instance_extensibility;
     ExtensibilitySpec device_extensibility;
+
+    // Directory used to persist compiled pipelines across runs.
+    // Each device uses its own file in the directory. Disabled if empty.
+    std::string pipeline_cache_dir;
   };
 
   // Creates a VulkanDriver that manages its own VkInstance.
@@ -82,13 +87,15 @@ class VulkanDriver final : public Driver {
   VulkanDriver(ref_ptr<DynamicSymbols> syms, VkInstance instance,
                bool owns_instance,
                std::unique_ptr<DebugReporter> debug_reporter,
-               ExtensibilitySpec device_extensibility_spec);
+               ExtensibilitySpec device_extensibility_spec,
+               std::string pipeline_cache_dir);
 
   ref_ptr<DynamicSymbols> syms_;
   VkInstance instance_;
   bool owns_instance_;
   std::unique_ptr<DebugReporter> debug_reporter_;
   ExtensibilitySpec device_extensibility_spec_;
+  std::string pipeline_cache_dir_;
 };
 
 }  // namespace vulkan
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <memory>
+#include <string>
 
 #include "absl/flags/flag.h"
 #include "iree/base/init.h"
@@ -30,6 +31,8 @@ ABSL_FLAG(bool, vulkan_debug_report, false,
           "Enables VK_EXT_debug_report and logs errors.");
 ABSL_FLAG(bool, vulkan_push_descriptors, true,
           "Enables use of vkCmdPushDescriptorSetKHR, if available.");
+ABSL_FLAG(std::string, vulkan_pipeline_cache_dir, "",
+          "Directory used to persist compiled pipelines across runs.");
 
 namespace iree {
 namespace hal {
@@ -84,6 +87,8 @@ StatusOr<ref_ptr<Driver>> CreateVulkanDriver() {
         VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
   }
 
+  options.pipeline_cache_dir = absl::GetFlag(FLAGS_vulkan_pipeline_cache_dir);
+
   // Create the driver and VkInstance.
   ASSIGN_OR_RETURN(auto driver, VulkanDriver::Create(options, std::move(syms)));
 
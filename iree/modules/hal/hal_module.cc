@@ -14,16 +14,26 @@
 
 #include "iree/modules/hal/hal_module.h"
 
+#include <cstring>
+#include <deque>
+#include <tuple>
+
 #include "absl/base/macros.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_join.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "iree/base/api.h"
 #include "iree/base/api_util.h"
+#include "iree/base/logging.h"
 #include "iree/base/tracing.h"
 #include "iree/hal/api.h"
 #include "iree/hal/command_queue.h"
 #include "iree/hal/device.h"
+#include "iree/hal/fence.h"
+#include "iree/hal/persistent_executable_cache.h"
 #include "iree/vm/module_abi_cc.h"
 
 namespace iree {
@@ -33,7 +43,7 @@ namespace {
 // TODO(benvanik): remove when we have proper ABI wrapping.
 static void ResetStackFrame(iree_vm_stack_frame_t* frame) {
   frame->return_registers = nullptr;
-  for (int i = 0; i < frame->registers.ref_register_count; ++i) {
+  for (int i = 0; i <= frame->registers.ref_mask; ++i) {
     iree_vm_ref_release(&frame->registers.ref[i]);
   }
 }
@@ -112,10 +122,15 @@ class HALModuleState final {
         executable_cache_(std::move(executable_cache)) {}
 
   ~HALModuleState() {
-    for (auto& ref : deferred_releases_) {
-      iree_vm_ref_release(&ref);
+    // Resources used by in-flight submissions must outlive their execution.
+    auto status = RetireSubmissions(/*wait_all=*/true);
+    if (!status.ok()) {
+      LOG(ERROR) << "Failed to wait for in-flight submissions: " << status;
+    }
+    for (auto& submission : in_flight_submissions_) {
+      ReleaseRefs(&submission.deferred_releases);
     }
-    deferred_releases_.clear();
+    ReleaseRefs(&deferred_releases_);
   }
 
   // NOTE: Ex* APIs are experimental and likely to be removed soon. Modules
@@ -134,6 +149,9 @@ class HALModuleState final {
   ExExecutableDescriptorSetLayout(vm::ref<iree_hal_executable_t>& executable,
                                   int32_t set);
   Status ExDeferRelease(vm::opaque_ref& operand);
+  Status ExSubmit(vm::ref<iree_hal_device_t>& device,
+                  vm::ref<iree_hal_command_buffer_t>& command_buffer);
+  Status ExWaitIdle(vm::ref<iree_hal_device_t>& device);
   Status ExSubmitAndWait(vm::ref<iree_hal_device_t>& device,
                          vm::ref<iree_hal_command_buffer_t>& command_buffer);
 
@@ -240,6 +258,53 @@ class HALModuleState final {
       vm::ref<iree_hal_device_t>& device);
 
  private:
+  // Maximum number of submissions that may be in-flight at a time. Submitting
+  // more will block until the oldest completes so that a module submitting in
+  // a loop cannot queue unbounded work (and retain unbounded resources).
+  static constexpr int kMaxInFlightSubmissions = 8;
+
+  // Fence timeline used to track submissions to a particular device.
+  struct SubmissionTimeline {
+    ref_ptr<Device> device;
+    ref_ptr<Fence> fence;
+    uint64_t last_value = 0;
+  };
+
+  // A submitted command buffer that may still be executing on the device.
+  // The command buffer and all resources deferred prior to the submission
+  // remain live until the fence reaches |fence_value|.
+  struct InFlightSubmission {
+    SubmissionTimeline* timeline;
+    uint64_t fence_value;
+    vm::ref<iree_hal_command_buffer_t> command_buffer;
+    std::vector<iree_vm_ref_t> deferred_releases;
+  };
+
+  static void ReleaseRefs(std::vector<iree_vm_ref_t>* refs) {
+    for (auto& ref : *refs) {
+      iree_vm_ref_release(&ref);
+    }
+    refs->clear();
+  }
+
+  // Returns the timeline for |device|, creating it if needed.
+  StatusOr<SubmissionTimeline*> GetSubmissionTimeline(Device* device);
+
+  // Submits |command_buffer| to the dispatch queue of |device| without waiting
+  // for it to complete and returns its in-flight record.
+  //
+  // Submissions are not chained with semaphores. Queue order does not make the
+  // writes of one submission visible to the next (such as on Vulkan), so
+  // command buffers must end with a barrier covering any writes that later
+  // submissions depend on. The stream lowering records one at the end of each
+  // stream.
+  StatusOr<InFlightSubmission*> SubmitCommandBuffer(
+      Device* device, vm::ref<iree_hal_command_buffer_t>& command_buffer);
+
+  // Releases the resources of all in-flight submissions that have completed.
+  // If |wait_all| is true blocks until all in-flight submissions complete.
+  Status RetireSubmissions(bool wait_all);
+
   iree_device_size_t CalculateBufferSize(absl::Span<const int32_t> shape,
                                          uint8_t element_size) {
     iree_device_size_t allocation_size = element_size;
@@ -264,12 +329,51 @@ class HALModuleState final {
     return offset;
   }
 
+  // Key of a constant buffer created from rodata: the allocator, the rodata
+  // contents, and the memory types and usage the buffer was requested with.
+  using ConstantBufferKey =
+      std::tuple<iree_hal_allocator_t*, const uint8_t*, iree_host_size_t,
+                 iree_device_size_t, iree_hal_memory_type_t,
+                 iree_hal_buffer_usage_t>;
+  struct ConstantBuffer {
+    // Retained so that the rodata contents (and the module owning them) stay
+    // alive and the address cannot be reused while the entry exists.
+    vm::ref<iree_vm_ro_byte_buffer_t> rodata;
+    vm::ref<iree_hal_buffer_t> buffer;
+  };
+
+  // Returns true if retaining |rodata| keeps its contents alive. Rodata from
+  // bytecode modules does so by retaining the module; other byte buffers may
+  // point at memory that is not owned by the buffer.
+  static bool OwnsContents(const iree_vm_ro_byte_buffer_t* rodata) {
+    return rodata->destroy != nullptr;
+  }
+
+  // Creates a buffer with the contents of |rodata|. Host-visible allocators
+  // wrap rodata that owns its contents directly and otherwise a copy is
+  // allocated and uploaded.
+  StatusOr<vm::ref<iree_hal_buffer_t>> CreateConstantBuffer(
+      iree_hal_allocator_t* allocator, iree_hal_memory_type_t memory_types,
+      iree_hal_buffer_usage_t buffer_usage,
+      iree_device_size_t allocation_size,
+      vm::ref<iree_vm_ro_byte_buffer_t>& rodata);
+
   iree_allocator_t allocator_;
   ref_ptr<Device> shared_device_;
   ref_ptr<ExecutableCache> executable_cache_;
 
+  // Constant buffers created by AllocatorAllocateConst so that each rodata
+  // segment is uploaded (or wrapped) once per state instead of on every use.
+  absl::flat_hash_map<ConstantBufferKey, ConstantBuffer> constant_buffers_;
+
+  // Resources to release once the next submission has completed.
   std::vector<iree_vm_ref_t> deferred_releases_;
 
+  absl::InlinedVector<std::unique_ptr<SubmissionTimeline>, 1>
+      submission_timelines_;
+  // In submission order.
+  std::deque<InFlightSubmission> in_flight_submissions_;
+
   std::vector<BufferBinding> bindings_;
 };
 
@@ -348,32 +452,134 @@ Status HALModuleState::ExDeferRelease(vm::opaque_ref& operand) {
   return OkStatus();
 }
 
-Status HALModuleState::ExSubmitAndWait(
-    vm::ref<iree_hal_device_t>& device,
-    vm::ref<iree_hal_command_buffer_t>& command_buffer) {
-  IREE_TRACE_SCOPE0("HALModuleState::ExSubmitAndWait");
-  IREE_RETURN_IF_NULL(device);
-  IREE_RETURN_IF_NULL(command_buffer);
+StatusOr<HALModuleState::SubmissionTimeline*>
+HALModuleState::GetSubmissionTimeline(Device* device) {
+  for (auto& timeline : submission_timelines_) {
+    if (timeline->device.get() == device) return timeline.get();
+  }
+  auto timeline = absl::make_unique<SubmissionTimeline>();
+  timeline->device = add_ref(device);
+  ASSIGN_OR_RETURN(timeline->fence, device->CreateFence(0u));
+  submission_timelines_.push_back(std::move(timeline));
+  return submission_timelines_.back().get();
+}
 
-  auto* device_ptr = reinterpret_cast<Device*>(device.get());
-  auto* queue = device_ptr->dispatch_queues().front();
-  ASSIGN_OR_RETURN(auto fence, device_ptr->CreateFence(0u));
+StatusOr<HALModuleState::InFlightSubmission*>
+HALModuleState::SubmitCommandBuffer(
+    Device* device, vm::ref<iree_hal_command_buffer_t>& command_buffer) {
+  IREE_TRACE_SCOPE0("HALModuleState::SubmitCommandBuffer");
+
+  // Apply backpressure by waiting for the oldest submission.
+  if (in_flight_submissions_.size() >= kMaxInFlightSubmissions) {
+    auto& oldest = in_flight_submissions_.front();
+    FenceValue fence_value = {oldest.timeline->fence.get(),
+                              oldest.fence_value};
+    RETURN_IF_ERROR(oldest.timeline->device->WaitAllFences(
+        {&fence_value, 1}, absl::InfiniteFuture()));
+  }
+  RETURN_IF_ERROR(RetireSubmissions(/*wait_all=*/false));
+
+  ASSIGN_OR_RETURN(auto* timeline, GetSubmissionTimeline(device));
+  uint64_t fence_value = timeline->last_value + 1;
+  auto* queue = device->dispatch_queues().front();
   SubmissionBatch batch;
   CommandBuffer* command_buffers[1] = {
       reinterpret_cast<CommandBuffer*>(command_buffer.get())};
   batch.command_buffers = absl::MakeConstSpan(command_buffers);
-  RETURN_IF_ERROR(queue->Submit(batch, {fence.get(), 1u}));
-  RETURN_IF_ERROR(queue->WaitIdle());
-
-  for (auto& ref : deferred_releases_) {
-    iree_vm_ref_release(&ref);
-  }
+  RETURN_IF_ERROR(queue->Submit(batch, {timeline->fence.get(), fence_value}));
+  timeline->last_value = fence_value;
+
+  // Everything deferred up to this point is (conservatively) assumed to be used
+  // by this submission.
+  in_flight_submissions_.push_back({});
+  auto& submission = in_flight_submissions_.back();
+  submission.timeline = timeline;
+  submission.fence_value = fence_value;
+  submission.command_buffer = vm::retain_ref(command_buffer);
+  submission.deferred_releases = std::move(deferred_releases_);
   deferred_releases_.clear();
   bindings_.clear();
+  return &submission;
+}
+
+Status HALModuleState::RetireSubmissions(bool wait_all) {
+  IREE_TRACE_SCOPE0("HALModuleState::RetireSubmissions");
+  if (in_flight_submissions_.empty()) return OkStatus();
+
+  if (wait_all) {
+    // Fence values are monotonic so waiting for the last submission on each
+    // timeline waits for all prior ones.
+    for (auto& timeline : submission_timelines_) {
+      FenceValue fence_value = {timeline->fence.get(), timeline->last_value};
+      RETURN_IF_ERROR(timeline->device->WaitAllFences({&fence_value, 1},
+                                                      absl::InfiniteFuture()));
+    }
+  }
 
+  // Query each timeline once and retire everything it has passed.
+  absl::InlinedVector<uint64_t, 1> completed_values;
+  for (auto& timeline : submission_timelines_) {
+    ASSIGN_OR_RETURN(uint64_t value, timeline->fence->QueryValue());
+    completed_values.push_back(value);
+  }
+  auto completed_value = [&](SubmissionTimeline* timeline) {
+    for (int i = 0; i < submission_timelines_.size(); ++i) {
+      if (submission_timelines_[i].get() == timeline) {
+        return completed_values[i];
+      }
+    }
+    return uint64_t{0};
+  };
+  for (auto it = in_flight_submissions_.begin();
+       it != in_flight_submissions_.end();) {
+    if (completed_value(it->timeline) >= it->fence_value) {
+      ReleaseRefs(&it->deferred_releases);
+      it = in_flight_submissions_.erase(it);
+    } else {
+      ++it;
+    }
+  }
   return OkStatus();
 }
 
+Status HALModuleState::ExSubmit(
+    vm::ref<iree_hal_device_t>& device,
+    vm::ref<iree_hal_command_buffer_t>& command_buffer) {
+  IREE_TRACE_SCOPE0("HALModuleState::ExSubmit");
+  IREE_RETURN_IF_NULL(device);
+  IREE_RETURN_IF_NULL(command_buffer);
+  return SubmitCommandBuffer(reinterpret_cast<Device*>(device.get()),
+                             command_buffer)
+      .status();
+}
+
+Status HALModuleState::ExWaitIdle(vm::ref<iree_hal_device_t>& device) {
+  IREE_TRACE_SCOPE0("HALModuleState::ExWaitIdle");
+  IREE_RETURN_IF_NULL(device);
+  // Wait for all work on the device, including work submitted outside of this
+  // state, and then release everything our own submissions were retaining.
+  auto* device_ptr = reinterpret_cast<Device*>(device.get());
+  RETURN_IF_ERROR(device_ptr->WaitIdle());
+  return RetireSubmissions(/*wait_all=*/true);
+}
+
+Status HALModuleState::ExSubmitAndWait(
+    vm::ref<iree_hal_device_t>& device,
+    vm::ref<iree_hal_command_buffer_t>& command_buffer) {
+  IREE_TRACE_SCOPE0("HALModuleState::ExSubmitAndWait");
+  IREE_RETURN_IF_NULL(device);
+  IREE_RETURN_IF_NULL(command_buffer);
+
+  auto* device_ptr = reinterpret_cast<Device*>(device.get());
+  ASSIGN_OR_RETURN(auto* submission,
+                   SubmitCommandBuffer(device_ptr, command_buffer));
+  FenceValue fence_value = {submission->timeline->fence.get(),
+                            submission->fence_value};
+  RETURN_IF_ERROR(
+      device_ptr->WaitAllFences({&fence_value, 1}, absl::InfiniteFuture()));
+  return RetireSubmissions(/*wait_all=*/false);
+}
+
 //===----------------------------------------------------------------------===//
 // iree::hal::Allocator
 //===----------------------------------------------------------------------===//
@@ -411,19 +617,76 @@ StatusOr<vm::ref<iree_hal_buffer_t>> HALModuleState::AllocatorAllocateConst(
            << "Constant data is too larger for the minimum allocation size";
   }
 
+  // Rodata that does not own its contents may be freed and its address reused
+  // by other contents at any time and so is neither wrapped nor cached.
+  if (!OwnsContents(value.get())) {
+    return CreateConstantBuffer(allocator.get(), memory_types, buffer_usage,
+                                allocation_size, value);
+  }
+
+  ConstantBufferKey key(allocator.get(), value->data.data,
+                        value->data.data_length, allocation_size, memory_types,
+                        buffer_usage);
+  auto it = constant_buffers_.find(key);
+  if (it != constant_buffers_.end()) {
+    return vm::retain_ref(it->second.buffer);
+  }
+
+  ASSIGN_OR_RETURN(auto buffer,
+                   CreateConstantBuffer(allocator.get(), memory_types,
+                                        buffer_usage, allocation_size, value));
+  auto& entry = constant_buffers_[key];
+  entry.rodata = vm::retain_ref(value);
+  entry.buffer = vm::retain_ref(buffer);
+  return buffer;
+}
+
+StatusOr<vm::ref<iree_hal_buffer_t>> HALModuleState::CreateConstantBuffer(
+    iree_hal_allocator_t* allocator, iree_hal_memory_type_t memory_types,
+    iree_hal_buffer_usage_t buffer_usage, iree_device_size_t allocation_size,
+    vm::ref<iree_vm_ro_byte_buffer_t>& rodata) {
+  IREE_TRACE_SCOPE0("HALModuleState::CreateConstantBuffer");
+
+  // Wrap the rodata in place when it covers the whole buffer. The buffer
+  // retains the rodata (and with it the memory backing it) until it is
+  // destroyed, which may be after the context has been torn down. It is
+  // read-only as the rodata may be mapped from the module file.
   vm::ref<iree_hal_buffer_t> buffer;
-  RETURN_IF_ERROR(FromApiStatus(iree_hal_allocator_allocate_buffer(
-                                    allocator.get(), memory_types, buffer_usage,
-                                    allocation_size, &buffer),
-                                IREE_LOC))
+  if (allocation_size == rodata->data.data_length &&
+      OwnsContents(rodata.get())) {
+    auto release_fn = +[](void* user_data) {
+      vm::assign_ref(static_cast<iree_vm_ro_byte_buffer_t*>(user_data));
+    };
+    iree_vm_ro_byte_buffer_t* retained_rodata =
+        vm::retain_ref(rodata).release();
+    iree_status_t wrap_status = iree_hal_allocator_wrap_buffer_with_release(
+        allocator, memory_types, IREE_HAL_MEMORY_ACCESS_READ, buffer_usage,
+        iree_byte_span_t{const_cast<uint8_t*>(rodata->data.data),
+                         rodata->data.data_length},
+        release_fn, retained_rodata, &buffer);
+    if (wrap_status == IREE_STATUS_OK) {
+      reinterpret_cast<Buffer*>(buffer.get())->MarkConstantContents();
+      return buffer;
+    }
+    // Allocators that cannot access host memory fall back to a copy.
+    release_fn(retained_rodata);
+  }
+
+  RETURN_IF_ERROR(FromApiStatus(
+      iree_hal_allocator_allocate_buffer(allocator, memory_types, buffer_usage,
+                                         allocation_size, &buffer),
+      IREE_LOC))
       << "Failed to allocate buffer";
 
   RETURN_IF_ERROR(FromApiStatus(
-      iree_hal_buffer_write_data(buffer.get(), 0, value->data.data,
-                                 value->data.data_length),
+      iree_hal_buffer_write_data(buffer.get(), 0, rodata->data.data,
+                                 rodata->data.data_length),
       IREE_LOC))
       << "Writing constant data";
 
+  // Lets consumers (such as the interpreter MatMul) cache data derived from
+  // the contents for as long as the buffer lives.
+  reinterpret_cast<Buffer*>(buffer.get())->MarkConstantContents();
   return buffer;
 }
 
@@ -456,7 +719,13 @@ StatusOr<vm::ref<iree_hal_buffer_t>> HALModuleState::BufferSubspan(
     int32_t length) {
   IREE_TRACE_SCOPE0("HALModuleState::BufferSubspan");
   IREE_RETURN_IF_NULL(source_buffer);
-  return UnimplementedErrorBuilder(IREE_LOC) << "BufferSubspan";
+  vm::ref<iree_hal_buffer_t> buffer;
+  RETURN_IF_ERROR(
+      FromApiStatus(iree_hal_buffer_subspan(source_buffer.get(), source_offset,
+                                            length, allocator_, &buffer),
+                    IREE_LOC))
+      << "Failed to subspan buffer";
+  return buffer;
 }
 
 Status HALModuleState::BufferFill(vm::ref<iree_hal_buffer_t>& target_buffer,
@@ -503,6 +772,9 @@ StatusOr<int32_t> HALModuleState::BufferLoad(
   IREE_TRACE_SCOPE0("HALModuleState::BufferLoad");
   IREE_RETURN_IF_NULL(source_buffer);
 
+  // The buffer may be written by an in-flight submission.
+  RETURN_IF_ERROR(RetireSubmissions(/*wait_all=*/true));
+
   uint32_t target_buffer = 0;
   if (length > sizeof(target_buffer)) {
     return InvalidArgumentErrorBuilder(IREE_LOC)
@@ -523,6 +795,9 @@ Status HALModuleState::BufferStore(int32_t value,
   IREE_TRACE_SCOPE0("HALModuleState::BufferStore");
   IREE_RETURN_IF_NULL(target_buffer);
 
+  // The buffer may be read by an in-flight submission.
+  RETURN_IF_ERROR(RetireSubmissions(/*wait_all=*/true));
+
   if (target_offset + length >
       iree_hal_buffer_byte_length(target_buffer.get())) {
     return OutOfRangeErrorBuilder(IREE_LOC) << "Out of bounds store";
@@ -790,6 +1065,8 @@ static const vm::NativeFunction<HALModuleState> kHALModuleFunctions[] = {
     vm::MakeNativeFunction("ex.executable_descriptor_set_layout",
                            &HALModuleState::ExExecutableDescriptorSetLayout),
     vm::MakeNativeFunction("ex.defer_release", &HALModuleState::ExDeferRelease),
+    vm::MakeNativeFunction("ex.submit", &HALModuleState::ExSubmit),
+    vm::MakeNativeFunction("ex.wait_idle", &HALModuleState::ExWaitIdle),
     vm::MakeNativeFunction("ex.submit_and_wait",
                            &HALModuleState::ExSubmitAndWait),
     vm::MakeNativeFunction("allocator.compute_size",
@@ -844,16 +1121,24 @@ static const vm::NativeFunction<HALModuleState> kHALModuleFunctions[] = {
 
 class HALModule final : public vm::NativeModule<HALModuleState> {
  public:
-  HALModule(iree_allocator_t allocator, ref_ptr<Device> shared_device)
+  HALModule(iree_allocator_t allocator, ref_ptr<Device> shared_device,
+            iree_hal_module_flags_t flags)
       : vm::NativeModule<HALModuleState>(
             "hal", allocator, absl::MakeConstSpan(kHALModuleFunctions)),
-        shared_device_(std::move(shared_device)) {}
+        shared_device_(std::move(shared_device)),
+        flags_(flags) {}
   ~HALModule() = default;
 
   Status Initialize() {
     IREE_TRACE_SCOPE0("HALModule::Initialize");
 
-    executable_cache_ = shared_device_->CreateExecutableCache();
+    // Executables are memoized across all contexts using the module so that
+    // only the first context loading a particular executable prepares it.
+    // Executable data is only retained if the user intends to serialize it.
+    bool enable_serialization =
+        (flags_ & IREE_HAL_MODULE_FLAG_SERIALIZE_EXECUTABLES) != 0;
+    executable_cache_ = make_ref<PersistentExecutableCache>(
+        shared_device_->CreateExecutableCache(), enable_serialization);
 
     return OkStatus();
   }
@@ -868,23 +1153,70 @@ class HALModule final : public vm::NativeModule<HALModuleState> {
     return state;
   }
 
+  const ref_ptr<ExecutableCache>& executable_cache() const {
+    return executable_cache_;
+  }
+
  private:
   ref_ptr<Device> shared_device_;
+  iree_hal_module_flags_t flags_;
   ref_ptr<ExecutableCache> executable_cache_;
 };
 
+// Returns the HALModule backing |module| or nullptr if it is not one.
+// HALModule is the only NativeModule using HALModuleState.
+HALModule* CastHALModule(iree_vm_module_t* module) {
+  return static_cast<HALModule*>(
+      vm::NativeModule<HALModuleState>::FromInterface(module));
+}
+
 IREE_API_EXPORT iree_status_t IREE_API_CALL
 iree_hal_module_create(iree_hal_device_t* device, iree_allocator_t allocator,
                        iree_vm_module_t** out_module) {
+  return iree_hal_module_create_with_flags(device, IREE_HAL_MODULE_FLAG_NONE,
+                                           allocator, out_module);
+}
+
+IREE_API_EXPORT iree_status_t IREE_API_CALL iree_hal_module_create_with_flags(
+    iree_hal_device_t* device, iree_hal_module_flags_t flags,
+    iree_allocator_t allocator, iree_vm_module_t** out_module) {
   if (!out_module) return IREE_STATUS_INVALID_ARGUMENT;
   *out_module = nullptr;
   auto module = std::make_unique<HALModule>(
-      allocator, add_ref(reinterpret_cast<Device*>(device)));
+      allocator, add_ref(reinterpret_cast<Device*>(device)), flags);
   IREE_API_RETURN_IF_ERROR(module->Initialize());
   *out_module = module.release()->interface();
   return IREE_STATUS_OK;
 }
 
+IREE_API_EXPORT iree_status_t IREE_API_CALL
+iree_hal_module_serialize_executables(iree_vm_module_t* module,
+                                      iree_allocator_t allocator,
+                                      iree_byte_span_t* out_data) {
+  IREE_TRACE_SCOPE0("iree_hal_module_serialize_executables");
+  if (!out_data) return IREE_STATUS_INVALID_ARGUMENT;
+  *out_data = {nullptr, 0};
+  auto* hal_module = CastHALModule(module);
+  if (!hal_module) return IREE_STATUS_INVALID_ARGUMENT;
+  IREE_API_ASSIGN_OR_RETURN(auto data,
+                            hal_module->executable_cache()->Serialize());
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      allocator, data.size(), reinterpret_cast<void**>(&out_data->data)));
+  std::memcpy(out_data->data, data.data(), data.size());
+  out_data->data_length = data.size();
+  return IREE_STATUS_OK;
+}
+
+IREE_API_EXPORT iree_status_t IREE_API_CALL
+iree_hal_module_load_executables(iree_vm_module_t* module,
+                                 iree_const_byte_span_t data) {
+  IREE_TRACE_SCOPE0("iree_hal_module_load_executables");
+  auto* hal_module = CastHALModule(module);
+  if (!hal_module) return IREE_STATUS_INVALID_ARGUMENT;
+  return ToApiStatus(hal_module->executable_cache()->Deserialize(
+      absl::MakeConstSpan(data.data, data.data_length)));
+}
+
 }  // namespace
 }  // namespace hal
 }  // namespace iree
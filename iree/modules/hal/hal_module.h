@@ -40,6 +40,16 @@ IREE_VM_DECLARE_TYPE_ADAPTERS(iree_hal_executable, iree_hal_executable_t);
 // WARNING: not thread-safe; call at startup before using.
 IREE_API_EXPORT iree_status_t IREE_API_CALL iree_hal_module_register_types();
 
+// Bitfield specifying HAL module behavior.
+typedef enum {
+  IREE_HAL_MODULE_FLAG_NONE = 0,
+
+  // Retains a copy of the data of each prepared executable such that the
+  // executables can be serialized with iree_hal_module_serialize_executables.
+  IREE_HAL_MODULE_FLAG_SERIALIZE_EXECUTABLES = 1 << 0,
+} iree_hal_module_flag_t;
+typedef uint32_t iree_hal_module_flags_t;
+
 // Creates the HAL module initialized to use a specific |device|.
 // Each context using this module will share the device and have compatible
 // allocations.
@@ -47,6 +57,29 @@ IREE_API_EXPORT iree_status_t IREE_API_CALL
 iree_hal_module_create(iree_hal_device_t* device, iree_allocator_t allocator,
                        iree_vm_module_t** out_module);
 
+// Creates the HAL module as with iree_hal_module_create with the behavior
+// specified by |flags|.
+IREE_API_EXPORT iree_status_t IREE_API_CALL iree_hal_module_create_with_flags(
+    iree_hal_device_t* device, iree_hal_module_flags_t flags,
+    iree_allocator_t allocator, iree_vm_module_t** out_module);
+
+// Serializes the executables prepared by all contexts using the HAL |module|
+// so that a future process can load them with
+// iree_hal_module_load_executables instead of preparing them again.
+// The module must have been created with
+// IREE_HAL_MODULE_FLAG_SERIALIZE_EXECUTABLES.
+// |out_data| is allocated from |allocator| and must be freed by the caller.
+IREE_API_EXPORT iree_status_t IREE_API_CALL
+iree_hal_module_serialize_executables(iree_vm_module_t* module,
+                                      iree_allocator_t allocator,
+                                      iree_byte_span_t* out_data);
+
+// Prepares the executables in |data| as produced by
+// iree_hal_module_serialize_executables such that contexts using the HAL
+// |module| reuse them. Executables the device cannot prepare are ignored.
+IREE_API_EXPORT iree_status_t IREE_API_CALL iree_hal_module_load_executables(
+    iree_vm_module_t* module, iree_const_byte_span_t data);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -177,7 +177,7 @@ using OperandEncodingBitfield = OperandEncoding;
                                                                         \
   RSV(0x20, RESERVED_OPC)                                               \
   RSV(0x21, RESERVED_OPC)                                               \
-  RSV(0x22, RESERVED_OPC)                                               \
+  OPC(0x22, kAllocStatic, "alloc_static", FLAG(kDefault), "itISr", FF)   \
   OPC(0x23, kAllocHeap, "alloc_heap", FLAG(kDefault), "itISr", FF)      \
   OPC(0x24, kDiscard, "discard", FLAG(kDefault), "s", FF)               \
                                                                         \
@@ -56,19 +56,34 @@ static void iree_vm_bytecode_dispatch_remap_argument_registers(
     uint8_t src_reg = src_reg_list->registers[i];
     if (src_reg & IREE_REF_REGISTER_TYPE_BIT) {
       uint8_t dst_reg = ref_reg_offset++;
-      memset(&dst_regs->ref[dst_reg & IREE_REF_REGISTER_MASK], 0,
-             sizeof(iree_vm_ref_t));
-      iree_vm_ref_retain_or_move(
-          src_reg & IREE_REF_REGISTER_MOVE_BIT,
-          &src_regs->ref[src_reg & IREE_REF_REGISTER_MASK],
-          &dst_regs->ref[dst_reg & IREE_REF_REGISTER_MASK]);
+      iree_vm_ref_retain_or_move(src_reg & IREE_REF_REGISTER_MOVE_BIT,
+                                 &src_regs->ref[src_reg & src_regs->ref_mask],
+                                 &dst_regs->ref[dst_reg & dst_regs->ref_mask]);
     } else {
       uint8_t dst_reg = i32_reg_offset++;
-      dst_regs->i32[dst_reg & IREE_I32_REGISTER_MASK] =
-          src_regs->i32[src_reg & IREE_I32_REGISTER_MASK];
+      dst_regs->i32[dst_reg & dst_regs->i32_mask] =
+          src_regs->i32[src_reg & src_regs->i32_mask];
     }
   }
-  dst_regs->ref_register_count = ref_reg_offset;
+}
+
+// Returns the register counts required in an import callee frame to receive
+// the arguments in |src_reg_list| and return the results in |dst_reg_list|.
+static void iree_vm_bytecode_dispatch_count_call_registers(
+    const iree_vm_register_list_t* src_reg_list,
+    const iree_vm_register_list_t* dst_reg_list, int32_t* out_i32_count,
+    int32_t* out_ref_count) {
+  int32_t arg_i32_count = 0;
+  int32_t arg_ref_count = 0;
+  iree_vm_register_list_count(src_reg_list, &arg_i32_count, &arg_ref_count);
+  int32_t result_i32_count = 0;
+  int32_t result_ref_count = 0;
+  iree_vm_register_list_count(dst_reg_list, &result_i32_count,
+                              &result_ref_count);
+  *out_i32_count =
+      arg_i32_count > result_i32_count ? arg_i32_count : result_i32_count;
+  *out_ref_count =
+      arg_ref_count > result_ref_count ? arg_ref_count : result_ref_count;
 }
 
 // Remaps registers from source to destination, possibly across frames.
@@ -83,13 +98,12 @@ static void iree_vm_bytecode_dispatch_remap_registers(
     uint8_t src_reg = src_reg_list->registers[i];
     uint8_t dst_reg = dst_reg_list->registers[i];
     if (src_reg & IREE_REF_REGISTER_TYPE_BIT) {
-      iree_vm_ref_retain_or_move(
-          src_reg & IREE_REF_REGISTER_MOVE_BIT,
-          &src_regs->ref[src_reg & IREE_REF_REGISTER_MASK],
-          &dst_regs->ref[dst_reg & IREE_REF_REGISTER_MASK]);
+      iree_vm_ref_retain_or_move(src_reg & IREE_REF_REGISTER_MOVE_BIT,
+                                 &src_regs->ref[src_reg & src_regs->ref_mask],
+                                 &dst_regs->ref[dst_reg & dst_regs->ref_mask]);
     } else {
-      dst_regs->i32[dst_reg & IREE_I32_REGISTER_MASK] =
-          src_regs->i32[src_reg & IREE_I32_REGISTER_MASK];
+      dst_regs->i32[dst_reg & dst_regs->i32_mask] =
+          src_regs->i32[src_reg & src_regs->i32_mask];
     }
   }
 }
@@ -102,7 +116,7 @@ static void iree_vm_bytecode_dispatch_discard_registers(
     uint8_t reg = reg_list->registers[i];
     if ((reg & (IREE_REF_REGISTER_TYPE_BIT | IREE_REF_REGISTER_MOVE_BIT)) ==
         (IREE_REF_REGISTER_TYPE_BIT | IREE_REF_REGISTER_MOVE_BIT)) {
-      iree_vm_ref_release(&regs->ref[reg & IREE_REF_REGISTER_MASK]);
+      iree_vm_ref_release(&regs->ref[reg & regs->ref_mask]);
     }
   }
 }
@@ -110,6 +124,10 @@ static void iree_vm_bytecode_dispatch_discard_registers(
 // Interleaved src-dst register sets.
 // This structure is an overlay for the bytecode that is serialized in a
 // matching format.
+//
+// Branches encode two lists back-to-back: first the i32 register pairs and then
+// the ref register pairs. This lets us remap each bank without checking the
+// register type bits.
 typedef struct {
   uint8_t size;
   struct pair {
@@ -125,20 +143,43 @@ static_assert(offsetof(iree_vm_register_remap_list_t, pairs) == 1,
 // Remaps registers from a source set to a destination set within the frame.
 static void iree_vm_bytecode_dispatch_remap_branch_registers(
     iree_vm_registers_t* regs,
-    const iree_vm_register_remap_list_t* remap_list) {
-  for (int i = 0; i < remap_list->size; ++i) {
-    // TODO(benvanik): change encoding to avoid this branching.
-    // Could write two arrays: one for prims and one for refs.
-    uint8_t src_reg = remap_list->pairs[i].src_reg;
-    uint8_t dst_reg = remap_list->pairs[i].dst_reg;
-    if (src_reg & IREE_REF_REGISTER_TYPE_BIT) {
-      iree_vm_ref_retain_or_move(src_reg & IREE_REF_REGISTER_MOVE_BIT,
-                                 &regs->ref[src_reg & IREE_REF_REGISTER_MASK],
-                                 &regs->ref[dst_reg & IREE_REF_REGISTER_MASK]);
-    } else {
-      regs->i32[dst_reg & IREE_I32_REGISTER_MASK] =
-          regs->i32[src_reg & IREE_I32_REGISTER_MASK];
-    }
+    const iree_vm_register_remap_list_t* i32_remap_list,
+    const iree_vm_register_remap_list_t* ref_remap_list) {
+  for (int i = 0; i < i32_remap_list->size; ++i) {
+    uint8_t src_reg = i32_remap_list->pairs[i].src_reg;
+    uint8_t dst_reg = i32_remap_list->pairs[i].dst_reg;
+    regs->i32[dst_reg & regs->i32_mask] = regs->i32[src_reg & regs->i32_mask];
+  }
+  for (int i = 0; i < ref_remap_list->size; ++i) {
+    uint8_t src_reg = ref_remap_list->pairs[i].src_reg;
+    uint8_t dst_reg = ref_remap_list->pairs[i].dst_reg;
+    iree_vm_ref_retain_or_move(src_reg & IREE_REF_REGISTER_MOVE_BIT,
+                               &regs->ref[src_reg & regs->ref_mask],
+                               &regs->ref[dst_reg & regs->ref_mask]);
+  }
+}
+
+// Remaps i32 registers from a source list to the 0-N ABI registers.
+// The list must contain only i32 registers.
+static void iree_vm_bytecode_dispatch_remap_i32_argument_registers(
+    iree_vm_registers_t* src_regs, const iree_vm_register_list_t* src_reg_list,
+    iree_vm_registers_t* dst_regs) {
+  for (int i = 0; i < src_reg_list->size; ++i) {
+    dst_regs->i32[i & dst_regs->i32_mask] =
+        src_regs->i32[src_reg_list->registers[i] & src_regs->i32_mask];
+  }
+}
+
+// Remaps i32 registers from source to destination, possibly across frames.
+// The lists must contain only i32 registers.
+static void iree_vm_bytecode_dispatch_remap_i32_registers(
+    iree_vm_registers_t* src_regs, const iree_vm_register_list_t* src_reg_list,
+    iree_vm_registers_t* dst_regs,
+    const iree_vm_register_list_t* dst_reg_list) {
+  VMCHECK(src_reg_list->size == dst_reg_list->size);
+  for (int i = 0; i < src_reg_list->size; ++i) {
+    dst_regs->i32[dst_reg_list->registers[i] & dst_regs->i32_mask] =
+        src_regs->i32[src_reg_list->registers[i] & src_regs->i32_mask];
   }
 }
 
@@ -207,10 +248,8 @@ iree_status_t iree_vm_bytecode_dispatch(
 
 #endif  // IREE_DISPATCH_MODE_COMPUTED_GOTO
 
-#define OP_R_I32(i) \
-  regs->i32[bytecode_data[offset + i] & IREE_I32_REGISTER_MASK]
-#define OP_R_REF(i) \
-  regs->ref[bytecode_data[offset + i] & IREE_REF_REGISTER_MASK]
+#define OP_R_I32(i) regs->i32[bytecode_data[offset + i] & regs->i32_mask]
+#define OP_R_REF(i) regs->ref[bytecode_data[offset + i] & regs->ref_mask]
 #define OP_R_REF_IS_MOVE(i) \
   (bytecode_data[offset + i] & IREE_REF_REGISTER_MOVE_BIT)
 #define OP_GLOBAL_I32(ord) module_state->global_i32_table[ord]
@@ -239,15 +278,19 @@ iree_status_t iree_vm_bytecode_dispatch(
   // The hope is that the compiler decides to keep these in registers (as
   // they are touched for every instruction executed). The frame will change
   // as we call into different functions.
-  const iree_vm_function_descriptor_t* entry_function_descriptor =
-      &module->function_descriptor_table[entry_frame->function.ordinal];
-  iree_vm_stack_frame_t* current_frame = entry_frame;
+  //
+  // If execution previously yielded the innermost frame may be a callee of the
+  // entry frame and we resume there instead.
+  iree_vm_stack_frame_t* current_frame = iree_vm_stack_current_frame(stack);
+  if (current_frame->function.module != &module->interface) {
+    return IREE_STATUS_FAILED_PRECONDITION;
+  }
+  const iree_vm_function_descriptor_t* current_function_descriptor =
+      &module->function_descriptor_table[current_frame->function.ordinal];
   const uint8_t* bytecode_data =
-      module->bytecode_data.data + entry_function_descriptor->bytecode_offset;
+      module->bytecode_data.data + current_function_descriptor->bytecode_offset;
   iree_vm_source_offset_t offset = current_frame->offset;
   iree_vm_registers_t* regs = &current_frame->registers;
-  // TODO(benvanik): hide this register initialization logic in the stack enter.
-  regs->ref_register_count = entry_function_descriptor->ref_register_count;
 
   memset(out_result, 0, sizeof(*out_result));
 
@@ -358,9 +401,15 @@ iree_status_t iree_vm_bytecode_dispatch(
       //   VM_EncResult<"value">,
       // ];
       int32_t rodata_ordinal = OP_I32(0);
-      // TODO(benvanik): allow decompression callbacks to run now (if needed).
-      iree_vm_ref_wrap_retain(&module_state->rodata_ref_table[rodata_ordinal],
-                              iree_vm_ro_byte_buffer_type_id(), &OP_R_REF(4));
+      iree_vm_ro_byte_buffer_t* rodata =
+          &module_state->rodata_ref_table[rodata_ordinal]->buffer;
+      if (!rodata->data.data) {
+        // Compressed segments are decompressed on first use.
+        IREE_RETURN_IF_ERROR(iree_vm_bytecode_module_load_rodata(
+            module, module_state, rodata_ordinal));
+      }
+      iree_vm_ref_wrap_retain(rodata, iree_vm_ro_byte_buffer_type_id(),
+                              &OP_R_REF(4));
       offset += 4 + 1;
     });
 
@@ -552,6 +601,37 @@ iree_status_t iree_vm_bytecode_dispatch(
     // Control flow
     //===------------------------------------------------------------------===//
 
+    // Reads the split i32/ref remap lists of a branch at |offset|.
+    // Advances |offset| past the lists.
+#define DISPATCH_READ_BRANCH_REMAP_LISTS(i32_remap_list, ref_remap_list)   \
+  const iree_vm_register_remap_list_t* i32_remap_list =                   \
+      (const iree_vm_register_remap_list_t*)&bytecode_data[offset];       \
+  offset += 1 + i32_remap_list->size * 2;                                 \
+  const iree_vm_register_remap_list_t* ref_remap_list =                   \
+      (const iree_vm_register_remap_list_t*)&bytecode_data[offset];       \
+  offset += 1 + ref_remap_list->size * 2;
+
+    // Branches to one of the two branch targets at |offset| based on
+    // |cond_value| and remaps the registers of the taken branch.
+#define DISPATCH_COND_BRANCH(cond_value)                                   \
+  int32_t true_block_offset = OP_I32(0);                                  \
+  offset += 4;                                                            \
+  DISPATCH_READ_BRANCH_REMAP_LISTS(true_i32_remap_list,                   \
+                                   true_ref_remap_list);                  \
+  int32_t false_block_offset = OP_I32(0);                                 \
+  offset += 4;                                                            \
+  DISPATCH_READ_BRANCH_REMAP_LISTS(false_i32_remap_list,                  \
+                                   false_ref_remap_list);                 \
+  if (cond_value) {                                                       \
+    offset = true_block_offset;                                           \
+    iree_vm_bytecode_dispatch_remap_branch_registers(                     \
+        regs, true_i32_remap_list, true_ref_remap_list);                  \
+  } else {                                                                \
+    offset = false_block_offset;                                          \
+    iree_vm_bytecode_dispatch_remap_branch_registers(                     \
+        regs, false_i32_remap_list, false_ref_remap_list);                \
+  }
+
     DISPATCH_OP(Branch, {
       // let encoding = [
       //   VM_EncOpcode<VM_OPC_Branch>,
@@ -559,11 +639,11 @@ iree_status_t iree_vm_bytecode_dispatch(
       // ];
 
       int32_t block_offset = OP_I32(0);
-      const iree_vm_register_remap_list_t* remap_list =
-          (const iree_vm_register_remap_list_t*)&bytecode_data[offset + 4];
-      offset += 4 + 1 + remap_list->size * 2;
+      offset += 4;
+      DISPATCH_READ_BRANCH_REMAP_LISTS(i32_remap_list, ref_remap_list);
       offset = block_offset;
-      iree_vm_bytecode_dispatch_remap_branch_registers(regs, remap_list);
+      iree_vm_bytecode_dispatch_remap_branch_registers(regs, i32_remap_list,
+                                                       ref_remap_list);
     });
 
     DISPATCH_OP(CondBranch, {
@@ -575,25 +655,35 @@ iree_status_t iree_vm_bytecode_dispatch(
       // ];
 
       int32_t cond_value = OP_R_I32(0);
-      int32_t true_block_offset = OP_I32(1);
-      const iree_vm_register_remap_list_t* true_remap_list =
-          (const iree_vm_register_remap_list_t*)&bytecode_data[offset + 1 + 4];
-      offset += 1 + 4 + 1 + true_remap_list->size * 2;
-      int32_t false_block_offset = OP_I32(0);
-      const iree_vm_register_remap_list_t* false_remap_list =
-          (const iree_vm_register_remap_list_t*)&bytecode_data[offset + 4];
-      offset += 4 + 1 + false_remap_list->size * 2;
-
-      if (cond_value) {
-        offset = true_block_offset;
-        iree_vm_bytecode_dispatch_remap_branch_registers(regs, true_remap_list);
-      } else {
-        offset = false_block_offset;
-        iree_vm_bytecode_dispatch_remap_branch_registers(regs,
-                                                         false_remap_list);
-      }
+      offset += 1;
+      DISPATCH_COND_BRANCH(cond_value);
     });
 
+    // Superinstruction fusing an i32 comparison with the conditional branch
+    // consuming its result. GT/GTE comparisons are encoded as LT/LTE with
+    // swapped operands.
+    //
+    // let encoding = [
+    //   VM_EncOpcode<opcode>,
+    //   VM_EncOperand<"lhs", 0>,
+    //   VM_EncOperand<"rhs", 1>,
+    //   VM_EncBranch<"getTrueDest", "getTrueOperands">,
+    //   VM_EncBranch<"getFalseDest", "getFalseOperands">,
+    // ];
+#define DISPATCH_OP_CMP_BRANCH_I32(op_name, type, op)                   \
+  DISPATCH_OP(op_name, {                                               \
+    int32_t cond_value = ((type)OP_R_I32(0))op((type)OP_R_I32(1));     \
+    offset += 1 + 1;                                                   \
+    DISPATCH_COND_BRANCH(cond_value);                                  \
+  });
+
+    DISPATCH_OP_CMP_BRANCH_I32(CondBranchEQI32, int32_t, ==);
+    DISPATCH_OP_CMP_BRANCH_I32(CondBranchNEI32, int32_t, !=);
+    DISPATCH_OP_CMP_BRANCH_I32(CondBranchLTI32S, int32_t, <);
+    DISPATCH_OP_CMP_BRANCH_I32(CondBranchLTI32U, uint32_t, <);
+    DISPATCH_OP_CMP_BRANCH_I32(CondBranchLTEI32S, int32_t, <=);
+    DISPATCH_OP_CMP_BRANCH_I32(CondBranchLTEI32U, uint32_t, <=);
+
     DISPATCH_OP(Call, {
       // let encoding = [
       //   VM_EncOpcode<VM_OPC_Call>,
@@ -633,10 +723,26 @@ iree_status_t iree_vm_bytecode_dispatch(
       fprintf(stderr, "CALL -> %s\n", target_name.data);
 #endif  // IREE_DISPATCH_LOGGING
 
+      // Size the callee frame for either the internal function locals or the
+      // import arguments and results.
+      int32_t i32_register_count = 0;
+      int32_t ref_register_count = 0;
+      if (is_import) {
+        iree_vm_bytecode_dispatch_count_call_registers(
+            src_reg_list, dst_reg_list, &i32_register_count,
+            &ref_register_count);
+      } else {
+        const iree_vm_function_descriptor_t* function_descriptor =
+            &module->function_descriptor_table[function_ordinal];
+        i32_register_count = function_descriptor->i32_register_count;
+        ref_register_count = function_descriptor->ref_register_count;
+      }
+
       // Remap registers from caller to callee.
       iree_vm_stack_frame_t* callee_frame = NULL;
-      iree_status_t enter_status =
-          iree_vm_stack_function_enter(stack, target_function, &callee_frame);
+      iree_status_t enter_status = iree_vm_stack_function_enter(
+          stack, target_function, i32_register_count, ref_register_count,
+          &callee_frame);
       if (!iree_status_is_ok(enter_status)) {
         // TODO(benvanik): set execution result to stack overflow.
         return enter_status;
@@ -651,6 +757,9 @@ iree_status_t iree_vm_bytecode_dispatch(
         if (!iree_status_is_ok(call_status)) {
           // TODO(benvanik): set execution result to failure/capture stack.
           return call_status;
+        } else if (out_result->flags & IREE_VM_EXECUTION_RESULT_FLAG_YIELDED) {
+          // TODO(benvanik): support resuming imports that yield.
+          return IREE_STATUS_UNIMPLEMENTED;
         }
         if (callee_frame->return_registers) {
           iree_vm_bytecode_dispatch_remap_registers(
@@ -667,12 +776,6 @@ iree_status_t iree_vm_bytecode_dispatch(
         bytecode_data =
             module->bytecode_data.data + function_descriptor->bytecode_offset;
         regs = &callee_frame->registers;
-        // TODO(benvanik): hide this in the stack.
-        memset(
-            &regs->ref[regs->ref_register_count], 0,
-            sizeof(iree_vm_ref_t) * (function_descriptor->ref_register_count -
-                                     regs->ref_register_count));
-        regs->ref_register_count = function_descriptor->ref_register_count;
         offset = callee_frame->offset;
       }
     });
@@ -723,9 +826,14 @@ iree_status_t iree_vm_bytecode_dispatch(
 #endif  // IREE_DISPATCH_LOGGING
 
       // Remap registers from caller to callee.
+      int32_t i32_register_count = 0;
+      int32_t ref_register_count = 0;
+      iree_vm_bytecode_dispatch_count_call_registers(
+          src_reg_list, dst_reg_list, &i32_register_count, &ref_register_count);
       iree_vm_stack_frame_t* callee_frame = NULL;
-      iree_status_t enter_status =
-          iree_vm_stack_function_enter(stack, target_function, &callee_frame);
+      iree_status_t enter_status = iree_vm_stack_function_enter(
+          stack, target_function, i32_register_count, ref_register_count,
+          &callee_frame);
       if (!iree_status_is_ok(enter_status)) {
         // TODO(benvanik): set execution result to stack overflow.
         return enter_status;
@@ -742,6 +850,9 @@ iree_status_t iree_vm_bytecode_dispatch(
       if (!iree_status_is_ok(call_status)) {
         // TODO(benvanik): set execution result to failure/capture stack.
         return call_status;
+      } else if (out_result->flags & IREE_VM_EXECUTION_RESULT_FLAG_YIELDED) {
+        // TODO(benvanik): support resuming imports that yield.
+        return IREE_STATUS_UNIMPLEMENTED;
       }
       if (callee_frame->return_registers) {
         iree_vm_bytecode_dispatch_remap_registers(
@@ -791,6 +902,89 @@ iree_status_t iree_vm_bytecode_dispatch(
       offset = caller_frame->offset;
     });
 
+    DISPATCH_OP(CallI32, {
+      // Superinstruction for calls to internal functions that take and return
+      // only i32 values. This avoids the import and register type checks.
+      //
+      // let encoding = [
+      //   VM_EncOpcode<VM_OPC_CallI32>,
+      //   VM_EncFuncAttr<"callee">,
+      //   VM_EncVariadicOperands<"operands">,
+      //   VM_EncVariadicResults<"results">,
+      // ];
+
+      // Get argument and result register lists and flush the caller frame.
+      int32_t function_ordinal = OP_I32(0);
+      const iree_vm_register_list_t* src_reg_list =
+          (const iree_vm_register_list_t*)&bytecode_data[offset + 4];
+      offset += 4 + 1 + src_reg_list->size;
+      const iree_vm_register_list_t* dst_reg_list =
+          (const iree_vm_register_list_t*)&bytecode_data[offset];
+      current_frame->return_registers = dst_reg_list;
+      offset += 1 + dst_reg_list->size;
+      current_frame->offset = offset;
+
+      iree_vm_function_t target_function;
+      target_function.module = &module->interface;
+      target_function.linkage = IREE_VM_FUNCTION_LINKAGE_INTERNAL;
+      target_function.ordinal = function_ordinal;
+      const iree_vm_function_descriptor_t* function_descriptor =
+          &module->function_descriptor_table[function_ordinal];
+
+      iree_vm_stack_frame_t* callee_frame = NULL;
+      iree_status_t enter_status = iree_vm_stack_function_enter(
+          stack, target_function, function_descriptor->i32_register_count,
+          function_descriptor->ref_register_count, &callee_frame);
+      if (!iree_status_is_ok(enter_status)) {
+        // TODO(benvanik): set execution result to stack overflow.
+        return enter_status;
+      }
+      iree_vm_bytecode_dispatch_remap_i32_argument_registers(
+          &current_frame->registers, src_reg_list, &callee_frame->registers);
+
+      // Switch execution to the target function.
+      current_frame = callee_frame;
+      bytecode_data =
+          module->bytecode_data.data + function_descriptor->bytecode_offset;
+      regs = &callee_frame->registers;
+      offset = callee_frame->offset;
+    });
+
+    DISPATCH_OP(ReturnI32, {
+      // Superinstruction for returning only i32 values.
+      //
+      // let encoding = [
+      //   VM_EncOpcode<VM_OPC_ReturnI32>,
+      //   VM_EncVariadicOperands<"operands">,
+      // ];
+
+      const iree_vm_register_list_t* src_reg_list =
+          (const iree_vm_register_list_t*)&bytecode_data[offset];
+      current_frame->offset = offset + 1 + src_reg_list->size;
+
+      if (current_frame == entry_frame) {
+        // Return from the top-level entry frame - return back to execute().
+        current_frame->return_registers = src_reg_list;
+        return IREE_STATUS_OK;
+      }
+
+      // The caller result registers are i32 as the function signature is.
+      iree_vm_stack_frame_t* caller_frame = iree_vm_stack_parent_frame(stack);
+      VMCHECK(caller_frame);
+      iree_vm_bytecode_dispatch_remap_i32_registers(
+          &current_frame->registers, src_reg_list, &caller_frame->registers,
+          caller_frame->return_registers);
+      iree_vm_stack_function_leave(stack);
+
+      current_frame = caller_frame;
+      bytecode_data =
+          module->bytecode_data.data +
+          module->function_descriptor_table[caller_frame->function.ordinal]
+              .bytecode_offset;
+      regs = &caller_frame->registers;
+      offset = caller_frame->offset;
+    });
+
     //===------------------------------------------------------------------===//
     // Async/fiber ops
     //===------------------------------------------------------------------===//
@@ -799,7 +993,10 @@ iree_status_t iree_vm_bytecode_dispatch(
       // let encoding = [
       //   VM_EncOpcode<VM_OPC_Yield>,
       // ];
-      // TODO(benvanik): yield with execution results.
+      // Flush the offset so that the next execute call resumes after the
+      // yield. All other state is already stored within the stack.
+      current_frame->offset = offset;
+      out_result->flags |= IREE_VM_EXECUTION_RESULT_FLAG_YIELDED;
       return IREE_STATUS_OK;
     });
 
@@ -848,10 +1045,10 @@ iree_status_t iree_vm_bytecode_dispatch(
       // ];
       // TODO(benvanik): break unconditionally.
       int32_t block_offset = OP_I32(0);
-      const iree_vm_register_remap_list_t* remap_list =
-          (const iree_vm_register_remap_list_t*)&bytecode_data[offset + 4];
-      offset += 4 + 1 + remap_list->size * 2;
-      iree_vm_bytecode_dispatch_remap_branch_registers(regs, remap_list);
+      offset += 4;
+      DISPATCH_READ_BRANCH_REMAP_LISTS(i32_remap_list, ref_remap_list);
+      iree_vm_bytecode_dispatch_remap_branch_registers(regs, i32_remap_list,
+                                                       ref_remap_list);
       offset = block_offset;
     });
 
@@ -865,10 +1062,10 @@ iree_status_t iree_vm_bytecode_dispatch(
         // TODO(benvanik): cond break.
       }
       int32_t block_offset = OP_I32(1);
-      const iree_vm_register_remap_list_t* remap_list =
-          (const iree_vm_register_remap_list_t*)&bytecode_data[offset + 1 + 4];
-      offset += 1 + 4 + 1 + remap_list->size * 2;
-      iree_vm_bytecode_dispatch_remap_branch_registers(regs, remap_list);
+      offset += 1 + 4;
+      DISPATCH_READ_BRANCH_REMAP_LISTS(i32_remap_list, ref_remap_list);
+      iree_vm_bytecode_dispatch_remap_branch_registers(regs, i32_remap_list,
+                                                       ref_remap_list);
       offset = block_offset;
     });
 
@@ -18,6 +18,7 @@
 
 #include "iree/base/api.h"
 #include "iree/base/flatbuffer_util.h"
+#include "iree/base/lz4.h"
 #include "iree/vm/bytecode_module_impl.h"
 #include "iree/vm/ref.h"
 #include "iree/vm/stack.h"
@@ -73,6 +74,70 @@ static iree_status_t iree_vm_bytecode_module_resolve_types(
   return IREE_STATUS_OK;
 }
 
+// Compares the bytes of a flatbuffer string against |rhs| as with memcmp,
+// ordering shorter strings first when one is a prefix of the other.
+// Omitted strings compare as empty.
+static int iree_vm_bytecode_module_compare_str(const flatbuffers::String* lhs,
+                                               iree_string_view_t rhs) {
+  size_t lhs_size = lhs ? lhs->size() : 0;
+  size_t min_size = lhs_size < rhs.size ? lhs_size : rhs.size;
+  int cmp = min_size ? memcmp(lhs->data(), rhs.data, min_size) : 0;
+  if (cmp != 0) return cmp;
+  return lhs_size < rhs.size ? -1 : (lhs_size > rhs.size ? 1 : 0);
+}
+
+// Returns the name that functions in each table are looked up by.
+static const flatbuffers::String* iree_vm_bytecode_module_function_name(
+    const iree::vm::ImportFunctionDef* import_def) {
+  return import_def->full_name();
+}
+static const flatbuffers::String* iree_vm_bytecode_module_function_name(
+    const iree::vm::ExportFunctionDef* export_def) {
+  return export_def->local_name();
+}
+static const flatbuffers::String* iree_vm_bytecode_module_function_name(
+    const iree::vm::InternalFunctionDef* function_def) {
+  return function_def->local_name();
+}
+
+// Verifies that |ordinals_by_name|, if present, references every function in
+// |function_defs| in strictly increasing name order so that it can be binary
+// searched.
+template <typename T>
+static iree_status_t iree_vm_bytecode_module_verify_name_index(
+    const flatbuffers::Vector<flatbuffers::Offset<T>>* function_defs,
+    const flatbuffers::Vector<int32_t>* ordinals_by_name) {
+  if (!ordinals_by_name) return IREE_STATUS_OK;
+  int function_count = function_defs ? function_defs->size() : 0;
+  if (static_cast<int>(ordinals_by_name->size()) != function_count) {
+    LOG(ERROR) << "Function name indices must reference all functions.";
+    return IREE_STATUS_INVALID_ARGUMENT;
+  }
+  const flatbuffers::String* previous_name = nullptr;
+  for (int i = 0; i < ordinals_by_name->size(); ++i) {
+    int32_t ordinal = ordinals_by_name->Get(i);
+    if (ordinal < 0 || ordinal >= function_count) {
+      LOG(ERROR) << "Out-of-bounds reference in a function name index.";
+      return IREE_STATUS_INVALID_ARGUMENT;
+    }
+    const auto* name =
+        iree_vm_bytecode_module_function_name(function_defs->Get(ordinal));
+    if (!name || name->size() == 0) {
+      LOG(ERROR) << "Functions in a name index require a name.";
+      return IREE_STATUS_INVALID_ARGUMENT;
+    }
+    if (previous_name &&
+        iree_vm_bytecode_module_compare_str(
+            previous_name, iree_string_view_t{name->data(), name->size()}) >=
+            0) {
+      LOG(ERROR) << "Function name indices must be sorted and unique.";
+      return IREE_STATUS_INVALID_ARGUMENT;
+    }
+    previous_name = name;
+  }
+  return IREE_STATUS_OK;
+}
+
 // Verifies the structure of the flatbuffer so that we can avoid doing so during
 // runtime. There are still some conditions we must be aware of (such as omitted
 // names on functions with internal linkage), however we shouldn't need to
@@ -148,6 +213,31 @@ static iree_status_t iree_vm_bytecode_module_flatbuffer_verify(
     }
   }
 
+  if (module_def->rodata_segments()) {
+    for (int i = 0; i < module_def->rodata_segments()->size(); ++i) {
+      auto* segment_def = module_def->rodata_segments()->Get(i);
+      if (!segment_def || !segment_def->data()) {
+        LOG(ERROR) << "All rodata segments must have data.";
+        return IREE_STATUS_INVALID_ARGUMENT;
+      }
+      switch (segment_def->compression_type_type()) {
+        case iree::vm::CompressionTypeDef::NONE:
+        case iree::vm::CompressionTypeDef::UncompressedDataDef:
+          break;
+        case iree::vm::CompressionTypeDef::LZ4DataDef:
+          if (segment_def->compression_type_as_LZ4DataDef()
+                  ->uncompressed_size() == 0) {
+            LOG(ERROR) << "Compressed rodata segments must not be empty.";
+            return IREE_STATUS_INVALID_ARGUMENT;
+          }
+          break;
+        default:
+          LOG(ERROR) << "Unsupported rodata segment compression type.";
+          return IREE_STATUS_UNIMPLEMENTED;
+      }
+    }
+  }
+
   for (int i = 0; i < module_def->exported_functions()->size(); ++i) {
     auto* export_def = module_def->exported_functions()->Get(i);
     if (!export_def) {
@@ -198,6 +288,16 @@ static iree_status_t iree_vm_bytecode_module_flatbuffer_verify(
     // TODO(benvanik): run bytecode verifier on contents.
   }
 
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_module_verify_name_index(
+      module_def->imported_functions(),
+      module_def->imported_functions_by_name()));
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_module_verify_name_index(
+      module_def->exported_functions(),
+      module_def->exported_functions_by_name()));
+  IREE_RETURN_IF_ERROR(iree_vm_bytecode_module_verify_name_index(
+      module_def->internal_functions(),
+      module_def->internal_functions_by_name()));
+
   return IREE_STATUS_OK;
 }
 
@@ -349,10 +449,41 @@ static iree_status_t iree_vm_bytecode_module_get_function_reflection_attr(
   return IREE_STATUS_OK;
 }
 
-static bool iree_vm_bytecode_module_compare_str(const flatbuffers::String* lhs,
-                                                iree_string_view_t rhs) {
-  if (!lhs || lhs->size() != rhs.size) return false;
-  return strncmp(lhs->c_str(), rhs.data, rhs.size) == 0;
+// Returns the ordinal of the function named |name| in |function_defs| or -1 if
+// it is not found. Binary searches |ordinals_by_name| if the module has one.
+template <typename T>
+static int iree_vm_bytecode_module_find_function(
+    const flatbuffers::Vector<flatbuffers::Offset<T>>* function_defs,
+    const flatbuffers::Vector<int32_t>* ordinals_by_name,
+    iree_string_view_t name) {
+  if (!function_defs) return -1;
+  if (ordinals_by_name) {
+    int low = 0;
+    int high = static_cast<int>(ordinals_by_name->size()) - 1;
+    while (low <= high) {
+      int mid = low + (high - low) / 2;
+      int ordinal = ordinals_by_name->Get(mid);
+      int cmp = iree_vm_bytecode_module_compare_str(
+          iree_vm_bytecode_module_function_name(function_defs->Get(ordinal)),
+          name);
+      if (cmp == 0) {
+        return ordinal;
+      } else if (cmp < 0) {
+        low = mid + 1;
+      } else {
+        high = mid - 1;
+      }
+    }
+    return -1;
+  }
+  for (int ordinal = 0; ordinal < function_defs->size(); ++ordinal) {
+    if (iree_vm_bytecode_module_compare_str(
+            iree_vm_bytecode_module_function_name(function_defs->Get(ordinal)),
+            name) == 0) {
+      return ordinal;
+    }
+  }
+  return -1;
 }
 
 static iree_status_t iree_vm_bytecode_module_lookup_function(
@@ -366,50 +497,50 @@ static iree_status_t iree_vm_bytecode_module_lookup_function(
   iree_vm_bytecode_module_t* module = (iree_vm_bytecode_module_t*)self;
   auto* module_def = IREE_VM_GET_MODULE_DEF(module);
 
-  // NOTE: we could organize imports/exports alphabetically so we could bsearch.
   if (linkage == IREE_VM_FUNCTION_LINKAGE_IMPORT) {
-    if (!module_def->imported_functions()) {
-      return IREE_STATUS_NOT_FOUND;
-    }
-    for (int ordinal = 0; ordinal < module_def->imported_functions()->size();
-         ++ordinal) {
-      auto* import_def = module_def->imported_functions()->Get(ordinal);
-      if (iree_vm_bytecode_module_compare_str(import_def->full_name(), name)) {
-        out_function->module = &module->interface;
-        out_function->linkage = linkage;
-        out_function->ordinal = ordinal;
-        return IREE_STATUS_OK;
-      }
-    }
-    return IREE_STATUS_NOT_FOUND;
+    int ordinal = iree_vm_bytecode_module_find_function(
+        module_def->imported_functions(),
+        module_def->imported_functions_by_name(), name);
+    if (ordinal < 0) return IREE_STATUS_NOT_FOUND;
+    out_function->module = &module->interface;
+    out_function->linkage = linkage;
+    out_function->ordinal = ordinal;
+    return IREE_STATUS_OK;
   } else if (linkage == IREE_VM_FUNCTION_LINKAGE_EXPORT) {
-    for (int ordinal = 0; ordinal < module_def->exported_functions()->size();
-         ++ordinal) {
-      auto* export_def = module_def->exported_functions()->Get(ordinal);
-      if (iree_vm_bytecode_module_compare_str(export_def->local_name(), name)) {
-        out_function->module = &module->interface;
-        out_function->linkage = IREE_VM_FUNCTION_LINKAGE_INTERNAL;
-        out_function->ordinal = export_def->internal_ordinal();
-        return IREE_STATUS_OK;
-      }
-    }
-    return IREE_STATUS_NOT_FOUND;
+    int ordinal = iree_vm_bytecode_module_find_function(
+        module_def->exported_functions(),
+        module_def->exported_functions_by_name(), name);
+    if (ordinal < 0) return IREE_STATUS_NOT_FOUND;
+    out_function->module = &module->interface;
+    out_function->linkage = IREE_VM_FUNCTION_LINKAGE_INTERNAL;
+    out_function->ordinal =
+        module_def->exported_functions()->Get(ordinal)->internal_ordinal();
+    return IREE_STATUS_OK;
   } else {
-    for (int ordinal = 0; ordinal < module_def->internal_functions()->size();
-         ++ordinal) {
-      auto* function_def = module_def->internal_functions()->Get(ordinal);
-      if (iree_vm_bytecode_module_compare_str(function_def->local_name(),
-                                              name)) {
-        out_function->module = &module->interface;
-        out_function->linkage = IREE_VM_FUNCTION_LINKAGE_INTERNAL;
-        out_function->ordinal = ordinal;
-        return IREE_STATUS_OK;
-      }
-    }
-    return IREE_STATUS_NOT_FOUND;
+    int ordinal = iree_vm_bytecode_module_find_function(
+        module_def->internal_functions(),
+        module_def->internal_functions_by_name(), name);
+    if (ordinal < 0) return IREE_STATUS_NOT_FOUND;
+    out_function->module = &module->interface;
+    out_function->linkage = IREE_VM_FUNCTION_LINKAGE_INTERNAL;
+    out_function->ordinal = ordinal;
+    return IREE_STATUS_OK;
   }
 }
 
+// Destroys a rodata segment once its last reference has been released.
+static void iree_vm_bytecode_rodata_segment_destroy(void* ptr) {
+  iree_vm_bytecode_rodata_segment_t* segment =
+      (iree_vm_bytecode_rodata_segment_t*)ptr;
+  iree_allocator_t allocator = segment->allocator;
+  iree_allocator_free(allocator, segment->decompressed_data);
+  iree_vm_module_release(segment->module);
+  iree_allocator_free(allocator, segment);
+}
+
+static iree_status_t iree_vm_bytecode_module_free_state(
+    void* self, iree_vm_module_state_t* module_state);
+
 static iree_status_t iree_vm_bytecode_module_alloc_state(
     void* self, iree_allocator_t allocator,
     iree_vm_module_state_t** out_module_state) {
@@ -437,7 +568,7 @@ static iree_status_t iree_vm_bytecode_module_alloc_state(
   total_state_struct_size += rwdata_storage_capacity;
   total_state_struct_size += global_ref_count * sizeof(iree_vm_ref_t);
   total_state_struct_size +=
-      rodata_ref_count * sizeof(iree_vm_ro_byte_buffer_t);
+      rodata_ref_count * sizeof(iree_vm_bytecode_rodata_segment_t*);
   total_state_struct_size += import_function_count * sizeof(iree_vm_function_t);
 
   iree_vm_bytecode_module_state_t* state = NULL;
@@ -453,19 +584,39 @@ static iree_status_t iree_vm_bytecode_module_alloc_state(
   state->global_ref_table = (iree_vm_ref_t*)p;
   p += global_ref_count * sizeof(*state->global_ref_table);
   state->rodata_ref_count = rodata_ref_count;
-  state->rodata_ref_table = (iree_vm_ro_byte_buffer_t*)p;
+  state->rodata_ref_table = (iree_vm_bytecode_rodata_segment_t**)p;
   p += rodata_ref_count * sizeof(*state->rodata_ref_table);
   state->import_count = import_function_count;
   state->import_table = (iree_vm_function_t*)p;
   p += import_function_count * sizeof(*state->import_table);
 
+  // Each segment retains the module so that its contents remain valid for as
+  // long as the segment is referenced. The state holds one reference to each.
   for (int i = 0; i < rodata_ref_count; ++i) {
-    const iree::vm::RodataSegmentDef* segment =
+    const iree::vm::RodataSegmentDef* segment_def =
         module_def->rodata_segments()->Get(i);
-    iree_vm_ro_byte_buffer_t* ref = &state->rodata_ref_table[i];
-    ref->ref_object.counter = 1;
-    ref->data.data = segment->data()->Data();
-    ref->data.data_length = segment->data()->size();
+    iree_vm_bytecode_rodata_segment_t* segment = NULL;
+    iree_status_t status =
+        iree_allocator_malloc(allocator, sizeof(*segment), (void**)&segment);
+    if (!iree_status_is_ok(status)) {
+      iree_vm_bytecode_module_free_state(self,
+                                         (iree_vm_module_state_t*)state);
+      return status;
+    }
+    segment->buffer.ref_object.counter = 1;
+    segment->buffer.destroy = iree_vm_bytecode_rodata_segment_destroy;
+    segment->module = &module->interface;
+    iree_vm_module_retain(segment->module);
+    segment->allocator = allocator;
+    if (auto* lz4_data_def = segment_def->compression_type_as_LZ4DataDef()) {
+      // Decompressed lazily by iree_vm_bytecode_module_load_rodata.
+      segment->buffer.data.data = NULL;
+      segment->buffer.data.data_length = lz4_data_def->uncompressed_size();
+    } else {
+      segment->buffer.data.data = segment_def->data()->Data();
+      segment->buffer.data.data_length = segment_def->data()->size();
+    }
+    state->rodata_ref_table[i] = segment;
   }
 
   *out_module_state = (iree_vm_module_state_t*)state;
@@ -483,9 +634,52 @@ static iree_status_t iree_vm_bytecode_module_free_state(
     iree_vm_ref_release(&state->global_ref_table[i]);
   }
 
+  // Release our references to the rodata segments. Segments still referenced
+  // elsewhere (such as by buffers wrapping their contents) outlive the state.
+  for (int i = 0; i < state->rodata_ref_count; ++i) {
+    iree_vm_ref_object_release(state->rodata_ref_table[i],
+                               iree_vm_ro_byte_buffer_get_descriptor());
+  }
+
   return state->allocator.free(state->allocator.self, module_state);
 }
 
+iree_status_t iree_vm_bytecode_module_load_rodata(
+    iree_vm_bytecode_module_t* module,
+    iree_vm_bytecode_module_state_t* module_state, int32_t ordinal) {
+  if (ordinal < 0 || ordinal >= module_state->rodata_ref_count) {
+    return IREE_STATUS_OUT_OF_RANGE;
+  }
+  iree_vm_bytecode_rodata_segment_t* segment =
+      module_state->rodata_ref_table[ordinal];
+  iree_vm_ro_byte_buffer_t* ref = &segment->buffer;
+  if (ref->data.data) return IREE_STATUS_OK;
+
+  auto* module_def = IREE_VM_GET_MODULE_DEF(module);
+  const iree::vm::RodataSegmentDef* segment_def =
+      module_def->rodata_segments()->Get(ordinal);
+  if (!segment_def->compression_type_as_LZ4DataDef()) {
+    return IREE_STATUS_FAILED_PRECONDITION;
+  }
+
+  uint8_t* data = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      segment->allocator, ref->data.data_length, (void**)&data));
+  auto status = iree::Lz4DecompressBlock(
+      absl::MakeConstSpan(segment_def->data()->Data(),
+                          segment_def->data()->size()),
+      absl::MakeSpan(data, ref->data.data_length));
+  if (!status.ok()) {
+    LOG(ERROR) << "Failed to decompress rodata segment " << ordinal << ": "
+               << status;
+    iree_allocator_free(segment->allocator, data);
+    return IREE_STATUS_DATA_LOSS;
+  }
+  segment->decompressed_data = data;
+  ref->data.data = data;
+  return IREE_STATUS_OK;
+}
+
 static iree_status_t iree_vm_bytecode_module_resolve_import(
     void* self, iree_vm_module_state_t* module_state, int32_t ordinal,
     iree_vm_function_t function) {
@@ -523,12 +717,16 @@ static iree_status_t iree_vm_bytecode_module_execute(
     return IREE_STATUS_INVALID_ARGUMENT;
   }
 
-  const iree_vm_function_descriptor_t* function_descriptor =
-      &module->function_descriptor_table[frame->function.ordinal];
-  iree_vm_registers_t* regs = &frame->registers;
-  memset(&regs->ref[regs->ref_register_count], 0,
-         sizeof(iree_vm_ref_t) * (function_descriptor->ref_register_count -
-                                  regs->ref_register_count));
+  // Callers only size the entry frame for the arguments they pass; grow it to
+  // hold all of the function registers. When resuming after a yield the frame
+  // was sized on the first call and may no longer be the innermost frame.
+  if (frame == iree_vm_stack_current_frame(stack)) {
+    const iree_vm_function_descriptor_t* function_descriptor =
+        &module->function_descriptor_table[frame->function.ordinal];
+    IREE_RETURN_IF_ERROR(iree_vm_stack_frame_reserve_registers(
+        stack, frame, function_descriptor->i32_register_count,
+        function_descriptor->ref_register_count));
+  }
 
   return iree_vm_bytecode_dispatch(
       module, (iree_vm_bytecode_module_state_t*)frame->module_state, stack,
@@ -603,3 +801,38 @@ IREE_API_EXPORT iree_status_t IREE_API_CALL iree_vm_bytecode_module_create(
   *out_module = &module->interface;
   return IREE_STATUS_OK;
 }
+
+// Releases the file mapping stashed in the allocator |self| when the module
+// frees its flatbuffer data.
+static iree_status_t iree_vm_bytecode_module_release_file_mapping(void* self,
+                                                                  void* ptr) {
+  return iree_file_mapping_release((iree_file_mapping_t*)self);
+}
+
+IREE_API_EXPORT iree_status_t IREE_API_CALL
+iree_vm_bytecode_module_create_from_file(iree_string_view_t path,
+                                         iree_allocator_t allocator,
+                                         iree_vm_module_t** out_module) {
+  if (!out_module) {
+    LOG(ERROR) << "Output module argument not set";
+    return IREE_STATUS_INVALID_ARGUMENT;
+  }
+  *out_module = NULL;
+
+  iree_file_mapping_t* file_mapping = NULL;
+  IREE_RETURN_IF_ERROR(
+      iree_file_mapping_open_read(path, allocator, &file_mapping));
+  iree_byte_span_t file_data = iree_file_mapping_data(file_mapping);
+
+  // The module takes ownership of the mapping reference and releases it via
+  // the flatbuffer allocator when destroyed.
+  iree_allocator_t file_mapping_allocator = {
+      file_mapping, NULL, iree_vm_bytecode_module_release_file_mapping};
+  iree_status_t status = iree_vm_bytecode_module_create(
+      iree_const_byte_span_t{file_data.data, file_data.data_length},
+      file_mapping_allocator, allocator, out_module);
+  if (status != IREE_STATUS_OK) {
+    iree_file_mapping_release(file_mapping);
+  }
+  return status;
+}
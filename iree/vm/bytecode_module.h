@@ -33,6 +33,16 @@ IREE_API_EXPORT iree_status_t IREE_API_CALL iree_vm_bytecode_module_create(
     iree_allocator_t flatbuffer_allocator, iree_allocator_t allocator,
     iree_vm_module_t** out_module);
 
+// Creates a VM module from a ModuleDef FlatBuffer file at |path|.
+// The file is mapped read-only and the mapping is retained until the module is
+// destroyed. The module references the mapped pages directly (including rodata
+// segments) so only the pages touched are read from disk and they may be
+// shared with other processes mapping the same file through the page cache.
+IREE_API_EXPORT iree_status_t IREE_API_CALL
+iree_vm_bytecode_module_create_from_file(iree_string_view_t path,
+                                         iree_allocator_t allocator,
+                                         iree_vm_module_t** out_module);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
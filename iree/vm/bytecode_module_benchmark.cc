@@ -12,11 +12,19 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include <vector>
+
 #include "absl/container/inlined_vector.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "benchmark/benchmark.h"
+#include "flatbuffers/flatbuffers.h"
 #include "iree/base/api.h"
 #include "iree/base/logging.h"
+#include "iree/schemas/bytecode_module_def_generated.h"
 #include "iree/vm/bytecode_module.h"
 #include "iree/vm/bytecode_module_benchmark_module.h"
 #include "iree/vm/module.h"
@@ -77,7 +85,8 @@ static iree_status_t RunFunction(benchmark::State& state,
       }};
 
   auto stack = std::make_unique<iree_vm_stack_t>();
-  iree_vm_stack_init(state_resolver, stack.get());
+  iree_vm_stack_init(state_resolver, iree_byte_span_t{nullptr, 0},
+                     IREE_ALLOCATOR_SYSTEM, stack.get());
 
   iree_vm_function_t function;
   IREE_CHECK_OK(module->lookup_function(
@@ -88,7 +97,8 @@ static iree_status_t RunFunction(benchmark::State& state,
 
   while (state.KeepRunningBatch(batch_size)) {
     iree_vm_stack_frame_t* entry_frame;
-    iree_vm_stack_function_enter(stack.get(), function, &entry_frame);
+    iree_vm_stack_function_enter(stack.get(), function, i32_args.size(),
+                                 /*ref_register_count=*/0, &entry_frame);
     // TODO(benvanik): replace direct register manipulation with setter:
     //   iree_vm_stack_frame_set_arguments(entry_frame, 1, i32_args, 0, {});
     for (int i = 0; i < i32_args.size(); ++i) {
@@ -179,6 +189,88 @@ static void BM_FullModuleInit(benchmark::State& state) {
 }
 BENCHMARK(BM_FullModuleInit);
 
+// Builds a module exporting a function for each of |names|, like those
+// produced for large generated programs. The functions have no bytecode and
+// can only be looked up. If |with_name_index| is false the module looks like
+// one produced before the compiler emitted function name indices.
+static std::vector<uint8_t> BuildSyntheticModule(
+    const std::vector<std::string>& names, bool with_name_index) {
+  flatbuffers::FlatBufferBuilder fbb;
+  auto signature_offset = iree::vm::CreateFunctionSignatureDef(fbb);
+  std::vector<flatbuffers::Offset<iree::vm::ExportFunctionDef>> export_defs;
+  std::vector<flatbuffers::Offset<iree::vm::InternalFunctionDef>>
+      function_defs;
+  std::vector<iree::vm::FunctionDescriptor> function_descriptors;
+  for (int i = 0; i < names.size(); ++i) {
+    auto name_offset = fbb.CreateString(names[i]);
+    export_defs.push_back(iree::vm::CreateExportFunctionDef(
+        fbb, name_offset, signature_offset, /*internal_ordinal=*/i));
+    function_defs.push_back(iree::vm::CreateInternalFunctionDef(
+        fbb, name_offset, signature_offset));
+    function_descriptors.emplace_back(0, 0, 0, 0);
+  }
+  std::vector<int32_t> ordinals_by_name(names.size());
+  std::iota(ordinals_by_name.begin(), ordinals_by_name.end(), 0);
+  std::sort(ordinals_by_name.begin(), ordinals_by_name.end(),
+            [&](int32_t lhs, int32_t rhs) { return names[lhs] < names[rhs]; });
+
+  auto name_offset = fbb.CreateString("synthetic");
+  auto types_offset =
+      fbb.CreateVector(std::vector<flatbuffers::Offset<iree::vm::TypeDef>>());
+  auto exports_offset = fbb.CreateVector(export_defs);
+  auto functions_offset = fbb.CreateVector(function_defs);
+  auto descriptors_offset = fbb.CreateVectorOfStructs(function_descriptors);
+  auto bytecode_offset = fbb.CreateVector(std::vector<uint8_t>());
+  auto ordinals_by_name_offset = fbb.CreateVector(ordinals_by_name);
+  iree::vm::BytecodeModuleDefBuilder bmd(fbb);
+  bmd.add_name(name_offset);
+  bmd.add_types(types_offset);
+  bmd.add_exported_functions(exports_offset);
+  bmd.add_internal_functions(functions_offset);
+  bmd.add_function_descriptors(descriptors_offset);
+  bmd.add_bytecode_data(bytecode_offset);
+  if (with_name_index) {
+    bmd.add_exported_functions_by_name(ordinals_by_name_offset);
+    bmd.add_internal_functions_by_name(ordinals_by_name_offset);
+  }
+  fbb.Finish(bmd.Finish(), iree::vm::BytecodeModuleDefIdentifier());
+  return std::vector<uint8_t>(fbb.GetBufferPointer(),
+                              fbb.GetBufferPointer() + fbb.GetSize());
+}
+
+// Looks up every export of a synthetic module by name, as is done when
+// resolving the imports of a module that calls all of them.
+// Args: function count, whether the module has a function name index.
+static void BM_LookupAllExports(benchmark::State& state) {
+  std::vector<std::string> names(state.range(0));
+  for (int i = 0; i < names.size(); ++i) {
+    names[i] = absl::StrCat("dispatch_", i, "_entry");
+  }
+  auto module_data = BuildSyntheticModule(names, state.range(1) != 0);
+  iree_vm_module_t* module = nullptr;
+  IREE_CHECK_OK(iree_vm_bytecode_module_create(
+      iree_const_byte_span_t{module_data.data(), module_data.size()},
+      IREE_ALLOCATOR_NULL, IREE_ALLOCATOR_SYSTEM, &module))
+      << "Bytecode module failed to load";
+
+  while (state.KeepRunningBatch(names.size())) {
+    for (const auto& name : names) {
+      iree_vm_function_t function;
+      IREE_CHECK_OK(module->lookup_function(
+          module->self, IREE_VM_FUNCTION_LINKAGE_EXPORT,
+          iree_string_view_t{name.data(), name.size()}, &function));
+      benchmark::DoNotOptimize(function);
+    }
+  }
+
+  module->destroy(module->self);
+}
+BENCHMARK(BM_LookupAllExports)
+    ->ArgPair(100, 0)
+    ->ArgPair(100, 1)
+    ->ArgPair(10000, 0)
+    ->ArgPair(10000, 1);
+
 static void BM_EmptyFuncReference(benchmark::State& state) {
   static auto empty_fn = +[]() {
     int ret = 1;
@@ -242,20 +334,35 @@ static void BM_CallImportedFuncReference(benchmark::State& state) {
   iree_vm_module_t* module_ptr = &import_module;
   benchmark::DoNotOptimize(module_ptr);
 
+  iree_vm_state_resolver_t state_resolver = {
+      nullptr,
+      +[](void* state_resolver, iree_vm_module_t* module,
+          iree_vm_module_state_t** out_module_state) -> iree_status_t {
+        *out_module_state = nullptr;
+        return IREE_STATUS_OK;
+      }};
   auto stack = std::make_unique<iree_vm_stack_t>();
-  iree_vm_stack_frame_t frame;
+  iree_vm_stack_init(state_resolver, iree_byte_span_t{nullptr, 0},
+                     IREE_ALLOCATOR_SYSTEM, stack.get());
+  iree_vm_function_t function = {module_ptr, IREE_VM_FUNCTION_LINKAGE_INTERNAL,
+                                 0};
+  iree_vm_stack_frame_t* frame = nullptr;
+  iree_vm_stack_function_enter(stack.get(), function,
+                               /*i32_register_count=*/1,
+                               /*ref_register_count=*/0, &frame);
   iree_vm_execution_result_t result;
   while (state.KeepRunningBatch(10)) {
     int value = 100;
     for (int i = 0; i < 10; ++i) {
-      frame.registers.i32[0] = value;
-      module_ptr->execute(module_ptr->self, stack.get(), &frame, &result);
-      value = frame.registers.i32[0];
+      frame->registers.i32[0] = value;
+      module_ptr->execute(module_ptr->self, stack.get(), frame, &result);
+      value = frame->registers.i32[0];
       benchmark::DoNotOptimize(value);
       benchmark::ClobberMemory();
     }
     benchmark::ClobberMemory();
   }
+  iree_vm_stack_deinit(stack.get());
 }
 BENCHMARK(BM_CallImportedFuncReference);
 
@@ -73,6 +73,25 @@ typedef struct {
   iree_vm_type_def_t* type_table;
 } iree_vm_bytecode_module_t;
 
+// A rodata segment referenced by module state and by any values produced from
+// it. Each segment is a separately reference counted iree_vm_ro_byte_buffer_t
+// that keeps its contents alive for as long as it is referenced, which may be
+// after the state that created it has been freed (such as when a HAL buffer
+// wraps the contents and is held by the application after the context is
+// destroyed).
+typedef struct {
+  // Must be first so that segments can be used as iree_vm_ro_byte_buffer_t.
+  iree_vm_ro_byte_buffer_t buffer;
+  // Retained module owning the FlatBuffer (and any file mapping) that
+  // uncompressed segment contents point into.
+  iree_vm_module_t* module;
+  // Allocator the segment and |decompressed_data| were allocated with.
+  iree_allocator_t allocator;
+  // Decompressed contents owned by the segment or NULL if the segment is
+  // uncompressed or has not yet been loaded.
+  void* decompressed_data;
+} iree_vm_bytecode_rodata_segment_t;
+
 // Per-instance module state.
 // This is allocated with a provided allocator as a single flat allocation.
 // This struct is a prefix to the allocation pointing into the dynamic offsets
@@ -90,11 +109,13 @@ typedef struct {
   iree_vm_ref_t* global_ref_table;
 
   // TODO(benvanik): move to iree_vm_bytecode_module_t if always static.
-  // Initialized references to rodata segments.
-  // Right now these don't do much, however we can perform lazy caching and
-  // on-the-fly decompression using this information.
+  // Retained references to rodata segments.
+  // Uncompressed segments point directly into the module FlatBuffer.
+  // Compressed segments start with a NULL data pointer and are decompressed
+  // into memory owned by the segment on first use by
+  // iree_vm_bytecode_module_load_rodata.
   int32_t rodata_ref_count;
-  iree_vm_ro_byte_buffer_t* rodata_ref_table;
+  iree_vm_bytecode_rodata_segment_t** rodata_ref_table;
 
   // Resolved function imports.
   int32_t import_count;
@@ -104,6 +125,13 @@ typedef struct {
   iree_allocator_t allocator;
 } iree_vm_bytecode_module_state_t;
 
+// Decompresses the rodata segment with the given |ordinal| into memory owned
+// by the segment and updates its entry in the rodata_ref_table.
+// Returns IREE_STATUS_DATA_LOSS if the segment contents are corrupt.
+iree_status_t iree_vm_bytecode_module_load_rodata(
+    iree_vm_bytecode_module_t* module,
+    iree_vm_bytecode_module_state_t* module_state, int32_t ordinal);
+
 // Begins (or resumes) execution of the given |entry_frame| and continues until
 // either a yield or return. |out_result| will contain the result status for
 // continuation, if needed.
@@ -18,10 +18,132 @@
 
 #include "iree/vm/bytecode_module.h"
 
+#include <cstring>
+#include <vector>
+
+#include "flatbuffers/flatbuffers.h"
+#include "iree/base/lz4.h"
+#include "iree/schemas/bytecode_module_def_generated.h"
 #include "iree/testing/gtest.h"
+#include "iree/vm/bytecode_module_impl.h"
+#include "iree/vm/types.h"
 
 namespace {
 
-// TODO(benvanik): bytecode_module_test.cc for flatbuffer/module implementation.
+using ::iree::vm::BytecodeModuleDefBuilder;
+using ::iree::vm::CompressionTypeDef;
+
+// Builds a module with a single empty function and two rodata segments
+// containing |contents|: the first uncompressed and the second LZ4 compressed.
+std::vector<uint8_t> BuildModuleWithRodata(
+    const std::vector<uint8_t>& contents) {
+  flatbuffers::FlatBufferBuilder fbb;
+
+  auto signature_def = iree::vm::CreateFunctionSignatureDef(fbb);
+  auto export_def = iree::vm::CreateExportFunctionDef(
+      fbb, fbb.CreateString("main"), signature_def, /*internal_ordinal=*/0);
+  auto internal_def = iree::vm::CreateInternalFunctionDef(
+      fbb, fbb.CreateString("main"), signature_def);
+  std::vector<iree::vm::FunctionDescriptor> function_descriptors = {
+      iree::vm::FunctionDescriptor(/*bytecode_offset=*/0,
+                                   /*bytecode_length=*/4,
+                                   /*i32_register_count=*/0,
+                                   /*ref_register_count=*/0)};
+  std::vector<uint8_t> bytecode_data(4, 0);
+
+  std::vector<uint8_t> compressed(iree::Lz4CompressBound(contents.size()));
+  compressed.resize(
+      iree::Lz4CompressBlock(contents, absl::MakeSpan(compressed)));
+  std::vector<flatbuffers::Offset<iree::vm::RodataSegmentDef>> rodata_defs = {
+      iree::vm::CreateRodataSegmentDef(
+          fbb, CompressionTypeDef::UncompressedDataDef,
+          iree::vm::CreateUncompressedDataDef(fbb).Union(),
+          fbb.CreateVector(contents)),
+      iree::vm::CreateRodataSegmentDef(
+          fbb, CompressionTypeDef::LZ4DataDef,
+          iree::vm::CreateLZ4DataDef(fbb, contents.size()).Union(),
+          fbb.CreateVector(compressed)),
+  };
+
+  auto name_offset = fbb.CreateString("module");
+  auto types_offset =
+      fbb.CreateVector(std::vector<flatbuffers::Offset<iree::vm::TypeDef>>{});
+  auto exports_offset = fbb.CreateVector(
+      std::vector<flatbuffers::Offset<iree::vm::ExportFunctionDef>>{
+          export_def});
+  auto internals_offset = fbb.CreateVector(
+      std::vector<flatbuffers::Offset<iree::vm::InternalFunctionDef>>{
+          internal_def});
+  auto rodata_offset = fbb.CreateVector(rodata_defs);
+  auto function_descriptors_offset =
+      fbb.CreateVectorOfStructs(function_descriptors);
+  auto bytecode_data_offset = fbb.CreateVector(bytecode_data);
+
+  BytecodeModuleDefBuilder module_def(fbb);
+  module_def.add_name(name_offset);
+  module_def.add_types(types_offset);
+  module_def.add_exported_functions(exports_offset);
+  module_def.add_internal_functions(internals_offset);
+  module_def.add_rodata_segments(rodata_offset);
+  module_def.add_function_descriptors(function_descriptors_offset);
+  module_def.add_bytecode_data(bytecode_data_offset);
+  iree::vm::FinishBytecodeModuleDefBuffer(fbb, module_def.Finish());
+  return std::vector<uint8_t>(fbb.GetBufferPointer(),
+                              fbb.GetBufferPointer() + fbb.GetSize());
+}
+
+// Rodata references must remain valid after the state that produced them and
+// the module owning their data have both been released, as happens when a
+// buffer wrapping a constant is held after its context is destroyed.
+TEST(BytecodeModuleTest, RodataOutlivesModule) {
+  ASSERT_EQ(IREE_STATUS_OK, iree_vm_register_builtin_types());
+
+  std::vector<uint8_t> contents(1024);
+  for (size_t i = 0; i < contents.size(); ++i) contents[i] = i % 7;
+  auto module_data = BuildModuleWithRodata(contents);
+
+  // The module frees its copy of the flatbuffer when destroyed so that any
+  // access after that is caught by the sanitizers.
+  uint8_t* flatbuffer_data = nullptr;
+  ASSERT_EQ(IREE_STATUS_OK,
+            iree_allocator_malloc(IREE_ALLOCATOR_SYSTEM, module_data.size(),
+                                  reinterpret_cast<void**>(&flatbuffer_data)));
+  std::memcpy(flatbuffer_data, module_data.data(), module_data.size());
+  iree_vm_module_t* module = nullptr;
+  ASSERT_EQ(IREE_STATUS_OK,
+            iree_vm_bytecode_module_create(
+                iree_const_byte_span_t{flatbuffer_data, module_data.size()},
+                IREE_ALLOCATOR_SYSTEM, IREE_ALLOCATOR_SYSTEM, &module));
+
+  iree_vm_module_state_t* module_state = nullptr;
+  ASSERT_EQ(IREE_STATUS_OK, module->alloc_state(module->self,
+                                                IREE_ALLOCATOR_SYSTEM,
+                                                &module_state));
+  auto* state =
+      reinterpret_cast<iree_vm_bytecode_module_state_t*>(module_state);
+  ASSERT_EQ(2, state->rodata_ref_count);
+  ASSERT_EQ(IREE_STATUS_OK,
+            iree_vm_bytecode_module_load_rodata(
+                reinterpret_cast<iree_vm_bytecode_module_t*>(module->self),
+                state, 1));
+  iree_vm_ref_t rodata_refs[2];
+  for (int i = 0; i < 2; ++i) {
+    rodata_refs[i] =
+        iree_vm_ro_byte_buffer_retain_ref(&state->rodata_ref_table[i]->buffer);
+  }
+
+  ASSERT_EQ(IREE_STATUS_OK, module->free_state(module->self, module_state));
+  iree_vm_module_release(module);
+
+  for (int i = 0; i < 2; ++i) {
+    iree_vm_ro_byte_buffer_t* rodata =
+        iree_vm_ro_byte_buffer_deref(&rodata_refs[i]);
+    ASSERT_NE(nullptr, rodata);
+    EXPECT_EQ(contents, std::vector<uint8_t>(
+                            rodata->data.data,
+                            rodata->data.data + rodata->data.data_length));
+    iree_vm_ref_release(&rodata_refs[i]);
+  }
+}
 
 }  // namespace
@@ -17,6 +17,7 @@
 #include <assert.h>
 #include <stdatomic.h>
 #include <stdbool.h>
+#include <string.h>
 
 struct iree_vm_context {
   atomic_intptr_t ref_count;
@@ -78,15 +79,21 @@ static iree_status_t iree_vm_context_resolve_module_imports(
 static iree_status_t iree_vm_invoke_empty_function(
     iree_vm_stack_t* stack, iree_vm_function_t function) {
   iree_vm_stack_frame_t* callee_frame = NULL;
-  iree_status_t status =
-      iree_vm_stack_function_enter(stack, function, &callee_frame);
+  iree_status_t status = iree_vm_stack_function_enter(
+      stack, function, /*i32_register_count=*/0, /*ref_register_count=*/0,
+      &callee_frame);
   if (!iree_status_is_ok(status)) {
     return status;
   }
 
+  // Initializers run synchronously and are resumed immediately if they yield.
   iree_vm_execution_result_t result;
-  status = function.module->execute(function.module->self, stack, callee_frame,
-                                    &result);
+  do {
+    memset(&result, 0, sizeof(result));
+    status = function.module->execute(function.module->self, stack,
+                                      callee_frame, &result);
+  } while (iree_status_is_ok(status) &&
+           (result.flags & IREE_VM_EXECUTION_RESULT_FLAG_YIELDED));
 
   iree_vm_stack_function_leave(stack);
   return IREE_STATUS_OK;
@@ -199,23 +206,20 @@ static iree_status_t iree_vm_context_destroy(iree_vm_context_t* context) {
   }
 
   if (context->list.count > 0) {
-    // Allocate a scratch stack used for initialization.
-    // If we shrunk the stack (or made it so that it could dynamically grow)
-    // then we could stack-allocate it here and not need the allocator at all.
-    iree_vm_stack_t* stack = NULL;
-    IREE_RETURN_IF_ERROR(iree_allocator_malloc(
-        context->allocator, sizeof(iree_vm_stack_t), (void**)&stack));
-    iree_status_t status =
-        iree_vm_stack_init(iree_vm_context_state_resolver(context), stack);
-    if (!iree_status_is_ok(status)) {
-      iree_allocator_free(context->allocator, stack);
-      return status;
-    }
+    // Scratch stack used for deinitialization. Frames are allocated from
+    // storage on the host stack and only spill to the heap if needed.
+    uint8_t stack_storage[IREE_VM_STACK_DEFAULT_INLINE_STORAGE_SIZE];
+    iree_byte_span_t stack_storage_span = {stack_storage,
+                                           sizeof(stack_storage)};
+    iree_vm_stack_t stack;
+    IREE_RETURN_IF_ERROR(
+        iree_vm_stack_init(iree_vm_context_state_resolver(context),
+                           stack_storage_span, context->allocator, &stack));
 
-    iree_vm_context_release_modules(context, stack, 0, context->list.count - 1);
+    iree_vm_context_release_modules(context, &stack, 0,
+                                    context->list.count - 1);
 
-    iree_vm_stack_deinit(stack);
-    iree_allocator_free(context->allocator, stack);
+    iree_vm_stack_deinit(&stack);
   }
 
   // Note: For non-static module lists, it is only dynamically allocated if
@@ -314,18 +318,15 @@ IREE_API_EXPORT iree_status_t IREE_API_CALL iree_vm_context_register_modules(
     context->list.capacity = new_capacity;
   }
 
-  // Allocate a scratch stack used for initialization.
-  // If we shrunk the stack (or made it so that it could dynamically grow)
-  // then we could stack-allocate it here and not need the allocator at all.
-  iree_vm_stack_t* stack = NULL;
-  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
-      context->allocator, sizeof(iree_vm_stack_t), (void**)&stack));
-  iree_status_t status =
-      iree_vm_stack_init(iree_vm_context_state_resolver(context), stack);
-  if (!iree_status_is_ok(status)) {
-    iree_allocator_free(context->allocator, stack);
-    return status;
-  }
+  // Scratch stack used for initialization. Frames are allocated from storage
+  // on the host stack and only spill to the heap if needed.
+  uint8_t stack_storage[IREE_VM_STACK_DEFAULT_INLINE_STORAGE_SIZE];
+  iree_byte_span_t stack_storage_span = {stack_storage, sizeof(stack_storage)};
+  iree_vm_stack_t stack_object;
+  iree_vm_stack_t* stack = &stack_object;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_stack_init(iree_vm_context_state_resolver(context),
+                         stack_storage_span, context->allocator, stack));
 
   // Retain all modules and allocate their state.
   assert(context->list.capacity >= context->list.count + module_count);
@@ -347,7 +348,6 @@ IREE_API_EXPORT iree_status_t IREE_API_CALL iree_vm_context_register_modules(
                                       orig_count + i);
       context->list.count = orig_count;
       iree_vm_stack_deinit(stack);
-      iree_allocator_free(context->allocator, stack);
       return alloc_status;
     }
     context->list.module_states[orig_count + i] = module_state;
@@ -362,7 +362,6 @@ IREE_API_EXPORT iree_status_t IREE_API_CALL iree_vm_context_register_modules(
                                       orig_count + i);
       context->list.count = orig_count;
       iree_vm_stack_deinit(stack);
-      iree_allocator_free(context->allocator, stack);
       return resolve_status;
     }
 
@@ -383,14 +382,12 @@ IREE_API_EXPORT iree_status_t IREE_API_CALL iree_vm_context_register_modules(
                                         orig_count + i);
         context->list.count = orig_count;
         iree_vm_stack_deinit(stack);
-        iree_allocator_free(context->allocator, stack);
         return init_status;
       }
     }
   }
 
   iree_vm_stack_deinit(stack);
-  iree_allocator_free(context->allocator, stack);
   return IREE_STATUS_OK;
 }
 
@@ -14,12 +14,31 @@
 
 #include "iree/vm/invocation.h"
 
+#include <stdatomic.h>
+#include <string.h>
+
+#include "iree/vm/stack.h"
+
 static iree_status_t iree_vm_validate_function_inputs(
     iree_vm_function_t function, iree_vm_variant_list_t* inputs) {
   // TODO(benvanik): validate inputs.
   return IREE_STATUS_OK;
 }
 
+static void iree_vm_count_input_registers(iree_vm_variant_list_t* inputs,
+                                          int32_t* out_i32_count,
+                                          int32_t* out_ref_count) {
+  iree_host_size_t count = iree_vm_variant_list_size(inputs);
+  int32_t ref_count = 0;
+  for (int i = 0; i < count; ++i) {
+    if (IREE_VM_VARIANT_IS_REF(iree_vm_variant_list_get(inputs, i))) {
+      ++ref_count;
+    }
+  }
+  *out_i32_count = (int32_t)count - ref_count;
+  *out_ref_count = ref_count;
+}
+
 static iree_status_t iree_vm_marshal_inputs(
     iree_vm_variant_list_t* inputs, iree_vm_stack_frame_t* callee_frame) {
   iree_vm_registers_t* registers = &callee_frame->registers;
@@ -36,7 +55,6 @@ static iree_status_t iree_vm_marshal_inputs(
       registers->i32[i32_reg++] = variant->i32;
     }
   }
-  registers->ref_register_count = ref_reg;
   return IREE_STATUS_OK;
 }
 
@@ -45,23 +63,23 @@ static iree_status_t iree_vm_marshal_outputs(
   iree_vm_registers_t* registers = &callee_frame->registers;
   const iree_vm_register_list_t* return_registers =
       callee_frame->return_registers;
+  if (!return_registers) return IREE_STATUS_OK;
   for (int i = 0; i < return_registers->size; ++i) {
     uint8_t reg = return_registers->registers[i];
     if (reg & IREE_REF_REGISTER_TYPE_BIT) {
       // Always move (as the stack frame will be destroyed soon).
       IREE_RETURN_IF_ERROR(iree_vm_variant_list_append_ref_move(
-          outputs, &registers->ref[reg & IREE_REF_REGISTER_MASK]));
+          outputs, &registers->ref[reg & registers->ref_mask]));
     } else {
       iree_vm_value_t value;
       value.type = IREE_VM_VALUE_TYPE_I32;
-      value.i32 = registers->i32[reg & IREE_I32_REGISTER_MASK];
+      value.i32 = registers->i32[reg & registers->i32_mask];
       IREE_RETURN_IF_ERROR(iree_vm_variant_list_append_value(outputs, value));
     }
   }
   return IREE_STATUS_OK;
 }
 
-// TODO(benvanik): implement this as an iree_vm_invocation_t sequence.
 IREE_API_EXPORT iree_status_t IREE_API_CALL iree_vm_invoke(
     iree_vm_context_t* context, iree_vm_function_t function,
     const iree_vm_invocation_policy_t* policy, iree_vm_variant_list_t* inputs,
@@ -71,33 +89,40 @@ IREE_API_EXPORT iree_status_t IREE_API_CALL iree_vm_invoke(
   // TODO(benvanik): validate outputs capacity.
   IREE_RETURN_IF_ERROR(iree_vm_validate_function_inputs(function, inputs));
 
-  // Allocate a stack on the heap and initialize it.
-  // If we shrunk the stack (or made it so that it could dynamically grow)
-  // then we could stack-allocate it here and not need the allocator at all.
-  iree_vm_stack_t* stack = NULL;
-  IREE_RETURN_IF_ERROR(iree_allocator_malloc(allocator, sizeof(iree_vm_stack_t),
-                                             (void**)&stack));
-  iree_status_t status =
-      iree_vm_stack_init(iree_vm_context_state_resolver(context), stack);
-  if (!iree_status_is_ok(status)) {
-    iree_allocator_free(allocator, stack);
-    return status;
-  }
+  // Frames are allocated from storage on the host stack and only spill to the
+  // heap for deep call chains.
+  uint8_t stack_storage[IREE_VM_STACK_DEFAULT_INLINE_STORAGE_SIZE];
+  iree_byte_span_t stack_storage_span = {stack_storage, sizeof(stack_storage)};
+  iree_vm_stack_t stack;
+  IREE_RETURN_IF_ERROR(iree_vm_stack_init(
+      iree_vm_context_state_resolver(context), stack_storage_span, allocator,
+      &stack));
 
+  // The callee will grow the frame as needed for its locals and results.
+  int32_t i32_register_count = 0;
+  int32_t ref_register_count = 0;
+  if (inputs) {
+    iree_vm_count_input_registers(inputs, &i32_register_count,
+                                  &ref_register_count);
+  }
   iree_vm_stack_frame_t* callee_frame = NULL;
-  status = iree_vm_stack_function_enter(stack, function, &callee_frame);
+  iree_status_t status =
+      iree_vm_stack_function_enter(&stack, function, i32_register_count,
+                                   ref_register_count, &callee_frame);
 
   // Marshal inputs.
   if (iree_status_is_ok(status) && inputs) {
     status = iree_vm_marshal_inputs(inputs, callee_frame);
   }
 
-  // Perform execution. Note that for synchronous execution we expect this to
-  // complete without yielding.
-  if (iree_status_is_ok(status)) {
+  // Perform execution. Synchronous execution resumes immediately if the
+  // function yields.
+  while (iree_status_is_ok(status)) {
     iree_vm_execution_result_t result;
-    status = function.module->execute(function.module->self, stack,
+    memset(&result, 0, sizeof(result));
+    status = function.module->execute(function.module->self, &stack,
                                       callee_frame, &result);
+    if (!(result.flags & IREE_VM_EXECUTION_RESULT_FLAG_YIELDED)) break;
   }
 
   // Marshal outputs.
@@ -105,8 +130,345 @@ IREE_API_EXPORT iree_status_t IREE_API_CALL iree_vm_invoke(
     status = iree_vm_marshal_outputs(callee_frame, outputs);
   }
 
-  iree_vm_stack_function_leave(stack);
-  iree_vm_stack_deinit(stack);
-  iree_allocator_free(allocator, stack);
+  if (callee_frame) {
+    iree_vm_stack_function_leave(&stack);
+  }
+  iree_vm_stack_deinit(&stack);
   return status;
 }
+
+//===----------------------------------------------------------------------===//
+// iree_vm_invocation_t
+//===----------------------------------------------------------------------===//
+
+struct iree_vm_invocation {
+  atomic_intptr_t ref_count;
+  iree_allocator_t allocator;
+  iree_vm_context_t* context;
+  iree_vm_function_t function;
+
+  // Policy the invocation is queued in, if any. The policy holds a reference
+  // to the invocation while it is queued.
+  iree_vm_invocation_policy_t* policy;
+  // Next invocation in the policy queue.
+  iree_vm_invocation_t* next;
+
+  // IREE_STATUS_UNAVAILABLE until the invocation completes.
+  iree_status_t status;
+  // Nonzero while the invocation is executing; used to reject re-entrant
+  // awaits and aborts.
+  int is_executing;
+  // Outputs of the invocation, valid once completed successfully.
+  iree_vm_variant_list_t* outputs;
+  // Issued once when |status| leaves IREE_STATUS_UNAVAILABLE, if set.
+  iree_vm_invocation_completion_callback_t completion_callback;
+
+  // Fiber stack retaining all execution state between resumes. Frames are
+  // allocated from |stack_storage| and only spill to the heap for deep call
+  // chains.
+  iree_vm_stack_t stack;
+  iree_vm_stack_frame_t* entry_frame;
+  uint8_t stack_storage[IREE_VM_STACK_DEFAULT_INLINE_STORAGE_SIZE];
+};
+
+struct iree_vm_invocation_policy {
+  atomic_intptr_t ref_count;
+  iree_allocator_t allocator;
+  // FIFO queue of retained invocations.
+  iree_vm_invocation_t* head;
+  iree_vm_invocation_t* tail;
+  // Nonzero while iree_vm_invocation_policy_run is executing.
+  int is_running;
+};
+
+// Marks |invocation| as completed with |status|, releasing its stack and
+// issuing the completion callback if this is the first time it completed.
+static void iree_vm_invocation_complete(iree_vm_invocation_t* invocation,
+                                        iree_status_t status) {
+  if (invocation->entry_frame) {
+    iree_vm_stack_deinit(&invocation->stack);
+    invocation->entry_frame = NULL;
+  }
+  int was_pending = invocation->status == IREE_STATUS_UNAVAILABLE;
+  invocation->status = status;
+  if (was_pending && invocation->completion_callback.fn) {
+    iree_vm_invocation_completion_callback_t callback =
+        invocation->completion_callback;
+    memset(&invocation->completion_callback, 0,
+           sizeof(invocation->completion_callback));
+    callback.fn(callback.self, invocation);
+  }
+}
+
+// Executes |invocation| until it completes or yields.
+static void iree_vm_invocation_resume(iree_vm_invocation_t* invocation) {
+  invocation->is_executing = 1;
+  iree_vm_execution_result_t result;
+  memset(&result, 0, sizeof(result));
+  iree_status_t status = invocation->function.module->execute(
+      invocation->function.module->self, &invocation->stack,
+      invocation->entry_frame, &result);
+  invocation->is_executing = 0;
+  if (invocation->status != IREE_STATUS_UNAVAILABLE) {
+    // Aborted while executing.
+    return;
+  } else if (iree_status_is_ok(status) &&
+             (result.flags & IREE_VM_EXECUTION_RESULT_FLAG_YIELDED)) {
+    // Still pending; the stack holds the state required to resume.
+    return;
+  }
+
+  if (iree_status_is_ok(status)) {
+    const iree_vm_register_list_t* return_registers =
+        invocation->entry_frame->return_registers;
+    status = iree_vm_variant_list_alloc(
+        return_registers ? return_registers->size : 0, invocation->allocator,
+        &invocation->outputs);
+  }
+  if (iree_status_is_ok(status)) {
+    status = iree_vm_marshal_outputs(invocation->entry_frame,
+                                     invocation->outputs);
+  }
+  iree_vm_invocation_complete(invocation, status);
+}
+
+static void iree_vm_invocation_policy_enqueue(
+    iree_vm_invocation_policy_t* policy, iree_vm_invocation_t* invocation) {
+  invocation->next = NULL;
+  if (policy->tail) {
+    policy->tail->next = invocation;
+  } else {
+    policy->head = invocation;
+  }
+  policy->tail = invocation;
+}
+
+IREE_API_EXPORT iree_status_t IREE_API_CALL iree_vm_invocation_policy_create(
+    iree_allocator_t allocator, iree_vm_invocation_policy_t** out_policy) {
+  if (!out_policy) return IREE_STATUS_INVALID_ARGUMENT;
+  *out_policy = NULL;
+
+  iree_vm_invocation_policy_t* policy = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      allocator, sizeof(iree_vm_invocation_policy_t), (void**)&policy));
+  atomic_store(&policy->ref_count, 1);
+  policy->allocator = allocator;
+
+  *out_policy = policy;
+  return IREE_STATUS_OK;
+}
+
+static void iree_vm_invocation_policy_destroy(
+    iree_vm_invocation_policy_t* policy) {
+  iree_vm_invocation_t* invocation = policy->head;
+  while (invocation) {
+    iree_vm_invocation_t* next = invocation->next;
+    if (invocation->status == IREE_STATUS_UNAVAILABLE) {
+      iree_vm_invocation_complete(invocation, IREE_STATUS_ABORTED);
+    }
+    invocation->policy = NULL;
+    invocation->next = NULL;
+    iree_vm_invocation_release(invocation);
+    invocation = next;
+  }
+  iree_allocator_free(policy->allocator, policy);
+}
+
+IREE_API_EXPORT iree_status_t IREE_API_CALL
+iree_vm_invocation_policy_retain(iree_vm_invocation_policy_t* policy) {
+  if (!policy) return IREE_STATUS_INVALID_ARGUMENT;
+  atomic_fetch_add(&policy->ref_count, 1);
+  return IREE_STATUS_OK;
+}
+
+IREE_API_EXPORT iree_status_t IREE_API_CALL
+iree_vm_invocation_policy_release(iree_vm_invocation_policy_t* policy) {
+  if (policy && atomic_fetch_sub(&policy->ref_count, 1) == 1) {
+    iree_vm_invocation_policy_destroy(policy);
+  }
+  return IREE_STATUS_OK;
+}
+
+IREE_API_EXPORT iree_status_t IREE_API_CALL iree_vm_invocation_policy_run(
+    iree_vm_invocation_policy_t* policy, iree_host_size_t* out_pending_count) {
+  if (!policy) return IREE_STATUS_INVALID_ARGUMENT;
+  if (out_pending_count) *out_pending_count = 0;
+  if (policy->is_running) return IREE_STATUS_FAILED_PRECONDITION;
+  policy->is_running = 1;
+
+  // Detach the current queue so that yielded invocations are requeued behind
+  // any queued while running and each only executes once per run.
+  iree_vm_invocation_t* invocation = policy->head;
+  policy->head = NULL;
+  policy->tail = NULL;
+  while (invocation) {
+    iree_vm_invocation_t* next = invocation->next;
+    if (invocation->status == IREE_STATUS_UNAVAILABLE) {
+      iree_vm_invocation_resume(invocation);
+    }
+    if (invocation->status == IREE_STATUS_UNAVAILABLE) {
+      iree_vm_invocation_policy_enqueue(policy, invocation);
+    } else {
+      // Completed (or aborted); drop the queue reference.
+      invocation->policy = NULL;
+      invocation->next = NULL;
+      iree_vm_invocation_release(invocation);
+    }
+    invocation = next;
+  }
+
+  if (out_pending_count) {
+    for (invocation = policy->head; invocation; invocation = invocation->next) {
+      ++*out_pending_count;
+    }
+  }
+  policy->is_running = 0;
+  return IREE_STATUS_OK;
+}
+
+IREE_API_EXPORT iree_status_t IREE_API_CALL iree_vm_invocation_create(
+    iree_vm_context_t* context, iree_vm_function_t function,
+    iree_vm_invocation_policy_t* policy, const iree_vm_variant_list_t* inputs,
+    iree_allocator_t allocator, iree_vm_invocation_t** out_invocation) {
+  if (!context || !function.module || !out_invocation) {
+    return IREE_STATUS_INVALID_ARGUMENT;
+  }
+  *out_invocation = NULL;
+  // NOTE: the variant list accessors are not const but we do not modify it.
+  iree_vm_variant_list_t* mutable_inputs = (iree_vm_variant_list_t*)inputs;
+  IREE_RETURN_IF_ERROR(
+      iree_vm_validate_function_inputs(function, mutable_inputs));
+
+  iree_vm_invocation_t* invocation = NULL;
+  IREE_RETURN_IF_ERROR(iree_allocator_malloc(
+      allocator, sizeof(iree_vm_invocation_t), (void**)&invocation));
+  atomic_store(&invocation->ref_count, 1);
+  invocation->allocator = allocator;
+  invocation->context = context;
+  iree_vm_context_retain(context);
+  invocation->function = function;
+  invocation->status = IREE_STATUS_UNAVAILABLE;
+
+  iree_byte_span_t stack_storage_span = {invocation->stack_storage,
+                                         sizeof(invocation->stack_storage)};
+  iree_status_t status = iree_vm_stack_init(
+      iree_vm_context_state_resolver(context), stack_storage_span, allocator,
+      &invocation->stack);
+
+  // The callee will grow the frame as needed for its locals and results.
+  if (iree_status_is_ok(status)) {
+    int32_t i32_register_count = 0;
+    int32_t ref_register_count = 0;
+    if (inputs) {
+      iree_vm_count_input_registers(mutable_inputs, &i32_register_count,
+                                    &ref_register_count);
+    }
+    status = iree_vm_stack_function_enter(
+        &invocation->stack, function, i32_register_count, ref_register_count,
+        &invocation->entry_frame);
+  }
+  if (iree_status_is_ok(status) && inputs) {
+    status = iree_vm_marshal_inputs(mutable_inputs, invocation->entry_frame);
+  }
+  if (!iree_status_is_ok(status)) {
+    iree_vm_invocation_complete(invocation, status);
+    iree_vm_invocation_release(invocation);
+    return status;
+  }
+
+  if (policy) {
+    // The policy retains the invocation until it completes.
+    iree_vm_invocation_retain(invocation);
+    invocation->policy = policy;
+    iree_vm_invocation_policy_enqueue(policy, invocation);
+  } else {
+    iree_vm_invocation_resume(invocation);
+  }
+
+  *out_invocation = invocation;
+  return IREE_STATUS_OK;
+}
+
+static void iree_vm_invocation_destroy(iree_vm_invocation_t* invocation) {
+  iree_vm_invocation_complete(invocation, IREE_STATUS_ABORTED);
+  if (invocation->outputs) {
+    iree_vm_variant_list_free(invocation->outputs);
+  }
+  iree_vm_context_release(invocation->context);
+  iree_allocator_free(invocation->allocator, invocation);
+}
+
+IREE_API_EXPORT iree_status_t IREE_API_CALL
+iree_vm_invocation_retain(iree_vm_invocation_t* invocation) {
+  if (!invocation) return IREE_STATUS_INVALID_ARGUMENT;
+  atomic_fetch_add(&invocation->ref_count, 1);
+  return IREE_STATUS_OK;
+}
+
+IREE_API_EXPORT iree_status_t IREE_API_CALL
+iree_vm_invocation_release(iree_vm_invocation_t* invocation) {
+  if (invocation && atomic_fetch_sub(&invocation->ref_count, 1) == 1) {
+    iree_vm_invocation_destroy(invocation);
+  }
+  return IREE_STATUS_OK;
+}
+
+IREE_API_EXPORT iree_status_t IREE_API_CALL
+iree_vm_invocation_query_status(iree_vm_invocation_t* invocation) {
+  if (!invocation) return IREE_STATUS_INVALID_ARGUMENT;
+  return invocation->status;
+}
+
+IREE_API_EXPORT const iree_vm_variant_list_t* IREE_API_CALL
+iree_vm_invocation_output(iree_vm_invocation_t* invocation) {
+  if (!invocation || !iree_status_is_ok(invocation->status)) return NULL;
+  return invocation->outputs;
+}
+
+IREE_API_EXPORT iree_status_t IREE_API_CALL iree_vm_invocation_await(
+    iree_vm_invocation_t* invocation, iree_time_t deadline) {
+  if (!invocation) return IREE_STATUS_INVALID_ARGUMENT;
+  while (invocation->status == IREE_STATUS_UNAVAILABLE) {
+    if (invocation->is_executing) return IREE_STATUS_FAILED_PRECONDITION;
+    if (deadline == IREE_TIME_INFINITE_PAST ||
+        (deadline != IREE_TIME_INFINITE_FUTURE &&
+         iree_time_now() >= deadline)) {
+      return IREE_STATUS_DEADLINE_EXCEEDED;
+    }
+    if (invocation->policy) {
+      // Drive the whole policy so that invocations queued ahead of us (which
+      // we may depend on) make progress too.
+      IREE_RETURN_IF_ERROR(
+          iree_vm_invocation_policy_run(invocation->policy, NULL));
+    } else {
+      iree_vm_invocation_resume(invocation);
+    }
+  }
+  return invocation->status;
+}
+
+IREE_API_EXPORT iree_status_t IREE_API_CALL
+iree_vm_invocation_set_completion_callback(
+    iree_vm_invocation_t* invocation,
+    iree_vm_invocation_completion_callback_t callback) {
+  if (!invocation || !callback.fn) return IREE_STATUS_INVALID_ARGUMENT;
+  if (invocation->completion_callback.fn) {
+    return IREE_STATUS_FAILED_PRECONDITION;
+  }
+  if (invocation->status != IREE_STATUS_UNAVAILABLE) {
+    callback.fn(callback.self, invocation);
+    return IREE_STATUS_OK;
+  }
+  invocation->completion_callback = callback;
+  return IREE_STATUS_OK;
+}
+
+IREE_API_EXPORT iree_status_t IREE_API_CALL
+iree_vm_invocation_abort(iree_vm_invocation_t* invocation) {
+  if (!invocation) return IREE_STATUS_INVALID_ARGUMENT;
+  if (invocation->status != IREE_STATUS_UNAVAILABLE) return IREE_STATUS_OK;
+  if (invocation->is_executing) return IREE_STATUS_FAILED_PRECONDITION;
+  // The policy drops its reference the next time it runs.
+  iree_vm_invocation_complete(invocation, IREE_STATUS_ABORTED);
+  return IREE_STATUS_OK;
+}
@@ -29,6 +29,14 @@ extern "C" {
 typedef struct iree_vm_invocation iree_vm_invocation_t;
 typedef struct iree_vm_invocation_policy iree_vm_invocation_policy_t;
 
+// Callback issued once an invocation completes (successfully or otherwise).
+// The invocation is valid only for the duration of the call and callbacks
+// must not execute, await, or release it.
+typedef struct {
+  void* self;
+  void(IREE_API_PTR* fn)(void* self, iree_vm_invocation_t* invocation);
+} iree_vm_invocation_completion_callback_t;
+
 #ifndef IREE_API_NO_PROTOTYPES
 
 // Synchronously invokes a function in the VM.
@@ -44,23 +52,69 @@ typedef struct iree_vm_invocation_policy iree_vm_invocation_policy_t;
 // |outputs| is populated after the function completes execution with the
 // output values and objects of the function. List ownership remains with the
 // caller.
+//
+// If the function yields it is immediately resumed on the calling thread.
 IREE_API_EXPORT iree_status_t IREE_API_CALL iree_vm_invoke(
     iree_vm_context_t* context, iree_vm_function_t function,
     const iree_vm_invocation_policy_t* policy, iree_vm_variant_list_t* inputs,
     iree_vm_variant_list_t* outputs, iree_allocator_t allocator);
 
-// TODO(benvanik): document and implement.
+// Creates a cooperative invocation policy.
+//
+// Invocations created with the policy are queued and executed in FIFO order
+// by iree_vm_invocation_policy_run (or when awaited). Each invocation runs
+// until it either completes or yields, and invocations that yield are moved to
+// the back of the queue. This allows a single thread to multiplex any number
+// of in-flight invocations, each of which keeps its execution state in its own
+// iree_vm_stack_t.
+//
+// Policies and the invocations scheduled with them are not thread-safe and
+// must only be used from one thread at a time.
+IREE_API_EXPORT iree_status_t IREE_API_CALL iree_vm_invocation_policy_create(
+    iree_allocator_t allocator, iree_vm_invocation_policy_t** out_policy);
+
+// Retains the given |policy| for the caller.
+IREE_API_EXPORT iree_status_t IREE_API_CALL
+iree_vm_invocation_policy_retain(iree_vm_invocation_policy_t* policy);
+
+// Releases the given |policy| from the caller.
+// Any invocations still pending when the last reference is released are
+// aborted.
+IREE_API_EXPORT iree_status_t IREE_API_CALL
+iree_vm_invocation_policy_release(iree_vm_invocation_policy_t* policy);
+
+// Executes each invocation pending in |policy| until it yields or completes.
+// Invocations queued while running will execute on the next call.
+// |out_pending_count| is optional and receives the number of invocations that
+// are still pending.
+//
+// Returns IREE_STATUS_FAILED_PRECONDITION if called re-entrantly from an
+// invocation executing under the same policy.
+IREE_API_EXPORT iree_status_t IREE_API_CALL iree_vm_invocation_policy_run(
+    iree_vm_invocation_policy_t* policy, iree_host_size_t* out_pending_count);
+
+// Creates an asynchronous invocation of |function|.
+//
+// |inputs| is marshaled into the invocation prior to returning and ownership
+// remains with the caller.
+//
+// If |policy| is provided the invocation is queued and runs as the policy is
+// executed. Otherwise the invocation begins executing on the calling thread
+// and runs until it completes or yields; yielded invocations resume when
+// awaited.
+//
+// |out_invocation| must be released by the caller.
 IREE_API_EXPORT iree_status_t IREE_API_CALL iree_vm_invocation_create(
     iree_vm_context_t* context, iree_vm_function_t function,
-    const iree_vm_invocation_policy_t* policy,
-    const iree_vm_variant_list_t* inputs, iree_allocator_t allocator,
-    iree_vm_invocation_t** out_invocation);
+    iree_vm_invocation_policy_t* policy, const iree_vm_variant_list_t* inputs,
+    iree_allocator_t allocator, iree_vm_invocation_t** out_invocation);
 
 // Retains the given |invocation| for the caller.
 IREE_API_EXPORT iree_status_t IREE_API_CALL
 iree_vm_invocation_retain(iree_vm_invocation_t* invocation);
 
 // Releases the given |invocation| from the caller.
+// Invocations queued with a policy remain queued until they complete.
 IREE_API_EXPORT iree_status_t IREE_API_CALL
 iree_vm_invocation_release(iree_vm_invocation_t* invocation);
 
@@ -84,14 +138,36 @@ IREE_API_EXPORT const iree_vm_variant_list_t* IREE_API_CALL
 iree_vm_invocation_output(iree_vm_invocation_t* invocation);
 
 // Blocks the caller until the invocation completes (successfully or otherwise).
+// As execution is cooperative the caller drives the invocation (and any other
+// invocations pending in the same policy) while waiting.
 //
 // Returns IREE_STATUS_DEADLINE_EXCEEDED if |deadline| elapses before the
 // invocation completes and otherwise returns iree_vm_invocation_query_status.
+// Pass IREE_TIME_INFINITE_PAST to poll without executing.
 IREE_API_EXPORT iree_status_t IREE_API_CALL iree_vm_invocation_await(
     iree_vm_invocation_t* invocation, iree_time_t deadline);
 
+// Registers |callback| to be issued when the invocation completes.
+// The callback is issued on the thread completing the invocation: the thread
+// executing it (the creating thread, iree_vm_invocation_policy_run, or
+// iree_vm_invocation_await), the thread aborting it, or the thread releasing
+// the last reference to it or its policy. If the invocation has already
+// completed the callback is issued immediately on the calling thread.
+//
+// This allows threads other than the one driving the invocation to wait on it;
+// see iree/vm/invocation_cc.h for an adapter to iree::WaitHandle.
+//
+// Returns IREE_STATUS_FAILED_PRECONDITION if a callback is already registered.
+IREE_API_EXPORT iree_status_t IREE_API_CALL
+iree_vm_invocation_set_completion_callback(
+    iree_vm_invocation_t* invocation,
+    iree_vm_invocation_completion_callback_t callback);
+
 // Attempts to abort the invocation if it is in-flight.
 // A no-op if the invocation has already completed.
+//
+// Returns IREE_STATUS_FAILED_PRECONDITION if called from within the
+// invocation while it is executing.
 IREE_API_EXPORT iree_status_t IREE_API_CALL
 iree_vm_invocation_abort(iree_vm_invocation_t* invocation);
 
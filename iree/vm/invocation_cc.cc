@@ -0,0 +1,57 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "iree/vm/invocation_cc.h"
+
+// WaitHandle is not yet available on Windows (google/iree/65); callers there
+// must use iree_vm_invocation_set_completion_callback directly.
+#if !defined(IREE_PLATFORM_WINDOWS)
+
+#include "iree/base/api_util.h"
+#include "iree/base/logging.h"
+
+namespace iree {
+namespace vm {
+
+StatusOr<WaitHandle> InvocationCompletionWaitHandle(
+    iree_vm_invocation_t* invocation) {
+  auto event = make_ref<ManualResetEvent>("VMInvocation");
+  WaitHandle wait_handle = event->OnSet();
+
+  // The callback adopts the reference released into |self| and is issued
+  // exactly once, even if the invocation has already completed.
+  iree_vm_invocation_completion_callback_t callback;
+  callback.self = event.release();
+  callback.fn = +[](void* self, iree_vm_invocation_t* invocation) {
+    auto event = assign_ref(reinterpret_cast<ManualResetEvent*>(self));
+    Status status = event->Set();
+    if (!status.ok()) {
+      LOG(ERROR) << "Failed to signal invocation completion: " << status;
+    }
+  };
+  Status status = FromApiStatus(
+      iree_vm_invocation_set_completion_callback(invocation, callback),
+      IREE_LOC);
+  if (!status.ok()) {
+    assign_ref(reinterpret_cast<ManualResetEvent*>(callback.self));
+    return status;
+  }
+  return wait_handle;
+}
+
+}  // namespace vm
+}  // namespace iree
+
+#endif  // !IREE_PLATFORM_WINDOWS
@@ -0,0 +1,52 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef IREE_VM_INVOCATION_CC_H_
+#define IREE_VM_INVOCATION_CC_H_
+
+#include "iree/base/status.h"
+#include "iree/base/target_platform.h"
+#include "iree/vm/invocation.h"
+
+#if !defined(IREE_PLATFORM_WINDOWS)
+#include "iree/base/wait_handle.h"
+#endif  // !IREE_PLATFORM_WINDOWS
+
+#ifndef __cplusplus
+#error "This header is meant for use with C++ implementations."
+#endif  // __cplusplus
+
+namespace iree {
+namespace vm {
+
+#if !defined(IREE_PLATFORM_WINDOWS)
+
+// Returns a WaitHandle that is signaled when |invocation| completes
+// (successfully or otherwise). The handle may be waited on from any thread,
+// including alongside other handles with WaitHandle::WaitAny, while another
+// thread drives the invocation or its policy.
+//
+// Registers the completion callback of |invocation|, so at most one handle may
+// be created per invocation. Returns FAILED_PRECONDITION if a completion
+// callback is already registered.
+StatusOr<WaitHandle> InvocationCompletionWaitHandle(
+    iree_vm_invocation_t* invocation);
+
+#endif  // !IREE_PLATFORM_WINDOWS
+
+}  // namespace vm
+}  // namespace iree
+
+#endif  // IREE_VM_INVOCATION_CC_H_
@@ -0,0 +1,472 @@
+// Copyright 2019 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "iree/vm/invocation.h"
+
+#include <cstring>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/time/time.h"
+#include "iree/base/api.h"
+#include "iree/base/logging.h"
+#include "iree/base/status_matchers.h"
+#include "iree/base/target_platform.h"
+#include "iree/testing/gtest.h"
+#include "iree/vm/context.h"
+#include "iree/vm/instance.h"
+#include "iree/vm/invocation_cc.h"
+#include "iree/vm/module.h"
+#include "iree/vm/stack.h"
+#include "iree/vm/variant_list.h"
+
+#if !defined(IREE_PLATFORM_WINDOWS)
+#include "iree/base/wait_handle.h"
+#endif  // !IREE_PLATFORM_WINDOWS
+
+namespace {
+
+// Module with functions that yield |ordinal| times before returning their
+// i32 argument plus the number of times they yielded. The frame offset is
+// used to track the yield count across resumes as the bytecode module does
+// with its program counter.
+class YieldingModule {
+ public:
+  YieldingModule() {
+    IREE_CHECK_OK(iree_vm_module_init(&interface_, this));
+    interface_.destroy = +[](void* self) -> iree_status_t {
+      return IREE_STATUS_OK;
+    };
+    interface_.signature = +[](void* self) {
+      iree_vm_module_signature_t signature = {0, 0, 0};
+      return signature;
+    };
+    interface_.lookup_function =
+        +[](void* self, iree_vm_function_linkage_t linkage,
+            iree_string_view_t name,
+            iree_vm_function_t* out_function) -> iree_status_t {
+          return IREE_STATUS_NOT_FOUND;
+        };
+    interface_.alloc_state =
+        +[](void* self, iree_allocator_t allocator,
+            iree_vm_module_state_t** out_module_state) -> iree_status_t {
+          *out_module_state = nullptr;
+          return IREE_STATUS_OK;
+        };
+    interface_.free_state =
+        +[](void* self, iree_vm_module_state_t* module_state) -> iree_status_t {
+          return IREE_STATUS_OK;
+        };
+    interface_.execute =
+        +[](void* self, iree_vm_stack_t* stack, iree_vm_stack_frame_t* frame,
+            iree_vm_execution_result_t* out_result) {
+          return reinterpret_cast<YieldingModule*>(self)->Execute(
+              stack, frame, out_result);
+        };
+  }
+
+  iree_vm_module_t* interface() { return &interface_; }
+
+  iree_vm_function_t function(int yield_count) {
+    iree_vm_function_t function;
+    function.module = &interface_;
+    function.linkage = IREE_VM_FUNCTION_LINKAGE_EXPORT;
+    function.ordinal = yield_count;
+    return function;
+  }
+
+  // Input argument of each execute call in order.
+  const std::vector<int32_t>& execution_log() const { return execution_log_; }
+
+ private:
+  iree_status_t Execute(iree_vm_stack_t* stack, iree_vm_stack_frame_t* frame,
+                        iree_vm_execution_result_t* out_result) {
+    if (frame->offset == 0) {
+      // The caller only sized the frame for the argument.
+      IREE_RETURN_IF_ERROR(iree_vm_stack_frame_reserve_registers(
+          stack, frame, /*i32_register_count=*/2, /*ref_register_count=*/0));
+    }
+    execution_log_.push_back(frame->registers.i32[0]);
+    if (frame->offset < frame->function.ordinal) {
+      ++frame->offset;
+      out_result->flags = IREE_VM_EXECUTION_RESULT_FLAG_YIELDED;
+      return IREE_STATUS_OK;
+    }
+    frame->registers.i32[1] = frame->registers.i32[0] + frame->offset;
+    frame->return_registers =
+        reinterpret_cast<const iree_vm_register_list_t*>(kReturnRegisters);
+    return IREE_STATUS_OK;
+  }
+
+  static constexpr uint8_t kReturnRegisters[2] = {1, 1};
+
+  iree_vm_module_t interface_;
+  std::vector<int32_t> execution_log_;
+};
+
+constexpr uint8_t YieldingModule::kReturnRegisters[2];
+
+class VMInvocationTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    IREE_ASSERT_OK(iree_vm_instance_create(IREE_ALLOCATOR_SYSTEM, &instance_));
+    iree_vm_module_t* modules[] = {module_.interface()};
+    IREE_ASSERT_OK(iree_vm_context_create_with_modules(
+        instance_, modules, 1, IREE_ALLOCATOR_SYSTEM, &context_));
+  }
+
+  void TearDown() override {
+    iree_vm_context_release(context_);
+    iree_vm_instance_release(instance_);
+  }
+
+  // Returns a new input list containing the i32 |value|.
+  iree_vm_variant_list_t* MakeInputs(int32_t value) {
+    iree_vm_variant_list_t* inputs = nullptr;
+    IREE_CHECK_OK(
+        iree_vm_variant_list_alloc(1, IREE_ALLOCATOR_SYSTEM, &inputs));
+    iree_vm_value_t input_value;
+    input_value.type = IREE_VM_VALUE_TYPE_I32;
+    input_value.i32 = value;
+    IREE_CHECK_OK(iree_vm_variant_list_append_value(inputs, input_value));
+    return inputs;
+  }
+
+  // Returns the single i32 output of |invocation|.
+  int32_t GetOutput(iree_vm_invocation_t* invocation) {
+    auto* outputs = const_cast<iree_vm_variant_list_t*>(
+        iree_vm_invocation_output(invocation));
+    CHECK(outputs);
+    CHECK_EQ(1, iree_vm_variant_list_size(outputs));
+    return iree_vm_variant_list_get(outputs, 0)->i32;
+  }
+
+  YieldingModule module_;
+  iree_vm_instance_t* instance_ = nullptr;
+  iree_vm_context_t* context_ = nullptr;
+};
+
+// Synchronous invocations resume immediately when the function yields.
+TEST_F(VMInvocationTest, InvokeResumesYields) {
+  iree_vm_variant_list_t* inputs = MakeInputs(5);
+  iree_vm_variant_list_t* outputs = nullptr;
+  IREE_ASSERT_OK(
+      iree_vm_variant_list_alloc(1, IREE_ALLOCATOR_SYSTEM, &outputs));
+  IREE_ASSERT_OK(iree_vm_invoke(context_, module_.function(3), nullptr, inputs,
+                                outputs, IREE_ALLOCATOR_SYSTEM));
+  ASSERT_EQ(1, iree_vm_variant_list_size(outputs));
+  EXPECT_EQ(8, iree_vm_variant_list_get(outputs, 0)->i32);
+  EXPECT_EQ(4, module_.execution_log().size());
+  iree_vm_variant_list_free(inputs);
+  iree_vm_variant_list_free(outputs);
+}
+
+// Invocations without a policy execute during creation.
+TEST_F(VMInvocationTest, NoPolicyCompletesImmediately) {
+  iree_vm_variant_list_t* inputs = MakeInputs(5);
+  iree_vm_invocation_t* invocation = nullptr;
+  IREE_ASSERT_OK(iree_vm_invocation_create(context_, module_.function(0),
+                                           nullptr, inputs,
+                                           IREE_ALLOCATOR_SYSTEM, &invocation));
+  iree_vm_variant_list_free(inputs);
+  IREE_EXPECT_OK(iree_vm_invocation_query_status(invocation));
+  EXPECT_EQ(5, GetOutput(invocation));
+  IREE_EXPECT_OK(iree_vm_invocation_await(invocation, IREE_TIME_INFINITE_PAST));
+  iree_vm_invocation_release(invocation);
+}
+
+// Invocations without a policy that yield are resumed by await.
+TEST_F(VMInvocationTest, NoPolicyAwaitResumes) {
+  iree_vm_variant_list_t* inputs = MakeInputs(5);
+  iree_vm_invocation_t* invocation = nullptr;
+  IREE_ASSERT_OK(iree_vm_invocation_create(context_, module_.function(2),
+                                           nullptr, inputs,
+                                           IREE_ALLOCATOR_SYSTEM, &invocation));
+  iree_vm_variant_list_free(inputs);
+  EXPECT_EQ(IREE_STATUS_UNAVAILABLE,
+            iree_vm_invocation_query_status(invocation));
+  EXPECT_EQ(nullptr, iree_vm_invocation_output(invocation));
+
+  // Polling does not execute.
+  EXPECT_EQ(IREE_STATUS_DEADLINE_EXCEEDED,
+            iree_vm_invocation_await(invocation, IREE_TIME_INFINITE_PAST));
+  EXPECT_EQ(1, module_.execution_log().size());
+
+  IREE_EXPECT_OK(
+      iree_vm_invocation_await(invocation, IREE_TIME_INFINITE_FUTURE));
+  EXPECT_EQ(3, module_.execution_log().size());
+  EXPECT_EQ(7, GetOutput(invocation));
+  iree_vm_invocation_release(invocation);
+}
+
+// Policies interleave queued invocations each time they yield.
+TEST_F(VMInvocationTest, PolicyInterleaves) {
+  iree_vm_invocation_policy_t* policy = nullptr;
+  IREE_ASSERT_OK(
+      iree_vm_invocation_policy_create(IREE_ALLOCATOR_SYSTEM, &policy));
+
+  iree_vm_variant_list_t* inputs_a = MakeInputs(100);
+  iree_vm_variant_list_t* inputs_b = MakeInputs(200);
+  iree_vm_invocation_t* invocation_a = nullptr;
+  iree_vm_invocation_t* invocation_b = nullptr;
+  IREE_ASSERT_OK(iree_vm_invocation_create(
+      context_, module_.function(2), policy, inputs_a, IREE_ALLOCATOR_SYSTEM,
+      &invocation_a));
+  IREE_ASSERT_OK(iree_vm_invocation_create(
+      context_, module_.function(1), policy, inputs_b, IREE_ALLOCATOR_SYSTEM,
+      &invocation_b));
+  iree_vm_variant_list_free(inputs_a);
+  iree_vm_variant_list_free(inputs_b);
+
+  // Nothing executes until the policy runs.
+  EXPECT_TRUE(module_.execution_log().empty());
+
+  iree_host_size_t pending_count = 0;
+  IREE_ASSERT_OK(iree_vm_invocation_policy_run(policy, &pending_count));
+  EXPECT_EQ(2, pending_count);
+  IREE_ASSERT_OK(iree_vm_invocation_policy_run(policy, &pending_count));
+  EXPECT_EQ(1, pending_count);
+  EXPECT_EQ(IREE_STATUS_UNAVAILABLE,
+            iree_vm_invocation_query_status(invocation_a));
+  IREE_EXPECT_OK(iree_vm_invocation_query_status(invocation_b));
+  EXPECT_EQ(201, GetOutput(invocation_b));
+
+  // Releasing our reference keeps the invocation alive in the policy.
+  iree_vm_invocation_release(invocation_b);
+
+  IREE_EXPECT_OK(
+      iree_vm_invocation_await(invocation_a, IREE_TIME_INFINITE_FUTURE));
+  EXPECT_EQ(102, GetOutput(invocation_a));
+  IREE_ASSERT_OK(iree_vm_invocation_policy_run(policy, &pending_count));
+  EXPECT_EQ(0, pending_count);
+
+  EXPECT_EQ((std::vector<int32_t>{100, 200, 100, 200, 100}),
+            module_.execution_log());
+
+  iree_vm_invocation_release(invocation_a);
+  iree_vm_invocation_policy_release(policy);
+}
+
+// Aborted invocations complete with ABORTED and are dropped by the policy.
+TEST_F(VMInvocationTest, Abort) {
+  iree_vm_invocation_policy_t* policy = nullptr;
+  IREE_ASSERT_OK(
+      iree_vm_invocation_policy_create(IREE_ALLOCATOR_SYSTEM, &policy));
+  iree_vm_variant_list_t* inputs = MakeInputs(5);
+  iree_vm_invocation_t* invocation = nullptr;
+  IREE_ASSERT_OK(iree_vm_invocation_create(context_, module_.function(5),
+                                           policy, inputs,
+                                           IREE_ALLOCATOR_SYSTEM, &invocation));
+  iree_vm_variant_list_free(inputs);
+
+  iree_host_size_t pending_count = 0;
+  IREE_ASSERT_OK(iree_vm_invocation_policy_run(policy, &pending_count));
+  EXPECT_EQ(1, pending_count);
+  IREE_ASSERT_OK(iree_vm_invocation_abort(invocation));
+  EXPECT_EQ(IREE_STATUS_ABORTED, iree_vm_invocation_query_status(invocation));
+  EXPECT_EQ(IREE_STATUS_ABORTED,
+            iree_vm_invocation_await(invocation, IREE_TIME_INFINITE_FUTURE));
+  EXPECT_EQ(nullptr, iree_vm_invocation_output(invocation));
+
+  IREE_ASSERT_OK(iree_vm_invocation_policy_run(policy, &pending_count));
+  EXPECT_EQ(0, pending_count);
+  EXPECT_EQ(1, module_.execution_log().size());
+
+  iree_vm_invocation_release(invocation);
+  iree_vm_invocation_policy_release(policy);
+}
+
+// Releasing a policy aborts all invocations still pending within it.
+TEST_F(VMInvocationTest, PolicyReleaseAbortsPending) {
+  iree_vm_invocation_policy_t* policy = nullptr;
+  IREE_ASSERT_OK(
+      iree_vm_invocation_policy_create(IREE_ALLOCATOR_SYSTEM, &policy));
+  iree_vm_variant_list_t* inputs = MakeInputs(5);
+  iree_vm_invocation_t* invocation = nullptr;
+  IREE_ASSERT_OK(iree_vm_invocation_create(context_, module_.function(5),
+                                           policy, inputs,
+                                           IREE_ALLOCATOR_SYSTEM, &invocation));
+  iree_vm_variant_list_free(inputs);
+  IREE_ASSERT_OK(iree_vm_invocation_policy_run(policy, nullptr));
+
+  iree_vm_invocation_policy_release(policy);
+  EXPECT_EQ(IREE_STATUS_ABORTED, iree_vm_invocation_query_status(invocation));
+  iree_vm_invocation_release(invocation);
+}
+
+// Records the invocation status observed by a completion callback.
+struct CompletionRecord {
+  int call_count = 0;
+  iree_status_t status = IREE_STATUS_UNKNOWN;
+
+  iree_vm_invocation_completion_callback_t callback() {
+    iree_vm_invocation_completion_callback_t callback;
+    callback.self = this;
+    callback.fn = +[](void* self, iree_vm_invocation_t* invocation) {
+      auto* record = reinterpret_cast<CompletionRecord*>(self);
+      ++record->call_count;
+      record->status = iree_vm_invocation_query_status(invocation);
+    };
+    return callback;
+  }
+};
+
+// Completion callbacks are issued once when the policy completes the
+// invocation.
+TEST_F(VMInvocationTest, CompletionCallback) {
+  iree_vm_invocation_policy_t* policy = nullptr;
+  IREE_ASSERT_OK(
+      iree_vm_invocation_policy_create(IREE_ALLOCATOR_SYSTEM, &policy));
+  iree_vm_variant_list_t* inputs = MakeInputs(5);
+  iree_vm_invocation_t* invocation = nullptr;
+  IREE_ASSERT_OK(iree_vm_invocation_create(context_, module_.function(1),
+                                           policy, inputs,
+                                           IREE_ALLOCATOR_SYSTEM, &invocation));
+  iree_vm_variant_list_free(inputs);
+
+  CompletionRecord record;
+  IREE_ASSERT_OK(iree_vm_invocation_set_completion_callback(
+      invocation, record.callback()));
+  EXPECT_EQ(IREE_STATUS_FAILED_PRECONDITION,
+            iree_vm_invocation_set_completion_callback(invocation,
+                                                       record.callback()));
+
+  IREE_ASSERT_OK(iree_vm_invocation_policy_run(policy, nullptr));
+  EXPECT_EQ(0, record.call_count);
+  IREE_ASSERT_OK(iree_vm_invocation_policy_run(policy, nullptr));
+  EXPECT_EQ(1, record.call_count);
+  EXPECT_EQ(IREE_STATUS_OK, record.status);
+
+  // Aborting or releasing a completed invocation does not reissue it.
+  IREE_ASSERT_OK(iree_vm_invocation_abort(invocation));
+  iree_vm_invocation_release(invocation);
+  iree_vm_invocation_policy_release(policy);
+  EXPECT_EQ(1, record.call_count);
+}
+
+// Completion callbacks registered after completion are issued immediately.
+TEST_F(VMInvocationTest, CompletionCallbackAfterCompletion) {
+  iree_vm_variant_list_t* inputs = MakeInputs(5);
+  iree_vm_invocation_t* invocation = nullptr;
+  IREE_ASSERT_OK(iree_vm_invocation_create(context_, module_.function(0),
+                                           nullptr, inputs,
+                                           IREE_ALLOCATOR_SYSTEM, &invocation));
+  iree_vm_variant_list_free(inputs);
+
+  CompletionRecord record;
+  IREE_ASSERT_OK(iree_vm_invocation_set_completion_callback(
+      invocation, record.callback()));
+  EXPECT_EQ(1, record.call_count);
+  EXPECT_EQ(IREE_STATUS_OK, record.status);
+  iree_vm_invocation_release(invocation);
+}
+
+// Completion callbacks observe aborts, including those from releasing the
+// policy holding the invocation.
+TEST_F(VMInvocationTest, CompletionCallbackAbort) {
+  iree_vm_invocation_policy_t* policy = nullptr;
+  IREE_ASSERT_OK(
+      iree_vm_invocation_policy_create(IREE_ALLOCATOR_SYSTEM, &policy));
+  iree_vm_variant_list_t* inputs = MakeInputs(5);
+  iree_vm_invocation_t* invocation = nullptr;
+  IREE_ASSERT_OK(iree_vm_invocation_create(context_, module_.function(5),
+                                           policy, inputs,
+                                           IREE_ALLOCATOR_SYSTEM, &invocation));
+  iree_vm_variant_list_free(inputs);
+
+  CompletionRecord record;
+  IREE_ASSERT_OK(iree_vm_invocation_set_completion_callback(
+      invocation, record.callback()));
+  iree_vm_invocation_release(invocation);
+  EXPECT_EQ(0, record.call_count);
+
+  iree_vm_invocation_policy_release(policy);
+  EXPECT_EQ(1, record.call_count);
+  EXPECT_EQ(IREE_STATUS_ABORTED, record.status);
+}
+
+#if !defined(IREE_PLATFORM_WINDOWS)
+
+// Invocations may be waited on from other threads while one thread drives the
+// policy.
+TEST_F(VMInvocationTest, CompletionWaitHandle) {
+  iree_vm_invocation_policy_t* policy = nullptr;
+  IREE_ASSERT_OK(
+      iree_vm_invocation_policy_create(IREE_ALLOCATOR_SYSTEM, &policy));
+  iree_vm_variant_list_t* inputs_a = MakeInputs(100);
+  iree_vm_variant_list_t* inputs_b = MakeInputs(200);
+  iree_vm_invocation_t* invocation_a = nullptr;
+  iree_vm_invocation_t* invocation_b = nullptr;
+  IREE_ASSERT_OK(iree_vm_invocation_create(
+      context_, module_.function(1), policy, inputs_a, IREE_ALLOCATOR_SYSTEM,
+      &invocation_a));
+  IREE_ASSERT_OK(iree_vm_invocation_create(
+      context_, module_.function(3), policy, inputs_b, IREE_ALLOCATOR_SYSTEM,
+      &invocation_b));
+  iree_vm_variant_list_free(inputs_a);
+  iree_vm_variant_list_free(inputs_b);
+
+  ASSERT_OK_AND_ASSIGN(auto wait_handle_a,
+                       iree::vm::InvocationCompletionWaitHandle(invocation_a));
+  ASSERT_OK_AND_ASSIGN(auto wait_handle_b,
+                       iree::vm::InvocationCompletionWaitHandle(invocation_b));
+  EXPECT_EQ(
+      iree::StatusCode::kFailedPrecondition,
+      iree::vm::InvocationCompletionWaitHandle(invocation_a).status().code());
+  ASSERT_OK_AND_ASSIGN(bool signaled, wait_handle_a.TryWait());
+  EXPECT_FALSE(signaled);
+
+  // The policy runs on another thread while this thread waits on whichever
+  // invocation completes first. Both may have completed by the time the wait
+  // returns so only the signaled one is checked.
+  std::thread thread([policy]() {
+    iree_host_size_t pending_count = 0;
+    do {
+      IREE_CHECK_OK(iree_vm_invocation_policy_run(policy, &pending_count));
+    } while (pending_count > 0);
+  });
+  ASSERT_OK_AND_ASSIGN(
+      int index, iree::WaitHandle::WaitAny({&wait_handle_a, &wait_handle_b},
+                                           absl::InfiniteFuture()));
+  iree_vm_invocation_t* invocations[] = {invocation_a, invocation_b};
+  IREE_EXPECT_OK(iree_vm_invocation_query_status(invocations[index]));
+  EXPECT_OK(wait_handle_a.Wait(absl::InfiniteFuture()));
+  EXPECT_OK(wait_handle_b.Wait(absl::InfiniteFuture()));
+  thread.join();
+
+  EXPECT_EQ(101, GetOutput(invocation_a));
+  EXPECT_EQ(203, GetOutput(invocation_b));
+  iree_vm_invocation_release(invocation_a);
+  iree_vm_invocation_release(invocation_b);
+  iree_vm_invocation_policy_release(policy);
+}
+
+// Wait handles created for completed invocations are already signaled.
+TEST_F(VMInvocationTest, CompletionWaitHandleAfterCompletion) {
+  iree_vm_variant_list_t* inputs = MakeInputs(5);
+  iree_vm_invocation_t* invocation = nullptr;
+  IREE_ASSERT_OK(iree_vm_invocation_create(context_, module_.function(0),
+                                           nullptr, inputs,
+                                           IREE_ALLOCATOR_SYSTEM, &invocation));
+  iree_vm_variant_list_free(inputs);
+  ASSERT_OK_AND_ASSIGN(auto wait_handle,
+                       iree::vm::InvocationCompletionWaitHandle(invocation));
+  ASSERT_OK_AND_ASSIGN(bool signaled, wait_handle.TryWait());
+  EXPECT_TRUE(signaled);
+  iree_vm_invocation_release(invocation);
+}
+
+#endif  // !IREE_PLATFORM_WINDOWS
+
+}  // namespace
@@ -75,13 +75,21 @@ typedef struct {
 // VM functions and accessing this state.
 typedef struct iree_vm_module_state iree_vm_module_state_t;
 
+// Flags describing how an iree_vm_module_execute request returned.
+typedef enum {
+  IREE_VM_EXECUTION_RESULT_FLAG_NONE = 0,
+  // Execution yielded before the function completed. The stack retains the
+  // execution state and the caller may resume by calling execute again with
+  // the same frame.
+  IREE_VM_EXECUTION_RESULT_FLAG_YIELDED = 1 << 0,
+} iree_vm_execution_result_flags_t;
+
 // Results of an iree_vm_module_execute request.
 typedef struct {
-  // TODO(benvanik): yield information.
-  // Yield modes:
-  // - yield (yield instruction)
+  // TODO(benvanik): additional yield modes:
   // - await (with 1+ wait handles)
   // - break
+  iree_vm_execution_result_flags_t flags;
 } iree_vm_execution_result_t;
 
 // Defines an interface that can be used to reflect and execute functions on a
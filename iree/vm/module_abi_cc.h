@@ -96,6 +96,15 @@ class NativeModule {
   // C API module interface bound to this NativeModule instance.
   iree_vm_module_t* interface() { return &interface_; }
 
+  // Returns the NativeModule bound to the C API |module| interface or nullptr
+  // if |module| is not a NativeModule with the same State type.
+  static NativeModule* FromInterface(iree_vm_module_t* module) {
+    if (!module || module->destroy != NativeModule::ModuleDestroy) {
+      return nullptr;
+    }
+    return FromModulePointer(module->self);
+  }
+
  protected:
   // Creates a new per-context module State holder.
   virtual StatusOr<std::unique_ptr<State>> CreateState(
@@ -253,7 +253,6 @@ struct DispatchFunctor {
     RETURN_IF_ERROR(param_state.status);
 
     frame->return_registers = nullptr;
-    frame->registers.ref_register_count = 0;
 
     auto results_or =
         ApplyFn(reinterpret_cast<FnPtr>(ptr), self, std::move(params),
@@ -272,6 +271,13 @@ struct DispatchFunctor {
     frame->return_registers =
         reinterpret_cast<const iree_vm_register_list_t*>(kResultList.data());
 
+    // Callers may size the frame only for the arguments; ensure there is room
+    // for the results in either bank.
+    RETURN_IF_ERROR(FromApiStatus(
+        iree_vm_stack_frame_reserve_registers(stack, frame, kResultCount,
+                                              kResultCount),
+        IREE_LOC));
+
     ResultPackState result_state;
     auto results = std::move(results_or).ValueOrDie();
     ResultPack<Results>(&result_state, frame, std::move(results));
@@ -300,7 +306,6 @@ struct DispatchFunctorVoid {
     RETURN_IF_ERROR(param_state.status);
 
     frame->return_registers = nullptr;
-    frame->registers.ref_register_count = 0;
 
     return ApplyFn(reinterpret_cast<FnPtr>(ptr), self, std::move(params),
                    std::make_index_sequence<sizeof...(Params)>());
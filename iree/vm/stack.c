@@ -18,10 +18,123 @@
 
 #include "iree/vm/module.h"
 
+// Alignment of all frames and register banks within stack storage.
+#define IREE_VM_STACK_ALIGNMENT 16
+
+// Header of a block of stack storage. Frame data immediately follows the
+// (aligned) header.
+struct iree_vm_stack_block {
+  iree_vm_stack_block_t* prev;
+  iree_vm_stack_block_t* next;
+  // Total number of bytes available for frames.
+  iree_host_size_t capacity;
+  // Offset of the next allocation within the block.
+  iree_host_size_t offset;
+  // Nonzero if the block was allocated from the stack allocator.
+  int is_owned;
+};
+
+static iree_host_size_t iree_vm_stack_align(iree_host_size_t value) {
+  return (value + IREE_VM_STACK_ALIGNMENT - 1) &
+         ~(iree_host_size_t)(IREE_VM_STACK_ALIGNMENT - 1);
+}
+
+static uint8_t* iree_vm_stack_block_data(iree_vm_stack_block_t* block) {
+  return (uint8_t*)block + iree_vm_stack_align(sizeof(iree_vm_stack_block_t));
+}
+
+// Returns the power-of-two bank size able to hold |count| registers.
+static int32_t iree_vm_stack_bank_size(int32_t count) {
+  int32_t size = 1;
+  while (size < count) size <<= 1;
+  return size;
+}
+
+// Allocates |byte_length| bytes from the stack storage, moving on to the next
+// block (or allocating a new one) if the current block is exhausted.
+static iree_status_t iree_vm_stack_allocate(iree_vm_stack_t* stack,
+                                            iree_host_size_t byte_length,
+                                            iree_vm_stack_block_t** out_block,
+                                            uint8_t** out_ptr) {
+  byte_length = iree_vm_stack_align(byte_length);
+  iree_vm_stack_block_t* block = stack->block;
+  if (!block || block->capacity - block->offset < byte_length) {
+    // Reuse the next block if it was retained from a previous deeper call.
+    iree_vm_stack_block_t* next_block = block ? block->next : stack->head_block;
+    if (!next_block || next_block->capacity < byte_length) {
+      if (!stack->allocator.alloc) return IREE_STATUS_RESOURCE_EXHAUSTED;
+      iree_host_size_t capacity = byte_length > IREE_VM_STACK_DEFAULT_BLOCK_SIZE
+                                      ? byte_length
+                                      : IREE_VM_STACK_DEFAULT_BLOCK_SIZE;
+      iree_vm_stack_block_t* new_block = NULL;
+      if (!iree_status_is_ok(iree_allocator_malloc(
+              stack->allocator,
+              iree_vm_stack_align(sizeof(iree_vm_stack_block_t)) + capacity,
+              (void**)&new_block))) {
+        return IREE_STATUS_RESOURCE_EXHAUSTED;
+      }
+      new_block->capacity = capacity;
+      new_block->is_owned = 1;
+      // Insert after the current block; any smaller retained block follows.
+      new_block->prev = block;
+      new_block->next = next_block;
+      if (next_block) next_block->prev = new_block;
+      if (block) {
+        block->next = new_block;
+      } else {
+        stack->head_block = new_block;
+      }
+      next_block = new_block;
+    }
+    next_block->offset = 0;
+    block = next_block;
+    stack->block = block;
+  }
+
+  *out_block = block;
+  *out_ptr = iree_vm_stack_block_data(block) + block->offset;
+  block->offset += byte_length;
+  return IREE_STATUS_OK;
+}
+
+IREE_API_EXPORT void IREE_API_CALL iree_vm_register_list_count(
+    const iree_vm_register_list_t* register_list, int32_t* out_i32_count,
+    int32_t* out_ref_count) {
+  int32_t i32_count = 0;
+  int32_t ref_count = 0;
+  for (int i = 0; i < register_list->size; ++i) {
+    if (register_list->registers[i] & IREE_REF_REGISTER_TYPE_BIT) {
+      ++ref_count;
+    } else {
+      ++i32_count;
+    }
+  }
+  *out_i32_count = i32_count;
+  *out_ref_count = ref_count;
+}
+
 IREE_API_EXPORT iree_status_t IREE_API_CALL iree_vm_stack_init(
-    iree_vm_state_resolver_t state_resolver, iree_vm_stack_t* out_stack) {
+    iree_vm_state_resolver_t state_resolver, iree_byte_span_t storage,
+    iree_allocator_t allocator, iree_vm_stack_t* out_stack) {
   memset(out_stack, 0, sizeof(iree_vm_stack_t));
   out_stack->state_resolver = state_resolver;
+  out_stack->allocator = allocator;
+
+  // Carve the head block out of the caller storage, if it is large enough to
+  // be useful.
+  uintptr_t storage_begin = (uintptr_t)storage.data;
+  uintptr_t storage_end = storage_begin + storage.data_length;
+  uintptr_t block_begin = iree_vm_stack_align(storage_begin);
+  iree_host_size_t header_size =
+      iree_vm_stack_align(sizeof(iree_vm_stack_block_t));
+  if (storage.data && block_begin + header_size < storage_end) {
+    iree_vm_stack_block_t* block = (iree_vm_stack_block_t*)block_begin;
+    memset(block, 0, sizeof(*block));
+    block->capacity = storage_end - block_begin - header_size;
+    out_stack->head_block = block;
+    out_stack->block = block;
+  }
+
   return IREE_STATUS_OK;
 }
 
@@ -30,75 +143,187 @@ iree_vm_stack_deinit(iree_vm_stack_t* stack) {
   while (stack->depth) {
     IREE_RETURN_IF_ERROR(iree_vm_stack_function_leave(stack));
   }
+
+  iree_vm_stack_block_t* block = stack->head_block;
+  while (block) {
+    iree_vm_stack_block_t* next_block = block->next;
+    if (block->is_owned) {
+      iree_allocator_free(stack->allocator, block);
+    }
+    block = next_block;
+  }
+  stack->head_block = NULL;
+  stack->block = NULL;
+
   return IREE_STATUS_OK;
 }
 
 IREE_API_EXPORT iree_vm_stack_frame_t* IREE_API_CALL
 iree_vm_stack_current_frame(iree_vm_stack_t* stack) {
-  return stack->depth > 0 ? &stack->frames[stack->depth - 1] : NULL;
+  return stack->top;
 }
 
 IREE_API_EXPORT iree_vm_stack_frame_t* IREE_API_CALL
 iree_vm_stack_parent_frame(iree_vm_stack_t* stack) {
-  return stack->depth > 1 ? &stack->frames[stack->depth - 2] : NULL;
+  return stack->top ? stack->top->parent : NULL;
+}
+
+// Allocates register banks able to hold the given register counts.
+// The banks are not initialized.
+static iree_status_t iree_vm_stack_allocate_registers(
+    iree_vm_stack_t* stack, int32_t i32_register_count,
+    int32_t ref_register_count, iree_vm_registers_t* out_registers) {
+  if (i32_register_count > IREE_I32_REGISTER_COUNT ||
+      ref_register_count > IREE_REF_REGISTER_COUNT) {
+    return IREE_STATUS_INVALID_ARGUMENT;
+  }
+  int32_t i32_bank_size = iree_vm_stack_bank_size(i32_register_count);
+  int32_t ref_bank_size = iree_vm_stack_bank_size(ref_register_count);
+  iree_host_size_t i32_byte_length =
+      iree_vm_stack_align(i32_bank_size * sizeof(int32_t));
+  iree_host_size_t ref_byte_length = ref_bank_size * sizeof(iree_vm_ref_t);
+
+  iree_vm_stack_block_t* block = NULL;
+  uint8_t* ptr = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_stack_allocate(
+      stack, i32_byte_length + ref_byte_length, &block, &ptr));
+  out_registers->i32 = (int32_t*)ptr;
+  out_registers->ref = (iree_vm_ref_t*)(ptr + i32_byte_length);
+  out_registers->i32_mask = (uint16_t)(i32_bank_size - 1);
+  out_registers->ref_mask = (uint16_t)(ref_bank_size - 1);
+  return IREE_STATUS_OK;
 }
 
 IREE_API_EXPORT iree_status_t IREE_API_CALL iree_vm_stack_function_enter(
     iree_vm_stack_t* stack, iree_vm_function_t function,
+    int32_t i32_register_count, int32_t ref_register_count,
     iree_vm_stack_frame_t** out_callee_frame) {
   *out_callee_frame = NULL;
-  if (stack->depth == IREE_MAX_STACK_DEPTH) {
-    return IREE_STATUS_RESOURCE_EXHAUSTED;
-  }
 
   // Try to reuse the same module state if the caller and callee are from the
   // same module. Otherwise, query the state from the registered handler.
-  iree_vm_stack_frame_t* callee_frame = &stack->frames[stack->depth];
-  if (stack->depth > 0) {
-    iree_vm_stack_frame_t* caller_frame = &stack->frames[stack->depth - 1];
-    if (caller_frame->function.module == function.module) {
-      callee_frame->module_state = caller_frame->module_state;
-    }
+  iree_vm_module_state_t* module_state = NULL;
+  iree_vm_stack_frame_t* caller_frame = stack->top;
+  if (caller_frame && caller_frame->function.module == function.module) {
+    module_state = caller_frame->module_state;
   }
-  if (!callee_frame->module_state) {
+  if (!module_state) {
     IREE_RETURN_IF_ERROR(stack->state_resolver.query_module_state(
-        stack->state_resolver.self, function.module,
-        &callee_frame->module_state));
+        stack->state_resolver.self, function.module, &module_state));
   }
 
-  ++stack->depth;
+  // Frames are allocated prior to their registers so that leaving the frame
+  // releases all storage allocated after it.
+  iree_vm_stack_block_t* block = NULL;
+  uint8_t* ptr = NULL;
+  IREE_RETURN_IF_ERROR(iree_vm_stack_allocate(
+      stack, sizeof(iree_vm_stack_frame_t), &block, &ptr));
+  iree_vm_stack_frame_t* callee_frame = (iree_vm_stack_frame_t*)ptr;
+  iree_status_t status = iree_vm_stack_allocate_registers(
+      stack, i32_register_count, ref_register_count, &callee_frame->registers);
+  if (!iree_status_is_ok(status)) {
+    stack->block = block;
+    block->offset = ptr - iree_vm_stack_block_data(block);
+    return status;
+  }
 
   callee_frame->function = function;
+  callee_frame->module_state = module_state;
   callee_frame->offset = 0;
-  callee_frame->registers.ref_register_count = 0;
   callee_frame->return_registers = NULL;
+  callee_frame->parent = caller_frame;
+  callee_frame->block = block;
 
+  iree_vm_registers_t* registers = &callee_frame->registers;
 #ifndef NDEBUG
-  memset(callee_frame->registers.i32, 0xCD,
-         sizeof(callee_frame->registers.i32));
-  memset(callee_frame->registers.ref, 0xCD,
-         sizeof(callee_frame->registers.ref));
+  memset(registers->i32, 0xCD, (registers->i32_mask + 1) * sizeof(int32_t));
 #endif  // !NDEBUG
+  memset(registers->ref, 0, (registers->ref_mask + 1) * sizeof(iree_vm_ref_t));
+
+  stack->top = callee_frame;
+  ++stack->depth;
 
   *out_callee_frame = callee_frame;
   return IREE_STATUS_OK;
 }
 
+IREE_API_EXPORT iree_status_t IREE_API_CALL
+iree_vm_stack_frame_reserve_registers(iree_vm_stack_t* stack,
+                                      iree_vm_stack_frame_t* frame,
+                                      int32_t i32_register_count,
+                                      int32_t ref_register_count) {
+  if (frame != stack->top) return IREE_STATUS_FAILED_PRECONDITION;
+  iree_vm_registers_t old_registers = frame->registers;
+  int32_t old_i32_bank_size = old_registers.i32_mask + 1;
+  int32_t old_ref_bank_size = old_registers.ref_mask + 1;
+  if (i32_register_count <= old_i32_bank_size &&
+      ref_register_count <= old_ref_bank_size) {
+    return IREE_STATUS_OK;
+  }
+  if (i32_register_count < old_i32_bank_size) {
+    i32_register_count = old_i32_bank_size;
+  }
+  if (ref_register_count < old_ref_bank_size) {
+    ref_register_count = old_ref_bank_size;
+  }
+
+  // If the banks are the last allocation in the current block we can grow them
+  // in-place (or at least not leave a hole behind when moving to a new block).
+  iree_vm_stack_block_t* old_block = stack->block;
+  iree_host_size_t old_offset = old_block->offset;
+  uint8_t* old_end = (uint8_t*)(old_registers.ref + old_ref_bank_size);
+  uint8_t* block_data = iree_vm_stack_block_data(old_block);
+  if (old_end == block_data + old_offset) {
+    old_block->offset = (uint8_t*)old_registers.i32 - block_data;
+  }
+
+  iree_vm_registers_t new_registers;
+  iree_status_t status = iree_vm_stack_allocate_registers(
+      stack, i32_register_count, ref_register_count, &new_registers);
+  if (!iree_status_is_ok(status)) {
+    stack->block = old_block;
+    old_block->offset = old_offset;
+    return status;
+  }
+
+  // The ref bank always moves to a higher address (or a different block) so
+  // it must be copied before the i32 bank is.
+  int32_t new_ref_bank_size = new_registers.ref_mask + 1;
+  memmove(new_registers.ref, old_registers.ref,
+          old_ref_bank_size * sizeof(iree_vm_ref_t));
+  memset(new_registers.ref + old_ref_bank_size, 0,
+         (new_ref_bank_size - old_ref_bank_size) * sizeof(iree_vm_ref_t));
+  memmove(new_registers.i32, old_registers.i32,
+          old_i32_bank_size * sizeof(int32_t));
+#ifndef NDEBUG
+  int32_t new_i32_bank_size = new_registers.i32_mask + 1;
+  memset(new_registers.i32 + old_i32_bank_size, 0xCD,
+         (new_i32_bank_size - old_i32_bank_size) * sizeof(int32_t));
+#endif  // !NDEBUG
+
+  frame->registers = new_registers;
+  return IREE_STATUS_OK;
+}
+
 IREE_API_EXPORT iree_status_t IREE_API_CALL
 iree_vm_stack_function_leave(iree_vm_stack_t* stack) {
-  if (stack->depth <= 0) {
+  iree_vm_stack_frame_t* callee_frame = stack->top;
+  if (!callee_frame) {
     return IREE_STATUS_FAILED_PRECONDITION;
   }
 
-  iree_vm_stack_frame_t* callee_frame = &stack->frames[stack->depth - 1];
-  --stack->depth;
-  memset(&callee_frame->function, 0, sizeof(callee_frame->function));
-  callee_frame->module_state = NULL;
-
   iree_vm_registers_t* registers = &callee_frame->registers;
-  for (int i = 0; i < registers->ref_register_count; ++i) {
+  for (int i = 0; i <= registers->ref_mask; ++i) {
     iree_vm_ref_release(&registers->ref[i]);
   }
 
+  stack->top = callee_frame->parent;
+  --stack->depth;
+
+  // Return all storage allocated since the frame was entered.
+  iree_vm_stack_block_t* block = callee_frame->block;
+  block->offset = (uint8_t*)callee_frame - iree_vm_stack_block_data(block);
+  stack->block = block;
+
   return IREE_STATUS_OK;
 }
@@ -27,8 +27,13 @@
 extern "C" {
 #endif  // __cplusplus
 
-// Maximum stack depth, in frames.
-#define IREE_MAX_STACK_DEPTH 32
+// Default size of the storage blocks that frames are allocated from when the
+// caller-provided storage (if any) is exhausted.
+#define IREE_VM_STACK_DEFAULT_BLOCK_SIZE (8 * 1024)
+
+// Recommended size of caller-provided stack storage. Sufficient for most
+// programs to run without needing any heap allocations.
+#define IREE_VM_STACK_DEFAULT_INLINE_STORAGE_SIZE (8 * 1024)
 
 // Maximum register count per bank.
 // This determines the bits required to reference registers in the VM bytecode.
@@ -48,14 +53,20 @@ extern "C" {
 typedef int64_t iree_vm_source_offset_t;
 
 // Register banks for use within a stack frame.
+//
+// Banks are sized per-frame based on the registers used by the function and
+// rounded up to a power of two. Register ordinals must be masked with the bank
+// mask prior to access so that malformed bytecode is unable to reach outside
+// of the frame storage.
 typedef struct {
   // Integer registers.
-  IREE_ALIGNAS(16) int32_t i32[IREE_I32_REGISTER_COUNT];
-  // Reference counted registers.
-  iree_vm_ref_t ref[IREE_REF_REGISTER_COUNT];
-  // Total number of valid ref registers used by the function.
-  // TODO(benvanik): make the above dynamic and include i32 count.
-  int8_t ref_register_count;
+  int32_t* i32;
+  // Reference counted registers. All are released when the frame is left.
+  iree_vm_ref_t* ref;
+  // Mask applied to i32 register ordinals; the bank has i32_mask + 1 entries.
+  uint16_t i32_mask;
+  // Mask applied to ref register ordinals; the bank has ref_mask + 1 entries.
+  uint16_t ref_mask;
 } iree_vm_registers_t;
 
 // A variable-length list of registers.
@@ -71,7 +82,21 @@ static_assert(alignof(iree_vm_register_list_t) == 1,
 static_assert(offsetof(iree_vm_register_list_t, registers) == 1,
               "Expect no padding in the struct");
 
+// Counts the number of registers of each type in |register_list|.
+// As arguments and results are left-aligned in each bank this is also the
+// number of registers required in each bank to pass the list.
+IREE_API_EXPORT void IREE_API_CALL iree_vm_register_list_count(
+    const iree_vm_register_list_t* register_list, int32_t* out_i32_count,
+    int32_t* out_ref_count);
+
+// A block of memory that stack frames are allocated from.
+typedef struct iree_vm_stack_block iree_vm_stack_block_t;
+
 // A single stack frame within the VM.
+//
+// Frames and their register banks are allocated from the stack storage and are
+// only valid until the frame is left. Frame pointers remain stable while the
+// frame is on the stack even as additional storage is allocated.
 typedef struct iree_vm_stack_frame {
   // Function that the stack frame is within.
   iree_vm_function_t function;
@@ -80,13 +105,18 @@ typedef struct iree_vm_stack_frame {
   // Offset within the function.
   iree_vm_source_offset_t offset;
   // Registers used within the frame.
-  // TODO(benvanik): pointer to an arena? avoids fixed overheads.
   iree_vm_registers_t registers;
 
   // Pointer to a register list where callers can source their return registers.
   // If omitted then the return values are assumed to be left-aligned in the
   // register banks.
   const iree_vm_register_list_t* return_registers;
+
+  // Caller frame or NULL if this is the outermost frame of the stack.
+  struct iree_vm_stack_frame* parent;
+  // Storage block containing the frame. Used by the stack to restore the
+  // allocation position when the frame is left.
+  iree_vm_stack_block_t* block;
 } iree_vm_stack_frame_t;
 
 // A state resolver that can allocate or lookup module state.
@@ -100,12 +130,26 @@ typedef struct iree_vm_state_resolver {
 // A fiber stack used for storing stack frame state during execution.
 // All required state is stored within the stack and no host thread-local state
 // is used allowing us to execute multiple fibers on the same host thread.
+//
+// Frames are allocated linearly from a chain of storage blocks. The first block
+// may be provided by the caller (such as from the host stack or a fiber pool)
+// and when it is exhausted additional blocks are allocated from the stack
+// allocator. Blocks are retained until the stack is deinitialized so that
+// repeatedly entering and leaving deep call chains does not reallocate. There
+// is no limit on stack depth beyond available memory.
 typedef struct iree_vm_stack {
   // TODO(benvanik): add globally useful things (instance/device manager?)
   // Depth of the stack, in frames. 0 indicates an empty stack.
   int32_t depth;
-  // [0-depth) valid stack frames.
-  iree_vm_stack_frame_t frames[IREE_MAX_STACK_DEPTH];
+  // Current (innermost) frame or NULL if the stack is empty.
+  iree_vm_stack_frame_t* top;
+
+  // Block that new frames are allocated from.
+  iree_vm_stack_block_t* block;
+  // First block in the chain; may be caller-provided storage.
+  iree_vm_stack_block_t* head_block;
+  // Allocator used for storage blocks beyond the caller-provided storage.
+  iree_allocator_t allocator;
 
   // Resolves a module to a module state within a context.
   // This will be called on function entry whenever module transitions occur.
@@ -113,10 +157,16 @@ typedef struct iree_vm_stack {
 } iree_vm_stack_t;
 
 // Constructs a stack in-place in |out_stack|.
+// |storage| is optional memory owned by the caller that will be used for frames
+// before falling back to allocating blocks from |allocator|. The storage must
+// remain valid until the stack is deinitialized. Pass IREE_ALLOCATOR_NULL to
+// restrict the stack to only the provided storage.
 IREE_API_EXPORT iree_status_t IREE_API_CALL iree_vm_stack_init(
-    iree_vm_state_resolver_t state_resolver, iree_vm_stack_t* out_stack);
+    iree_vm_state_resolver_t state_resolver, iree_byte_span_t storage,
+    iree_allocator_t allocator, iree_vm_stack_t* out_stack);
 
-// Destructs |stack|.
+// Destructs |stack|, leaving any remaining frames and freeing all storage
+// blocks allocated by the stack.
 IREE_API_EXPORT iree_status_t IREE_API_CALL
 iree_vm_stack_deinit(iree_vm_stack_t* stack);
 
@@ -129,11 +179,30 @@ IREE_API_EXPORT iree_vm_stack_frame_t* IREE_API_CALL
 iree_vm_stack_parent_frame(iree_vm_stack_t* stack);
 
 // Enters into the given |function| and returns the callee stack frame.
+// The frame has room for at least |i32_register_count| and
+// |ref_register_count| registers and all ref registers are initialized to null.
 // Callers must populate the argument registers as defined by the VM API.
+//
+// Returns IREE_STATUS_RESOURCE_EXHAUSTED if storage for the frame could not be
+// allocated.
 IREE_API_EXPORT iree_status_t IREE_API_CALL iree_vm_stack_function_enter(
     iree_vm_stack_t* stack, iree_vm_function_t function,
+    int32_t i32_register_count, int32_t ref_register_count,
     iree_vm_stack_frame_t** out_callee_frame);
 
+// Grows the register banks of the current stack frame to hold at least
+// |i32_register_count| and |ref_register_count| registers. Existing register
+// contents are preserved and new ref registers are initialized to null.
+// Callees use this when they require more registers than their caller
+// provided, such as for bytecode function locals or native function results.
+// Only the current frame may be resized and doing so invalidates any
+// pointers into its register banks.
+IREE_API_EXPORT iree_status_t IREE_API_CALL
+iree_vm_stack_frame_reserve_registers(iree_vm_stack_t* stack,
+                                      iree_vm_stack_frame_t* frame,
+                                      int32_t i32_register_count,
+                                      int32_t ref_register_count);
+
 // Leaves the current stack frame.
 // Callers must have retrieved the result registers as defined by the VM API.
 IREE_API_EXPORT iree_status_t IREE_API_CALL
@@ -15,6 +15,7 @@
 #include "iree/vm/stack.h"
 
 #include <cstring>
+#include <vector>
 
 #include "iree/base/api.h"
 #include "iree/base/ref_ptr.h"
@@ -28,6 +29,8 @@ namespace {
 #define MODULE_A_STATE_SENTINEL reinterpret_cast<iree_vm_module_state_t*>(101)
 #define MODULE_B_STATE_SENTINEL reinterpret_cast<iree_vm_module_state_t*>(102)
 
+static const iree_byte_span_t kNoStorage = {nullptr, 0};
+
 static int module_a_state_resolve_count = 0;
 static int module_b_state_resolve_count = 0;
 static iree_status_t SentinelStateResolver(
@@ -49,7 +52,8 @@ static iree_status_t SentinelStateResolver(
 TEST(VMStackTest, Usage) {
   auto stack = std::make_unique<iree_vm_stack_t>();
   iree_vm_state_resolver_t state_resolver = {nullptr, SentinelStateResolver};
-  IREE_EXPECT_OK(iree_vm_stack_init(state_resolver, stack.get()));
+  IREE_EXPECT_OK(iree_vm_stack_init(state_resolver, kNoStorage,
+                                    IREE_ALLOCATOR_SYSTEM, stack.get()));
 
   EXPECT_EQ(nullptr, iree_vm_stack_current_frame(stack.get()));
   EXPECT_EQ(nullptr, iree_vm_stack_parent_frame(stack.get()));
@@ -58,7 +62,7 @@ TEST(VMStackTest, Usage) {
                                    IREE_VM_FUNCTION_LINKAGE_INTERNAL, 0};
   iree_vm_stack_frame_t* frame_a = nullptr;
   IREE_EXPECT_OK(
-      iree_vm_stack_function_enter(stack.get(), function_a, &frame_a));
+      iree_vm_stack_function_enter(stack.get(), function_a, 0, 0, &frame_a));
   EXPECT_EQ(0, frame_a->function.ordinal);
   EXPECT_EQ(frame_a, iree_vm_stack_current_frame(stack.get()));
   EXPECT_EQ(nullptr, iree_vm_stack_parent_frame(stack.get()));
@@ -67,7 +71,7 @@ TEST(VMStackTest, Usage) {
                                    IREE_VM_FUNCTION_LINKAGE_INTERNAL, 1};
   iree_vm_stack_frame_t* frame_b = nullptr;
   IREE_EXPECT_OK(
-      iree_vm_stack_function_enter(stack.get(), function_b, &frame_b));
+      iree_vm_stack_function_enter(stack.get(), function_b, 0, 0, &frame_b));
   EXPECT_EQ(1, frame_b->function.ordinal);
   EXPECT_EQ(frame_b, iree_vm_stack_current_frame(stack.get()));
   EXPECT_EQ(frame_a, iree_vm_stack_parent_frame(stack.get()));
@@ -86,13 +90,14 @@ TEST(VMStackTest, Usage) {
 TEST(VMStackTest, DeinitWithRemainingFrames) {
   auto stack = std::make_unique<iree_vm_stack_t>();
   iree_vm_state_resolver_t state_resolver = {nullptr, SentinelStateResolver};
-  IREE_EXPECT_OK(iree_vm_stack_init(state_resolver, stack.get()));
+  IREE_EXPECT_OK(iree_vm_stack_init(state_resolver, kNoStorage,
+                                    IREE_ALLOCATOR_SYSTEM, stack.get()));
 
   iree_vm_function_t function_a = {MODULE_A_SENTINEL,
                                    IREE_VM_FUNCTION_LINKAGE_INTERNAL, 0};
   iree_vm_stack_frame_t* frame_a = nullptr;
   IREE_EXPECT_OK(
-      iree_vm_stack_function_enter(stack.get(), function_a, &frame_a));
+      iree_vm_stack_function_enter(stack.get(), function_a, 0, 0, &frame_a));
   EXPECT_EQ(0, frame_a->function.ordinal);
   EXPECT_EQ(frame_a, iree_vm_stack_current_frame(stack.get()));
   EXPECT_EQ(nullptr, iree_vm_stack_parent_frame(stack.get()));
@@ -102,30 +107,81 @@ TEST(VMStackTest, DeinitWithRemainingFrames) {
   EXPECT_EQ(nullptr, iree_vm_stack_current_frame(stack.get()));
 }
 
-// Tests stack overflow detection.
-TEST(VMStackTest, StackOverflow) {
+// Tests that the stack depth is only limited by available memory.
+TEST(VMStackTest, DeepStack) {
   auto stack = std::make_unique<iree_vm_stack_t>();
   iree_vm_state_resolver_t state_resolver = {nullptr, SentinelStateResolver};
-  IREE_EXPECT_OK(iree_vm_stack_init(state_resolver, stack.get()));
+  IREE_EXPECT_OK(iree_vm_stack_init(state_resolver, kNoStorage,
+                                    IREE_ALLOCATOR_SYSTEM, stack.get()));
 
-  EXPECT_EQ(nullptr, iree_vm_stack_current_frame(stack.get()));
-  EXPECT_EQ(nullptr, iree_vm_stack_parent_frame(stack.get()));
+  // Enter enough frames to span many storage blocks.
+  static const int kDepth = 1000;
+  iree_vm_function_t function_a = {MODULE_A_SENTINEL,
+                                   IREE_VM_FUNCTION_LINKAGE_INTERNAL, 0};
+  std::vector<iree_vm_stack_frame_t*> frames;
+  for (int i = 0; i < kDepth; ++i) {
+    iree_vm_stack_frame_t* frame_a = nullptr;
+    IREE_ASSERT_OK(
+        iree_vm_stack_function_enter(stack.get(), function_a, 16, 4, &frame_a));
+    frame_a->registers.i32[0] = i;
+    frames.push_back(frame_a);
+  }
+  EXPECT_EQ(kDepth, stack->depth);
+
+  // Frames must not have moved as the stack grew.
+  for (int i = kDepth - 1; i >= 0; --i) {
+    EXPECT_EQ(frames[i], iree_vm_stack_current_frame(stack.get()));
+    EXPECT_EQ(i, frames[i]->registers.i32[0]);
+    IREE_EXPECT_OK(iree_vm_stack_function_leave(stack.get()));
+  }
+
+  // Storage blocks are retained and reused on the next descent.
+  for (int i = 0; i < kDepth; ++i) {
+    iree_vm_stack_frame_t* frame_a = nullptr;
+    IREE_ASSERT_OK(
+        iree_vm_stack_function_enter(stack.get(), function_a, 16, 4, &frame_a));
+    EXPECT_EQ(frames[i], frame_a);
+  }
+
+  IREE_EXPECT_OK(iree_vm_stack_deinit(stack.get()));
+}
 
-  // Fill the entire stack up to the max.
+// Tests stack exhaustion when limited to caller-provided storage.
+TEST(VMStackTest, StorageExhausted) {
+  alignas(16) uint8_t storage[1024];
+  auto stack = std::make_unique<iree_vm_stack_t>();
+  iree_vm_state_resolver_t state_resolver = {nullptr, SentinelStateResolver};
+  IREE_EXPECT_OK(iree_vm_stack_init(
+      state_resolver, iree_byte_span_t{storage, sizeof(storage)},
+      IREE_ALLOCATOR_NULL, stack.get()));
+
+  // Fill the storage until no more frames fit.
   iree_vm_function_t function_a = {MODULE_A_SENTINEL,
                                    IREE_VM_FUNCTION_LINKAGE_INTERNAL, 0};
-  for (int i = 0; i < IREE_MAX_STACK_DEPTH; ++i) {
+  iree_status_t status = IREE_STATUS_OK;
+  int depth = 0;
+  while (iree_status_is_ok(status)) {
     iree_vm_stack_frame_t* frame_a = nullptr;
-    IREE_EXPECT_OK(
-        iree_vm_stack_function_enter(stack.get(), function_a, &frame_a));
+    status =
+        iree_vm_stack_function_enter(stack.get(), function_a, 8, 2, &frame_a);
+    if (iree_status_is_ok(status)) {
+      EXPECT_GE(reinterpret_cast<uint8_t*>(frame_a), storage);
+      EXPECT_LT(reinterpret_cast<uint8_t*>(frame_a), storage + sizeof(storage));
+      ++depth;
+    }
+    ASSERT_LT(depth, 1024);
   }
+  EXPECT_EQ(IREE_STATUS_RESOURCE_EXHAUSTED, status);
+  EXPECT_GT(depth, 0);
+  EXPECT_EQ(depth, stack->depth);
 
   // Try to push on one more frame.
   iree_vm_function_t function_b = {MODULE_B_SENTINEL,
                                    IREE_VM_FUNCTION_LINKAGE_INTERNAL, 1};
   iree_vm_stack_frame_t* frame_b = nullptr;
   EXPECT_EQ(IREE_STATUS_RESOURCE_EXHAUSTED,
-            iree_vm_stack_function_enter(stack.get(), function_b, &frame_b));
+            iree_vm_stack_function_enter(stack.get(), function_b, 8, 2,
+                                         &frame_b));
 
   // Should still be frame A.
   EXPECT_EQ(0, iree_vm_stack_current_frame(stack.get())->function.ordinal);
@@ -133,11 +189,94 @@ TEST(VMStackTest, StackOverflow) {
   IREE_EXPECT_OK(iree_vm_stack_deinit(stack.get()));
 }
 
+// Tests that register banks are sized to the requested register counts.
+TEST(VMStackTest, RegisterBankSizes) {
+  auto stack = std::make_unique<iree_vm_stack_t>();
+  iree_vm_state_resolver_t state_resolver = {nullptr, SentinelStateResolver};
+  IREE_EXPECT_OK(iree_vm_stack_init(state_resolver, kNoStorage,
+                                    IREE_ALLOCATOR_SYSTEM, stack.get()));
+
+  iree_vm_function_t function_a = {MODULE_A_SENTINEL,
+                                   IREE_VM_FUNCTION_LINKAGE_INTERNAL, 0};
+  iree_vm_stack_frame_t* frame_a = nullptr;
+  IREE_EXPECT_OK(
+      iree_vm_stack_function_enter(stack.get(), function_a, 5, 0, &frame_a));
+  EXPECT_EQ(7, frame_a->registers.i32_mask);
+  EXPECT_EQ(0, frame_a->registers.ref_mask);
+  EXPECT_EQ(nullptr, frame_a->registers.ref[0].ptr);
+
+  iree_vm_stack_frame_t* frame_b = nullptr;
+  IREE_EXPECT_OK(iree_vm_stack_function_enter(
+      stack.get(), function_a, IREE_I32_REGISTER_COUNT,
+      IREE_REF_REGISTER_COUNT, &frame_b));
+  EXPECT_EQ(IREE_I32_REGISTER_MASK, frame_b->registers.i32_mask);
+  EXPECT_EQ(IREE_REF_REGISTER_MASK, frame_b->registers.ref_mask);
+  IREE_EXPECT_OK(iree_vm_stack_function_leave(stack.get()));
+
+  // Register counts beyond what bytecode can address are rejected.
+  iree_vm_stack_frame_t* frame_c = nullptr;
+  EXPECT_EQ(IREE_STATUS_INVALID_ARGUMENT,
+            iree_vm_stack_function_enter(stack.get(), function_a,
+                                         IREE_I32_REGISTER_COUNT + 1, 0,
+                                         &frame_c));
+  EXPECT_EQ(frame_a, iree_vm_stack_current_frame(stack.get()));
+
+  IREE_EXPECT_OK(iree_vm_stack_deinit(stack.get()));
+}
+
+// Tests growing the register banks of the current frame.
+TEST(VMStackTest, ReserveRegisters) {
+  auto stack = std::make_unique<iree_vm_stack_t>();
+  iree_vm_state_resolver_t state_resolver = {nullptr, SentinelStateResolver};
+  IREE_EXPECT_OK(iree_vm_stack_init(state_resolver, kNoStorage,
+                                    IREE_ALLOCATOR_SYSTEM, stack.get()));
+
+  iree_vm_function_t function_a = {MODULE_A_SENTINEL,
+                                   IREE_VM_FUNCTION_LINKAGE_INTERNAL, 0};
+  iree_vm_stack_frame_t* frame_a = nullptr;
+  IREE_EXPECT_OK(
+      iree_vm_stack_function_enter(stack.get(), function_a, 2, 0, &frame_a));
+  frame_a->registers.i32[0] = 123;
+  frame_a->registers.i32[1] = 456;
+
+  iree_vm_stack_frame_t* frame_b = nullptr;
+  IREE_EXPECT_OK(
+      iree_vm_stack_function_enter(stack.get(), function_a, 2, 1, &frame_b));
+  frame_b->registers.i32[0] = 789;
+
+  // Only the current frame may be resized.
+  EXPECT_EQ(IREE_STATUS_FAILED_PRECONDITION,
+            iree_vm_stack_frame_reserve_registers(stack.get(), frame_a, 64, 8));
+
+  // Growing preserves existing values and nulls the new ref registers.
+  IREE_EXPECT_OK(
+      iree_vm_stack_frame_reserve_registers(stack.get(), frame_b, 100, 8));
+  EXPECT_EQ(127, frame_b->registers.i32_mask);
+  EXPECT_EQ(7, frame_b->registers.ref_mask);
+  EXPECT_EQ(789, frame_b->registers.i32[0]);
+  for (int i = 0; i <= frame_b->registers.ref_mask; ++i) {
+    EXPECT_EQ(nullptr, frame_b->registers.ref[i].ptr);
+  }
+
+  // Shrinking is a no-op.
+  IREE_EXPECT_OK(
+      iree_vm_stack_frame_reserve_registers(stack.get(), frame_b, 1, 1));
+  EXPECT_EQ(127, frame_b->registers.i32_mask);
+
+  // The parent frame must be unaffected.
+  IREE_EXPECT_OK(iree_vm_stack_function_leave(stack.get()));
+  EXPECT_EQ(123, frame_a->registers.i32[0]);
+  EXPECT_EQ(456, frame_a->registers.i32[1]);
+
+  IREE_EXPECT_OK(iree_vm_stack_deinit(stack.get()));
+}
+
 // Tests unbalanced stack popping.
 TEST(VMStackTest, UnbalancedPop) {
   auto stack = std::make_unique<iree_vm_stack_t>();
   iree_vm_state_resolver_t state_resolver = {nullptr, SentinelStateResolver};
-  IREE_EXPECT_OK(iree_vm_stack_init(state_resolver, stack.get()));
+  IREE_EXPECT_OK(iree_vm_stack_init(state_resolver, kNoStorage,
+                                    IREE_ALLOCATOR_SYSTEM, stack.get()));
 
   EXPECT_EQ(IREE_STATUS_FAILED_PRECONDITION,
             iree_vm_stack_function_leave(stack.get()));
@@ -149,7 +288,8 @@ TEST(VMStackTest, UnbalancedPop) {
 TEST(VMStackTest, ModuleStateQueries) {
   auto stack = std::make_unique<iree_vm_stack_t>();
   iree_vm_state_resolver_t state_resolver = {nullptr, SentinelStateResolver};
-  IREE_EXPECT_OK(iree_vm_stack_init(state_resolver, stack.get()));
+  IREE_EXPECT_OK(iree_vm_stack_init(state_resolver, kNoStorage,
+                                    IREE_ALLOCATOR_SYSTEM, stack.get()));
 
   EXPECT_EQ(nullptr, iree_vm_stack_current_frame(stack.get()));
   EXPECT_EQ(nullptr, iree_vm_stack_parent_frame(stack.get()));
@@ -162,7 +302,7 @@ TEST(VMStackTest, ModuleStateQueries) {
                                    IREE_VM_FUNCTION_LINKAGE_INTERNAL, 0};
   iree_vm_stack_frame_t* frame_a = nullptr;
   IREE_EXPECT_OK(
-      iree_vm_stack_function_enter(stack.get(), function_a, &frame_a));
+      iree_vm_stack_function_enter(stack.get(), function_a, 0, 0, &frame_a));
   EXPECT_EQ(MODULE_A_STATE_SENTINEL, frame_a->module_state);
   EXPECT_EQ(1, module_a_state_resolve_count);
 
@@ -171,13 +311,13 @@ TEST(VMStackTest, ModuleStateQueries) {
                                    IREE_VM_FUNCTION_LINKAGE_INTERNAL, 1};
   iree_vm_stack_frame_t* frame_b = nullptr;
   IREE_EXPECT_OK(
-      iree_vm_stack_function_enter(stack.get(), function_b, &frame_b));
+      iree_vm_stack_function_enter(stack.get(), function_b, 0, 0, &frame_b));
   EXPECT_EQ(MODULE_B_STATE_SENTINEL, frame_b->module_state);
   EXPECT_EQ(1, module_b_state_resolve_count);
 
   // [A, B, B (reuse)]
   IREE_EXPECT_OK(
-      iree_vm_stack_function_enter(stack.get(), function_b, &frame_b));
+      iree_vm_stack_function_enter(stack.get(), function_b, 0, 0, &frame_b));
   EXPECT_EQ(MODULE_B_STATE_SENTINEL, frame_b->module_state);
   EXPECT_EQ(1, module_b_state_resolve_count);
 
@@ -198,14 +338,15 @@ TEST(VMStackTest, ModuleStateQueryFailure) {
         // NOTE: always failing.
         return IREE_STATUS_INTERNAL;
       }};
-  IREE_EXPECT_OK(iree_vm_stack_init(state_resolver, stack.get()));
+  IREE_EXPECT_OK(iree_vm_stack_init(state_resolver, kNoStorage,
+                                    IREE_ALLOCATOR_SYSTEM, stack.get()));
 
   // Push should fail if we can't query state, status should propagate.
   iree_vm_function_t function_a = {MODULE_A_SENTINEL,
                                    IREE_VM_FUNCTION_LINKAGE_INTERNAL, 0};
   iree_vm_stack_frame_t* frame_a = nullptr;
-  EXPECT_EQ(IREE_STATUS_INTERNAL,
-            iree_vm_stack_function_enter(stack.get(), function_a, &frame_a));
+  EXPECT_EQ(IREE_STATUS_INTERNAL, iree_vm_stack_function_enter(
+                                      stack.get(), function_a, 0, 0, &frame_a));
 
   IREE_EXPECT_OK(iree_vm_stack_deinit(stack.get()));
 }
@@ -234,7 +375,8 @@ iree_vm_ref_type_t DummyObject::kTypeID = IREE_VM_REF_TYPE_NULL;
 TEST(VMStackTest, RefRegisterCleanup) {
   auto stack = std::make_unique<iree_vm_stack_t>();
   iree_vm_state_resolver_t state_resolver = {nullptr, SentinelStateResolver};
-  IREE_EXPECT_OK(iree_vm_stack_init(state_resolver, stack.get()));
+  IREE_EXPECT_OK(iree_vm_stack_init(state_resolver, kNoStorage,
+                                    IREE_ALLOCATOR_SYSTEM, stack.get()));
 
   dummy_object_count = 0;
   DummyObject::RegisterType();
@@ -243,14 +385,19 @@ TEST(VMStackTest, RefRegisterCleanup) {
                                    IREE_VM_FUNCTION_LINKAGE_INTERNAL, 0};
   iree_vm_stack_frame_t* frame_a = nullptr;
   IREE_EXPECT_OK(
-      iree_vm_stack_function_enter(stack.get(), function_a, &frame_a));
-  frame_a->registers.ref_register_count = 1;
-  memset(&frame_a->registers.ref[0], 0, sizeof(iree_vm_ref_t));
+      iree_vm_stack_function_enter(stack.get(), function_a, 0, 1, &frame_a));
   IREE_EXPECT_OK(iree_vm_ref_wrap_assign(
       new DummyObject(), DummyObject::kTypeID, &frame_a->registers.ref[0]));
   EXPECT_EQ(1, dummy_object_count);
 
-  // This should release the ref for us. Heap checker will yell if it doesn't.
+  // Move the ref into a grown bank to ensure it is still tracked.
+  IREE_EXPECT_OK(
+      iree_vm_stack_frame_reserve_registers(stack.get(), frame_a, 0, 4));
+  IREE_EXPECT_OK(iree_vm_ref_wrap_assign(
+      new DummyObject(), DummyObject::kTypeID, &frame_a->registers.ref[3]));
+  EXPECT_EQ(2, dummy_object_count);
+
+  // This should release the refs for us. Heap checker will yell if it doesn't.
   IREE_EXPECT_OK(iree_vm_stack_function_leave(stack.get()));
   EXPECT_EQ(0, dummy_object_count);
 